@@ -0,0 +1,184 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DirectoryIndex.hpp"
+
+#include "StringUtil.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <system_error>
+
+namespace utility {
+
+  using Lock = std::lock_guard<std::mutex>;
+
+  namespace {
+    // Covers the 2-second timestamp granularity of FAT file systems
+    constexpr auto RECENT_MODIFICATION_WINDOW = std::chrono::seconds(2);
+
+    // Static shared directory indexes
+    std::mutex directoryIndexesMutex;
+    std::map<std::wstring, std::shared_ptr<DirectoryIndex>> directoryIndexes; // Case-folded directory -> index
+  }
+
+  DirectoryIndex::DirectoryIndex(const std::wstring& directory)
+    : rootDirectory(directory), foldedRootDirectory(foldPath(directory)) {
+  }
+
+  std::wstring DirectoryIndex::find(const std::wstring& relativePath) {
+    // Walk down the relative path one level at a time, so only levels on the way are ever listed.
+    std::wstring foldedRelativePath = foldPath(relativePath);
+    std::wstring levelKey;
+    std::wstring levelPath = rootDirectory;
+    for (const auto& foldedName : split(foldedRelativePath, L"/")) {
+      if (foldedName.empty()) {
+        continue;
+      }
+
+      std::wstring path = findInLevel(levelKey, levelPath, foldedName);
+      if (path.empty()) {
+        return std::wstring();
+      }
+      levelKey = levelKey.empty() ? foldedName : levelKey + L'/' + foldedName;
+      levelPath = path;
+    }
+    return levelKey.empty() ? std::wstring() : levelPath;
+  }
+
+  bool DirectoryIndex::add(const std::wstring& filePath) {
+    std::wstring foldedFilePath = foldPath(filePath);
+    if (foldedFilePath.size() <= foldedRootDirectory.size() || !foldedFilePath.starts_with(foldedRootDirectory) || foldedFilePath[foldedRootDirectory.size()] != L'/') {
+      return false;
+    }
+
+    // Only levels that have been listed need to be updated, others will pick up the file when they are listed. Parent
+    // directories are added as well, in case they are newly created.
+    Lock lock(levelsMutex);
+    for (std::filesystem::path path(filePath); foldPath(path.wstring()).size() > foldedRootDirectory.size(); path = path.parent_path()) {
+      std::wstring foldedRelativePath = foldPath(path.lexically_relative(std::filesystem::path(rootDirectory)).wstring());
+      auto separatorPos = foldedRelativePath.rfind(L'/');
+      std::wstring levelKey = (separatorPos == std::wstring::npos) ? std::wstring() : foldedRelativePath.substr(0, separatorPos);
+      auto iter = levels.find(levelKey);
+      if (iter != levels.end() && iter->second.listed) {
+        iter->second.entries[foldedRelativePath.substr(separatorPos + 1)] = path.wstring();
+      }
+    }
+    return true;
+  }
+
+  std::wstring DirectoryIndex::foldPath(const std::wstring& path) {
+    std::wstring foldedPath = toLower(path);
+    std::replace(foldedPath.begin(), foldedPath.end(), L'\\', L'/');
+    while (!foldedPath.empty() && foldedPath.back() == L'/') {
+      foldedPath.pop_back();
+    }
+    return foldedPath;
+  }
+
+  // Private methods
+  //
+
+  std::wstring DirectoryIndex::findInLevel(const std::wstring& levelKey, const std::wstring& levelPath, const std::wstring& foldedName) {
+    bool listed = false;
+    bool recentlyModified = false;
+    std::filesystem::file_time_type listedWriteTime;
+    {
+      Lock lock(levelsMutex);
+      const auto& level = levels[levelKey];
+      if (level.listed) {
+        auto iter = level.entries.find(foldedName);
+        if (iter != level.entries.end()) {
+          return iter->second;
+        }
+        listed = true;
+        recentlyModified = level.recentlyModified;
+        listedWriteTime = level.writeTime;
+      }
+    }
+
+    // Either the level has not been listed yet, or the name is not in it. In the latter case, only re-list the level if
+    // its modification time shows entries have been added/removed since it was listed. File system access is done without
+    // holding the lock.
+    std::error_code errorCode;
+    if (listed && !recentlyModified) {
+      auto writeTime = std::filesystem::last_write_time(std::filesystem::path(levelPath), errorCode);
+      if (errorCode || writeTime == listedWriteTime) {
+        return std::wstring();
+      }
+    }
+
+    Level listedLevel = list(levelPath);
+    Lock lock(levelsMutex);
+    auto& level = levels[levelKey];
+    level = std::move(listedLevel);
+    auto iter = level.entries.find(foldedName);
+    return (iter != level.entries.end()) ? iter->second : std::wstring();
+  }
+
+  DirectoryIndex::Level DirectoryIndex::list(const std::wstring& levelPath) {
+    Level level {
+      .listed = true
+    };
+
+    // Modification time is taken before listing, so an entry added during listing will cause a re-list on next miss.
+    // Directories that can't be accessed are left empty, as PapyrusCompiler won't be able to use them either.
+    std::error_code errorCode;
+    std::filesystem::path directory(levelPath);
+    level.writeTime = std::filesystem::last_write_time(directory, errorCode);
+    level.recentlyModified = !errorCode && std::filesystem::file_time_type::clock::now() - level.writeTime < RECENT_MODIFICATION_WINDOW;
+    for (auto iter = std::filesystem::directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, errorCode);
+      !errorCode && iter != std::filesystem::directory_iterator(); iter.increment(errorCode)) {
+      level.entries[foldPath(iter->path().filename().wstring())] = iter->path().wstring();
+    }
+    return level;
+  }
+
+  // Directory index registry
+  //
+
+  std::shared_ptr<DirectoryIndex> getDirectoryIndex(const std::wstring& directory) {
+    // Creating an index doesn't access the file system, so it's cheap to do while holding the lock.
+    std::wstring foldedDirectory = DirectoryIndex::foldPath(directory);
+    Lock lock(directoryIndexesMutex);
+    auto& directoryIndex = directoryIndexes[foldedDirectory];
+    if (!directoryIndex) {
+      directoryIndex = std::make_shared<DirectoryIndex>(directory);
+    }
+    return directoryIndex;
+  }
+
+  std::wstring findFileIgnoringCase(const std::wstring& directory, const std::wstring& relativePath) {
+    return directory.empty() ? std::wstring() : getDirectoryIndex(directory)->find(relativePath);
+  }
+
+  void addFileToDirectoryIndexes(const std::wstring& filePath) {
+    Lock lock(directoryIndexesMutex);
+    for (const auto& [directory, directoryIndex] : directoryIndexes) {
+      directoryIndex->add(filePath);
+    }
+  }
+
+  void clearDirectoryIndexes() {
+    Lock lock(directoryIndexesMutex);
+    directoryIndexes.clear();
+  }
+
+} // namespace
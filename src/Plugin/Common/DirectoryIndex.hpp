@@ -0,0 +1,89 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace utility {
+
+  // An index of files under a directory, keyed by case-folded relative path. Papyrus class names are case insensitive,
+  // so looking up a class file through the index gives its real on-disk spelling, which is required on case-sensitive
+  // file systems, and it costs hash lookups instead of file system probes.
+  //
+  // Index is built lazily, one directory level at a time, only for levels that lookups actually walk through. When a
+  // name is not found, the level's modification time is checked, and the level is re-listed if it has changed, so that
+  // files created outside of the editor are picked up. A level modified shortly before it was listed is always re-listed
+  // on a miss, as file systems with coarse timestamps may not change modification time for entries added right after.
+  class DirectoryIndex {
+    public:
+      // Create index of given directory. No file system access is done until the first lookup.
+      explicit DirectoryIndex(const std::wstring& directory);
+
+      // Disable all copy/move constructors/assignment operators
+      DirectoryIndex(DirectoryIndex&& other) = delete;
+
+      inline const std::wstring& directory() const noexcept { return rootDirectory; }
+
+      // Find the real full path of a file under this directory, with relative path in any case. Returns empty string if not found.
+      std::wstring find(const std::wstring& relativePath);
+
+      // Add a file under this directory to the index, e.g. when a new file is created. Returns false if the file is not under this directory.
+      bool add(const std::wstring& filePath);
+
+      // Case-fold a path so that it can be used as index key
+      static std::wstring foldPath(const std::wstring& path);
+
+    private:
+      struct Level {
+        bool listed {false};
+        bool recentlyModified {false};
+        std::filesystem::file_time_type writeTime;
+        std::unordered_map<std::wstring, std::wstring> entries; // Case-folded name -> real full path
+      };
+
+      std::wstring findInLevel(const std::wstring& levelKey, const std::wstring& levelPath, const std::wstring& foldedName);
+      static Level list(const std::wstring& levelPath);
+
+      // Private members
+      //
+      std::wstring rootDirectory;
+      std::wstring foldedRootDirectory;
+
+      std::mutex levelsMutex;
+      std::unordered_map<std::wstring, Level> levels; // Case-folded relative directory path -> directory level
+  };
+
+  // Get the shared index of a directory. Index is created on first request and reused afterwards.
+  std::shared_ptr<DirectoryIndex> getDirectoryIndex(const std::wstring& directory);
+
+  // Find the real full path of a file under a directory ignoring case. Returns empty string if not found.
+  std::wstring findFileIgnoringCase(const std::wstring& directory, const std::wstring& relativePath);
+
+  // Add a created/saved file to all existing directory indexes it belongs to
+  void addFileToDirectoryIndexes(const std::wstring& filePath);
+
+  // Drop all directory indexes, e.g. when import directories are changed. They will be rebuilt on demand.
+  void clearDirectoryIndexes();
+
+} // namespace
@@ -0,0 +1,159 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Game.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace papyrus {
+
+  namespace game {
+
+    // Papyrus language features that are not available in every game
+    struct GameFeatures {
+      bool structs;       // Struct/EndStruct
+      bool groups;        // Group/EndGroup and their flags
+      bool constants;     // Const/Mandatory flags
+      bool varType;       // Var type
+      bool namespaces;    // ":" in script names, e.g. "MyMod:MyScript"
+      bool isOperator;    // Is operator
+      bool debugFlags;    // DebugOnly/BetaOnly flags
+    };
+
+    // Feature table of each game. Auto mode doesn't know which game a script is for, so it allows all features.
+    template <Game game>
+    constexpr GameFeatures gameFeatures {
+      .structs = true,
+      .groups = true,
+      .constants = true,
+      .varType = true,
+      .namespaces = true,
+      .isOperator = true,
+      .debugFlags = true
+    };
+
+    template <>
+    constexpr GameFeatures gameFeatures<Game::Skyrim> {
+      .structs = false,
+      .groups = false,
+      .constants = false,
+      .varType = false,
+      .namespaces = false,
+      .isOperator = false,
+      .debugFlags = false
+    };
+
+    template <>
+    constexpr GameFeatures gameFeatures<Game::SkyrimSE> = gameFeatures<Game::Skyrim>;
+
+    // Whether a game supports every feature, so that feature checks can be skipped altogether
+    template <Game game>
+    constexpr bool hasAllFeatures = gameFeatures<game>.structs && gameFeatures<game>.groups && gameFeatures<game>.constants
+      && gameFeatures<game>.varType && gameFeatures<game>.namespaces && gameFeatures<game>.isOperator && gameFeatures<game>.debugFlags;
+
+    // Lower-cased words that are only valid when the corresponding feature is supported
+    constexpr std::pair<std::string_view, bool GameFeatures::*> featureWords[] {
+      {"struct", &GameFeatures::structs},
+      {"endstruct", &GameFeatures::structs},
+      {"group", &GameFeatures::groups},
+      {"endgroup", &GameFeatures::groups},
+      {"collapsed", &GameFeatures::groups},
+      {"collapsedonref", &GameFeatures::groups},
+      {"collapsedonbase", &GameFeatures::groups},
+      {"const", &GameFeatures::constants},
+      {"mandatory", &GameFeatures::constants},
+      {"var", &GameFeatures::varType},
+      {"is", &GameFeatures::isOperator},
+      {"debugonly", &GameFeatures::debugFlags},
+      {"betaonly", &GameFeatures::debugFlags}
+    };
+
+    // Check whether a lower-cased word is supported by a game. For games that support all features this is a constant.
+    // Lexer doesn't check words one by one, as its word lists are filtered with this when a game is selected.
+    template <Game game>
+    constexpr bool isWordSupported(std::string_view word) {
+      if constexpr (hasAllFeatures<game>) {
+        return true;
+      } else {
+        for (const auto& [featureWord, feature] : featureWords) {
+          if (featureWord == word) {
+            return gameFeatures<game>.*feature;
+          }
+        }
+        return true;
+      }
+    }
+
+    // Remove words a game doesn't support from a white space separated word list, as Notepad++ passes it to lexer
+    template <Game game>
+    std::string filterWordList(std::string_view wordList) {
+      if constexpr (hasAllFeatures<game>) {
+        return std::string(wordList);
+      } else {
+        constexpr std::string_view whiteSpaces = " \t\r\n";
+        std::string filteredWordList;
+        for (size_t start = wordList.find_first_not_of(whiteSpaces); start != std::string_view::npos; start = wordList.find_first_not_of(whiteSpaces, start)) {
+          size_t end = std::min(wordList.find_first_of(whiteSpaces, start), wordList.size());
+          auto word = wordList.substr(start, end - start);
+          if (isWordSupported<game>(word)) {
+            if (!filteredWordList.empty()) {
+              filteredWordList += ' ';
+            }
+            filteredWordList += word;
+          }
+          start = end;
+        }
+        return filteredWordList;
+      }
+    }
+
+    // Check whether a character can be part of an identifier, including ":" in script names with namespaces
+    template <Game game>
+    inline bool isIdentifierCharacter(int ch) {
+      return ch <= 255 && (std::isalnum(ch) || ch == '_' || (gameFeatures<game>.namespaces && ch == ':'));
+    }
+
+    // Call a generic function with the game as a compile time constant, so game specific code paths can be selected once
+    // instead of checking the game everywhere.
+    template <class Function>
+    decltype(auto) dispatch(Game game, Function&& function) {
+      switch (game) {
+        case Game::Skyrim:
+          return function(std::integral_constant<Game, Game::Skyrim>());
+
+        case Game::SkyrimSE:
+          return function(std::integral_constant<Game, Game::SkyrimSE>());
+
+        case Game::Fallout4:
+          return function(std::integral_constant<Game, Game::Fallout4>());
+
+        default:
+          return function(std::integral_constant<Game, Game::Auto>());
+      }
+    }
+
+  } // namespace game
+
+} // namespace papyrus
@@ -0,0 +1,47 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <string>
+
+namespace utility {
+
+  // 64-bit FNV-1a hash. Not cryptographically secure, only meant to detect content changes.
+  constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+  constexpr uint64_t FNV_PRIME        = 1099511628211ULL;
+
+  inline uint64_t hash(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS) noexcept {
+    uint64_t result = seed;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      result ^= bytes[i];
+      result *= FNV_PRIME;
+    }
+    return result;
+  }
+
+  inline uint64_t hash(const std::string& str, uint64_t seed = FNV_OFFSET_BASIS) noexcept { return hash(str.data(), str.size(), seed); }
+  inline uint64_t hash(const std::wstring& str, uint64_t seed = FNV_OFFSET_BASIS) noexcept { return hash(str.data(), str.size() * sizeof(wchar_t), seed); }
+
+  inline std::wstring hashToHexStr(uint64_t hashValue) noexcept { return std::format(L"{:016X}", hashValue); }
+
+} // namespace
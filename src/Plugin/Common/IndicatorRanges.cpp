@@ -0,0 +1,150 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "IndicatorRanges.hpp"
+
+#include "..\..\external\npp\PluginInterface.h"
+
+#include <algorithm>
+
+namespace utility {
+
+  void IndicatorRanges::add(npp_position_t start, npp_length_t length) {
+    if (length > 0) {
+      pendingRanges.push_back(Range {
+        .start = start,
+        .end = start + length
+      });
+    }
+  }
+
+  void IndicatorRanges::paint(HWND handle, int indicatorID) {
+    if (pendingRanges.empty()) {
+      return;
+    }
+
+    std::sort(pendingRanges.begin(), pendingRanges.end(),
+      [](const auto& range1, const auto& range2) {
+        return range1.start < range2.start;
+      }
+    );
+
+    npp_ptr_t document = reinterpret_cast<npp_ptr_t>(::SendMessage(handle, SCI_GETDOCPOINTER, 0, 0));
+    auto& paintedRanges = paintedDocuments.try_emplace(document, PaintedRanges { .indicatorID = indicatorID }).first->second;
+    std::vector<Range> mergedRanges;
+    Range merged = pendingRanges.front();
+    for (auto iter = std::next(pendingRanges.begin()); iter != pendingRanges.end(); ++iter) {
+      if (iter->start <= merged.end) {
+        merged.end = std::max(merged.end, iter->end);
+      } else {
+        mergedRanges.push_back(merged);
+        merged = *iter;
+      }
+    }
+    mergedRanges.push_back(merged);
+    pendingRanges.clear();
+
+    ::SendMessage(handle, SCI_SETINDICATORCURRENT, indicatorID, 0);
+    for (const auto& range : mergedRanges) {
+      ::SendMessage(handle, SCI_INDICATORFILLRANGE, range.start, range.end - range.start);
+    }
+
+    // Keep recorded ranges sorted and apart, so moving them along with edits stays simple. Ranges painted earlier on the same
+    // document are rare, e.g. error indications painted file by file.
+    auto& ranges = paintedRanges.ranges;
+    ranges.insert(ranges.end(), mergedRanges.begin(), mergedRanges.end());
+    std::sort(ranges.begin(), ranges.end(),
+      [](const auto& range1, const auto& range2) {
+        return range1.start < range2.start;
+      }
+    );
+    size_t count = 0;
+    for (const auto& range : ranges) {
+      if (count > 0 && range.start <= ranges[count - 1].end) {
+        ranges[count - 1].end = std::max(ranges[count - 1].end, range.end);
+      } else {
+        ranges[count++] = range;
+      }
+    }
+    ranges.resize(count);
+  }
+
+  void IndicatorRanges::clear(HWND handle) {
+    pendingRanges.clear();
+    auto iter = paintedDocuments.find(reinterpret_cast<npp_ptr_t>(::SendMessage(handle, SCI_GETDOCPOINTER, 0, 0)));
+    if (iter != paintedDocuments.end()) {
+      ::SendMessage(handle, SCI_SETINDICATORCURRENT, iter->second.indicatorID, 0);
+      for (const auto& range : iter->second.ranges) {
+        ::SendMessage(handle, SCI_INDICATORCLEARRANGE, range.start, range.end - range.start);
+      }
+      paintedDocuments.erase(iter);
+    }
+  }
+
+  void IndicatorRanges::discard() {
+    pendingRanges.clear();
+    paintedDocuments.clear();
+  }
+
+  void IndicatorRanges::contentChanged(HWND handle, npp_position_t position, npp_length_t lengthAdded) {
+    if (paintedDocuments.empty() || lengthAdded == 0) {
+      return;
+    }
+
+    auto iter = paintedDocuments.find(reinterpret_cast<npp_ptr_t>(::SendMessage(handle, SCI_GETDOCPOINTER, 0, 0)));
+    if (iter == paintedDocuments.end()) {
+      return;
+    }
+
+    auto& ranges = iter->second.ranges;
+    auto range = std::lower_bound(ranges.begin(), ranges.end(), position,
+      [](const auto& range, npp_position_t position) {
+        return range.end < position;
+      }
+    );
+    if (lengthAdded > 0) {
+      // Like Scintilla, text inserted in the middle of a range extends it, while text inserted at either end doesn't.
+      for (; range != ranges.end(); ++range) {
+        if (range->start >= position) {
+          range->start += lengthAdded;
+        }
+        if (range->end > position) {
+          range->end += lengthAdded;
+        }
+      }
+    } else {
+      // Ranges within deleted text are gone, and the ones deleted text overlaps shrink.
+      auto shifted = [&](npp_position_t pos) {
+        return (pos <= position) ? pos : std::max(position, pos + lengthAdded);
+      };
+      auto kept = range;
+      for (; range != ranges.end(); ++range) {
+        Range moved {
+          .start = shifted(range->start),
+          .end = shifted(range->end)
+        };
+        if (moved.end > moved.start) {
+          *kept++ = moved;
+        }
+      }
+      ranges.erase(kept, ranges.end());
+    }
+  }
+
+} // namespace
@@ -0,0 +1,71 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "NotepadPlusPlus.hpp"
+
+#include <map>
+#include <vector>
+
+#include <windows.h>
+
+namespace utility {
+
+  // Keeps track of ranges a component painted with its indicator, so that they can be cleared without clearing the whole
+  // document. Indicators are usually shared with other components and plugins, so only the recorded ranges are cleared, and
+  // they are moved along with edits the same way Scintilla moves indications. Indications belong to documents rather than
+  // views, so painted ranges are tracked per document, and cleared when the document is shown again. Ranges are painted in
+  // batches: they are queued first, then sorted and merged so that overlapping or adjacent ranges only take one Scintilla call.
+  class IndicatorRanges {
+    public:
+      // Queue a range to be painted
+      void add(npp_position_t start, npp_length_t length);
+
+      // Paint queued ranges with given indicator on the document shown on given view
+      void paint(HWND handle, int indicatorID);
+
+      // Clear ranges painted on the document shown on given view
+      void clear(HWND handle);
+
+      // Forget all painted ranges without clearing them, e.g. when they have been cleared along with all other indications
+      void discard();
+
+      // Move ranges painted on the document shown on given view, after text was inserted (positive length) or deleted
+      // (negative length) at given position
+      void contentChanged(HWND handle, npp_position_t position, npp_length_t lengthAdded);
+
+    private:
+      struct Range {
+        npp_position_t start;
+        npp_position_t end;
+      };
+
+      struct PaintedRanges {
+        int indicatorID;
+        std::vector<Range> ranges; // Sorted and never overlap
+      };
+
+      // Private members
+      //
+      std::vector<Range> pendingRanges;
+      std::map<npp_ptr_t, PaintedRanges> paintedDocuments;
+  };
+
+} // namespace
@@ -0,0 +1,445 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+namespace utility {
+
+  // Summary for trees that don't need one
+  struct LineTreeNoSummary {
+    template <class T>
+    static inline LineTreeNoSummary of(const T&) noexcept { return LineTreeNoSummary(); }
+    static inline LineTreeNoSummary combine(const LineTreeNoSummary&, const LineTreeNoSummary&) noexcept { return LineTreeNoSummary(); }
+  };
+
+  // Ordered sequence of items located by line, e.g. what lexer finds on each line of a document. Multiple items can be on the
+  // same line, and they keep the order they are inserted in. Each item stores its line relative to the previous item, so adding
+  // or deleting lines only changes the item right after the edit, and nodes, which are handed out as handles, stay valid until
+  // their items are erased.
+  //
+  // Items are kept in a treap, a randomized balanced binary search tree, so looking up, inserting and erasing items, as well as
+  // shifting lines, are all O(log n). Each node also keeps a summary of its subtree, combined from summaries of items in order,
+  // which lets searches skip whole subtrees. Summary type needs to provide static "of(item)" and "combine(summary1, summary2)"
+  // methods, where combine is associative and a default constructed summary is its identity.
+  template <class T, class Summary = LineTreeNoSummary>
+  class LineTree {
+    public:
+      using line_t = std::ptrdiff_t;
+
+      class Node {
+        friend class LineTree;
+
+        public:
+          inline const T& item() const noexcept { return value; }
+
+        private:
+          inline Node(T&& value, line_t lineDelta, uint32_t priority) : value(std::move(value)), priority(priority), lineDelta(lineDelta) {}
+
+          T value;
+          Node* parent {nullptr};
+          Node* left {nullptr};
+          Node* right {nullptr};
+          uint32_t priority;
+          line_t lineDelta;      // Relative to previous node's line, or to line 0 for the first node
+          line_t lineSum {0};    // Sum of line deltas in subtree
+          Summary summary {};    // Summary of subtree
+      };
+
+      [[nodiscard]] inline LineTree() {}
+      inline ~LineTree() { clear(); }
+
+      // Disable all copy/move constructors/assignment operators
+      LineTree(LineTree&& other) = delete;
+
+      inline bool empty() const noexcept { return root == nullptr; }
+      inline size_t size() const noexcept { return nodeCount; }
+
+      void clear() noexcept {
+        // Detach nodes bottom-up without recursion
+        Node* node = root;
+        while (node != nullptr) {
+          if (node->left != nullptr) {
+            node = std::exchange(node->left, nullptr);
+          } else if (node->right != nullptr) {
+            node = std::exchange(node->right, nullptr);
+          } else {
+            delete std::exchange(node, node->parent);
+          }
+        }
+        root = nullptr;
+        nodeCount = 0;
+      }
+
+      // Add an item after all items on the same line
+      Node* insert(line_t line, T value) {
+        // Find where the new node goes as a leaf, i.e. after the last node on or before the line
+        Node* parent = nullptr;
+        bool asLeftChild = false;
+        line_t base = 0;
+        for (Node* node = root; node != nullptr;) {
+          parent = node;
+          line_t nodeLine = base + lineSum(node->left) + node->lineDelta;
+          if (nodeLine <= line) {
+            base = nodeLine;
+            node = node->right;
+            asLeftChild = false;
+          } else {
+            node = node->left;
+            asLeftChild = true;
+          }
+        }
+
+        Node* previousNode = asLeftChild ? previous(parent) : parent;
+        Node* nextNode = asLeftChild ? parent : ((parent != nullptr) ? next(parent) : nullptr);
+        line_t previousLine = (previousNode != nullptr) ? lineOf(previousNode) : 0;
+        Node* newNode = new Node(std::move(value), line - previousLine, static_cast<uint32_t>(random()));
+        nodeCount++;
+        newNode->parent = parent;
+        if (parent == nullptr) {
+          root = newNode;
+        } else if (asLeftChild) {
+          parent->left = newNode;
+        } else {
+          parent->right = newNode;
+        }
+
+        // Next node is now relative to the new one
+        if (nextNode != nullptr) {
+          nextNode->lineDelta -= newNode->lineDelta;
+        }
+        updateToRoot(newNode);
+
+        while (newNode->parent != nullptr && newNode->parent->priority < newNode->priority) {
+          rotateUp(newNode);
+        }
+        return newNode;
+      }
+
+      void erase(Node* node) noexcept {
+        // Next node becomes relative to the previous one
+        Node* nextNode = next(node);
+        if (nextNode != nullptr) {
+          nextNode->lineDelta += node->lineDelta;
+        }
+
+        // Rotate the node down to a leaf, then detach it
+        while (node->left != nullptr || node->right != nullptr) {
+          Node* child = (node->right == nullptr || (node->left != nullptr && node->left->priority > node->right->priority)) ? node->left : node->right;
+          rotateUp(child);
+        }
+        Node* parent = node->parent;
+        if (parent == nullptr) {
+          root = nullptr;
+        } else if (parent->left == node) {
+          parent->left = nullptr;
+        } else {
+          parent->right = nullptr;
+        }
+        delete node;
+        nodeCount--;
+        updateToRoot(parent);
+        updateToRoot(nextNode);
+      }
+
+      // Erase all items on lines in [firstLine, lastLine]. Returns whether anything was erased.
+      bool eraseLines(line_t firstLine, line_t lastLine) noexcept {
+        bool erased = false;
+        for (Node* node = lowerBound(firstLine); node != nullptr && lineOf(node) <= lastLine;) {
+          Node* nextNode = next(node);
+          erase(node);
+          node = nextNode;
+          erased = true;
+        }
+        return erased;
+      }
+
+      // Shift lines of all items after the given line, after lines were added (positive) or deleted (negative) after it. Items on
+      // deleted lines are erased.
+      void shiftLines(line_t line, line_t linesAdded) noexcept {
+        if (linesAdded < 0) {
+          eraseLines(line + 1, line - linesAdded);
+        }
+
+        Node* node = lowerBound(line + 1);
+        if (node != nullptr && linesAdded != 0) {
+          node->lineDelta += linesAdded;
+          updateToRoot(node);
+        }
+      }
+
+      // Line of an item
+      line_t lineOf(const Node* node) const noexcept {
+        line_t line = node->lineDelta + lineSum(node->left);
+        for (; node->parent != nullptr; node = node->parent) {
+          if (node->parent->right == node) {
+            line += node->parent->lineDelta + lineSum(node->parent->left);
+          }
+        }
+        return line;
+      }
+
+      // First item on or after the given line, or nullptr if there isn't any
+      Node* lowerBound(line_t line) const noexcept {
+        Node* result = nullptr;
+        line_t base = 0;
+        for (Node* node = root; node != nullptr;) {
+          line_t nodeLine = base + lineSum(node->left) + node->lineDelta;
+          if (nodeLine >= line) {
+            result = node;
+            node = node->left;
+          } else {
+            base = nodeLine;
+            node = node->right;
+          }
+        }
+        return result;
+      }
+
+      Node* first() const noexcept { return (root != nullptr) ? leftmost(root) : nullptr; }
+      Node* last() const noexcept { return (root != nullptr) ? rightmost(root) : nullptr; }
+
+      Node* next(const Node* node) const noexcept {
+        if (node->right != nullptr) {
+          return leftmost(node->right);
+        }
+        for (; node->parent != nullptr; node = node->parent) {
+          if (node->parent->left == node) {
+            return node->parent;
+          }
+        }
+        return nullptr;
+      }
+
+      Node* previous(const Node* node) const noexcept {
+        if (node->left != nullptr) {
+          return rightmost(node->left);
+        }
+        for (; node->parent != nullptr; node = node->parent) {
+          if (node->parent->right == node) {
+            return node->parent;
+          }
+        }
+        return nullptr;
+      }
+
+      // Call a function with line and item of every item in order
+      template <class Func>
+      void forEach(Func func) const {
+        line_t line = 0;
+        for (Node* node = first(); node != nullptr; node = next(node)) {
+          line += node->lineDelta;
+          func(line, node->value);
+        }
+      }
+
+      // Find the first item after the given node (or from the beginning if it's nullptr) that a searcher is looking for. Searcher
+      // needs to provide "bool contains(const Summary&)", which tells whether the item is within consecutive items of the given
+      // summary, and "void skip(const Summary&)", which is called with consecutive items that have been passed, in order.
+      template <class Searcher>
+      Node* findNext(const Node* node, Searcher& searcher) const {
+        if (node == nullptr) {
+          return findFirstIn(root, searcher);
+        }
+
+        if (Node* found = findFirstIn(node->right, searcher)) {
+          return found;
+        }
+        for (; node->parent != nullptr; node = node->parent) {
+          if (node->parent->left == node) {
+            Node* parent = node->parent;
+            auto itemSummary = Summary::of(parent->value);
+            if (searcher.contains(itemSummary)) {
+              return parent;
+            }
+            searcher.skip(itemSummary);
+            if (Node* found = findFirstIn(parent->right, searcher)) {
+              return found;
+            }
+          }
+        }
+        return nullptr;
+      }
+
+      // Same as findNext, but backward from the given node (or from the end if it's nullptr). Consecutive items are passed to
+      // searcher in reverse order.
+      template <class Searcher>
+      Node* findPrevious(const Node* node, Searcher& searcher) const {
+        if (node == nullptr) {
+          return findLastIn(root, searcher);
+        }
+
+        if (Node* found = findLastIn(node->left, searcher)) {
+          return found;
+        }
+        for (; node->parent != nullptr; node = node->parent) {
+          if (node->parent->right == node) {
+            Node* parent = node->parent;
+            auto itemSummary = Summary::of(parent->value);
+            if (searcher.contains(itemSummary)) {
+              return parent;
+            }
+            searcher.skip(itemSummary);
+            if (Node* found = findLastIn(parent->left, searcher)) {
+              return found;
+            }
+          }
+        }
+        return nullptr;
+      }
+
+    private:
+      static inline line_t lineSum(const Node* node) noexcept { return (node != nullptr) ? node->lineSum : 0; }
+
+      static inline Node* leftmost(Node* node) noexcept {
+        while (node->left != nullptr) {
+          node = node->left;
+        }
+        return node;
+      }
+
+      static inline Node* rightmost(Node* node) noexcept {
+        while (node->right != nullptr) {
+          node = node->right;
+        }
+        return node;
+      }
+
+      static void update(Node* node) noexcept {
+        node->lineSum = lineSum(node->left) + node->lineDelta + lineSum(node->right);
+        node->summary = Summary::of(node->value);
+        if (node->left != nullptr) {
+          node->summary = Summary::combine(node->left->summary, node->summary);
+        }
+        if (node->right != nullptr) {
+          node->summary = Summary::combine(node->summary, node->right->summary);
+        }
+      }
+
+      static void updateToRoot(Node* node) noexcept {
+        for (; node != nullptr; node = node->parent) {
+          update(node);
+        }
+      }
+
+      // Rotate a node above its parent, keeping the order of items
+      void rotateUp(Node* node) noexcept {
+        Node* parent = node->parent;
+        Node* grandparent = parent->parent;
+        if (parent->left == node) {
+          parent->left = node->right;
+          if (node->right != nullptr) {
+            node->right->parent = parent;
+          }
+          node->right = parent;
+        } else {
+          parent->right = node->left;
+          if (node->left != nullptr) {
+            node->left->parent = parent;
+          }
+          node->left = parent;
+        }
+        parent->parent = node;
+        node->parent = grandparent;
+        if (grandparent == nullptr) {
+          root = node;
+        } else if (grandparent->left == parent) {
+          grandparent->left = node;
+        } else {
+          grandparent->right = node;
+        }
+        update(parent);
+        update(node);
+      }
+
+      template <class Searcher>
+      static Node* findFirstIn(Node* node, Searcher& searcher) {
+        if (node == nullptr) {
+          return nullptr;
+        }
+        if (!searcher.contains(node->summary)) {
+          searcher.skip(node->summary);
+          return nullptr;
+        }
+
+        // The item is in this subtree
+        while (true) {
+          if (node->left != nullptr) {
+            if (searcher.contains(node->left->summary)) {
+              node = node->left;
+              continue;
+            }
+            searcher.skip(node->left->summary);
+          }
+          auto itemSummary = Summary::of(node->value);
+          if (searcher.contains(itemSummary)) {
+            return node;
+          }
+          searcher.skip(itemSummary);
+          if (node->right == nullptr) {
+            return nullptr;
+          }
+          node = node->right;
+        }
+      }
+
+      template <class Searcher>
+      static Node* findLastIn(Node* node, Searcher& searcher) {
+        if (node == nullptr) {
+          return nullptr;
+        }
+        if (!searcher.contains(node->summary)) {
+          searcher.skip(node->summary);
+          return nullptr;
+        }
+
+        // The item is in this subtree
+        while (true) {
+          if (node->right != nullptr) {
+            if (searcher.contains(node->right->summary)) {
+              node = node->right;
+              continue;
+            }
+            searcher.skip(node->right->summary);
+          }
+          auto itemSummary = Summary::of(node->value);
+          if (searcher.contains(itemSummary)) {
+            return node;
+          }
+          searcher.skip(itemSummary);
+          if (node->left == nullptr) {
+            return nullptr;
+          }
+          node = node->left;
+        }
+      }
+
+      // Private members
+      //
+      Node* root {nullptr};
+      size_t nodeCount {0};
+      std::minstd_rand random {1}; // Fixed seed, so trees are shaped the same on every run
+  };
+
+} // namespace
@@ -0,0 +1,131 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "MappedFile.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utility {
+
+  MappedFile::~MappedFile() {
+    close();
+  }
+
+  bool MappedFile::open(const std::wstring& filePath, bool writable) {
+    close();
+
+#ifdef _WIN32
+    file = ::CreateFileW(filePath.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return fail();
+    }
+
+    LARGE_INTEGER fileSize {};
+    if (!::GetFileSizeEx(file, &fileSize)) {
+      return fail();
+    }
+    if (fileSize.QuadPart == 0) {
+      ::SetLastError(ERROR_FILE_INVALID);
+      return fail();
+    }
+
+    mapping = ::CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+      return fail();
+    }
+
+    view = static_cast<unsigned char*>(::MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr) {
+      return fail();
+    }
+    viewSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    file = ::open(std::filesystem::path(filePath).c_str(), writable ? O_RDWR : O_RDONLY);
+    if (file < 0) {
+      return fail();
+    }
+
+    struct stat fileStatus {};
+    if (::fstat(file, &fileStatus) != 0) {
+      return fail();
+    }
+    if (fileStatus.st_size == 0) {
+      errno = EINVAL;
+      return fail();
+    }
+
+    void* address = ::mmap(nullptr, static_cast<size_t>(fileStatus.st_size), writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, file, 0);
+    if (address == MAP_FAILED) {
+      return fail();
+    }
+    view = static_cast<unsigned char*>(address);
+    viewSize = static_cast<size_t>(fileStatus.st_size);
+#endif
+    return true;
+  }
+
+  void MappedFile::close() {
+#ifdef _WIN32
+    if (view != nullptr) {
+      ::UnmapViewOfFile(view);
+    }
+    if (mapping != nullptr) {
+      ::CloseHandle(mapping);
+      mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+      ::CloseHandle(file);
+      file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (view != nullptr) {
+      ::munmap(view, viewSize);
+    }
+    if (file >= 0) {
+      ::close(file);
+      file = -1;
+    }
+#endif
+    view = nullptr;
+    viewSize = 0;
+  }
+
+  // Private methods
+  //
+
+  bool MappedFile::fail() {
+#ifdef _WIN32
+    errorCode = ::GetLastError();
+#else
+    errorCode = static_cast<unsigned long>(errno);
+#endif
+    close();
+    return false;
+  }
+
+} // namespace
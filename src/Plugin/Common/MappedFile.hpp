@@ -0,0 +1,70 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace utility {
+
+  // A whole file mapped into memory, either read-only or writable. Writes to a writable mapping go straight to the file, so a
+  // file can be patched in place without reading it into a buffer first. Empty files can't be mapped on every platform, so
+  // opening one always fails.
+  class MappedFile {
+    public:
+      MappedFile() = default;
+      ~MappedFile();
+
+      // Disable all copy/move constructors/assignment operators
+      MappedFile(MappedFile&& other) = delete;
+
+      // Map a file, closing the one mapped before. Returns false if the file can't be opened or mapped, in which case the error
+      // code of the failed system call is available.
+      bool open(const std::wstring& filePath, bool writable);
+      void close();
+
+      inline bool isOpen() const { return view != nullptr; }
+      inline unsigned char* data() const { return view; }
+      inline size_t size() const { return viewSize; }
+      inline unsigned long getErrorCode() const { return errorCode; }
+
+    private:
+      bool fail();
+
+      // Private members
+      //
+      unsigned char* view {nullptr};
+      size_t viewSize {0};
+      unsigned long errorCode {0};
+
+#ifdef _WIN32
+      HANDLE file {INVALID_HANDLE_VALUE};
+      HANDLE mapping {nullptr};
+#else
+      int file {-1};
+#endif
+  };
+
+} // namespace
@@ -41,9 +41,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PPM_COMPILER_NOT_FOUND    (WM_USER + 3)
 #define PPM_OTHER_ERROR           (WM_USER + 4)
 #define PPM_JUMP_TO_ERROR         (WM_USER + 5)
+#define PPM_BLOCK_CHECK_DONE      (WM_USER + 6)
+#define PPM_AUTO_INDENT           (WM_USER + 7)
+#define PPM_COMPILATION_ERRORS    (WM_USER + 8)
+#define PPM_COMPILATION_CANCELLED (WM_USER + 9)
 
-#define PARAM_COMPILATION_ONLY                0
-#define PARAM_COMPILATION_WITH_ANONYMIZATION  1
+//
+// Timers on message window
+//
+
+#define PPT_MATCH_KEYWORD         1
+#define PPT_JUMP_TO_ERROR_LINE    2
+#define PPT_CHECK_BLOCKS          3
 
 //
 // Resources
@@ -108,11 +108,10 @@ namespace utility {
     size_t prevPos = 0;
     size_t pos = 0;
     while ((pos = indexOf(str, delimiter, prevPos, ignoreCase)) != std::string::npos) {
-      result.push_back(str.substr(prevPos, pos));
-      pos += delimiter.size();
-      prevPos = pos;
+      result.push_back(str.substr(prevPos, pos - prevPos));
+      prevPos = pos + delimiter.size();
     }
-    result.push_back(str.substr(prevPos, pos));
+    result.push_back(str.substr(prevPos));
 
     return result;
   }
@@ -122,11 +121,10 @@ namespace utility {
     size_t prevPos = 0;
     size_t pos = 0;
     while ((pos = indexOf(str, delimiter, prevPos, ignoreCase)) != std::string::npos) {
-      result.push_back(str.substr(prevPos, pos));
-      pos += delimiter.size();
-      prevPos = pos;
+      result.push_back(str.substr(prevPos, pos - prevPos));
+      prevPos = pos + delimiter.size();
     }
-    result.push_back(str.substr(prevPos, pos));
+    result.push_back(str.substr(prevPos));
 
     return result;
   }
@@ -46,19 +46,18 @@ namespace utility {
 
   void Timer::cancel() noexcept {
     if (valid && timerID) {
-      // Cancel timer. Ignore return value as there is no good handling of errors.
-      ::DeleteTimerQueueTimer(nullptr, timerID, nullptr);
+      // Cancel timer and wait for a callback that is already running, so it never runs after the timer is gone. Ignore return
+      // value as there is no good handling of errors.
+      ::DeleteTimerQueueTimer(timerQueue, timerID, INVALID_HANDLE_VALUE);
       valid = false;
       timerID = nullptr;
     }
   }
 
   void CALLBACK Timer::callback(PVOID lpParameter, BOOLEAN) {
-    Timer* timer = static_cast<Timer*>(lpParameter);
-    timer->func();
-    if (timer->onlyOnce) {
-      timer->cancel();
-    }
+    // A one-time timer doesn't fire again, but its resource is only released by cancel() from the owner. Cancelling here would
+    // wait for this very callback to finish.
+    static_cast<Timer*>(lpParameter)->func();
   }
 
   // Convenience functions to start a timer
@@ -49,10 +49,10 @@ namespace utility {
   // Timer allows you to get a callback after some specific time. Naturally, the callback happens on a
   // separate thread so the client function should take synchronization between threads into consideration.
   //
-  // Due to the nature of this class, it usually should not be discarded before timer callback is invoked,
-  // as that will trigger the destructor and cause unexpected behavior. If the actions defined in the callback
-  // are no longer needed, the returned value can be disposed at that time. In such a case it is recommended
-  // to call cancel() to make the behavior explicit.
+  // Cancelling or discarding a timer waits for a callback that is already running to finish, so the callback
+  // can safely use whatever the owner of the timer owns. For the same reason, the callback must not cancel or
+  // discard its own timer, and must not wait for the thread that does, e.g. by sending a message to a window
+  // owned by that thread.
   //
   class Timer {
     public:
@@ -66,7 +66,7 @@ namespace utility {
       // Only a valid timer will trigger callback
       inline bool isValid() const noexcept { return valid; }
 
-      // Cancel the timer and release timer resource
+      // Cancel the timer and release timer resource. Waits for a running callback to finish.
       void cancel() noexcept;
 
     private:
@@ -31,19 +31,19 @@ namespace utility {
       using handler_t = std::function<void(const T&)>;
 
       // Represents a subscription on the topic
-      template <class T>
+      template <class U>
       class Subscription {
-        friend class Topic<T>;
+        friend class Topic<U>;
 
         public:
-          using topic_t = Topic<T>;
+          using topic_t = Topic<U>;
           using handler_t = topic_t::handler_t;
 
           [[nodiscard]] inline Subscription(topic_t& topic, handler_t&& func) noexcept : topic(topic), handler(func), subscribed(true) {}
           inline ~Subscription() { unsubscribe(); }
 
           // Message from subscribed topic
-          inline void notify(const T& message) {
+          inline void notify(const U& message) {
             if (subscribed) {
               handler(message);
             }
@@ -114,8 +114,9 @@ namespace papyrus {
       // Update annotation style.
       updateAnnotationStyle(view, handle);
 
-      // Update indicator style.
+      // Update indicator style, and clear indications drawn before, which may be for outdated errors.
       updateIndicatorStyle(handle);
+      clearIndications(handle);
 
       for (const LineError& lineError : fileErrors->second) {
         // Annotation
@@ -124,6 +125,7 @@ namespace papyrus {
         // Indicator
         drawIndications(handle, lineError);
       }
+      indicatorRanges.paint(handle, indicatorID);
     } else {
       clearAnnotations(handle);
       clearIndications(handle);
@@ -149,8 +151,8 @@ namespace papyrus {
     ::SendMessage(handle, SCI_ANNOTATIONCLEARALL, 0, 0);
   }
 
-  void ErrorAnnotator::clearIndications(HWND handle) const {
-    utility::clearIndications(handle, indicatorID);
+  void ErrorAnnotator::clearIndications(HWND handle) {
+    indicatorRanges.clear(handle);
   }
 
   void ErrorAnnotator::showAnnotations(HWND handle) const {
@@ -233,6 +235,7 @@ namespace papyrus {
       if (!secondViewFilePath.empty()) {
         utility::clearIndications(nppData._scintillaSecondHandle, oldIndicatorID);
       }
+      indicatorRanges.discard();
 
       // Draw new indications if needed.
       if (!mainViewFilePath.empty()) {
@@ -270,10 +273,11 @@ namespace papyrus {
       for (const LineError& lineError : fileErrors->second) {
         drawIndications(handle, lineError);
       }
+      indicatorRanges.paint(handle, indicatorID);
     }
   }
 
-  void ErrorAnnotator::drawIndications(HWND handle, const LineError& lineError) const {
+  void ErrorAnnotator::drawIndications(HWND handle, const LineError& lineError) {
     // Get line start position and length.
     npp_position_t lineStart = ::SendMessage(handle, SCI_POSITIONFROMLINE, lineError.line, 0);
     npp_position_t lineLength = ::SendMessage(handle, SCI_LINELENGTH, lineError.line, 0);
@@ -326,7 +330,7 @@ namespace papyrus {
         }
       }
 
-      ::SendMessage(handle, SCI_INDICATORFILLRANGE, lineStart + column, length);
+      indicatorRanges.add(lineStart + column, length);
     }
   }
 
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Error.hpp"
 #include "ErrorAnnotatorSettings.hpp"
 
+#include "..\Common\IndicatorRanges.hpp"
 #include "..\Common\NotepadPlusPlus.hpp"
 
 #include "..\..\external\npp\PluginInterface.h"
@@ -44,6 +45,11 @@ namespace papyrus {
       void annotate(const std::vector<Error>& compilationErrors);
       void annotate(npp_view_t view, std::wstring filePath);
 
+      // Document content has changed, so indications have moved
+      inline void contentChanged(HWND scintillaHandle, npp_position_t position, npp_length_t lengthAdded) {
+        indicatorRanges.contentChanged(scintillaHandle, position, lengthAdded);
+      }
+
     private:
       struct LineError {
         int line;
@@ -57,7 +63,7 @@ namespace papyrus {
       void annotate(npp_view_t view);
 
       void clearAnnotations(HWND handle) const;
-      void clearIndications(HWND handle) const;
+      void clearIndications(HWND handle);
 
       void showAnnotations(HWND handle) const;
       void hideAnnotations(HWND handle) const;
@@ -78,7 +84,8 @@ namespace papyrus {
       void updateIndicatorStyle(HWND handle) const;
       void updateIndicatorStyleOnFile(HWND handle, const std::wstring& filePath);
 
-      void drawIndications(HWND handle, const LineError& lineError) const;
+      // Queue indications of a line. They are painted together once all lines are done.
+      void drawIndications(HWND handle, const LineError& lineError);
 
       // Private members
       //
@@ -88,6 +95,7 @@ namespace papyrus {
 
       int indicatorID {0};
       int allocatedIndicatorID {0};
+      utility::IndicatorRanges indicatorRanges;
 
       int mainViewStyleAssigned {0};
       int secondViewStyleAssigned {0};
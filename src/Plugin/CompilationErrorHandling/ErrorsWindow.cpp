@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ErrorsWindow.hpp"
 
 #include "..\Common\Resources.hpp"
+#include "..\Common\StringUtil.hpp"
 
 #include "..\..\external\npp\Notepad_plus_msgs.h"
 
@@ -63,9 +64,21 @@ namespace papyrus {
   }
 
   void ErrorsWindow::show(const std::vector<Error>& compilationErrors) {
-    errors = compilationErrors;
-    for (int i = 0; i < static_cast<int>(errors.size()); ++i) {
-      std::wstring filename = std::filesystem::path(errors[i].file).filename();
+    errors.clear();
+    add(compilationErrors);
+  }
+
+  void ErrorsWindow::add(const std::vector<Error>& compilationErrors, const std::wstring& scriptFile) {
+    int firstNewError = static_cast<int>(errors.size());
+    for (const auto& error : compilationErrors) {
+      errors.push_back(ListedError {
+        .error = error,
+        .scriptFile = scriptFile
+      });
+    }
+    for (int i = firstNewError; i < static_cast<int>(errors.size()); ++i) {
+      const Error& error = errors[i].error;
+      std::wstring filename = std::filesystem::path(error.file).filename();
       LVITEM item {
         .mask = LVIF_TEXT,
         .iItem = i,
@@ -73,20 +86,33 @@ namespace papyrus {
       };
       ListView_InsertItem(listView, &item);
       item.iSubItem = 1;
-      item.pszText = const_cast<LPWSTR>(errors[i].message.c_str());
+      item.pszText = const_cast<LPWSTR>(error.message.c_str());
       ListView_SetItem(listView, &item);
       item.iSubItem = 2;
-      std::wstring line = std::to_wstring(errors[i].line);
+      std::wstring line = std::to_wstring(error.line);
       item.pszText = const_cast<LPWSTR>(line.c_str());
       ListView_SetItem(listView, &item);
       item.iSubItem = 3;
-      std::wstring column = std::to_wstring(errors[i].column);
+      std::wstring column = std::to_wstring(error.column);
       item.pszText = const_cast<LPWSTR>(column.c_str());
       ListView_SetItem(listView, &item);
     }
     display();
   }
 
+  void ErrorsWindow::remove(const std::wstring& scriptFile) {
+    // Go backward so indexes of items yet to be checked don't change
+    for (int i = static_cast<int>(errors.size()) - 1; i >= 0; --i) {
+      if (utility::compare(errors[i].scriptFile, scriptFile)) {
+        ListView_DeleteItem(listView, i);
+        errors.erase(errors.begin() + i);
+      }
+    }
+    if (errors.empty()) {
+      hide();
+    }
+  }
+
   // Protected methods
   //
 
@@ -101,7 +127,7 @@ namespace papyrus {
         NMITEMACTIVATE* item = reinterpret_cast<NMITEMACTIVATE*>(lParam);
         if (item->hdr.hwndFrom == listView && item->hdr.code == NM_DBLCLK) {
           if (item->iItem != -1) {
-            Error error = errors[item->iItem];
+            Error error = errors[item->iItem].error;
             ::SendMessage(pluginMessageWindow, PPM_JUMP_TO_ERROR, reinterpret_cast<WPARAM>(&error), 0);
           }
           return true;
@@ -37,6 +37,14 @@ namespace papyrus {
       ErrorsWindow(HINSTANCE instance, HWND parent, HWND pluginMessageWindow);
 
       void show(const std::vector<Error>& compilationErrors);
+
+      // Append errors to the list and show it, e.g. when they are reported while compiler is still running. Errors are listed
+      // under the script whose compilation reported them, if given, so they can be removed without touching other scripts'.
+      void add(const std::vector<Error>& compilationErrors, const std::wstring& scriptFile = std::wstring());
+
+      // Remove errors reported by compiling a script, and hide the list once it's empty
+      void remove(const std::wstring& scriptFile);
+
       inline void hide() { display(false); }
       void clear();
 
@@ -44,13 +52,18 @@ namespace papyrus {
       INT_PTR CALLBACK run_dlgProc(UINT message, WPARAM wParam, LPARAM lParam) override;
 
     private:
+      struct ListedError {
+        Error error;
+        std::wstring scriptFile;
+      };
+
       void resize() const;
 
       // Private members
       //
       HWND pluginMessageWindow;
       HWND listView;
-      std::vector<Error> errors;
+      std::vector<ListedError> errors;
   };
 
 } // namespace
@@ -0,0 +1,295 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatchBuilder.hpp"
+
+#include "BuildManifest.hpp"
+
+#include "..\Common\StringUtil.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <tuple>
+
+namespace papyrus {
+
+  BatchBuilder::BatchBuilder(Compiler& compiler)
+    : compiler(compiler) {
+  }
+
+  size_t BatchBuilder::start(const std::wstring& directory, size_t groupSize, request_factory_t createRequest) {
+    if (running) {
+      return 0;
+    }
+
+    scripts.clear();
+    groups.clear();
+    scriptsByRequestID.clear();
+    compilingScripts = 0;
+    report = BatchReport();
+
+    // Discover scripts
+    std::map<std::string, size_t> scriptsByName;
+    std::vector<std::vector<std::string>> scriptDependencies;
+    std::error_code errorCode;
+    for (auto iter = std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, errorCode);
+      !errorCode && iter != std::filesystem::recursive_directory_iterator(); iter.increment(errorCode)) {
+      if (iter->is_regular_file(errorCode) && utility::compare(iter->path().extension().wstring(), L".psc")) {
+        Script script;
+        if (createRequest(iter->path().wstring(), script.request)) {
+          std::string scriptName;
+          std::vector<std::string> dependencies;
+          parseScript(script.request.filePath, scriptName, script.request.scriptName, dependencies);
+          scriptsByName[scriptName] = scripts.size();
+          scriptDependencies.push_back(std::move(dependencies));
+          scripts.push_back(std::move(script));
+        }
+      }
+    }
+
+    groupScripts(groupSize);
+
+    // Link scripts with the ones they depend on. Scripts outside of the batch, e.g. base game scripts, are not compiled, so
+    // they don't need to be waited for. Neither are scripts in the same group.
+    for (size_t index = 0; index < scripts.size(); ++index) {
+      std::set<size_t> dependencies;
+      for (const auto& dependencyName : scriptDependencies[index]) {
+        auto iter = scriptsByName.find(dependencyName);
+        if (iter != scriptsByName.end() && iter->second != index) {
+          dependencies.insert(iter->second);
+        }
+      }
+      for (size_t dependency : dependencies) {
+        scripts[dependency].dependents.push_back(index);
+        if (scripts[dependency].group != scripts[index].group) {
+          scripts[index].pendingDependencies++;
+        }
+      }
+    }
+
+    report.total = scripts.size();
+    if (scripts.empty()) {
+      return 0;
+    }
+
+    running = true;
+    startTime = std::chrono::steady_clock::now();
+    for (size_t group = 0; group < groups.size() && running; ++group) {
+      if (isReady(group)) {
+        dispatch(group);
+      }
+    }
+    if (running && compilingScripts == 0) {
+      // Every group is in a dependency cycle
+      for (size_t group = 0; group < groups.size(); ++group) {
+        dispatch(group);
+      }
+    }
+    return scripts.size();
+  }
+
+  void BatchBuilder::cancel() {
+    if (!running) {
+      return;
+    }
+
+    report.cancelled = true;
+    for (auto& script : scripts) {
+      if (script.state == ScriptState::Waiting) {
+        script.state = ScriptState::Skipped;
+        report.skipped++;
+      }
+    }
+  }
+
+  bool BatchBuilder::owns(const CompilationRequest& request) const {
+    return running && scriptsByRequestID.contains(request.id);
+  }
+
+  bool BatchBuilder::handleResult(const CompilationResult& result, bool succeeded) {
+    auto iter = scriptsByRequestID.find(result.request.id);
+    if (!running || iter == scriptsByRequestID.end()) {
+      return false;
+    }
+
+    size_t index = iter->second;
+    scriptsByRequestID.erase(iter);
+    compilingScripts--;
+
+    auto& script = scripts[index];
+    if (succeeded) {
+      script.state = ScriptState::Succeeded;
+      report.succeeded++;
+      if (result.upToDate) {
+        report.upToDate++;
+      }
+      for (size_t dependent : script.dependents) {
+        auto& dependentScript = scripts[dependent];
+        if (dependentScript.state == ScriptState::Waiting && dependentScript.group != script.group
+          && --dependentScript.pendingDependencies == 0 && isReady(dependentScript.group)) {
+          dispatch(dependentScript.group);
+        }
+      }
+    } else if (result.cancelled) {
+      script.state = ScriptState::Skipped;
+      report.skipped++;
+      skipDependents(index);
+    } else {
+      script.state = ScriptState::Failed;
+      report.failed++;
+      if (!result.errors.empty()) {
+        report.errors.insert(report.errors.end(), result.errors.begin(), result.errors.end());
+      } else {
+        std::wstring message = result.title.empty() ? result.message : result.title + L" " + result.message;
+        report.errors.push_back(Error {
+          .message = script.request.filePath + L": " + (message.empty() ? L"Compilation failed." : message)
+        });
+      }
+      skipDependents(index);
+    }
+
+    if (compilingScripts == 0) {
+      // Scripts still waiting depend on each other in a cycle. Compiler resolves that by itself, so just compile them all.
+      for (size_t group = 0; group < groups.size(); ++group) {
+        dispatch(group);
+      }
+    }
+
+    if (compilingScripts == 0) {
+      running = false;
+      report.elapsedTime = std::chrono::steady_clock::now() - startTime;
+      return true;
+    }
+    return false;
+  }
+
+  // Private methods
+  //
+
+  void BatchBuilder::parseScript(const std::wstring& filePath, std::string& scriptName, std::string& originalScriptName, std::vector<std::string>& dependencies) {
+    std::ifstream file {std::filesystem::path(filePath)};
+    BuildManifest::parseScript(file, scriptName, originalScriptName, dependencies);
+    if (scriptName.empty()) {
+      originalScriptName = std::filesystem::path(filePath).stem().string();
+      scriptName = utility::toLower(originalScriptName);
+    }
+  }
+
+  void BatchBuilder::groupScripts(size_t groupSize) {
+    // Compiler can only take a group of scripts in one go when they are for the same game and output directory. Skyrim's
+    // compiler takes either one script or a whole folder, so its folders are not split.
+    std::map<std::tuple<Game, bool, std::wstring>, std::vector<size_t>> folders;
+    for (size_t index = 0; index < scripts.size(); ++index) {
+      const auto& request = scripts[index].request;
+      auto folder = utility::toLower(std::filesystem::path(request.filePath).parent_path().wstring());
+      folders[std::make_tuple(request.game, request.useAutoModeOutputDirectory, folder)].push_back(index);
+    }
+
+    for (const auto& [key, members] : folders) {
+      size_t size = (groupSize <= 1) ? 1 : (std::get<0>(key) == Game::Fallout4) ? groupSize : members.size();
+      for (size_t start = 0; start < members.size(); start += size) {
+        std::vector<size_t> group(members.begin() + start, members.begin() + std::min(start + size, members.size()));
+        for (size_t index : group) {
+          scripts[index].group = groups.size();
+        }
+        groups.push_back(std::move(group));
+      }
+    }
+  }
+
+  bool BatchBuilder::isReady(size_t group) const {
+    bool hasWaitingScripts = false;
+    for (size_t index : groups[group]) {
+      if (scripts[index].state == ScriptState::Waiting) {
+        if (scripts[index].pendingDependencies > 0) {
+          return false;
+        }
+        hasWaitingScripts = true;
+      }
+    }
+    return hasWaitingScripts;
+  }
+
+  void BatchBuilder::dispatch(size_t group) {
+    // Scripts in a group are queued after the ones in the group they depend on, as compiler may still compile them one at a time
+    // in the given order. Scripts in a dependency cycle are queued in their original order after the rest.
+    std::map<size_t, size_t> pendingInGroup;
+    for (size_t index : groups[group]) {
+      if (scripts[index].state == ScriptState::Waiting) {
+        pendingInGroup.try_emplace(index, 0);
+        for (size_t dependent : scripts[index].dependents) {
+          if (scripts[dependent].group == group && scripts[dependent].state == ScriptState::Waiting) {
+            pendingInGroup[dependent]++;
+          }
+        }
+      }
+    }
+
+    std::vector<size_t> orderedScripts;
+    for (size_t index : groups[group]) {
+      auto iter = pendingInGroup.find(index);
+      if (iter != pendingInGroup.end() && iter->second == 0) {
+        orderedScripts.push_back(index);
+      }
+    }
+    for (size_t next = 0; next < orderedScripts.size(); ++next) {
+      for (size_t dependent : scripts[orderedScripts[next]].dependents) {
+        auto iter = pendingInGroup.find(dependent);
+        if (iter != pendingInGroup.end() && iter->second > 0 && --iter->second == 0) {
+          orderedScripts.push_back(dependent);
+        }
+      }
+    }
+    for (size_t index : groups[group]) {
+      auto iter = pendingInGroup.find(index);
+      if (iter != pendingInGroup.end() && iter->second > 0) {
+        orderedScripts.push_back(index);
+      }
+    }
+
+    std::vector<CompilationRequest> requests;
+    for (size_t index : orderedScripts) {
+      auto& script = scripts[index];
+      script.state = ScriptState::Compiling;
+      scriptsByRequestID[script.request.id] = index;
+      compilingScripts++;
+      requests.push_back(script.request);
+    }
+    if (!requests.empty()) {
+      compiler.start(requests);
+    }
+  }
+
+  void BatchBuilder::skipDependents(size_t index) {
+    std::vector<size_t> failedScripts {index};
+    while (!failedScripts.empty()) {
+      size_t failedIndex = failedScripts.back();
+      failedScripts.pop_back();
+      for (size_t dependent : scripts[failedIndex].dependents) {
+        if (scripts[dependent].state == ScriptState::Waiting) {
+          scripts[dependent].state = ScriptState::Skipped;
+          report.skipped++;
+          failedScripts.push_back(dependent);
+        }
+      }
+    }
+  }
+
+} // namespace
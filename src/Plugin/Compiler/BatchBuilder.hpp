@@ -0,0 +1,122 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "CompilationRequest.hpp"
+#include "Compiler.hpp"
+
+#include "..\CompilationErrorHandling\Error.hpp"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace papyrus {
+
+  // Summary of a batch build
+  struct BatchReport {
+    size_t total {0};
+    size_t succeeded {0};
+    size_t upToDate {0};  // Succeeded without compiling, as nothing changed since last build
+    size_t failed {0};
+    size_t skipped {0};   // Not compiled because a script it depends on failed, or batch was cancelled
+    bool cancelled {false};
+    std::chrono::steady_clock::duration elapsedTime {};
+    std::vector<Error> errors;
+  };
+
+  // Builds all scripts under a directory. A dependency graph is built from "extends" and "import" statements, so a script is
+  // only compiled after the scripts it depends on have succeeded, while scripts that don't depend on each other are queued
+  // at the same time and compiled in parallel by compiler's workers. Scripts in the same folder can be grouped, so a group is
+  // compiled by one compiler process once none of its scripts is waiting for scripts in other groups.
+  class BatchBuilder {
+    public:
+      // Create a compilation request for a script file. Returns false if the file can't be compiled, e.g. no game is configured.
+      using request_factory_t = std::function<bool(const std::wstring& filePath, CompilationRequest& request)>;
+
+      BatchBuilder(Compiler& compiler);
+
+      // Start building all scripts under a directory, including sub-directories, with at most groupSize scripts compiled by
+      // one compiler process. Returns number of scripts to be compiled.
+      size_t start(const std::wstring& directory, size_t groupSize, request_factory_t createRequest);
+
+      inline bool isRunning() const { return running; }
+
+      // Stop queuing scripts. Scripts already queued are expected to be cancelled by compiler, and batch is done when their
+      // results are all handled.
+      void cancel();
+
+      // Check whether a compilation request was made by current batch
+      bool owns(const CompilationRequest& request) const;
+
+      // Handle the result of a request made by current batch, and queue scripts that are unblocked by it. Returns true when
+      // the whole batch is done.
+      bool handleResult(const CompilationResult& result, bool succeeded);
+
+      inline const BatchReport& getReport() const { return report; }
+
+    private:
+      enum class ScriptState {
+        Waiting,
+        Compiling,
+        Succeeded,
+        Failed,
+        Skipped
+      };
+
+      struct Script {
+        CompilationRequest request;
+        std::vector<size_t> dependents;
+        size_t pendingDependencies {0}; // Only scripts in other groups, as the ones in the same group are compiled together
+        ScriptState state {ScriptState::Waiting};
+        size_t group {0};
+      };
+
+      // Parse a script file for its full script name and the names of the scripts it depends on, all lower-cased
+      static void parseScript(const std::wstring& filePath, std::string& scriptName, std::string& originalScriptName, std::vector<std::string>& dependencies);
+
+      // Put scripts in groups that can be compiled by one compiler process
+      void groupScripts(size_t groupSize);
+
+      // Check whether none of the waiting scripts in a group is waiting for scripts in other groups
+      bool isReady(size_t group) const;
+
+      // Queue waiting scripts of a group for compilation, each after the scripts in the group it depends on
+      void dispatch(size_t group);
+
+      // Mark all scripts that depend on a failed script, directly or indirectly, as skipped
+      void skipDependents(size_t index);
+
+      // Private members
+      //
+      Compiler& compiler;
+
+      bool running {false};
+      std::vector<Script> scripts;
+      std::vector<std::vector<size_t>> groups;
+      std::map<size_t, size_t> scriptsByRequestID;
+      size_t compilingScripts {0};
+      std::chrono::steady_clock::time_point startTime;
+      BatchReport report;
+  };
+
+} // namespace
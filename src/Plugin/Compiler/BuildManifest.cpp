@@ -0,0 +1,410 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BuildManifest.hpp"
+
+#include "..\Common\DirectoryIndex.hpp"
+#include "..\Common\Hash.hpp"
+#include "..\Common\StringUtil.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+namespace papyrus {
+
+  using Lock = std::lock_guard<std::mutex>;
+
+  // Manifest file layout, all numbers are stored in native byte order:
+  //   Signature:      4 bytes, "PSBM".
+  //   Format version: 4 bytes.
+  //   Entries count:  8 bytes, followed by each entry:
+  //     Source path:       4 bytes length, followed by the path in wide chars.
+  //     Source hash:       8 bytes.
+  //     Dependencies hash: 8 bytes.
+  //     Flags hash:        8 bytes.
+  //     Output time:       8 bytes.
+  //     Output size:       8 bytes.
+  constexpr char BUILD_MANIFEST_SIGNATURE[] = {'P', 'S', 'B', 'M'};
+  constexpr uint32_t BUILD_MANIFEST_FORMAT_VERSION = 1;
+  constexpr wchar_t BUILD_MANIFEST_FILE_NAME[] = L"PapyrusBuild.manifest";
+
+  namespace {
+    template <class T>
+    inline void writeValue(std::ofstream& file, T value) {
+      file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    inline void writeString(std::ofstream& file, const std::wstring& str) {
+      writeValue(file, static_cast<uint32_t>(str.size()));
+      file.write(reinterpret_cast<const char*>(str.data()), str.size() * sizeof(wchar_t));
+    }
+
+    template <class T>
+    inline bool readValue(std::ifstream& file, T& value) {
+      return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    // String size is checked against the rest of the file, so a corrupted size can't make it allocate a huge string
+    inline bool readString(std::ifstream& file, uint64_t fileSize, std::wstring& str) {
+      uint32_t size {};
+      if (!readValue(file, size)) {
+        return false;
+      }
+      auto position = file.tellg();
+      if (position < 0 || size > (fileSize - static_cast<uint64_t>(position)) / sizeof(wchar_t)) {
+        return false;
+      }
+      str.resize(size);
+      return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(str.data()), size * sizeof(wchar_t)));
+    }
+
+    // Relative path of a script file from its full script name, e.g. "MyMod:MyScript" -> "MyMod\MyScript.psc"
+    inline std::wstring scriptFilePath(const std::string& scriptName) {
+      std::filesystem::path filePath;
+      for (const auto& scriptNameComponent : utility::split(scriptName, ":")) {
+        filePath /= scriptNameComponent;
+      }
+      filePath += ".psc";
+      return filePath.wstring();
+    }
+  }
+
+  bool BuildManifest::computeInputs(const std::wstring& filePath, const std::wstring& sourceDirectory, const CompilerSettings::GameSettings& gameSettings, BuildInputs& inputs) {
+    FileInfo sourceInfo;
+    if (!getFileInfo(filePath, sourceInfo)) {
+      return false;
+    }
+    inputs.sourceHash = sourceInfo.hash;
+
+    // Other scripts are looked up the same way compiler does, in source directory first and then import directories in order
+    std::vector<std::wstring> searchDirectories {sourceDirectory};
+    for (const auto& importDirectory : utility::split(gameSettings.importDirectories, L";")) {
+      if (!importDirectory.empty()) {
+        searchDirectories.push_back(importDirectory);
+      }
+    }
+
+    // Walk all scripts the source depends on, directly or indirectly. They are hashed in a stable order, so the result
+    // doesn't depend on the order of statements. Scripts that can't be found are hashed by name, so adding them later
+    // changes the result.
+    std::map<std::wstring, uint64_t> dependencyHashes;
+    std::set<std::string> visitedScripts;
+    std::vector<std::string> pendingScripts = sourceInfo.dependencies;
+    while (!pendingScripts.empty()) {
+      std::string scriptName = std::move(pendingScripts.back());
+      pendingScripts.pop_back();
+      if (!visitedScripts.insert(scriptName).second) {
+        continue;
+      }
+
+      std::wstring dependencyFile;
+      for (const auto& searchDirectory : searchDirectories) {
+        dependencyFile = utility::findFileIgnoringCase(searchDirectory, scriptFilePath(scriptName));
+        if (!dependencyFile.empty()) {
+          break;
+        }
+      }
+
+      FileInfo dependencyInfo;
+      if (!dependencyFile.empty() && getFileInfo(dependencyFile, dependencyInfo)) {
+        dependencyHashes[utility::toLower(dependencyFile)] = dependencyInfo.hash;
+        pendingScripts.insert(pendingScripts.end(), dependencyInfo.dependencies.begin(), dependencyInfo.dependencies.end());
+      } else {
+        dependencyHashes[std::wstring(scriptName.begin(), scriptName.end())] = 0;
+      }
+    }
+    dependencyHashes.erase(utility::toLower(filePath));
+
+    inputs.dependenciesHash = utility::FNV_OFFSET_BASIS;
+    for (const auto& [dependencyFile, dependencyHash] : dependencyHashes) {
+      inputs.dependenciesHash = utility::hash(dependencyFile, inputs.dependenciesHash);
+      inputs.dependenciesHash = utility::hash(&dependencyHash, sizeof(dependencyHash), inputs.dependenciesHash);
+    }
+
+    // Flag file is looked up in import directories as well, and its content matters rather than its name
+    uint64_t flagFileHash {0};
+    for (size_t i = 1; i < searchDirectories.size() && !gameSettings.flagFile.empty(); ++i) {
+      std::wstring flagFile = utility::findFileIgnoringCase(searchDirectories[i], gameSettings.flagFile);
+      FileInfo flagFileInfo;
+      if (!flagFile.empty() && getFileInfo(flagFile, flagFileInfo)) {
+        flagFileHash = flagFileInfo.hash;
+        break;
+      }
+    }
+
+    bool flags[] {gameSettings.optimizeFlag, gameSettings.releaseFlag, gameSettings.finalFlag, gameSettings.anonynmizeFlag};
+    inputs.flagsHash = utility::hash(utility::toLower(gameSettings.compilerPath));
+    inputs.flagsHash = utility::hash(utility::toLower(gameSettings.importDirectories), inputs.flagsHash);
+    inputs.flagsHash = utility::hash(utility::toLower(gameSettings.flagFile), inputs.flagsHash);
+    inputs.flagsHash = utility::hash(&flagFileHash, sizeof(flagFileHash), inputs.flagsHash);
+    inputs.flagsHash = utility::hash(gameSettings.additionalArguments, inputs.flagsHash);
+    inputs.flagsHash = utility::hash(flags, sizeof(flags), inputs.flagsHash);
+    return true;
+  }
+
+  bool BuildManifest::isUpToDate(const std::wstring& outputDirectory, const std::wstring& filePath, const BuildInputs& inputs, const std::wstring& outputFile) {
+    int64_t outputTime {};
+    uint64_t outputSize {};
+    if (!getOutputStamp(outputFile, outputTime, outputSize)) {
+      return false;
+    }
+
+    Lock lock(manifestsMutex);
+    const auto& entries = getManifest(outputDirectory).entries;
+    auto iter = entries.find(utility::toLower(filePath));
+    if (iter == entries.end()) {
+      return false;
+    }
+
+    const Entry& entry = iter->second;
+    return entry.inputs.sourceHash == inputs.sourceHash
+      && entry.inputs.dependenciesHash == inputs.dependenciesHash
+      && entry.inputs.flagsHash == inputs.flagsHash
+      && entry.outputTime == outputTime
+      && entry.outputSize == outputSize;
+  }
+
+  void BuildManifest::record(const std::wstring& outputDirectory, const std::wstring& filePath, const BuildInputs& inputs, const std::wstring& outputFile) {
+    Entry entry {
+      .inputs = inputs
+    };
+    if (!getOutputStamp(outputFile, entry.outputTime, entry.outputSize)) {
+      return;
+    }
+
+    Lock lock(manifestsMutex);
+    auto& manifest = getManifest(outputDirectory);
+    manifest.entries[utility::toLower(filePath)] = entry;
+    manifest.changed = true;
+    manifest.version++;
+  }
+
+  void BuildManifest::save() {
+    // Changed manifests are copied and written without holding the lock, so workers can keep using them meanwhile. A manifest
+    // that changes again while being written stays changed, to be written next time.
+    Lock saveLock(saveMutex);
+    std::vector<std::pair<std::wstring, Manifest>> changedManifests;
+    {
+      Lock lock(manifestsMutex);
+      for (const auto& [key, manifest] : manifests) {
+        if (manifest.changed) {
+          changedManifests.emplace_back(key, manifest);
+        }
+      }
+    }
+
+    for (const auto& [key, manifest] : changedManifests) {
+      if (store(std::filesystem::path(manifest.directory) / BUILD_MANIFEST_FILE_NAME, manifest)) {
+        Lock lock(manifestsMutex);
+        auto& storedManifest = manifests[key];
+        if (storedManifest.version == manifest.version) {
+          storedManifest.changed = false;
+        }
+      }
+    }
+  }
+
+  void BuildManifest::parseScript(std::istream& content, std::string& scriptName, std::string& originalScriptName, std::vector<std::string>& dependencies) {
+    std::string line;
+    bool inMultiLineComment = false;
+    while (std::getline(content, line)) {
+      if (inMultiLineComment) {
+        size_t commentEnd = line.find("/;");
+        if (commentEnd == std::string::npos) {
+          continue;
+        }
+        inMultiLineComment = false;
+        line.erase(0, commentEnd + 2);
+      }
+
+      size_t commentStart = line.find(';');
+      if (commentStart != std::string::npos) {
+        if (line.compare(commentStart, 2, ";/") == 0 && line.find("/;", commentStart + 2) == std::string::npos) {
+          inMultiLineComment = true;
+        }
+        line.erase(commentStart);
+      }
+
+      // Only "ScriptName <name> extends <parent>" and "Import <name>" statements matter
+      std::istringstream words(line);
+      std::string keyword;
+      std::string name;
+      if (!(words >> keyword >> name)) {
+        continue;
+      }
+      keyword = utility::toLower(keyword);
+      if (keyword == "scriptname") {
+        originalScriptName = name;
+        scriptName = utility::toLower(name);
+
+        std::string extends;
+        std::string parentName;
+        if (words >> extends >> parentName && utility::toLower(extends) == "extends") {
+          dependencies.push_back(utility::toLower(parentName));
+        }
+      } else if (keyword == "import") {
+        dependencies.push_back(utility::toLower(name));
+      }
+    }
+  }
+
+  // Private methods
+  //
+
+  bool BuildManifest::getFileInfo(const std::wstring& filePath, FileInfo& fileInfo) {
+    std::error_code errorCode;
+    auto lastWriteTime = std::filesystem::last_write_time(filePath, errorCode);
+    if (errorCode) {
+      return false;
+    }
+    auto size = std::filesystem::file_size(filePath, errorCode);
+    if (errorCode) {
+      return false;
+    }
+
+    std::wstring key = utility::toLower(filePath);
+    {
+      Lock lock(filesMutex);
+      auto iter = files.find(key);
+      if (iter != files.end() && iter->second.lastWriteTime == lastWriteTime && iter->second.size == size) {
+        fileInfo = iter->second;
+        return true;
+      }
+    }
+
+    // Read file without holding the lock, so other workers can use the cache meanwhile
+    std::ifstream file(std::filesystem::path(filePath), std::ios::binary);
+    if (!file) {
+      return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    fileInfo = FileInfo {
+      .lastWriteTime = lastWriteTime,
+      .size = size,
+      .hash = utility::hash(content.data(), content.size())
+    };
+    if (utility::compare(std::filesystem::path(filePath).extension().wstring(), L".psc")) {
+      std::istringstream contentStream(content);
+      std::string scriptName;
+      std::string originalScriptName;
+      parseScript(contentStream, scriptName, originalScriptName, fileInfo.dependencies);
+    }
+
+    Lock lock(filesMutex);
+    files[key] = fileInfo;
+    return true;
+  }
+
+  bool BuildManifest::getOutputStamp(const std::wstring& outputFile, int64_t& outputTime, uint64_t& outputSize) {
+    std::error_code errorCode;
+    auto lastWriteTime = std::filesystem::last_write_time(outputFile, errorCode);
+    if (errorCode) {
+      return false;
+    }
+    auto size = std::filesystem::file_size(outputFile, errorCode);
+    if (errorCode) {
+      return false;
+    }
+
+    outputTime = static_cast<int64_t>(lastWriteTime.time_since_epoch().count());
+    outputSize = static_cast<uint64_t>(size);
+    return true;
+  }
+
+  BuildManifest::Manifest& BuildManifest::getManifest(const std::wstring& outputDirectory) {
+    std::wstring key = utility::toLower(outputDirectory);
+    auto iter = manifests.find(key);
+    if (iter == manifests.end()) {
+      iter = manifests.emplace(key, Manifest {.directory = outputDirectory}).first;
+      if (!load(std::filesystem::path(outputDirectory) / BUILD_MANIFEST_FILE_NAME, iter->second)) {
+        // Missing or broken manifest simply means everything needs to be compiled
+        iter->second.entries.clear();
+      }
+    }
+    return iter->second;
+  }
+
+  bool BuildManifest::load(const std::filesystem::path& manifestFile, Manifest& manifest) {
+    std::error_code errorCode;
+    uint64_t fileSize = std::filesystem::file_size(manifestFile, errorCode);
+    std::ifstream file(manifestFile, std::ios::binary);
+    if (errorCode || !file) {
+      return false;
+    }
+
+    char signature[sizeof(BUILD_MANIFEST_SIGNATURE)] {};
+    uint32_t formatVersion {};
+    uint64_t entriesCount {};
+    if (!file.read(signature, sizeof(signature)) || !std::equal(std::begin(signature), std::end(signature), std::begin(BUILD_MANIFEST_SIGNATURE))
+      || !readValue(file, formatVersion) || formatVersion != BUILD_MANIFEST_FORMAT_VERSION
+      || !readValue(file, entriesCount)) {
+      return false;
+    }
+
+    for (uint64_t i = 0; i < entriesCount; ++i) {
+      std::wstring filePath;
+      Entry entry;
+      if (!readString(file, fileSize, filePath)
+        || !readValue(file, entry.inputs.sourceHash) || !readValue(file, entry.inputs.dependenciesHash) || !readValue(file, entry.inputs.flagsHash)
+        || !readValue(file, entry.outputTime) || !readValue(file, entry.outputSize)) {
+        return false;
+      }
+      manifest.entries[filePath] = entry;
+    }
+    return true;
+  }
+
+  bool BuildManifest::store(const std::filesystem::path& manifestFile, const Manifest& manifest) {
+    // Write to a temporary file first, so a partially written manifest can never be loaded
+    auto tempFilePath = std::filesystem::path(manifestFile).replace_extension(".tmp");
+    std::error_code errorCode;
+    {
+      std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+      if (!file) {
+        return false;
+      }
+
+      file.write(BUILD_MANIFEST_SIGNATURE, sizeof(BUILD_MANIFEST_SIGNATURE));
+      writeValue(file, BUILD_MANIFEST_FORMAT_VERSION);
+      writeValue(file, static_cast<uint64_t>(manifest.entries.size()));
+      for (const auto& [filePath, entry] : manifest.entries) {
+        writeString(file, filePath);
+        writeValue(file, entry.inputs.sourceHash);
+        writeValue(file, entry.inputs.dependenciesHash);
+        writeValue(file, entry.inputs.flagsHash);
+        writeValue(file, entry.outputTime);
+        writeValue(file, entry.outputSize);
+      }
+
+      if (!file) {
+        file.close();
+        std::filesystem::remove(tempFilePath, errorCode);
+        return false;
+      }
+    }
+
+    std::filesystem::rename(tempFilePath, manifestFile, errorCode);
+    return !errorCode;
+  }
+
+} // namespace
@@ -0,0 +1,107 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "CompilerSettings.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace papyrus {
+
+  // Hashes of everything that affects the output of a compilation
+  struct BuildInputs {
+    uint64_t sourceHash {0};
+    uint64_t dependenciesHash {0}; // Scripts the source extends or imports, directly or indirectly
+    uint64_t flagsHash {0};        // Compiler path, import directories, flag file and compiler flags
+  };
+
+  // Records the inputs of each successful compilation in a manifest file in output directory, along with a stamp of the
+  // generated PEX file, so a script whose inputs are unchanged since then doesn't need to be compiled again. File hashes are
+  // cached by last write time and size, so scripts shared by many others, e.g. base game scripts, are only read once.
+  class BuildManifest {
+    public:
+      // Compute inputs of compiling a script. Source directory is the root of the script's namespace, where other scripts in
+      // the same project are looked up before import directories. Returns false if source file can't be read.
+      bool computeInputs(const std::wstring& filePath, const std::wstring& sourceDirectory, const CompilerSettings::GameSettings& gameSettings, BuildInputs& inputs);
+
+      // Check whether a script was compiled into the given output file with the same inputs, and the output file hasn't
+      // been changed or removed since then
+      bool isUpToDate(const std::wstring& outputDirectory, const std::wstring& filePath, const BuildInputs& inputs, const std::wstring& outputFile);
+
+      // Record a successful compilation
+      void record(const std::wstring& outputDirectory, const std::wstring& filePath, const BuildInputs& inputs, const std::wstring& outputFile);
+
+      // Write all changed manifests to disk
+      void save();
+
+      // Parse script content for its full script name and the names of the scripts it depends on, all lower-cased
+      static void parseScript(std::istream& content, std::string& scriptName, std::string& originalScriptName, std::vector<std::string>& dependencies);
+
+    private:
+      struct FileInfo {
+        std::filesystem::file_time_type lastWriteTime;
+        uintmax_t size {0};
+        uint64_t hash {0};
+        std::vector<std::string> dependencies;
+      };
+
+      struct Entry {
+        BuildInputs inputs;
+        int64_t outputTime {0};
+        uint64_t outputSize {0};
+      };
+
+      struct Manifest {
+        std::wstring directory; // As given when first used, which is where the file goes on case-sensitive file systems
+        std::map<std::wstring, Entry> entries; // Keyed by case-folded source file path
+        bool changed {false};
+        uint64_t version {0}; // Increases on every change
+      };
+
+      // Get hash and dependencies of a file, from cache if it hasn't changed
+      bool getFileInfo(const std::wstring& filePath, FileInfo& fileInfo);
+
+      // Get the stamp of an output file. Returns false if it doesn't exist.
+      static bool getOutputStamp(const std::wstring& outputFile, int64_t& outputTime, uint64_t& outputSize);
+
+      // Get the manifest of an output directory, loading it on first use. Must be called with manifests locked.
+      Manifest& getManifest(const std::wstring& outputDirectory);
+
+      static bool load(const std::filesystem::path& manifestFile, Manifest& manifest);
+      static bool store(const std::filesystem::path& manifestFile, const Manifest& manifest);
+
+      // Private members
+      //
+      std::mutex filesMutex;
+      std::unordered_map<std::wstring, FileInfo> files; // Keyed by case-folded file path
+
+      std::mutex manifestsMutex;
+      std::map<std::wstring, Manifest> manifests; // Keyed by case-folded output directory
+      std::mutex saveMutex; // Only one save at a time, as it writes to a temporary file next to manifest file
+  };
+
+} // namespace
@@ -19,20 +19,45 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "..\CompilationErrorHandling\Error.hpp"
 #include "..\Common\Game.hpp"
 #include "..\Common\NotepadPlusPlus.hpp"
 
 #include <string>
+#include <vector>
 
 namespace papyrus {
 
   using Game = game::Game;
 
+  // Requests for the active document are served before background ones, e.g. batch builds
+  enum class CompilationPriority {
+    Foreground,
+    Background
+  };
+
   struct CompilationRequest {
+    size_t id {0};
     Game game {Game::Auto};
     npp_buffer_t bufferID {0};
     std::wstring filePath;
+    std::string scriptName; // Full script name, e.g. "MyMod:MyScript". Retrieved from lexer with buffer ID if empty.
     bool useAutoModeOutputDirectory {false};
+    CompilationPriority priority {CompilationPriority::Foreground};
+    bool skipIfUpToDate {false}; // Don't compile if inputs are unchanged since last successful compilation, per build manifest
+  };
+
+  // Result of a compilation request, sent to plugin message window along with the request it is for
+  struct CompilationResult {
+    CompilationRequest request;
+    bool anonymized {false};          // PPM_COMPILATION_DONE
+    bool upToDate {false};            // PPM_COMPILATION_DONE, when compilation is skipped
+    bool cancelled {false};           // PPM_COMPILATION_CANCELLED
+    std::vector<Error> errors;        // PPM_COMPILATION_FAILED, or errors found since last PPM_COMPILATION_ERRORS
+    size_t publishedErrors {0};       // PPM_COMPILATION_FAILED, number of leading errors already sent with PPM_COMPILATION_ERRORS
+    bool hasUnparsableLines {false};  // PPM_COMPILATION_FAILED
+    std::wstring message;             // PPM_ANONYMIZATION_FAILED and PPM_OTHER_ERROR
+    std::wstring title;               // PPM_OTHER_ERROR
   };
 
 } // namespace
@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Compiler.hpp"
 
+#include "PexAnonymizer.hpp"
+
+#include "..\Common\DirectoryIndex.hpp"
 #include "..\Common\Logger.hpp"
 #include "..\Common\Resources.hpp"
 #include "..\Common\StringUtil.hpp"
@@ -28,333 +31,647 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "..\..\external\gsl\include\gsl\util"
 #include "..\..\external\npp\Common.h"
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <format>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 
 namespace papyrus {
 
-  constexpr DWORD STDOUT_PIPE_SIZE = 10 * 1024 * 1024;  // Allow up to 10 MiB data to be returned from stdout
-  constexpr DWORD STDERR_PIPE_SIZE = 500 * 1024 * 1024; // Allow up to 500 MiB data to be returned from stderr
+  using Lock = std::lock_guard<std::mutex>;
 
   Compiler::Compiler(HWND messageWindow, const CompilerSettings& settings)
    : messageWindow(messageWindow), settings(settings) {
   }
 
+  Compiler::~Compiler() {
+    stop();
+  }
+
   void Compiler::start(const CompilationRequest& request) {
-    try {
-      if (!compilationThread.joinable()) {
-        compilationThread = std::thread([=]() { compile(request); }); // Capture the request by value due to asynchronous nature of thread
-      } else {
-        ::SendMessage(messageWindow, PPM_OTHER_ERROR, reinterpret_cast<WPARAM>(L"Compilation thread unusable."), reinterpret_cast<LPARAM>(L"Compilation aborted."));
+    start(std::vector<CompilationRequest> {request});
+  }
+
+  void Compiler::start(const std::vector<CompilationRequest>& requests) {
+    if (requests.empty()) {
+      return;
+    }
+
+    bool noWorker = false;
+    {
+      Lock lock(queueMutex);
+      if (stopping) {
+        return;
+      }
+
+      auto& queue = (requests.front().priority == CompilationPriority::Foreground) ? foregroundRequests : backgroundRequests;
+      queue.push_back(requests);
+
+      // Only start a new worker when idle ones can't take all queued requests
+      if (foregroundRequests.size() + backgroundRequests.size() > idleWorkers && workers.size() < maxWorkers()) {
+        try {
+          workers.emplace_back([this]() { runWorker(); });
+        } catch (const std::system_error&) {
+          // Existing workers will get to the requests eventually. Without any, they would never be served.
+          if (workers.empty()) {
+            queue.pop_back();
+            noWorker = true;
+          }
+        }
+      }
+    }
+
+    if (noWorker) {
+      for (const auto& request : requests) {
+        CompilationResult result {
+          .request = request,
+          .message = L"Starting compiler in thread failed.",
+          .title = L"Compilation stopped."
+        };
+        sendResult(PPM_OTHER_ERROR, result);
+      }
+    } else {
+      queueCondition.notify_one();
+    }
+  }
+
+  void Compiler::cancelAll() {
+    std::vector<CompilationRequest> queuedRequests;
+    {
+      Lock lock(queueMutex);
+      for (auto* queue : {&foregroundRequests, &backgroundRequests}) {
+        for (auto& requests : *queue) {
+          queuedRequests.insert(queuedRequests.end(), std::make_move_iterator(requests.begin()), std::make_move_iterator(requests.end()));
+        }
+        queue->clear();
+      }
+      for (auto& [requestID, launcher] : runningProcesses) {
+        launcher->cancel();
+      }
+    }
+
+    // Running compilations are reported by their workers once the processes are gone
+    for (const auto& request : queuedRequests) {
+      CompilationResult result {
+        .request = request,
+        .cancelled = true
+      };
+      sendResult(PPM_COMPILATION_CANCELLED, result);
+    }
+  }
+
+  void Compiler::stop() {
+    {
+      Lock lock(queueMutex);
+      if (stopping) {
+        return;
+      }
+      stopping = true;
+      for (auto& [requestID, launcher] : runningProcesses) {
+        launcher->cancel();
+      }
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) {
+      if (worker.joinable()) {
+#ifdef _WIN32
+        // A worker may be in the middle of sending a result to message window, which is served by this thread. Such messages
+        // are dispatched while waiting, or the two threads would wait for each other forever.
+        HANDLE workerHandle = worker.native_handle();
+        while (::MsgWaitForMultipleObjects(1, &workerHandle, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1) {
+          MSG msg;
+          ::PeekMessage(&msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+        }
+#endif
+        worker.join();
       }
-    } catch (const std::system_error&) {
-      ::SendMessage(messageWindow, PPM_OTHER_ERROR, reinterpret_cast<WPARAM>(L"Starting compiler in thread failed."), reinterpret_cast<LPARAM>(L"Compilation stopped."));
     }
+    workers.clear();
+    buildManifest.save();
   }
 
   // Private methods
   //
 
-  void Compiler::compile(CompilationRequest request) {
+  void Compiler::runWorker() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+      idleWorkers++;
+      queueCondition.wait(lock, [&] { return stopping || !foregroundRequests.empty() || !backgroundRequests.empty(); });
+      idleWorkers--;
+      if (stopping) {
+        return;
+      }
+
+      auto& queue = !foregroundRequests.empty() ? foregroundRequests : backgroundRequests;
+      std::vector<CompilationRequest> requests = std::move(queue.front());
+      queue.pop_front();
+
+      // All requests in the group share the same launcher, so cancelling any of them stops the whole group
+      ProcessLauncher launcher;
+      for (const auto& request : requests) {
+        runningProcesses[request.id] = &launcher;
+      }
+      lock.unlock();
+      compile(requests, launcher);
+      lock.lock();
+      for (const auto& request : requests) {
+        // Requests queued again separately may be running on other workers by now
+        auto process = runningProcesses.find(request.id);
+        if (process != runningProcesses.end() && process->second == &launcher) {
+          runningProcesses.erase(process);
+        }
+      }
+
+      // Manifest is saved once queue is drained rather than after every compilation, as a batch build may have thousands
+      if (foregroundRequests.empty() && backgroundRequests.empty()) {
+        lock.unlock();
+        buildManifest.save();
+        lock.lock();
+      }
+    }
+  }
+
+  size_t Compiler::maxWorkers() const {
+    if (settings.maxConcurrentCompilations > 0) {
+      return static_cast<size_t>(settings.maxConcurrentCompilations);
+    }
+
+    // Each compiler process is fairly heavy, so by default leave half of the processors for everything else
+    return std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+  }
+
+  void Compiler::compile(const std::vector<CompilationRequest>& requests, ProcessLauncher& launcher) {
     try {
-      const CompilerSettings::GameSettings& gameSettings = settings.gameSettings(request.game);
-      std::wstring path = gameSettings.compilerPath;
-      if (std::ifstream(path).good()) {
-        // Determine output file directory
-        std::wstring outputDirectory = gameSettings.outputDirectory;
-        if (request.useAutoModeOutputDirectory) {
-          if (std::filesystem::path(settings.autoModeOutputDirectory).is_absolute()) {
-            outputDirectory = settings.autoModeOutputDirectory;
-          } else {
-            outputDirectory = std::filesystem::path(request.filePath).parent_path() / settings.autoModeOutputDirectory;
+      const CompilerSettings::GameSettings& gameSettings = settings.gameSettings(requests.front().game);
+      if (!std::ifstream(gameSettings.compilerPath).good()) {
+        for (const auto& request : requests) {
+          CompilationResult result {
+            .request = request
+          };
+          sendResult(PPM_COMPILER_NOT_FOUND, result);
+        }
+        return;
+      }
+
+      // Skip compilation of scripts if nothing has changed since last time
+      std::vector<Job> jobs;
+      for (const auto& request : requests) {
+        Job job = prepareJob(request, gameSettings);
+        if (request.skipIfUpToDate && job.hasBuildInputs) {
+          std::wstring outputFile = utility::findFileIgnoringCase(job.outputDirectory, job.relativeOutputFile.wstring());
+          if (!outputFile.empty() && buildManifest.isUpToDate(job.outputDirectory, request.filePath, job.buildInputs, outputFile)) {
+            CompilationResult result {
+              .request = request,
+              .upToDate = true
+            };
+            sendResult(PPM_COMPILATION_DONE, result);
+            continue;
           }
         }
+        jobs.push_back(std::move(job));
+      }
+      if (jobs.empty()) {
+        return;
+      }
 
-        // Determine PapyrusCompiler's working directory
-        std::filesystem::path filePath = std::filesystem::path(request.filePath);
-        auto scriptName = Lexer::getScriptName(request.bufferID);
-        auto scriptNameComponents = utility::split(scriptName, ":");
-        for (size_t i = 0; i < scriptNameComponents.size(); ++i) {
-          filePath = filePath.parent_path();
+      // Define compiler process. A group of scripts is passed as their folder when it's all of the folder, or as a project
+      // file on Fallout 4. Otherwise compiler can only take one script at a time.
+      ProcessCommand command {
+        .program = gameSettings.compilerPath,
+        .extraArguments = gameSettings.additionalArguments,
+        .workingDirectory = jobs.front().sourceDirectory
+      };
+      std::filesystem::path projectFile;
+      if (jobs.size() == 1) {
+        command.arguments.push_back(jobs.front().request.filePath);
+      } else if (isWholeFolder(jobs)) {
+        command.arguments.push_back(std::filesystem::path(jobs.front().request.filePath).parent_path().wstring());
+        command.arguments.push_back(L"-all");
+      } else if (requests.front().game == Game::Fallout4) {
+        projectFile = std::filesystem::temp_directory_path() / std::format(L"PapyrusBatch{}.ppj", requests.front().id);
+        if (!writeProjectFile(jobs, gameSettings, projectFile)) {
+          projectFile.clear();
         }
-        LPCWSTR workingDirectory {filePath.c_str()};
-
-        // Define compiler process.
-        std::wstring commandLine =
-          L"\"" + path + L"\"" +
-          L" \"" + request.filePath + L"\"" +
-          L" -i=\"" + gameSettings.importDirectories + L"\"" +
-          L" -o=\"" + outputDirectory + L"\"" +
-          L" -f=\"" + gameSettings.flagFile + L"\"" +
-          (gameSettings.optimizeFlag ? L" -op" : L"") +
-          (gameSettings.releaseFlag ? L" -r" : L"") +
-          (gameSettings.finalFlag ? L" -final" : L"") +
-          L" " + gameSettings.additionalArguments;
-        STARTUPINFO startupInfo {
-          .dwFlags = STARTF_USESTDHANDLES
-        };
+      }
 
-        // Setup error output pipe.
-        HANDLE outputReadHandle {};
-        HANDLE errorReadHandle {};
-        SECURITY_ATTRIBUTES attr {};
-        attr.bInheritHandle = TRUE;
-        if (::CreatePipe(&outputReadHandle, &startupInfo.hStdOutput, &attr, STDOUT_PIPE_SIZE) && ::CreatePipe(&errorReadHandle, &startupInfo.hStdError, &attr, STDERR_PIPE_SIZE)) {
-          // Run the process.
-          PROCESS_INFORMATION compilationProcess {};
-          if (::CreateProcess(nullptr, const_cast<LPWSTR>(commandLine.c_str()), nullptr, nullptr, TRUE, CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT, nullptr, workingDirectory, &startupInfo, &compilationProcess)) {
-            if (::WaitForSingleObject(compilationProcess.hProcess, INFINITE) != WAIT_FAILED) {
-              DWORD size {};
-              if (::PeekNamedPipe(errorReadHandle, nullptr, 0, nullptr, &size, nullptr)) {
-                // Check if there are error reported by compiler on stderr.
-                if (size > 0) {
-                  // Read the error output from pipe.
-                  std::vector<char> data(size);
-                  if (::ReadFile(errorReadHandle, &data[0], size, nullptr, nullptr)) {
-                    std::wstring errorOutput(data.begin(), data.end());
-                    parseErrors(errorOutput, gameSettings, outputDirectory);
-                  } else {
-                    sendOtherErrorMessage(L"ReadFile failed. Compilation stopped.");
-                    closeProcess(compilationProcess, startupInfo);
-                    return;
-                  }
-                } else {
-                  // Check stdout as well. This is for the rare case that compilation passed but somehow the compiler chokes at .pas file, when optimize flag is used.
-                  if (::PeekNamedPipe(outputReadHandle, nullptr, 0, nullptr, &size, nullptr)) {
-                    bool hasError = false;
-                    if (size > 0) {
-                      std::vector<char> data(size);
-                      if (::ReadFile(outputReadHandle, &data[0], size, nullptr, nullptr)) {
-                        std::wstring stdOutput(data.begin(), data.end());
-                        if (stdOutput.find(L"compilation failed") != std::string::npos) {
-                          hasError = true;
-                          parseErrors(stdOutput, gameSettings, outputDirectory);
-                        }
-                      }
-                    }
-
-                    if (!hasError) {
-                      // No error, check if anonymization is needed.
-                      if (gameSettings.anonynmizeFlag) {
-                        // Output file has the same name as script name (relative path is determined by namepsace), with file extension set as ".pex".
-                        std::filesystem::path outputFile = std::filesystem::path(outputDirectory);
-                        for (const auto& scriptNameComponent : scriptNameComponents) {
-                          outputFile /= scriptNameComponent;
-                        }
-                        outputFile += ".pex";
-
-                        std::wstring errorMsg;
-                        if (anonymizeOutput(outputFile, errorMsg)) {
-                          ::SendMessage(messageWindow, PPM_COMPILATION_DONE, PARAM_COMPILATION_WITH_ANONYMIZATION, 0);
-                        } else {
-                          ::SendMessage(messageWindow, PPM_ANONYMIZATION_FAILED, reinterpret_cast<WPARAM>(&errorMsg), 0);
-                        }
-                      } else {
-                        ::SendMessage(messageWindow, PPM_COMPILATION_DONE, PARAM_COMPILATION_ONLY, 0);
-                      }
-                    }
-                  } else {
-                    sendOtherErrorMessage(L"PeekNamedPipe failed on stdout. Compilation stopped.");
-                    closeProcess(compilationProcess, startupInfo);
-                    return;
-                  }
-                }
-              } else {
-                sendOtherErrorMessage(L"PeekNamedPipe failed on stderr. Compilation stopped.");
-                closeProcess(compilationProcess, startupInfo);
-                return;
-              }
-            } else {
-              sendOtherErrorMessage(L"WaitForSingleObject failed. Compilation stopped.");
-              closeProcess(compilationProcess, startupInfo);
-              return;
-            }
-
-            // Always close child process handles.
-            closeProcess(compilationProcess, startupInfo);
-          } else {
-            sendOtherErrorMessage(L"CreateProcess failed. Compilation stopped.");
-            return;
-          }
-        } else {
-          sendOtherErrorMessage(L"CreatePipe failed. Compilation stopped.");
-          return;
+      if (jobs.size() > 1 && command.arguments.empty() && projectFile.empty()) {
+        std::vector<CompilationRequest> separateRequests;
+        for (const auto& job : jobs) {
+          separateRequests.push_back(job.request);
         }
+        queueSeparately(separateRequests, launcher);
+        return;
+      }
+
+      if (projectFile.empty()) {
+        appendFlags(command, jobs.front(), gameSettings);
       } else {
-        ::SendMessage(messageWindow, PPM_COMPILER_NOT_FOUND, 0, 0);
+        // Flags are all in the project file
+        command.arguments.push_back(projectFile.wstring());
       }
+      auto removeProjectFile = gsl::finally([&] {
+        if (!projectFile.empty()) {
+          std::error_code ec;
+          std::filesystem::remove(projectFile, ec);
+        }
+      });
+      runJobs(jobs, command, gameSettings, launcher);
     } catch (...) {
       // In case of any exception
-      ::SendMessage(messageWindow, PPM_OTHER_ERROR, reinterpret_cast<WPARAM>(L"Running compiler in thread failed."), reinterpret_cast<LPARAM>(L"Compilation stopped."));
+      for (const auto& request : requests) {
+        CompilationResult result {
+          .request = request,
+          .message = L"Running compiler in thread failed.",
+          .title = L"Compilation stopped."
+        };
+        sendResult(PPM_OTHER_ERROR, result);
+      }
     }
-    compilationThread.detach();
   }
 
-  bool Compiler::anonymizeOutput(const std::wstring& outputFile, std::wstring& errorMsg) {
-    bool noError = true;
-    std::fstream file;
-    file.open(outputFile, std::ios::binary | std::ios::in | std::ios::out);
-    auto autoCleanup = gsl::finally([&] { file.close(); });
-
-    if (file.fail()) {
-      wchar_t errorMsgBuffer[512];
-      _wcserror_s(errorMsgBuffer, errno);
-      errorMsg = std::wstring(errorMsgBuffer);
-      noError = false;
-    } else {
-      // PEX file format (Skyrim & SSE in big endian, FO4 in little endian):
-      //   Signature:         4 bytes. Value: 0xDEC057FA (Skyrim & Skyrim SE) or 0xFA57C0DE (Fallout 4)
-      //   Major version:     1 byte.
-      //   Minor version:     1 byte.
-      //   Game ID:           2 bytes.
-      //   Compilation time:  8 bytes.
-      //   Script path size:  2 bytes.
-      //   Script path:       n bytes.
-      //   User name size:    2 bytes.
-      //   User name:         n bytes.
-      //   Host name size:    2 bytes.
-      //   Host name:         n bytes.
-      unsigned __int32 signature {};
-      file.read(reinterpret_cast<char *>(&signature), 4);
-      if (signature == 0xDEC057FA || signature == 0xFA57C0DE) {
-        bool isBigEndian = (signature == 0xDEC057FA);
-
-        // Skip to "Script path size".
-        file.seekg(16);
-
-        // Anonymize "Script path".
-        anonymizeCurrentField(file, isBigEndian);
-
-        // Anonymize "User name".
-        anonymizeCurrentField(file, isBigEndian);
-
-        // Anonymize "Host name".
-        anonymizeCurrentField(file, isBigEndian);
-      } else {
-        errorMsg = L"Unknown PEX file format: " + outputFile;
-        noError = false;
+  void Compiler::queueSeparately(const std::vector<CompilationRequest>& requests, const ProcessLauncher& launcher) {
+    {
+      Lock lock(queueMutex);
+      if (stopping) {
+        return;
+      }
+
+      // Requests of a group that was cancelled are not queued again, as cancelAll couldn't find them in the queue
+      if (!launcher.isCancelled()) {
+        // Requests go to the front of the queue, where the group was taken from, so they are served in the same order
+        auto& queue = (requests.front().priority == CompilationPriority::Foreground) ? foregroundRequests : backgroundRequests;
+        for (auto request = requests.rbegin(); request != requests.rend(); ++request) {
+          queue.push_front({*request});
+        }
+
+        // This worker takes one of them once it's done with the group, so failing to start another one is fine
+        while (foregroundRequests.size() + backgroundRequests.size() > idleWorkers + 1 && workers.size() < maxWorkers()) {
+          try {
+            workers.emplace_back([this]() { runWorker(); });
+          } catch (const std::system_error&) {
+            break;
+          }
+        }
+        queueCondition.notify_all();
+        return;
       }
     }
 
-    return noError;
+    for (const auto& request : requests) {
+      CompilationResult result {
+        .request = request,
+        .cancelled = true
+      };
+      sendResult(PPM_COMPILATION_CANCELLED, result);
+    }
   }
 
-  void Compiler::anonymizeCurrentField(std::fstream& file, bool isBigEndian) {
-    // First read current field's size.
-    int size = readSize(file, isBigEndian);
-    if (size > 0) {
-      // Switch to write mode.
-      file.seekp(file.tellg());
+  Compiler::Job Compiler::prepareJob(const CompilationRequest& request, const CompilerSettings::GameSettings& gameSettings) {
+    Job job {
+      .request = request
+    };
 
-      // Overwrite with dashes.
-      char* buffer = new char[size];
-      auto autoCleanup = gsl::finally([&] { delete[] buffer; });
-      memset(buffer, '-', size);
-      file.write(buffer, size);
+    // Determine output file directory
+    job.outputDirectory = gameSettings.outputDirectory;
+    if (request.useAutoModeOutputDirectory) {
+      if (std::filesystem::path(settings.autoModeOutputDirectory).is_absolute()) {
+        job.outputDirectory = settings.autoModeOutputDirectory;
+      } else {
+        job.outputDirectory = (std::filesystem::path(request.filePath).parent_path() / settings.autoModeOutputDirectory).wstring();
+      }
+    }
 
-      // Switch back to read mode.
-      file.seekg(file.tellp());
+    // Determine PapyrusCompiler's working directory
+    std::filesystem::path filePath = std::filesystem::path(request.filePath);
+    auto scriptName = request.scriptName.empty() ? Lexer::getScriptName(request.bufferID) : request.scriptName;
+    auto scriptNameComponents = utility::split(scriptName, ":");
+    for (size_t i = 0; i < scriptNameComponents.size(); ++i) {
+      filePath = filePath.parent_path();
     }
-  }
+    job.sourceDirectory = filePath.wstring();
 
-  int Compiler::readSize(std::fstream& file, bool isBigEndian) {
-    std::int16_t size {};
-    char* bytes = reinterpret_cast<char*>(&size);
-    file.read(bytes, 2);
+    // Output file has the same name as script name (relative path is determined by namepsace), with file extension set as ".pex".
+    for (const auto& scriptNameComponent : scriptNameComponents) {
+      job.relativeOutputFile /= scriptNameComponent;
+    }
+    job.relativeOutputFile += ".pex";
 
-    if (isBigEndian)
-    {
-      std::swap(bytes[0], bytes[1]);
+    job.hasBuildInputs = buildManifest.computeInputs(request.filePath, job.sourceDirectory, gameSettings, job.buildInputs);
+    return job;
+  }
+
+  void Compiler::appendFlags(ProcessCommand& command, const Job& job, const CompilerSettings::GameSettings& gameSettings) {
+    command.arguments.push_back(L"-i=" + gameSettings.importDirectories);
+    command.arguments.push_back(L"-o=" + job.outputDirectory);
+    command.arguments.push_back(L"-f=" + gameSettings.flagFile);
+    if (gameSettings.optimizeFlag) {
+      command.arguments.push_back(L"-op");
+    }
+    if (gameSettings.releaseFlag) {
+      command.arguments.push_back(L"-r");
+    }
+    if (gameSettings.finalFlag) {
+      command.arguments.push_back(L"-final");
     }
-    return size;
   }
 
-  void Compiler::parseErrors(const std::wstring& errorText, const CompilerSettings::GameSettings& gameSettings, const std::wstring& outputDirectory) {
-    bool hasUnparsableLines = false;
-    std::vector<Error> errors;
-    std::wstringstream output(errorText);
-    std::wstring line;
-    while (std::getline(output, line)) {
-      try {
-        std::wstring lineError = line;
-        Error error;
-        bool isScriptError = false;
-        if (utility::startsWith(lineError, L"<unknown>")) {
-          error.file = L"<unknown>";
-          lineError.erase(0, 10);
-        } else {
-          size_t fileExtIndex = utility::indexOf(lineError, L".psc(");
-          if (fileExtIndex == std::string::npos && gameSettings.optimizeFlag) {
-            fileExtIndex = utility::indexOf(lineError, L".pas(");
-            isScriptError = true;
-          }
+  bool Compiler::isWholeFolder(const std::vector<Job>& jobs) {
+    auto folder = std::filesystem::path(jobs.front().request.filePath).parent_path();
+    for (const auto& job : jobs) {
+      if (!utility::compare(std::filesystem::path(job.request.filePath).parent_path().wstring(), folder.wstring())) {
+        return false;
+      }
+    }
 
-          if (fileExtIndex != std::string::npos) {
-            error.file = lineError.substr(0, fileExtIndex + 4);
-            if (isScriptError) {
-              error.file = std::filesystem::path(outputDirectory) / error.file; // Papyrus compiler doesn't provide full path for .pas files
-            }
-            lineError.erase(0, fileExtIndex + 5);
-          }
+    std::error_code ec;
+    size_t scriptCount = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+      if (entry.is_regular_file(ec) && utility::compare(entry.path().extension().wstring(), L".psc")) {
+        scriptCount++;
+      }
+    }
+    return !ec && scriptCount == jobs.size();
+  }
+
+  bool Compiler::writeProjectFile(const std::vector<Job>& jobs, const CompilerSettings::GameSettings& gameSettings, const std::filesystem::path& projectFile) {
+    auto escape = [](const std::wstring& value) {
+      std::string escaped;
+      auto utf8Value = std::filesystem::path(value).u8string();
+      for (char ch : std::string(utf8Value.begin(), utf8Value.end())) {
+        switch (ch) {
+          case '&': escaped += "&amp;"; break;
+          case '<': escaped += "&lt;"; break;
+          case '>': escaped += "&gt;"; break;
+          case '"': escaped += "&quot;"; break;
+          default: escaped += ch; break;
         }
+      }
+      return escaped;
+    };
+    auto boolean = [](bool value) { return value ? "true" : "false"; };
+
+    std::ofstream file(projectFile, std::ios::binary | std::ios::trunc);
+    file << "<?xml version='1.0'?>\n"
+      << "<PapyrusProject xmlns=\"PapyrusProject.xsd\" Flags=\"" << escape(gameSettings.flagFile)
+      << "\" Output=\"" << escape(jobs.front().outputDirectory)
+      << "\" Optimize=\"" << boolean(gameSettings.optimizeFlag)
+      << "\" Release=\"" << boolean(gameSettings.releaseFlag)
+      << "\" Final=\"" << boolean(gameSettings.finalFlag) << "\">\n"
+      << "  <Imports>\n";
+    for (const auto& importDirectory : utility::split(gameSettings.importDirectories, L";")) {
+      if (!importDirectory.empty()) {
+        file << "    <Import>" << escape(importDirectory) << "</Import>\n";
+      }
+    }
+    file << "  </Imports>\n"
+      << "  <Scripts>\n";
+    for (const auto& job : jobs) {
+      file << "    <Script>" << escape(job.request.filePath) << "</Script>\n";
+    }
+    file << "  </Scripts>\n"
+      << "</PapyrusProject>\n";
+    return file.good();
+  }
 
-        if (!error.file.empty()) {
-          if (!isScriptError) { // .psc
-            size_t indexComma = lineError.find_first_of(L',');
-            error.line = std::stoi(lineError.substr(0, indexComma));
-
-            size_t indexParenthesis = lineError.find_first_of(L')');
-            error.column = std::stoi(lineError.substr(indexComma + 1, indexParenthesis - (indexComma - 1)));
-            error.message = lineError.substr(indexParenthesis + 3);
-          } else { // .pas
-            size_t indexParenthesis = lineError.find_first_of(L')');
-            error.line = std::stoi(lineError.substr(0, indexParenthesis));
-            error.column = 1; // Papyrus compiler doesn't provide column info for .pas files
-            error.message = lineError.substr(indexParenthesis + 4);
-          }
+  void Compiler::runJobs(const std::vector<Job>& jobs, const ProcessCommand& command, const CompilerSettings::GameSettings& gameSettings, ProcessLauncher& launcher) {
+    // Run the process, reading its output while it runs. Errors on stderr are parsed as they come in and sent back right away,
+    // each with the request of the script it was reported for.
+    const CompilationRequest& firstRequest = jobs.front().request;
+    auto startTime = std::filesystem::file_time_type::clock::now();
+    std::string output;
+    std::string errorOutput;
+    ErrorParser errorParser(gameSettings.optimizeFlag, jobs.front().outputDirectory);
+    size_t publishedErrors = 0;
+    int timeout = settings.compilationTimeout * static_cast<int>(jobs.size()); // A group gets as long as its scripts would get one by one
+    bool launched = launcher.run(command, [&](ProcessStream stream, const char* data, size_t size) {
+      if (stream == ProcessStream::Output) {
+        output.append(data, size);
+      } else {
+        errorOutput.append(data, size);
+        errorParser.feed(data, size);
+        publishErrors(jobs, errorParser, publishedErrors);
+      }
+    }, std::chrono::seconds(timeout));
+    if (!launched) {
+      for (const auto& job : jobs) {
+        sendOtherErrorMessage(job.request, std::wstring(launcher.getFailedCall()) + L" failed. Compilation stopped.", launcher.getErrorCode());
+      }
+      return;
+    }
 
-          // Discard duplicate errors.
-          auto iter = std::find_if(errors.begin(), errors.end(),
-            [&](const auto& comparisionError) {
-              return comparisionError.file == error.file
-                && comparisionError.message == error.message
-                && comparisionError.line == error.line
-                && comparisionError.column == error.column;
-            }
-          );
-          if (iter == errors.end()) {
-            errors.push_back(error);
-          }
+    // Output of a process that was stopped is incomplete, so it's not looked at
+    if (launcher.getEnd() == ProcessEnd::Cancelled) {
+      for (const auto& job : jobs) {
+        CompilationResult result {
+          .request = job.request,
+          .cancelled = true
+        };
+        sendResult(PPM_COMPILATION_CANCELLED, result);
+      }
+      return;
+    }
+    if (launcher.getEnd() == ProcessEnd::TimedOut) {
+      for (const auto& job : jobs) {
+        CompilationResult result {
+          .request = job.request,
+          .message = std::format(L"Compiler didn't finish in {} seconds and was stopped: {}", timeout, job.request.filePath),
+          .title = L"Compilation timed out."
+        };
+        sendResult(PPM_OTHER_ERROR, result);
+      }
+      return;
+    }
+
+    if (jobs.size() == 1) {
+      // Check if there are error reported by compiler on stderr. Also check stdout, for the rare case that compilation passed
+      // but somehow the compiler chokes at .pas file, when optimize flag is used.
+      if (!errorOutput.empty()) {
+        errorParser.finish();
+        sendErrors(firstRequest, errorParser, errorOutput, publishedErrors);
+      } else if (output.find("compilation failed") != std::string::npos) {
+        ErrorParser outputParser(gameSettings.optimizeFlag, jobs.front().outputDirectory);
+        outputParser.feed(output.data(), output.size());
+        outputParser.finish();
+        sendErrors(firstRequest, outputParser, output, 0);
+      } else {
+        completeJobs(jobs, gameSettings);
+      }
+      return;
+    }
+
+    // Combined output of a group is split by file each error is for. Scripts without errors of their own succeeded if their
+    // output files were written by this run, as compiler stops at the first failed script in some cases.
+    errorParser.finish();
+    std::vector<Error> errors = errorParser.getErrors();
+    bool hasUnparsableLines = errorParser.hasUnparsableLines();
+    if (output.find("compilation failed") != std::string::npos) {
+      ErrorParser outputParser(gameSettings.optimizeFlag, jobs.front().outputDirectory);
+      outputParser.feed(output.data(), output.size());
+      outputParser.finish();
+      errors.insert(errors.end(), outputParser.getErrors().begin(), outputParser.getErrors().end());
+      hasUnparsableLines = hasUnparsableLines || outputParser.hasUnparsableLines();
+    }
+
+    std::vector<std::vector<Error>> jobErrors(jobs.size());
+    std::vector<Error> unattributedErrors;
+    for (auto& error : errors) {
+      size_t owner = findOwner(jobs, error.file);
+      if (owner < jobs.size()) {
+        jobErrors[owner].push_back(std::move(error));
+      } else {
+        unattributedErrors.push_back(std::move(error));
+      }
+    }
+
+    std::vector<Job> succeededJobs;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      const auto& job = jobs[i];
+      if (jobErrors[i].empty()) {
+        std::error_code ec;
+        auto outputFile = utility::findFileIgnoringCase(job.outputDirectory, job.relativeOutputFile.wstring());
+        if (!outputFile.empty() && std::filesystem::last_write_time(outputFile, ec) >= startTime && !ec) {
+          succeededJobs.push_back(job);
+          continue;
         }
-      } catch (...) {
-        //log(line);
-        hasUnparsableLines = true;
       }
+
+      CompilationResult result {
+        .request = job.request,
+        .errors = !jobErrors[i].empty() ? jobErrors[i] : unattributedErrors,
+        .hasUnparsableLines = hasUnparsableLines
+      };
+      if (result.errors.empty()) {
+        result.errors.push_back(Error {
+          .file = job.request.filePath,
+          .message = errorOutput.empty() && output.empty() ? L"No output generated." : ErrorParser::decode(output) + ErrorParser::decode(errorOutput)
+        });
+      }
+      sendResult(PPM_COMPILATION_FAILED, result);
+    }
+    if (!succeededJobs.empty()) {
+      completeJobs(succeededJobs, gameSettings);
+    }
+  }
+
+  size_t Compiler::findOwner(const std::vector<Job>& jobs, const std::wstring& file) {
+    if (file.empty()) {
+      return jobs.size();
+    }
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (utility::compare(jobs[i].request.filePath, file)) {
+        return i;
+      }
+    }
+
+    // Compiler may report a relative path, or the assembly file of a script when optimize flag is used. Both are matched by
+    // file name, which is the last component of script name.
+    auto stem = std::filesystem::path(file).stem().wstring();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (utility::compare(jobs[i].relativeOutputFile.stem().wstring(), stem)) {
+        return i;
+      }
+    }
+    return jobs.size();
+  }
+
+  void Compiler::completeJobs(const std::vector<Job>& jobs, const CompilerSettings::GameSettings& gameSettings) {
+    // Script name is case insensitive, so find out output file's real path through directory index. The file may have just been
+    // created, in which case its directory is re-scanned.
+    std::vector<std::wstring> outputFiles;
+    for (const auto& job : jobs) {
+      std::wstring outputFile = utility::findFileIgnoringCase(job.outputDirectory, job.relativeOutputFile.wstring());
+      if (outputFile.empty()) {
+        outputFile = (std::filesystem::path(job.outputDirectory) / job.relativeOutputFile).wstring();
+      }
+      outputFiles.push_back(std::move(outputFile));
     }
 
-    if (errors.empty()) {
+    // No error, check if anonymization is needed. Outputs of a group are anonymized in parallel.
+    AnonymizationReport anonymizationReport;
+    if (gameSettings.anonynmizeFlag) {
+      anonymizationReport = PexAnonymizer::anonymize(outputFiles);
+      utility::logger.log(std::format(L"[Anonymize] {} files in {} ms ({:.0f} files/s), {} failed", anonymizationReport.total,
+        std::chrono::duration_cast<std::chrono::milliseconds>(anonymizationReport.elapsedTime).count(), anonymizationReport.filesPerSecond(), anonymizationReport.failed));
+    }
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      const auto& job = jobs[i];
+      CompilationResult result {
+        .request = job.request,
+        .anonymized = gameSettings.anonynmizeFlag
+      };
+      if (gameSettings.anonynmizeFlag && !anonymizationReport.errorMessages[i].empty()) {
+        result.anonymized = false;
+        result.message = anonymizationReport.errorMessages[i];
+        sendResult(PPM_ANONYMIZATION_FAILED, result);
+        continue;
+      }
+
+      if (job.hasBuildInputs) {
+        buildManifest.record(job.outputDirectory, job.request.filePath, job.buildInputs, outputFiles[i]);
+      }
+      sendResult(PPM_COMPILATION_DONE, result);
+    }
+  }
+
+  void Compiler::publishErrors(const std::vector<Job>& jobs, const ErrorParser& errorParser, size_t& publishedErrors) {
+    const auto& errors = errorParser.getErrors();
+    if (errors.size() <= publishedErrors) {
+      return;
+    }
+
+    // Errors not matching any script of the group are listed with the first one
+    std::vector<std::vector<Error>> jobErrors(jobs.size());
+    for (size_t i = publishedErrors; i < errors.size(); ++i) {
+      size_t owner = findOwner(jobs, errors[i].file);
+      jobErrors[owner < jobs.size() ? owner : 0].push_back(errors[i]);
+    }
+    publishedErrors = errors.size();
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (!jobErrors[i].empty()) {
+        CompilationResult result {
+          .request = jobs[i].request,
+          .errors = std::move(jobErrors[i])
+        };
+        sendResult(PPM_COMPILATION_ERRORS, result);
+      }
+    }
+  }
+
+  void Compiler::sendErrors(const CompilationRequest& request, const ErrorParser& errorParser, const std::string& output, size_t publishedErrors) {
+    CompilationResult result {
+      .request = request,
+      .errors = errorParser.getErrors(),
+      .publishedErrors = publishedErrors,
+      .hasUnparsableLines = errorParser.hasUnparsableLines()
+    };
+    if (result.errors.empty()) {
       // In the rare case when error cannot be parsed (likely some errors dumped on stdout that are not related to specific files), send the whole output to error window.
-      errors.push_back(Error {
-        .message = errorText
+      result.errors.push_back(Error {
+        .message = ErrorParser::decode(output)
       });
     }
-    ::SendMessage(messageWindow, PPM_COMPILATION_FAILED, reinterpret_cast<WPARAM>(&errors), hasUnparsableLines);
+    sendResult(PPM_COMPILATION_FAILED, result);
   }
 
-  void Compiler::closeProcess(const PROCESS_INFORMATION& processInfo, const STARTUPINFO& startupInfo) {
-    // Properly close child process handles, i.e. hProcess and hThread
-    CloseHandle(processInfo.hProcess);
-    CloseHandle(processInfo.hThread);
-
-    // Close pipes assigned to child process.
-    CloseHandle(startupInfo.hStdOutput);
-    CloseHandle(startupInfo.hStdError);
+  void Compiler::sendResult(UINT message, const CompilationResult& result) {
+    if (!stopping) {
+      ::SendMessage(messageWindow, message, reinterpret_cast<WPARAM>(&result), 0);
+    }
   }
 
-  void Compiler::sendOtherErrorMessage(const wchar_t* msg) {
-    std::wstring errorMsg(L"Error code: " + std::to_wstring(::GetLastError()));
-    ::SendMessage(messageWindow, PPM_OTHER_ERROR, reinterpret_cast<WPARAM>(errorMsg.c_str()), reinterpret_cast<LPARAM>(msg));
+  void Compiler::sendOtherErrorMessage(const CompilationRequest& request, const std::wstring& msg, unsigned long errorCode) {
+    CompilationResult result {
+      .request = request,
+      .message = L"Error code: " + std::to_wstring(errorCode),
+      .title = msg
+    };
+    sendResult(PPM_OTHER_ERROR, result);
   }
 
 } // namespace
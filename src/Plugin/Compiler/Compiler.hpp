@@ -20,11 +20,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "BuildManifest.hpp"
 #include "CompilationRequest.hpp"
 #include "CompilerSettings.hpp"
+#include "ErrorParser.hpp"
+#include "ProcessLauncher.hpp"
 
 #include "..\CompilationErrorHandling\Error.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -32,39 +41,102 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace papyrus {
 
+  // Compiles scripts on a pool of worker threads, each running its own compiler process. Requests are queued and served in the
+  // order they come in, with foreground requests ahead of background ones. A group of requests can be compiled by a single
+  // compiler process, to save the cost of starting compiler and loading imported scripts for each of them. Workers are started on demand, up to the limit in
+  // settings, and the result of each request is sent back to message window along with the request. Successful compilations
+  // are recorded in build manifest, so requests that allow it can be skipped when nothing has changed. A compiler process that
+  // is cancelled or runs longer than the timeout in settings is killed along with any process it started, so a hung compiler
+  // never holds a worker forever.
   class Compiler {
     public:
       Compiler(HWND messageWindow, const CompilerSettings& settings);
+      ~Compiler();
 
+      // Queue a compilation request
       void start(const CompilationRequest& request);
 
+      // Queue a group of requests to be compiled together, e.g. scripts in the same folder in a batch build. They must be for
+      // the same game and have the same output directory. Result of each request is still sent back separately.
+      void start(const std::vector<CompilationRequest>& requests);
+
+      // Cancel all queued and running compilations. Each of them is reported back as cancelled.
+      void cancelAll();
+
+      // Cancel everything and wait for workers to exit, e.g. when Notepad++ shuts down. Nothing is reported back from then on.
+      void stop();
+
     private:
-      // Compile the given script file in a separate thread
-      void compile(CompilationRequest request);
+      // A script being compiled, with everything derived from its request
+      struct Job {
+        CompilationRequest request;
+        std::wstring outputDirectory;
+        std::wstring sourceDirectory; // Root of script's namespace, used as compiler's working directory
+        std::filesystem::path relativeOutputFile;
+        BuildInputs buildInputs;
+        bool hasBuildInputs {false};
+      };
+
+      // Serve queued requests until compiler is destroyed
+      void runWorker();
+
+      // Maximum number of workers, from settings
+      size_t maxWorkers() const;
+
+      // Compile a group of requests with a process launcher that can be cancelled from other threads. Runs on a worker thread.
+      void compile(const std::vector<CompilationRequest>& requests, ProcessLauncher& launcher);
+
+      // Queue requests of a group separately when compiler can't take them together, so as many workers as settings allow can
+      // compile them. If the group was cancelled meanwhile, they are reported as cancelled instead.
+      void queueSeparately(const std::vector<CompilationRequest>& requests, const ProcessLauncher& launcher);
+
+      // Work out output and working directories of a request, and the inputs of compiling it
+      Job prepareJob(const CompilationRequest& request, const CompilerSettings::GameSettings& gameSettings);
+
+      // Add import directories, output directory, flag file, and optional flags to compiler's arguments
+      static void appendFlags(ProcessCommand& command, const Job& job, const CompilerSettings::GameSettings& gameSettings);
+
+      // Check whether jobs are all the scripts in their folder, so they can be compiled with "-all" flag
+      static bool isWholeFolder(const std::vector<Job>& jobs);
+
+      // Write a Fallout 4 project file that lists the scripts of all jobs, along with compiler flags
+      static bool writeProjectFile(const std::vector<Job>& jobs, const CompilerSettings::GameSettings& gameSettings, const std::filesystem::path& projectFile);
+
+      // Run compiler for jobs and send back the result of each of them
+      void runJobs(const std::vector<Job>& jobs, const ProcessCommand& command, const CompilerSettings::GameSettings& gameSettings, ProcessLauncher& launcher);
 
-      // Anonymize generated PEX script
-      bool anonymizeOutput(const std::wstring& outputFile, std::wstring& errorMsg);
+      // Find the job a reported file belongs to. Returns number of jobs if there isn't one.
+      static size_t findOwner(const std::vector<Job>& jobs, const std::wstring& file);
 
-      // Anonymize a field that is at current location. This feild can be "Script path", or "User name", or "Host name"
-      void anonymizeCurrentField(std::fstream& file, bool isBigEndian);
+      // Anonymize outputs of succeeded jobs if needed, record the compilations in build manifest, and send back success
+      void completeJobs(const std::vector<Job>& jobs, const CompilerSettings::GameSettings& gameSettings);
 
-      // Read size of a field from PEX header. Skyrim & SSE use big endian, FO4 uses little endian
-      int readSize(std::fstream& file, bool isBigEndian);
+      // Send errors parsed since last time to plugin message window while compiler is still running, grouped by the job they belong to
+      void publishErrors(const std::vector<Job>& jobs, const ErrorParser& errorParser, size_t& publishedErrors);
 
-      // Parse compilation errors and send the result back to plugin message window
-      void parseErrors(const std::wstring& errorText, const CompilerSettings::GameSettings& gameSettings, const std::wstring& outputDirectory);
+      // Send all parsed errors to plugin message window once compiler has exited. If none can be parsed, the whole output is sent instead.
+      void sendErrors(const CompilationRequest& request, const ErrorParser& errorParser, const std::string& output, size_t publishedErrors);
 
-      // Close compilation process
-      void closeProcess(const PROCESS_INFORMATION& processInfo, const STARTUPINFO& startupInfo);
+      // Send a result to plugin message window, unless compiler is stopping
+      void sendResult(UINT message, const CompilationResult& result);
 
-      // Send any unexpected "other error message" to plugin main processor, along with last error code from Win32 API
-      void sendOtherErrorMessage(const wchar_t* msg);
+      // Send any unexpected "other error message" to plugin main processor, along with error code from the failed system call
+      void sendOtherErrorMessage(const CompilationRequest& request, const std::wstring& msg, unsigned long errorCode);
 
       // Private members
       //
       const HWND messageWindow;
       const CompilerSettings& settings;
-      std::thread compilationThread;
+      BuildManifest buildManifest;
+
+      std::mutex queueMutex;
+      std::condition_variable queueCondition;
+      std::deque<std::vector<CompilationRequest>> foregroundRequests;
+      std::deque<std::vector<CompilationRequest>> backgroundRequests;
+      std::vector<std::thread> workers;
+      std::map<size_t, ProcessLauncher*> runningProcesses; // Keyed by request ID
+      size_t idleWorkers {0};
+      std::atomic<bool> stopping {false};
   };
 
 } // namespace
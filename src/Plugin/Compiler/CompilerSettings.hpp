@@ -32,6 +32,10 @@ namespace papyrus {
 
   using Game = game::Game;
 
+  constexpr int DEFAULT_MAX_CONCURRENT_COMPILATIONS = 0; // Half of logical processors
+  constexpr int DEFAULT_COMPILATION_TIMEOUT = 300;       // In seconds
+  constexpr int DEFAULT_BATCH_GROUP_SIZE = 1;            // One script per compiler process
+
   struct CompilerSettings {
 
     struct GameSettings {
@@ -55,6 +59,10 @@ namespace papyrus {
     Game autoModeDefaultGame {Game::Auto};
     std::wstring autoModeOutputDirectory;
     utility::PrimitiveTypeValueMonitor<bool> allowUnmanagedSource;
+    utility::PrimitiveTypeValueMonitor<int> maxConcurrentCompilations;
+    utility::PrimitiveTypeValueMonitor<bool> incrementalBatchBuild;
+    utility::PrimitiveTypeValueMonitor<int> compilationTimeout; // In seconds, 0 for no limit
+    utility::PrimitiveTypeValueMonitor<int> batchGroupSize;     // Max number of scripts in the same folder compiled by one compiler process
 
     const GameSettings& gameSettings(Game game) const;
     GameSettings& gameSettings(Game game);
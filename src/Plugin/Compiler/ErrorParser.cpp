@@ -0,0 +1,197 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ErrorParser.hpp"
+
+#include "..\Common\Hash.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+
+namespace papyrus {
+
+  namespace {
+    inline char toLowerAscii(char ch) {
+      return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+    }
+
+    // Find a lower-cased ASCII pattern in text, ignoring case
+    size_t findIgnoringCase(std::string_view text, std::string_view pattern) {
+      auto iter = std::search(text.begin(), text.end(), pattern.begin(), pattern.end(),
+        [](char ch1, char ch2) {
+          return toLowerAscii(ch1) == ch2;
+        }
+      );
+      return (iter == text.end()) ? std::string_view::npos : static_cast<size_t>(iter - text.begin());
+    }
+
+    // Parse a number at the start of text after optional white spaces, ignoring anything after it
+    bool parseNumber(std::string_view text, int& number) {
+      size_t start = text.find_first_not_of(" \t");
+      if (start == std::string_view::npos) {
+        return false;
+      }
+      auto [end, errorCode] = std::from_chars(text.data() + start, text.data() + text.size(), number);
+      return errorCode == std::errc();
+    }
+
+    void appendCodePoint(std::wstring& str, char32_t codePoint) {
+      if constexpr (sizeof(wchar_t) == 2) {
+        if (codePoint >= 0x10000) {
+          codePoint -= 0x10000;
+          str += static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+          str += static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+          return;
+        }
+      }
+      str += static_cast<wchar_t>(codePoint);
+    }
+  }
+
+  std::wstring ErrorParser::decode(std::string_view text) {
+    std::wstring str;
+    str.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+      auto byte = static_cast<unsigned char>(text[i]);
+      size_t length = (byte < 0x80) ? 1 : ((byte & 0xE0) == 0xC0) ? 2 : ((byte & 0xF0) == 0xE0) ? 3 : ((byte & 0xF8) == 0xF0) ? 4 : 0;
+      char32_t codePoint = (length == 1) ? byte : (length == 2) ? (byte & 0x1F) : (length == 3) ? (byte & 0x0F) : (byte & 0x07);
+      bool valid = (length > 0 && i + length <= text.size());
+      for (size_t j = 1; valid && j < length; ++j) {
+        auto continuation = static_cast<unsigned char>(text[i + j]);
+        valid = ((continuation & 0xC0) == 0x80);
+        codePoint = (codePoint << 6) | (continuation & 0x3F);
+      }
+
+      // Reject overlong forms, surrogates and out of range code points as well
+      constexpr char32_t minCodePoints[] {0, 0, 0x80, 0x800, 0x10000};
+      if (valid && codePoint >= minCodePoints[length] && codePoint <= 0x10FFFF && (codePoint < 0xD800 || codePoint > 0xDFFF)) {
+        appendCodePoint(str, codePoint);
+        i += length;
+      } else {
+        str += static_cast<wchar_t>(byte);
+        i++;
+      }
+    }
+    return str;
+  }
+
+  ErrorParser::ErrorParser(bool optimizeFlag, const std::wstring& outputDirectory)
+    : optimizeFlag(optimizeFlag), outputDirectory(outputDirectory) {
+  }
+
+  void ErrorParser::feed(const char* data, size_t size) {
+    std::string_view chunk(data, size);
+    size_t lineStart = 0;
+    for (size_t lineEnd = chunk.find('\n'); lineEnd != std::string_view::npos; lineEnd = chunk.find('\n', lineStart)) {
+      if (pendingLine.empty()) {
+        unparsableLines |= !parseLine(chunk.substr(lineStart, lineEnd - lineStart));
+      } else {
+        pendingLine.append(chunk.substr(lineStart, lineEnd - lineStart));
+        unparsableLines |= !parseLine(pendingLine);
+        pendingLine.clear();
+      }
+      lineStart = lineEnd + 1;
+    }
+    pendingLine.append(chunk.substr(lineStart));
+  }
+
+  void ErrorParser::finish() {
+    if (!pendingLine.empty()) {
+      unparsableLines |= !parseLine(pendingLine);
+      pendingLine.clear();
+    }
+  }
+
+  // Private methods
+  //
+
+  bool ErrorParser::parseLine(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+
+    // Errors look like "<file>.psc(<line>,<column>): <message>", or "<file>.pas(<line>):  <message>" when optimize flag
+    // is used, or "<unknown>: <line>,<column>): <message>" when compiler can't tell the file.
+    constexpr std::string_view unknownFile = "<unknown>";
+    Error error;
+    bool isScriptError = false;
+    if (line.size() >= unknownFile.size() && findIgnoringCase(line.substr(0, unknownFile.size()), unknownFile) == 0) {
+      error.file = L"<unknown>";
+      line.remove_prefix(std::min<size_t>(line.size(), unknownFile.size() + 1));
+    } else {
+      size_t fileExtIndex = findIgnoringCase(line, ".psc(");
+      if (fileExtIndex == std::string_view::npos && optimizeFlag) {
+        fileExtIndex = findIgnoringCase(line, ".pas(");
+        isScriptError = true;
+      }
+      if (fileExtIndex == std::string_view::npos) {
+        // Not an error line
+        return true;
+      }
+
+      error.file = decode(line.substr(0, fileExtIndex + 4));
+      if (isScriptError) {
+        error.file = (std::filesystem::path(outputDirectory) / error.file).wstring(); // Papyrus compiler doesn't provide full path for .pas files
+      }
+      line.remove_prefix(fileExtIndex + 5);
+    }
+
+    size_t indexParenthesis = line.find(')');
+    size_t messageStart = (indexParenthesis == std::string_view::npos) ? std::string_view::npos : indexParenthesis + (isScriptError ? 4 : 3);
+    if (messageStart == std::string_view::npos || messageStart > line.size() || !parseNumber(line, error.line)) {
+      return false;
+    }
+    if (!isScriptError) { // .psc
+      size_t indexComma = line.find(',');
+      if (indexComma == std::string_view::npos || !parseNumber(line.substr(indexComma + 1), error.column)) {
+        return false;
+      }
+    } else { // .pas
+      error.column = 1; // Papyrus compiler doesn't provide column info for .pas files
+    }
+    error.message = decode(line.substr(messageStart));
+    addError(std::move(error));
+    return true;
+  }
+
+  void ErrorParser::addError(Error&& error) {
+    uint64_t key = utility::hash(error.file);
+    key = utility::hash(error.message, key);
+    key = utility::hash(&error.line, sizeof(error.line), key);
+    key = utility::hash(&error.column, sizeof(error.column), key);
+
+    // Discard duplicate errors.
+    auto& sameHashErrors = errorsByHash[key];
+    bool isDuplicate = std::any_of(sameHashErrors.begin(), sameHashErrors.end(),
+      [&](size_t index) {
+        const auto& comparisionError = errors[index];
+        return comparisionError.file == error.file
+          && comparisionError.message == error.message
+          && comparisionError.line == error.line
+          && comparisionError.column == error.column;
+      }
+    );
+    if (!isDuplicate) {
+      sameHashErrors.push_back(errors.size());
+      errors.push_back(std::move(error));
+    }
+  }
+
+} // namespace
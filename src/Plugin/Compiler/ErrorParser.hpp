@@ -0,0 +1,73 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\CompilationErrorHandling\Error.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace papyrus {
+
+  // Parses compiler output into errors as it comes in. Output can be fed in chunks of any size, and each complete line is
+  // parsed right away, so errors are available while the compiler is still running. Lines are parsed in place as views into
+  // the chunk, and only a line split between chunks is copied. Output is decoded as UTF-8, and bytes that are not valid UTF-8
+  // are taken as Latin-1, so output in a legacy code page still reads mostly right.
+  class ErrorParser {
+    public:
+      // Decode output the same way as errors are, e.g. to show output that has no parsable errors
+      static std::wstring decode(std::string_view text);
+
+      // Papyrus compiler reports errors in .pas files relative to output directory, and only when optimize flag is used
+      ErrorParser(bool optimizeFlag, const std::wstring& outputDirectory);
+
+      // Parse all complete lines in a chunk of output. An incomplete last line is kept until the next chunk.
+      void feed(const char* data, size_t size);
+
+      // Parse the last line if output doesn't end with a line break
+      void finish();
+
+      // Errors found so far, without duplicates, in the order they are reported
+      inline const std::vector<Error>& getErrors() const { return errors; }
+
+      inline bool hasUnparsableLines() const { return unparsableLines; }
+
+    private:
+      // Parse a line without line break. Returns false if it looks like an error but can't be parsed.
+      bool parseLine(std::string_view line);
+
+      // Add an error unless the same one has been added
+      void addError(Error&& error);
+
+      // Private members
+      //
+      bool optimizeFlag;
+      std::wstring outputDirectory;
+
+      std::string pendingLine;
+      std::vector<Error> errors;
+      std::unordered_map<uint64_t, std::vector<size_t>> errorsByHash; // Indexes of errors with the same hash
+      bool unparsableLines {false};
+  };
+
+} // namespace
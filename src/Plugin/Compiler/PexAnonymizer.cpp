@@ -0,0 +1,146 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "PexAnonymizer.hpp"
+
+#include "..\Common\MappedFile.hpp"
+#include "..\Common\StringUtil.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <thread>
+
+namespace papyrus {
+
+  namespace {
+    // PEX file format (Skyrim & SSE in big endian, FO4 in little endian):
+    //   Signature:         4 bytes. Value: 0xFA57C0DE, stored in file's byte order
+    //   Major version:     1 byte. Value: 3
+    //   Minor version:     1 byte.
+    //   Game ID:           2 bytes.
+    //   Compilation time:  8 bytes.
+    //   Script path size:  2 bytes.
+    //   Script path:       n bytes.
+    //   User name size:    2 bytes.
+    //   User name:         n bytes.
+    //   Host name size:    2 bytes.
+    //   Host name:         n bytes.
+    constexpr unsigned char BIG_ENDIAN_SIGNATURE[] {0xFA, 0x57, 0xC0, 0xDE};
+    constexpr unsigned char LITTLE_ENDIAN_SIGNATURE[] {0xDE, 0xC0, 0x57, 0xFA};
+    constexpr unsigned char MAJOR_VERSION = 3;
+    constexpr size_t FIRST_FIELD_OFFSET = 16;
+    constexpr size_t ANONYMIZED_FIELDS = 3;
+  }
+
+  bool PexAnonymizer::anonymize(const std::wstring& filePath, std::wstring& errorMsg) {
+    utility::MappedFile file;
+    if (!file.open(filePath, true)) {
+      errorMsg = std::format(L"Can't open {} (error code {})", filePath, file.getErrorCode());
+      return false;
+    }
+
+    const unsigned char* data = file.data();
+    size_t size = file.size();
+    bool isBigEndian = (size >= FIRST_FIELD_OFFSET && std::memcmp(data, BIG_ENDIAN_SIGNATURE, 4) == 0);
+    bool isLittleEndian = (size >= FIRST_FIELD_OFFSET && std::memcmp(data, LITTLE_ENDIAN_SIGNATURE, 4) == 0);
+    if ((!isBigEndian && !isLittleEndian) || data[4] != MAJOR_VERSION) {
+      errorMsg = L"Unknown PEX file format: " + filePath;
+      return false;
+    }
+
+    // Locate all fields first, so a truncated file is left as is
+    size_t fieldOffsets[ANONYMIZED_FIELDS] {};
+    size_t fieldSizes[ANONYMIZED_FIELDS] {};
+    size_t offset = FIRST_FIELD_OFFSET;
+    for (size_t i = 0; i < ANONYMIZED_FIELDS; ++i) {
+      if (offset + 2 > size) {
+        errorMsg = L"Truncated PEX file: " + filePath;
+        return false;
+      }
+      fieldSizes[i] = isBigEndian ? (data[offset] << 8 | data[offset + 1]) : (data[offset + 1] << 8 | data[offset]);
+      fieldOffsets[i] = offset + 2;
+      offset = fieldOffsets[i] + fieldSizes[i];
+      if (offset > size) {
+        errorMsg = L"Truncated PEX file: " + filePath;
+        return false;
+      }
+    }
+
+    for (size_t i = 0; i < ANONYMIZED_FIELDS; ++i) {
+      std::memset(file.data() + fieldOffsets[i], '-', fieldSizes[i]);
+    }
+    return true;
+  }
+
+  AnonymizationReport PexAnonymizer::anonymize(const std::vector<std::wstring>& filePaths, size_t maxThreads) {
+    auto startTime = std::chrono::steady_clock::now();
+    AnonymizationReport report {
+      .total = filePaths.size(),
+      .errorMessages = std::vector<std::wstring>(filePaths.size())
+    };
+
+    // Each file is small, so threads take the next file from a shared counter rather than a fixed share of them
+    std::atomic<size_t> nextFile {0};
+    std::atomic<size_t> failed {0};
+    auto anonymizeFiles = [&]() {
+      for (size_t index = nextFile++; index < filePaths.size(); index = nextFile++) {
+        if (!anonymize(filePaths[index], report.errorMessages[index])) {
+          failed++;
+        }
+      }
+    };
+
+    size_t threadCount = std::min<size_t>((maxThreads > 0) ? maxThreads : std::max(1u, std::thread::hardware_concurrency()), filePaths.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i) {
+      try {
+        threads.emplace_back(anonymizeFiles);
+      } catch (const std::system_error&) {
+        // Remaining files are taken by the threads already running, including this one
+        break;
+      }
+    }
+    anonymizeFiles();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    report.failed = failed;
+    report.anonymized = report.total - report.failed;
+    report.elapsedTime = std::chrono::steady_clock::now() - startTime;
+    return report;
+  }
+
+  AnonymizationReport PexAnonymizer::anonymizeDirectory(const std::wstring& directory, size_t maxThreads) {
+    std::vector<std::wstring> filePaths;
+    std::error_code errorCode;
+    for (auto iter = std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, errorCode);
+      !errorCode && iter != std::filesystem::recursive_directory_iterator(); iter.increment(errorCode)) {
+      if (iter->is_regular_file(errorCode) && utility::compare(iter->path().extension().wstring(), L".pex")) {
+        filePaths.push_back(iter->path().wstring());
+      }
+    }
+    return anonymize(filePaths, maxThreads);
+  }
+
+} // namespace
@@ -0,0 +1,58 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace papyrus {
+
+  // Summary of anonymizing a set of PEX files
+  struct AnonymizationReport {
+    size_t total {0};
+    size_t anonymized {0};
+    size_t failed {0};
+    std::vector<std::wstring> errorMessages; // Same order as files, empty for files that were anonymized
+    std::chrono::steady_clock::duration elapsedTime {};
+
+    inline double filesPerSecond() const {
+      double seconds = std::chrono::duration<double>(elapsedTime).count();
+      return (seconds > 0) ? total / seconds : 0;
+    }
+  };
+
+  // Removes script path, user name and host name that compiler writes into PEX header, by overwriting them with dashes in a
+  // memory-mapped file. Field sizes are kept, so nothing else in the file moves, and the header is fully validated before
+  // anything is written, so a file that isn't a PEX file is never touched. Many files can be anonymized in parallel.
+  class PexAnonymizer {
+    public:
+      // Anonymize a PEX file in place. Returns false with an error message if the file can't be mapped, or isn't a PEX file.
+      static bool anonymize(const std::wstring& filePath, std::wstring& errorMsg);
+
+      // Anonymize PEX files on up to maxThreads threads (0 for all logical processors)
+      static AnonymizationReport anonymize(const std::vector<std::wstring>& filePaths, size_t maxThreads = 0);
+
+      // Anonymize all PEX files under a directory, including sub-directories
+      static AnonymizationReport anonymizeDirectory(const std::wstring& directory, size_t maxThreads = 0);
+  };
+
+} // namespace
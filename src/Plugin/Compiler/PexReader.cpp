@@ -0,0 +1,438 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "PexReader.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <format>
+
+namespace papyrus {
+
+  namespace {
+    constexpr unsigned char BIG_ENDIAN_SIGNATURE[] {0xFA, 0x57, 0xC0, 0xDE};
+    constexpr unsigned char LITTLE_ENDIAN_SIGNATURE[] {0xDE, 0xC0, 0x57, 0xFA};
+    constexpr uint8_t MAJOR_VERSION = 3;
+
+    // Number of fixed arguments of each opcode. Calls are followed by an integer argument count and that many arguments.
+    constexpr uint8_t OPCODE_ARGUMENTS[] {
+      0,                            // nop
+      3, 3, 3, 3, 3, 3, 3, 3, 3,    // iadd, fadd, isub, fsub, imul, fmul, idiv, fdiv, imod
+      2, 2, 2, 2, 2,                // not, ineg, fneg, assign, cast
+      3, 3, 3, 3, 3,                // cmp_eq, cmp_lt, cmp_le, cmp_gt, cmp_ge
+      1, 2, 2,                      // jmp, jmpt, jmpf
+      3, 2, 3,                      // callmethod, callparent, callstatic
+      1, 3, 3, 3,                   // return, strcat, propget, propset
+      2, 2, 3, 3, 4, 4,             // array_create, array_length, array_getelement, array_setelement, array_findelement, array_rfindelement
+      3, 1, 3, 3, 5, 5,             // FO4 only: is, struct_create, struct_get, struct_set, array_findstruct, array_rfindstruct
+      3, 3, 1, 3, 1                 // FO4 only: array_add, array_insert, array_removelast, array_remove, array_clear
+    };
+    constexpr uint8_t SKYRIM_OPCODES = 0x24;
+    constexpr uint8_t FIRST_CALL_OPCODE = 0x17;
+    constexpr uint8_t LAST_CALL_OPCODE = 0x19;
+  }
+
+  // Reads values in file's byte order. Reading past the end returns zeros and marks the cursor as failed, so bounds only need
+  // to be checked once after a group of reads.
+  class PexReader::Cursor {
+    public:
+      Cursor(std::span<const unsigned char> data, bool isBigEndian)
+        : data(data), isBigEndian(isBigEndian) {
+      }
+
+      inline bool failed() const { return outOfBounds; }
+      inline std::span<const unsigned char> remaining() const { return outOfBounds ? std::span<const unsigned char>() : data.subspan(position); }
+
+      std::span<const unsigned char> bytes(size_t size) {
+        if (outOfBounds || size > data.size() - position) {
+          outOfBounds = true;
+          return {};
+        }
+        auto result = data.subspan(position, size);
+        position += size;
+        return result;
+      }
+
+      inline uint8_t u8() {
+        auto value = bytes(1);
+        return value.empty() ? 0 : value[0];
+      }
+
+      inline uint16_t u16() { return static_cast<uint16_t>(read(2)); }
+      inline uint32_t u32() { return static_cast<uint32_t>(read(4)); }
+      inline uint64_t u64() { return read(8); }
+      inline float f32() { return std::bit_cast<float>(u32()); }
+
+    private:
+      uint64_t read(size_t size) {
+        auto value = bytes(size);
+        uint64_t result = 0;
+        for (size_t i = 0; i < value.size(); ++i) {
+          result |= static_cast<uint64_t>(value[isBigEndian ? i : value.size() - 1 - i]) << (8 * (value.size() - 1 - i));
+        }
+        return result;
+      }
+
+      // Private members
+      //
+      std::span<const unsigned char> data;
+      size_t position {0};
+      bool isBigEndian;
+      bool outOfBounds {false};
+  };
+
+  bool PexReader::open(const std::wstring& filePath) {
+    if (!file.open(filePath, false)) {
+      return fail(std::format(L"Can't open {} (error code {})", filePath, file.getErrorCode()));
+    }
+    if (!parse(std::span<const unsigned char>(file.data(), file.size()))) {
+      error += L": " + filePath;
+      return false;
+    }
+    return true;
+  }
+
+  bool PexReader::parse(std::span<const unsigned char> data) {
+    error.clear();
+    pexHeader = PexHeader();
+    stringTable.clear();
+    pexDebugInfo = PexDebugInfo();
+    pexUserFlags.clear();
+    pexObjects.clear();
+
+    // Header. Strings in it are not in string table.
+    if (data.size() < 4) {
+      return fail(L"Unknown PEX file format");
+    }
+    if (std::equal(std::begin(BIG_ENDIAN_SIGNATURE), std::end(BIG_ENDIAN_SIGNATURE), data.begin())) {
+      pexHeader.isBigEndian = true;
+    } else if (!std::equal(std::begin(LITTLE_ENDIAN_SIGNATURE), std::end(LITTLE_ENDIAN_SIGNATURE), data.begin())) {
+      return fail(L"Unknown PEX file format");
+    }
+
+    Cursor cursor(data.subspan(4), pexHeader.isBigEndian);
+    pexHeader.majorVersion = cursor.u8();
+    pexHeader.minorVersion = cursor.u8();
+    pexHeader.gameID = cursor.u16();
+    pexHeader.compilationTime = cursor.u64();
+    for (auto* field : {&pexHeader.sourceFileName, &pexHeader.userName, &pexHeader.machineName}) {
+      auto size = cursor.u16();
+      auto bytes = cursor.bytes(size);
+      *field = std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    if (cursor.failed()) {
+      return fail(L"Truncated PEX header");
+    }
+    if (pexHeader.majorVersion != MAJOR_VERSION || (pexHeader.gameID != SKYRIM_GAME_ID && pexHeader.gameID != FALLOUT4_GAME_ID)) {
+      return fail(std::format(L"Unsupported PEX version {}.{} for game {}", pexHeader.majorVersion, pexHeader.minorVersion, pexHeader.gameID));
+    }
+
+    // String table, which the rest of the file refers to by index
+    stringTable.resize(cursor.u16());
+    for (auto& string : stringTable) {
+      auto size = cursor.u16();
+      auto bytes = cursor.bytes(size);
+      string = std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    if (cursor.failed()) {
+      return fail(L"Truncated string table");
+    }
+
+    if (!readDebugInfo(cursor)) {
+      return false;
+    }
+
+    pexUserFlags.resize(cursor.u16());
+    for (auto& userFlag : pexUserFlags) {
+      if (!readString(cursor, userFlag.name)) {
+        return fail(L"Invalid user flags");
+      }
+      userFlag.flagIndex = cursor.u8();
+    }
+
+    pexObjects.resize(cursor.u16());
+    for (auto& object : pexObjects) {
+      if (!readObject(cursor, object)) {
+        return fail(L"Invalid object");
+      }
+    }
+    if (cursor.failed()) {
+      return fail(L"Truncated PEX file");
+    }
+    return true;
+  }
+
+  bool PexReader::decodeInstructions(const PexFunction& function, std::vector<PexInstruction>& instructions) const {
+    instructions.resize(function.instructionCount);
+    Cursor cursor(function.code, pexHeader.isBigEndian);
+    for (auto& instruction : instructions) {
+      if (!readInstruction(cursor, &instruction)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Private methods
+  //
+
+  bool PexReader::readString(Cursor& cursor, std::string_view& string) const {
+    auto index = cursor.u16();
+    if (cursor.failed() || index >= stringTable.size()) {
+      return false;
+    }
+    string = stringTable[index];
+    return true;
+  }
+
+  bool PexReader::readValue(Cursor& cursor, PexValue& value) const {
+    value.type = static_cast<PexValueType>(cursor.u8());
+    switch (value.type) {
+      case PexValueType::None:
+        return !cursor.failed();
+
+      case PexValueType::Identifier:
+      case PexValueType::String:
+        return readString(cursor, value.string);
+
+      case PexValueType::Integer:
+        value.integer = static_cast<int32_t>(cursor.u32());
+        return !cursor.failed();
+
+      case PexValueType::Float:
+        value.floatValue = cursor.f32();
+        return !cursor.failed();
+
+      case PexValueType::Bool:
+        value.boolValue = (cursor.u8() != 0);
+        return !cursor.failed();
+
+      default:
+        return false;
+    }
+  }
+
+  bool PexReader::readInstruction(Cursor& cursor, PexInstruction* instruction) const {
+    // Instructions are skipped over while parsing, in which case arguments are read into a throwaway value
+    PexValue argument;
+    uint8_t opcode = cursor.u8();
+    if (cursor.failed() || opcode >= (hasFallout4Layout() ? std::size(OPCODE_ARGUMENTS) : SKYRIM_OPCODES)) {
+      return false;
+    }
+
+    size_t argumentCount = OPCODE_ARGUMENTS[opcode];
+    if (instruction != nullptr) {
+      instruction->opcode = opcode;
+      instruction->arguments.clear();
+    }
+    for (size_t i = 0; i < argumentCount; ++i) {
+      if (!readValue(cursor, argument)) {
+        return false;
+      }
+      if (instruction != nullptr) {
+        instruction->arguments.push_back(argument);
+      }
+
+      // Calls have variable arguments, with their count as an integer after the fixed ones
+      if (i + 1 == OPCODE_ARGUMENTS[opcode] && opcode >= FIRST_CALL_OPCODE && opcode <= LAST_CALL_OPCODE) {
+        if (!readValue(cursor, argument) || argument.type != PexValueType::Integer || argument.integer < 0) {
+          return false;
+        }
+        argumentCount += static_cast<size_t>(argument.integer);
+      }
+    }
+    return true;
+  }
+
+  bool PexReader::readFunction(Cursor& cursor, PexFunction& function) const {
+    if (!readString(cursor, function.returnType) || !readString(cursor, function.docString)) {
+      return false;
+    }
+    function.userFlags = cursor.u32();
+    function.flags = cursor.u8();
+    for (auto* parameters : {&function.parameters, &function.locals}) {
+      parameters->resize(cursor.u16());
+      for (auto& parameter : *parameters) {
+        if (!readString(cursor, parameter.name) || !readString(cursor, parameter.typeName)) {
+          return false;
+        }
+      }
+    }
+
+    // Walk over instructions to find where they end
+    function.instructionCount = cursor.u16();
+    auto code = cursor.remaining();
+    for (uint16_t i = 0; i < function.instructionCount; ++i) {
+      if (!readInstruction(cursor, nullptr)) {
+        return false;
+      }
+    }
+    function.code = code.first(code.size() - cursor.remaining().size());
+    return true;
+  }
+
+  bool PexReader::readDebugInfo(Cursor& cursor) {
+    pexDebugInfo.hasDebugInfo = (cursor.u8() != 0);
+    if (!pexDebugInfo.hasDebugInfo) {
+      return cursor.failed() ? fail(L"Truncated debug info") : true;
+    }
+
+    pexDebugInfo.modificationTime = cursor.u64();
+    pexDebugInfo.functions.resize(cursor.u16());
+    for (auto& function : pexDebugInfo.functions) {
+      if (!readString(cursor, function.objectName) || !readString(cursor, function.stateName) || !readString(cursor, function.functionName)) {
+        return fail(L"Invalid function debug info");
+      }
+      function.functionType = cursor.u8();
+      uint16_t lineCount = cursor.u16();
+      auto lines = cursor.bytes(lineCount * size_t(2));
+      function.lineNumbers = PexUint16Array(lines.data(), lines.size() / 2, pexHeader.isBigEndian);
+    }
+
+    if (hasFallout4Layout()) {
+      pexDebugInfo.propertyGroups.resize(cursor.u16());
+      for (auto& propertyGroup : pexDebugInfo.propertyGroups) {
+        if (!readString(cursor, propertyGroup.objectName) || !readString(cursor, propertyGroup.name) || !readString(cursor, propertyGroup.docString)) {
+          return fail(L"Invalid property group debug info");
+        }
+        propertyGroup.userFlags = cursor.u32();
+        propertyGroup.propertyNames.resize(cursor.u16());
+        for (auto& propertyName : propertyGroup.propertyNames) {
+          if (!readString(cursor, propertyName)) {
+            return fail(L"Invalid property group debug info");
+          }
+        }
+      }
+
+      pexDebugInfo.structOrders.resize(cursor.u16());
+      for (auto& structOrder : pexDebugInfo.structOrders) {
+        if (!readString(cursor, structOrder.objectName) || !readString(cursor, structOrder.name)) {
+          return fail(L"Invalid struct order debug info");
+        }
+        structOrder.memberNames.resize(cursor.u16());
+        for (auto& memberName : structOrder.memberNames) {
+          if (!readString(cursor, memberName)) {
+            return fail(L"Invalid struct order debug info");
+          }
+        }
+      }
+    }
+    return cursor.failed() ? fail(L"Truncated debug info") : true;
+  }
+
+  bool PexReader::readObject(Cursor& cursor, PexObject& object) const {
+    if (!readString(cursor, object.name)) {
+      return false;
+    }
+    cursor.u32(); // Size of object data, not needed as everything is parsed anyway
+    if (!readString(cursor, object.parentClassName) || !readString(cursor, object.docString)) {
+      return false;
+    }
+    if (hasFallout4Layout()) {
+      object.isConst = (cursor.u8() != 0);
+    }
+    object.userFlags = cursor.u32();
+    if (!readString(cursor, object.autoStateName)) {
+      return false;
+    }
+
+    if (hasFallout4Layout()) {
+      object.structs.resize(cursor.u16());
+      for (auto& pexStruct : object.structs) {
+        if (!readString(cursor, pexStruct.name)) {
+          return false;
+        }
+        pexStruct.members.resize(cursor.u16());
+        for (auto& member : pexStruct.members) {
+          if (!readString(cursor, member.name) || !readString(cursor, member.typeName)) {
+            return false;
+          }
+          member.userFlags = cursor.u32();
+          if (!readValue(cursor, member.initialValue)) {
+            return false;
+          }
+          member.isConst = (cursor.u8() != 0);
+          if (!readString(cursor, member.docString)) {
+            return false;
+          }
+        }
+      }
+    }
+
+    object.variables.resize(cursor.u16());
+    for (auto& variable : object.variables) {
+      if (!readString(cursor, variable.name) || !readString(cursor, variable.typeName)) {
+        return false;
+      }
+      variable.userFlags = cursor.u32();
+      if (!readValue(cursor, variable.initialValue)) {
+        return false;
+      }
+      if (hasFallout4Layout()) {
+        variable.isConst = (cursor.u8() != 0);
+      }
+    }
+
+    object.properties.resize(cursor.u16());
+    for (auto& property : object.properties) {
+      if (!readString(cursor, property.name) || !readString(cursor, property.typeName) || !readString(cursor, property.docString)) {
+        return false;
+      }
+      property.userFlags = cursor.u32();
+      property.flags = cursor.u8();
+      if (property.isAuto()) {
+        if (!readString(cursor, property.autoVariableName)) {
+          return false;
+        }
+      } else {
+        // Handlers of full properties. Auto properties have none, even though their read and write flags are set.
+        property.hasReadHandler = property.isRead();
+        if (property.hasReadHandler && !readFunction(cursor, property.readHandler)) {
+          return false;
+        }
+        property.hasWriteHandler = property.isWrite();
+        if (property.hasWriteHandler && !readFunction(cursor, property.writeHandler)) {
+          return false;
+        }
+      }
+    }
+
+    object.states.resize(cursor.u16());
+    for (auto& state : object.states) {
+      if (!readString(cursor, state.name)) {
+        return false;
+      }
+      state.functions.resize(cursor.u16());
+      for (auto& function : state.functions) {
+        if (!readString(cursor, function.name) || !readFunction(cursor, function)) {
+          return false;
+        }
+      }
+    }
+    return !cursor.failed();
+  }
+
+  bool PexReader::fail(const std::wstring& message) {
+    error = message;
+    return false;
+  }
+
+} // namespace
@@ -0,0 +1,259 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "..\Common\MappedFile.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace papyrus {
+
+  constexpr uint16_t SKYRIM_GAME_ID = 1;
+  constexpr uint16_t FALLOUT4_GAME_ID = 2;
+
+  // Strings in PEX files are all views into the file, and can't outlive the reader that returned them
+  //
+
+  enum class PexValueType : uint8_t {
+    None,
+    Identifier,
+    String,
+    Integer,
+    Float,
+    Bool
+  };
+
+  struct PexValue {
+    PexValueType type {PexValueType::None};
+    std::string_view string; // Identifier and String
+    int32_t integer {0};
+    float floatValue {0};
+    bool boolValue {false};
+  };
+
+  // Array of 16-bit integers in file's byte order, e.g. line numbers of a function
+  class PexUint16Array {
+    public:
+      PexUint16Array() = default;
+      PexUint16Array(const unsigned char* data, size_t count, bool isBigEndian)
+        : data(data), count(count), isBigEndian(isBigEndian) {
+      }
+
+      inline size_t size() const { return count; }
+      inline uint16_t operator[](size_t index) const {
+        const unsigned char* bytes = data + index * 2;
+        return static_cast<uint16_t>(isBigEndian ? (bytes[0] << 8 | bytes[1]) : (bytes[1] << 8 | bytes[0]));
+      }
+
+    private:
+      const unsigned char* data {nullptr};
+      size_t count {0};
+      bool isBigEndian {false};
+  };
+
+  struct PexHeader {
+    bool isBigEndian {false};     // Skyrim & SSE use big endian, FO4 uses little endian
+    uint8_t majorVersion {0};
+    uint8_t minorVersion {0};
+    uint16_t gameID {0};          // SKYRIM_GAME_ID or FALLOUT4_GAME_ID
+    uint64_t compilationTime {0};
+    std::string_view sourceFileName;
+    std::string_view userName;
+    std::string_view machineName;
+  };
+
+  struct PexFunctionDebugInfo {
+    std::string_view objectName;
+    std::string_view stateName;
+    std::string_view functionName;
+    uint8_t functionType {0};     // 0: regular function, 1: property getter, 2: property setter
+    PexUint16Array lineNumbers;   // Source line of each instruction
+  };
+
+  // FO4 only
+  struct PexPropertyGroup {
+    std::string_view objectName;
+    std::string_view name;
+    std::string_view docString;
+    uint32_t userFlags {0};
+    std::vector<std::string_view> propertyNames;
+  };
+
+  // FO4 only
+  struct PexStructOrder {
+    std::string_view objectName;
+    std::string_view name;
+    std::vector<std::string_view> memberNames;
+  };
+
+  struct PexDebugInfo {
+    bool hasDebugInfo {false};
+    uint64_t modificationTime {0};
+    std::vector<PexFunctionDebugInfo> functions;
+    std::vector<PexPropertyGroup> propertyGroups;
+    std::vector<PexStructOrder> structOrders;
+  };
+
+  struct PexUserFlag {
+    std::string_view name;
+    uint8_t flagIndex {0};        // Bit of the flag in user flags of objects, properties, variables and functions
+  };
+
+  // A name and type pair, used for both parameters and local variables of functions
+  struct PexParameter {
+    std::string_view name;
+    std::string_view typeName;
+  };
+
+  struct PexFunction {
+    std::string_view name;        // Empty for property handlers
+    std::string_view returnType;
+    std::string_view docString;
+    uint32_t userFlags {0};
+    uint8_t flags {0};
+    std::vector<PexParameter> parameters;
+    std::vector<PexParameter> locals;
+    uint16_t instructionCount {0};
+    std::span<const unsigned char> code; // Instructions as they are in the file. Use PexReader::decodeInstructions() to read them.
+
+    inline bool isGlobal() const { return (flags & 0x01) != 0; }
+    inline bool isNative() const { return (flags & 0x02) != 0; }
+  };
+
+  struct PexInstruction {
+    uint8_t opcode {0};
+    std::vector<PexValue> arguments; // Fixed arguments of the opcode, followed by variable arguments of calls
+  };
+
+  struct PexVariable {
+    std::string_view name;
+    std::string_view typeName;
+    uint32_t userFlags {0};
+    PexValue initialValue;
+    bool isConst {false};         // FO4 only
+  };
+
+  struct PexProperty {
+    std::string_view name;
+    std::string_view typeName;
+    std::string_view docString;
+    uint32_t userFlags {0};
+    uint8_t flags {0};
+    std::string_view autoVariableName; // Auto properties only
+    bool hasReadHandler {false};
+    PexFunction readHandler;
+    bool hasWriteHandler {false};
+    PexFunction writeHandler;
+
+    inline bool isRead() const { return (flags & 0x01) != 0; }
+    inline bool isWrite() const { return (flags & 0x02) != 0; }
+    inline bool isAuto() const { return (flags & 0x04) != 0; }
+  };
+
+  struct PexState {
+    std::string_view name;        // Empty for the default state
+    std::vector<PexFunction> functions;
+  };
+
+  // FO4 only
+  struct PexStructMember {
+    std::string_view name;
+    std::string_view typeName;
+    uint32_t userFlags {0};
+    PexValue initialValue;
+    bool isConst {false};
+    std::string_view docString;
+  };
+
+  // FO4 only
+  struct PexStruct {
+    std::string_view name;
+    std::vector<PexStructMember> members;
+  };
+
+  struct PexObject {
+    std::string_view name;
+    std::string_view parentClassName;
+    std::string_view docString;
+    bool isConst {false};         // FO4 only
+    uint32_t userFlags {0};
+    std::string_view autoStateName;
+    std::vector<PexStruct> structs;
+    std::vector<PexVariable> variables;
+    std::vector<PexProperty> properties;
+    std::vector<PexState> states;
+  };
+
+  // Read-only parser of compiled Papyrus scripts of Skyrim, Skyrim SE and Fallout 4. A file is memory-mapped and parsed in one
+  // pass, without copying any of its strings or code: names, string values, line numbers and instructions all point into the
+  // mapping. Instructions are only skipped over while parsing, and decoded on demand. Everything is validated against the
+  // bounds of the file, so a truncated or corrupt file fails to parse instead of being read past its end.
+  class PexReader {
+    public:
+      // Map and parse a PEX file. Returns false if the file can't be mapped or parsed, with an error message available.
+      bool open(const std::wstring& filePath);
+
+      // Parse PEX data that is already in memory. Data must outlive the reader.
+      bool parse(std::span<const unsigned char> data);
+
+      inline const std::wstring& getError() const { return error; }
+
+      inline const PexHeader& header() const { return pexHeader; }
+      inline const std::vector<std::string_view>& strings() const { return stringTable; }
+      inline const PexDebugInfo& debugInfo() const { return pexDebugInfo; }
+      inline const std::vector<PexUserFlag>& userFlags() const { return pexUserFlags; }
+      inline const std::vector<PexObject>& objects() const { return pexObjects; }
+
+      // Decode instructions of a function that was returned by this reader. Returns false if they can't be decoded.
+      bool decodeInstructions(const PexFunction& function, std::vector<PexInstruction>& instructions) const;
+
+    private:
+      class Cursor;
+
+      bool readString(Cursor& cursor, std::string_view& string) const;
+      bool readValue(Cursor& cursor, PexValue& value) const;
+      bool readInstruction(Cursor& cursor, PexInstruction* instruction) const;
+      bool readFunction(Cursor& cursor, PexFunction& function) const;
+      bool readDebugInfo(Cursor& cursor);
+      bool readObject(Cursor& cursor, PexObject& object) const;
+
+      // Whether file has FO4 additions, e.g. structs and property groups
+      inline bool hasFallout4Layout() const { return pexHeader.gameID == FALLOUT4_GAME_ID; }
+
+      bool fail(const std::wstring& message);
+
+      // Private members
+      //
+      utility::MappedFile file;
+      std::wstring error;
+
+      PexHeader pexHeader;
+      std::vector<std::string_view> stringTable;
+      PexDebugInfo pexDebugInfo;
+      std::vector<PexUserFlag> pexUserFlags;
+      std::vector<PexObject> pexObjects;
+  };
+
+} // namespace
@@ -0,0 +1,388 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ProcessLauncher.hpp"
+
+#include "..\..\external\gsl\include\gsl\util"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <filesystem>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace papyrus {
+
+  using Lock = std::lock_guard<std::mutex>;
+
+  constexpr unsigned long PIPE_BUFFER_SIZE = 64 * 1024;  // Suggested size of each pipe's buffer
+  constexpr size_t READ_BUFFER_SIZE = 64 * 1024;         // Size of the buffer each stream is read into
+  constexpr int POLL_INTERVAL_MS = 100;                  // How often a running process is checked for cancellation and timeout
+
+  bool ProcessLauncher::run(const ProcessCommand& command, const output_callback_t& onOutput, std::chrono::milliseconds timeout) {
+    end = ProcessEnd::Exited;
+    exitCode = 0;
+    failedCall = nullptr;
+    errorCode = 0;
+    hasDeadline = (timeout > std::chrono::milliseconds::zero());
+    deadline = std::chrono::steady_clock::now() + timeout;
+    if (shouldStop()) {
+      return true;
+    }
+
+    std::mutex outputMutex;
+    output_callback_t serializedOnOutput = [&](ProcessStream stream, const char* data, size_t size) {
+      Lock lock(outputMutex);
+      onOutput(stream, data, size);
+    };
+
+#ifdef _WIN32
+    // Only the write ends are inherited by child process. Read ends stay with this process.
+    HANDLE outputReadHandle {};
+    HANDLE outputWriteHandle {};
+    HANDLE errorReadHandle {};
+    HANDLE errorWriteHandle {};
+    HANDLE job {};
+    auto autoCleanup = gsl::finally([&] {
+      for (HANDLE handle : {outputReadHandle, outputWriteHandle, errorReadHandle, errorWriteHandle, job}) {
+        if (handle) {
+          ::CloseHandle(handle);
+        }
+      }
+    });
+
+    SECURITY_ATTRIBUTES attr {
+      .nLength = sizeof(SECURITY_ATTRIBUTES),
+      .bInheritHandle = TRUE
+    };
+    if (!::CreatePipe(&outputReadHandle, &outputWriteHandle, &attr, PIPE_BUFFER_SIZE) || !::CreatePipe(&errorReadHandle, &errorWriteHandle, &attr, PIPE_BUFFER_SIZE)) {
+      return fail(L"CreatePipe");
+    }
+    if (!::SetHandleInformation(outputReadHandle, HANDLE_FLAG_INHERIT, 0) || !::SetHandleInformation(errorReadHandle, HANDLE_FLAG_INHERIT, 0)) {
+      return fail(L"SetHandleInformation");
+    }
+
+    // Processes in the job, including any the process creates, are killed when job is terminated or closed
+    job = ::CreateJobObject(nullptr, nullptr);
+    if (!job) {
+      return fail(L"CreateJobObject");
+    }
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimits {};
+    jobLimits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    if (!::SetInformationJobObject(job, JobObjectExtendedLimitInformation, &jobLimits, sizeof(jobLimits))) {
+      return fail(L"SetInformationJobObject");
+    }
+
+    // Process inherits its own write ends only. Inheriting every inheritable handle would hand it the write ends of processes
+    // launched concurrently by other threads as well, and their pipes wouldn't close until this process exits.
+    SIZE_T attributeListSize {};
+    ::InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeListSize);
+    std::vector<char> attributeListBuffer(attributeListSize);
+    auto attributeList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeListBuffer.data());
+    if (!::InitializeProcThreadAttributeList(attributeList, 1, 0, &attributeListSize)) {
+      return fail(L"InitializeProcThreadAttributeList");
+    }
+    auto attributeListCleanup = gsl::finally([&] { ::DeleteProcThreadAttributeList(attributeList); });
+    HANDLE inheritedHandles[] {outputWriteHandle, errorWriteHandle};
+    if (!::UpdateProcThreadAttribute(attributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, inheritedHandles, sizeof(inheritedHandles), nullptr, nullptr)) {
+      return fail(L"UpdateProcThreadAttribute");
+    }
+
+    // Process is created suspended, so it can't start any child process before it's in the job
+    STARTUPINFOEX startupInfo {
+      .StartupInfo = {
+        .cb = sizeof(STARTUPINFOEX),
+        .dwFlags = STARTF_USESTDHANDLES,
+        .hStdOutput = outputWriteHandle,
+        .hStdError = errorWriteHandle
+      },
+      .lpAttributeList = attributeList
+    };
+    PROCESS_INFORMATION processInfo {};
+    std::wstring commandLine = buildCommandLine(command);
+    LPCWSTR workingDirectory = command.workingDirectory.empty() ? nullptr : command.workingDirectory.c_str();
+    DWORD creationFlags = CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT | CREATE_SUSPENDED | EXTENDED_STARTUPINFO_PRESENT;
+    if (!::CreateProcess(nullptr, commandLine.data(), nullptr, nullptr, TRUE, creationFlags, nullptr, workingDirectory, &startupInfo.StartupInfo, &processInfo)) {
+      return fail(L"CreateProcess");
+    }
+    auto processCleanup = gsl::finally([&] {
+      ::CloseHandle(processInfo.hProcess);
+      ::CloseHandle(processInfo.hThread);
+    });
+    if (!::AssignProcessToJobObject(job, processInfo.hProcess)) {
+      fail(L"AssignProcessToJobObject");
+      ::TerminateProcess(processInfo.hProcess, 1);
+      return false;
+    }
+    ::ResumeThread(processInfo.hThread);
+
+    // Close write ends held by this process, so reading ends once child processes have closed their own
+    ::CloseHandle(outputWriteHandle);
+    outputWriteHandle = nullptr;
+    ::CloseHandle(errorWriteHandle);
+    errorWriteHandle = nullptr;
+
+    // Whatever is left of the process tree is killed before readers are joined, so they never wait on a pipe held open by it
+    std::vector<std::thread> readers;
+    auto readersCleanup = gsl::finally([&] {
+      ::TerminateJobObject(job, 1);
+      for (auto& reader : readers) {
+        reader.join();
+      }
+    });
+    readers.emplace_back([&] { readPipe(outputReadHandle, ProcessStream::Output, serializedOnOutput); });
+    readers.emplace_back([&] { readPipe(errorReadHandle, ProcessStream::Error, serializedOnOutput); });
+
+    DWORD waitResult {};
+    while ((waitResult = ::WaitForSingleObject(processInfo.hProcess, POLL_INTERVAL_MS)) == WAIT_TIMEOUT) {
+      if (shouldStop()) {
+        ::TerminateJobObject(job, 1);
+        ::WaitForSingleObject(processInfo.hProcess, INFINITE);
+        return true;
+      }
+    }
+    if (waitResult == WAIT_FAILED) {
+      return fail(L"WaitForSingleObject");
+    }
+
+    DWORD processExitCode {};
+    if (!::GetExitCodeProcess(processInfo.hProcess, &processExitCode)) {
+      return fail(L"GetExitCodeProcess");
+    }
+    exitCode = static_cast<int>(processExitCode);
+    return true;
+#else
+    int outputPipe[2] {-1, -1};
+    int errorPipe[2] {-1, -1};
+    auto autoCleanup = gsl::finally([&] {
+      for (int fd : {outputPipe[0], outputPipe[1], errorPipe[0], errorPipe[1]}) {
+        if (fd >= 0) {
+          ::close(fd);
+        }
+      }
+    });
+    // Pipes are closed on exec, so processes launched concurrently by other threads don't inherit them and keep them open.
+    // The ends dup'ed onto stdout and stderr of this process are not.
+    if (::pipe2(outputPipe, O_CLOEXEC) != 0 || ::pipe2(errorPipe, O_CLOEXEC) != 0) {
+      return fail(L"pipe2");
+    }
+
+    // Arguments are passed as UTF-8
+    auto toUtf8 = [](const std::wstring& str) {
+      auto utf8Str = std::filesystem::path(str).u8string();
+      return std::string(utf8Str.begin(), utf8Str.end());
+    };
+    std::vector<std::string> arguments {toUtf8(command.program)};
+    for (const auto& argument : command.arguments) {
+      arguments.push_back(toUtf8(argument));
+    }
+    std::istringstream extraArguments(toUtf8(command.extraArguments));
+    for (std::string argument; extraArguments >> argument;) {
+      arguments.push_back(argument);
+    }
+    std::vector<char*> argv;
+    for (auto& argument : arguments) {
+      argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t fileActions;
+    ::posix_spawn_file_actions_init(&fileActions);
+    auto fileActionsCleanup = gsl::finally([&] { ::posix_spawn_file_actions_destroy(&fileActions); });
+    ::posix_spawn_file_actions_adddup2(&fileActions, outputPipe[1], STDOUT_FILENO);
+    ::posix_spawn_file_actions_adddup2(&fileActions, errorPipe[1], STDERR_FILENO);
+    std::string workingDirectory = toUtf8(command.workingDirectory);
+    if (!workingDirectory.empty()) {
+      ::posix_spawn_file_actions_addchdir_np(&fileActions, workingDirectory.c_str());
+    }
+
+    // Process gets a process group of its own, which any child process it creates joins as well
+    posix_spawnattr_t attributes;
+    ::posix_spawnattr_init(&attributes);
+    auto attributesCleanup = gsl::finally([&] { ::posix_spawnattr_destroy(&attributes); });
+    ::posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    ::posix_spawnattr_setpgroup(&attributes, 0);
+
+    pid_t pid {};
+    int result = ::posix_spawnp(&pid, argv[0], &fileActions, &attributes, argv.data(), environ);
+    if (result != 0) {
+      errno = result;
+      return fail(L"posix_spawnp");
+    }
+    processGroup = pid;
+
+    // Close write ends held by this process, so reading ends once child processes have closed their own
+    ::close(outputPipe[1]);
+    outputPipe[1] = -1;
+    ::close(errorPipe[1]);
+    errorPipe[1] = -1;
+
+    readPipes(outputPipe[0], errorPipe[0], serializedOnOutput);
+
+    int status {};
+    while (true) {
+      pid_t waitResult = ::waitpid(pid, &status, WNOHANG);
+      if (waitResult == pid) {
+        break;
+      }
+      if (waitResult < 0 && errno != EINTR) {
+        killProcessGroup();
+        return fail(L"waitpid");
+      }
+      if (shouldStop()) {
+        killProcessGroup();
+        ::waitpid(pid, &status, 0);
+        return true;
+      }
+      ::poll(nullptr, 0, POLL_INTERVAL_MS);
+    }
+
+    // Child processes left behind would otherwise keep running
+    killProcessGroup();
+    if (end == ProcessEnd::Exited) {
+      exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+    return true;
+#endif
+  }
+
+  // Private methods
+  //
+
+#ifdef _WIN32
+  std::wstring ProcessLauncher::buildCommandLine(const ProcessCommand& command) {
+    std::wstring commandLine;
+    auto appendArgument = [&](const std::wstring& argument) {
+      if (!commandLine.empty()) {
+        commandLine += L' ';
+      }
+      if (!argument.empty() && argument.find_first_of(L" \t\"") == std::wstring::npos) {
+        commandLine += argument;
+        return;
+      }
+
+      // Backslashes are only special right before a quote, where each of them needs to be escaped
+      commandLine += L'"';
+      size_t backslashes = 0;
+      for (wchar_t ch : argument) {
+        if (ch == L'\\') {
+          backslashes++;
+        } else {
+          if (ch == L'"') {
+            commandLine.append(backslashes + 1, L'\\');
+          }
+          backslashes = 0;
+        }
+        commandLine += ch;
+      }
+      commandLine.append(backslashes, L'\\');
+      commandLine += L'"';
+    };
+
+    appendArgument(command.program);
+    for (const auto& argument : command.arguments) {
+      appendArgument(argument);
+    }
+    if (!command.extraArguments.empty()) {
+      commandLine += L' ' + command.extraArguments;
+    }
+    return commandLine;
+  }
+
+  void ProcessLauncher::readPipe(HANDLE pipe, ProcessStream stream, const output_callback_t& onOutput) {
+    char buffer[READ_BUFFER_SIZE];
+    DWORD size {};
+    while (::ReadFile(pipe, buffer, sizeof(buffer), &size, nullptr) && size > 0) {
+      onOutput(stream, buffer, size);
+    }
+  }
+#else
+  void ProcessLauncher::readPipes(int outputPipe, int errorPipe, const output_callback_t& onOutput) {
+    char buffer[READ_BUFFER_SIZE];
+    pollfd pipes[] {
+      {.fd = outputPipe, .events = POLLIN},
+      {.fd = errorPipe, .events = POLLIN}
+    };
+    while (pipes[0].fd >= 0 || pipes[1].fd >= 0) {
+      if (shouldStop()) {
+        killProcessGroup();
+        return;
+      }
+
+      int result = ::poll(pipes, 2, POLL_INTERVAL_MS);
+      if (result < 0 && errno != EINTR) {
+        return;
+      }
+
+      for (size_t i = 0; i < 2 && result > 0; ++i) {
+        if (pipes[i].fd >= 0 && (pipes[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+          ssize_t size = ::read(pipes[i].fd, buffer, sizeof(buffer));
+          if (size > 0) {
+            onOutput(i == 0 ? ProcessStream::Output : ProcessStream::Error, buffer, static_cast<size_t>(size));
+          } else if (size == 0 || errno != EINTR) {
+            // Negative file descriptors are ignored by poll
+            pipes[i].fd = -1;
+          }
+        }
+      }
+    }
+  }
+
+  void ProcessLauncher::killProcessGroup() {
+    if (processGroup > 0) {
+      ::kill(-processGroup, SIGKILL);
+    }
+  }
+#endif
+
+  bool ProcessLauncher::shouldStop() {
+    if (end == ProcessEnd::Exited) {
+      if (cancelled) {
+        end = ProcessEnd::Cancelled;
+      } else if (hasDeadline && std::chrono::steady_clock::now() >= deadline) {
+        end = ProcessEnd::TimedOut;
+      }
+    }
+    return end != ProcessEnd::Exited;
+  }
+
+  bool ProcessLauncher::fail(const wchar_t* call) {
+    failedCall = call;
+#ifdef _WIN32
+    errorCode = ::GetLastError();
+#else
+    errorCode = static_cast<unsigned long>(errno);
+#endif
+    return false;
+  }
+
+} // namespace
@@ -0,0 +1,116 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+namespace papyrus {
+
+  // A process to launch, with arguments quoted as needed for the platform
+  struct ProcessCommand {
+    std::wstring program;
+    std::vector<std::wstring> arguments;
+    std::wstring extraArguments; // User provided arguments. Appended to command line as is on Windows, split by white spaces elsewhere.
+    std::wstring workingDirectory;
+  };
+
+  enum class ProcessStream {
+    Output,
+    Error
+  };
+
+  // How a process that was run came to an end
+  enum class ProcessEnd {
+    Exited,
+    Cancelled,
+    TimedOut
+  };
+
+  // Launches a process and reads its stdout and stderr concurrently while it runs, so a process that writes a lot of output is
+  // never blocked on a full pipe. Output is read in chunks into small fixed-size buffers that are reused, and each chunk is
+  // handed to a callback as soon as it's read. Windows processes are created with CreateProcess in a job object, others with
+  // posix_spawn in a process group of their own, so the whole process tree can be killed when the process is cancelled or
+  // runs out of time. Either way, running a process never blocks forever.
+  class ProcessLauncher {
+    public:
+      // Called with each chunk of output. Calls are serialized even though the streams are read on different threads.
+      using output_callback_t = std::function<void(ProcessStream stream, const char* data, size_t size)>;
+
+      // Run the process until it exits and both output streams are drained, or until it's cancelled or has run longer than
+      // timeout (no limit if 0), in which case the process tree is killed. Returns false if the process can't be run, in which
+      // case the failed system call and its error code are available.
+      bool run(const ProcessCommand& command, const output_callback_t& onOutput, std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+
+      // Stop the process from another thread. If the process hasn't started yet, it won't be.
+      inline void cancel() { cancelled = true; }
+      inline bool isCancelled() const { return cancelled; }
+
+      inline ProcessEnd getEnd() const { return end; }
+      inline int getExitCode() const { return exitCode; }
+      inline const wchar_t* getFailedCall() const { return failedCall; }
+      inline unsigned long getErrorCode() const { return errorCode; }
+
+    private:
+#ifdef _WIN32
+      // Build a command line that CommandLineToArgvW parses back into the same arguments
+      static std::wstring buildCommandLine(const ProcessCommand& command);
+
+      // Read a pipe until it's closed
+      static void readPipe(HANDLE pipe, ProcessStream stream, const output_callback_t& onOutput);
+#else
+      // Read both pipes until they are closed, or process should be stopped
+      void readPipes(int outputPipe, int errorPipe, const output_callback_t& onOutput);
+
+      // Kill the whole process group
+      void killProcessGroup();
+#endif
+
+      // Check whether process has been cancelled or has run out of time. If so, how it ends is recorded.
+      bool shouldStop();
+
+      // Record the system call that failed, along with last error code
+      bool fail(const wchar_t* call);
+
+      // Private members
+      //
+      std::atomic<bool> cancelled {false};
+      std::chrono::steady_clock::time_point deadline;
+      bool hasDeadline {false};
+#ifndef _WIN32
+      pid_t processGroup {0};
+#endif
+
+      ProcessEnd end {ProcessEnd::Exited};
+      int exitCode {0};
+      const wchar_t* failedCall {nullptr};
+      unsigned long errorCode {0};
+  };
+
+} // namespace
@@ -0,0 +1,159 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AutoIndenter.hpp"
+
+#include "..\Common\StringUtil.hpp"
+#include "..\Lexer\Lexer.hpp"
+
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace papyrus {
+
+  namespace {
+    constexpr npp_position_t MAX_OUTDENT_KEYWORD_LENGTH = 11; // "EndFunction" and "EndProperty"
+  }
+
+  void AutoIndenter::handleCharAdded(HWND scintillaHandle, npp_buffer_t bufferID, int ch) const {
+    auto blockIndex = Lexer::getBlockIndex(bufferID);
+    if (!blockIndex) {
+      return;
+    }
+
+    npp_position_t caret = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETCURRENTPOS, 0, 0));
+    npp_position_t line = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_LINEFROMPOSITION, caret, 0));
+    bool isNewLine = (ch == '\n' || (ch == '\r' && ::SendMessage(scintillaHandle, SCI_GETEOLMODE, 0, 0) == SC_EOL_CR));
+    if (isNewLine) {
+      if (line == 0) {
+        return;
+      }
+
+      // End of line completes an outdent keyword that the line ended with, e.g. "EndIf"
+      npp_position_t endedLine = line - 1;
+      if (isOutdentKeywordEndingAt(scintillaHandle, endedLine, static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEENDPOSITION, endedLine, 0)))) {
+        indentLine(scintillaHandle, *blockIndex, endedLine, true);
+      }
+      indentLine(scintillaHandle, *blockIndex, line, false);
+    } else if (ch == ' ' || ch == '(') {
+      // A space or parenthesis completes the first word, so identifiers such as "ElseCount" are not mistaken for keywords
+      if (isOutdentKeywordEndingAt(scintillaHandle, line, caret - 1)) {
+        indentLine(scintillaHandle, *blockIndex, line, true);
+      }
+    }
+  }
+
+  // Private methods
+  //
+
+  void AutoIndenter::indentLine(HWND scintillaHandle, BlockIndex& blockIndex, npp_position_t line, bool outdent) const {
+    // Lines above may not have been lexed yet, e.g. the one just ended with Enter
+    npp_position_t lineStart = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_POSITIONFROMLINE, line, 0));
+    npp_position_t endStyled = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETENDSTYLED, 0, 0));
+    if (endStyled < lineStart) {
+      ::SendMessage(scintillaHandle, SCI_COLOURISE, endStyled, lineStart);
+    }
+
+    npp_position_t previousLine = line - 1;
+    npp_position_t previousIndentPos {0};
+    while (previousLine >= 0) {
+      previousIndentPos = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEINDENTPOSITION, previousLine, 0));
+      if (previousIndentPos != static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEENDPOSITION, previousLine, 0))) {
+        break;
+      }
+      previousLine--;
+    }
+    std::vector<BlockKeyword> keywords;
+    if (previousLine < 0 || !blockIndex.findOnLine(previousLine, keywords)) {
+      return;
+    }
+
+    // Count blocks left open by previous line. Closing and middle keywords leading a line were already outdented when typed.
+    npp_position_t previousIndentColumn = previousIndentPos - static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_POSITIONFROMLINE, previousLine, 0));
+    int levels = outdent ? -1 : 0;
+    for (const auto& keyword : keywords) {
+      if (keyword.role == BlockRole::Open) {
+        levels++;
+      } else if (keyword.role == BlockRole::Close) {
+        levels--;
+      }
+      if (keyword.column == previousIndentColumn && keyword.role != BlockRole::Open) {
+        levels++;
+      }
+    }
+
+    int indentSize = static_cast<int>(::SendMessage(scintillaHandle, SCI_GETINDENT, 0, 0));
+    if (indentSize == 0) {
+      indentSize = static_cast<int>(::SendMessage(scintillaHandle, SCI_GETTABWIDTH, 0, 0));
+    }
+    int indentation = std::max(0, static_cast<int>(::SendMessage(scintillaHandle, SCI_GETLINEINDENTATION, previousLine, 0)) + levels * indentSize);
+    if (indentation != static_cast<int>(::SendMessage(scintillaHandle, SCI_GETLINEINDENTATION, line, 0))) {
+      npp_position_t caret = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETCURRENTPOS, 0, 0));
+      npp_position_t indentPos = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEINDENTPOSITION, line, 0));
+      ::SendMessage(scintillaHandle, SCI_SETLINEINDENTATION, line, indentation);
+
+      // Indentation is replaced at line start, which leaves caret there if it was in the indentation
+      if (caret >= lineStart && caret <= indentPos) {
+        ::SendMessage(scintillaHandle, SCI_GOTOPOS, ::SendMessage(scintillaHandle, SCI_GETLINEINDENTPOSITION, line, 0), 0);
+      }
+    }
+  }
+
+  bool AutoIndenter::isOutdentKeywordEndingAt(HWND scintillaHandle, npp_position_t line, npp_position_t wordEnd) const {
+    npp_position_t indentPos = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEINDENTPOSITION, line, 0));
+    if (wordEnd <= indentPos || wordEnd - indentPos > MAX_OUTDENT_KEYWORD_LENGTH) {
+      return false;
+    }
+
+    std::string firstWord = getFirstWord(scintillaHandle, line);
+    return indentPos + static_cast<npp_position_t>(firstWord.length()) == wordEnd && isOutdentKeyword(firstWord);
+  }
+
+  bool AutoIndenter::isOutdentKeyword(const std::string& word) {
+    BlockType type;
+    BlockRole role;
+    return BlockIndex::isBlockKeyword(word, type, role) && (role == BlockRole::Middle || (role == BlockRole::Close && word.starts_with("end")));
+  }
+
+  std::string AutoIndenter::getFirstWord(HWND scintillaHandle, npp_position_t line) const {
+    npp_position_t wordStart = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEINDENTPOSITION, line, 0));
+    npp_position_t lineEnd = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLINEENDPOSITION, line, 0));
+    npp_position_t textEnd = std::min(lineEnd, wordStart + MAX_OUTDENT_KEYWORD_LENGTH + 1);
+    if (textEnd <= wordStart) {
+      return std::string();
+    }
+
+    std::string text(textEnd - wordStart + 1, '\0');
+    Sci_TextRange textRange {
+      .chrg = {
+        .cpMin = static_cast<Sci_PositionCR>(wordStart),
+        .cpMax = static_cast<Sci_PositionCR>(textEnd)
+      },
+      .lpstrText = text.data()
+    };
+    ::SendMessage(scintillaHandle, SCI_GETTEXTRANGE, 0, reinterpret_cast<LPARAM>(&textRange));
+
+    auto wordEnd = std::find_if(text.begin(), text.end(), [](char ch) { return !std::isalpha(static_cast<unsigned char>(ch)); });
+    return utility::toLower(std::string(text.begin(), wordEnd));
+  }
+
+} // namespace
@@ -0,0 +1,55 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\Common\NotepadPlusPlus.hpp"
+#include "..\Lexer\BlockIndex.hpp"
+
+#include <string>
+
+#include <windows.h>
+
+namespace papyrus {
+
+  // Indents lines as they are typed. Indentation of a new line is based on the previous non-empty line and the block keywords
+  // lexer found on it, so only a couple of lines are ever looked at no matter how large the document is.
+  class AutoIndenter {
+    public:
+      // Adjust indentation after a character was added. A new line is indented one level deeper if the previous line opens a
+      // block, and a line is outdented when a closing or middle keyword, e.g. "EndIf" or "Else", is typed at its start and
+      // completed by a space, a parenthesis or end of line.
+      void handleCharAdded(HWND scintillaHandle, npp_buffer_t bufferID, int ch) const;
+
+    private:
+      // Set indentation of a line based on the previous non-empty line, one level less if outdent is requested
+      void indentLine(HWND scintillaHandle, BlockIndex& blockIndex, npp_position_t line, bool outdent) const;
+
+      // Check whether the first word of a line is an outdent keyword that ends at the given position
+      bool isOutdentKeywordEndingAt(HWND scintillaHandle, npp_position_t line, npp_position_t wordEnd) const;
+
+      // Check whether a lower-cased word closes or continues a block when it starts a line. Closing flags that follow
+      // declarations on the same line, e.g. "Native" and "Auto", don't count.
+      static bool isOutdentKeyword(const std::string& word);
+
+      // Get the lower-cased first word of a line, up to the length of the longest outdent keyword
+      std::string getFirstWord(HWND scintillaHandle, npp_position_t line) const;
+  };
+
+} // namespace
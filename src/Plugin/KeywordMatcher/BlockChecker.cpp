@@ -0,0 +1,165 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BlockChecker.hpp"
+
+#include "..\Common\Resources.hpp"
+#include "..\Lexer\Lexer.hpp"
+
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <algorithm>
+
+namespace papyrus {
+
+  BlockChecker::BlockChecker(const NppData& nppData, const KeywordMatcherSettings& settings, HWND messageWindow)
+    : nppData(nppData), settings(settings), messageWindow(messageWindow) {
+    // Subscribe to settings changes
+    KeywordMatcherSettings& subscribableSettings = const_cast<KeywordMatcherSettings&>(settings);
+    subscribableSettings.enableBlockCheck.subscribe([&](auto eventData) {
+      if (!eventData.newValue) {
+        stop();
+        clear();
+      }
+    });
+    subscribableSettings.unmatchedIndicatorForegroundColor.subscribe([&](auto) {
+      if (handle != 0) {
+        setupIndicator(handle);
+      }
+    });
+  }
+
+  void BlockChecker::check(HWND scintillaHandle, npp_buffer_t bufferID) {
+    if (!settings.enableBlockCheck) {
+      return;
+    }
+
+    scheduledScintillaHandle = scintillaHandle;
+    scheduledBufferID = bufferID;
+    scheduledDocument = reinterpret_cast<npp_ptr_t>(::SendMessage(scintillaHandle, SCI_GETDOCPOINTER, 0, 0));
+    schedule(BLOCK_CHECK_DELAY);
+  }
+
+  void BlockChecker::runScheduledCheck() {
+    // View may have been switched to another document while waiting.
+    HWND scintillaHandle = scheduledScintillaHandle;
+    if (!settings.enableBlockCheck || scintillaHandle == 0
+      || reinterpret_cast<npp_ptr_t>(::SendMessage(scintillaHandle, SCI_GETDOCPOINTER, 0, 0)) != scheduledDocument) {
+      return;
+    }
+
+    auto blockIndex = Lexer::getBlockIndex(scheduledBufferID);
+    if (!blockIndex) {
+      return;
+    }
+
+    // Scintilla only styles what is shown, so the index may not cover the whole document yet. An opening keyword whose closing
+    // keyword hasn't been lexed would be reported as unbalanced, so have the rest lexed first. Lexing is incremental from where
+    // styling ended, and is done a chunk at a time so a big document doesn't block UI.
+    npp_position_t docLength = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETLENGTH, 0, 0));
+    npp_position_t endStyled = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETENDSTYLED, 0, 0));
+    if (endStyled < docLength) {
+      ::SendMessage(scintillaHandle, SCI_COLOURISE, endStyled, std::min(endStyled + BLOCK_CHECK_LEX_CHUNK_SIZE, docLength));
+      schedule(BLOCK_CHECK_LEX_CHUNK_DELAY);
+      return;
+    }
+
+    // The check runs on timer thread. Result is handed over to UI thread, which owns it once the message is posted. Replacing
+    // the timer waits for previous check, which only takes as long as going through the keywords.
+    HWND window = messageWindow;
+    npp_buffer_t bufferID = scheduledBufferID;
+    checkTimer = utility::startTimer(0, [=] {
+      auto result = std::make_unique<BlockCheckResult>(BlockCheckResult {
+        .scintillaHandle = scintillaHandle,
+        .bufferID = bufferID,
+        .generation = blockIndex->getGeneration()
+      });
+      if (blockIndex->findUnbalancedKeywords(result->unbalancedKeywords)
+        && ::PostMessage(window, PPM_BLOCK_CHECK_DONE, reinterpret_cast<WPARAM>(result.get()), 0)) {
+        result.release();
+      }
+    });
+  }
+
+  void BlockChecker::showResult(const BlockCheckResult& result) {
+    if (!settings.enableBlockCheck) {
+      return;
+    }
+
+    // Index changed after the check, e.g. user kept typing. Check again instead of showing outdated result.
+    auto blockIndex = Lexer::getBlockIndex(result.bufferID);
+    if (!blockIndex || blockIndex->getGeneration() != result.generation) {
+      check(result.scintillaHandle, result.bufferID);
+      return;
+    }
+
+    HWND scintillaHandle = result.scintillaHandle;
+
+    clear();
+    indicatorRanges.clear(scintillaHandle);
+    if (!setupIndicator(scintillaHandle)) {
+      return;
+    }
+
+    handle = scintillaHandle;
+    for (const auto& keyword : result.unbalancedKeywords) {
+      npp_position_t pos = static_cast<npp_position_t>(::SendMessage(handle, SCI_POSITIONFROMLINE, keyword.line, 0)) + keyword.column;
+      indicatorRanges.add(pos, keyword.length);
+    }
+    indicatorRanges.paint(handle, indicatorID);
+  }
+
+  void BlockChecker::clear() {
+    if (handle != 0) {
+      indicatorRanges.clear(handle);
+      handle = 0;
+    }
+  }
+
+  void BlockChecker::stop() {
+    ::KillTimer(messageWindow, PPT_CHECK_BLOCKS);
+    scheduledScintillaHandle = 0;
+    checkTimer.reset();
+  }
+
+  // Private methods
+  //
+
+  void BlockChecker::schedule(int delay) {
+    // Setting the same timer again just restarts it
+    ::SetTimer(messageWindow, PPT_CHECK_BLOCKS, delay, nullptr);
+  }
+
+  bool BlockChecker::setupIndicator(HWND scintillaHandle) {
+    if (indicatorID == 0) {
+      if (!static_cast<bool>(::SendMessage(nppData._nppHandle, NPPM_ALLOCATEINDICATOR, 1, reinterpret_cast<LPARAM>(&indicatorID)))) {
+        // Likely no available indicator ID left. Unlike keyword matching, there is no default ID to fall back to.
+        indicatorID = -1;
+      }
+    }
+    if (indicatorID < 0) {
+      return false;
+    }
+
+    ::SendMessage(scintillaHandle, SCI_INDICSETSTYLE, indicatorID, INDIC_SQUIGGLE);
+    ::SendMessage(scintillaHandle, SCI_INDICSETFORE, indicatorID, settings.unmatchedIndicatorForegroundColor);
+    return true;
+  }
+
+} // namespace
@@ -0,0 +1,100 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "KeywordMatcherSettings.hpp"
+
+#include "..\Common\IndicatorRanges.hpp"
+#include "..\Common\NotepadPlusPlus.hpp"
+#include "..\Common\Timer.hpp"
+#include "..\Lexer\BlockIndex.hpp"
+
+#include "..\..\external\npp\PluginInterface.h"
+
+#include <memory>
+#include <vector>
+
+namespace papyrus {
+
+  // Delay (in milliseconds) before checking block balance after document changes, so that typing doesn't trigger checks
+  constexpr int BLOCK_CHECK_DELAY = 500;
+
+  // Parts of document not yet lexed are lexed in chunks of this size (in bytes) before checking, with a short delay (in
+  // milliseconds) between chunks so UI stays responsive with big documents
+  constexpr npp_position_t BLOCK_CHECK_LEX_CHUNK_SIZE = 64 * 1024;
+  constexpr int BLOCK_CHECK_LEX_CHUNK_DELAY = 10;
+
+  // Result of a block balance check, posted from background thread to message window with PPM_BLOCK_CHECK_DONE
+  struct BlockCheckResult {
+    HWND scintillaHandle;
+    npp_buffer_t bufferID;
+    size_t generation;
+    std::vector<BlockKeyword> unbalancedKeywords;
+  };
+
+  // Checks whether block keywords of the whole document are balanced, and marks the ones that are not. A check is scheduled
+  // with PPT_CHECK_BLOCKS timer on message window, so a burst of changes ends up with one check. The check itself is done on
+  // a timer thread using block index built by lexer, so it never walks document text. Result is shown on UI thread.
+  class BlockChecker {
+    public:
+      BlockChecker(const NppData& nppData, const KeywordMatcherSettings& settings, HWND messageWindow);
+
+      // Schedule a check of given document shown on given view. Previously scheduled check that hasn't started yet is dropped.
+      void check(HWND scintillaHandle, npp_buffer_t bufferID);
+
+      // PPT_CHECK_BLOCKS timer handler. Lexes next chunk of the document if it is not fully lexed yet, otherwise starts the
+      // scheduled check.
+      void runScheduledCheck();
+
+      // Show result of a finished check. Caller should make sure the document is still shown on the view.
+      void showResult(const BlockCheckResult& result);
+
+      // Document content has changed, so marked keywords have moved
+      inline void contentChanged(HWND scintillaHandle, npp_position_t position, npp_length_t lengthAdded) {
+        indicatorRanges.contentChanged(scintillaHandle, position, lengthAdded);
+      }
+
+      void clear();
+
+      // Drop scheduled check and wait for running one to finish, e.g. when Notepad++ is shutting down
+      void stop();
+
+    private:
+      void schedule(int delay);
+      bool setupIndicator(HWND scintillaHandle);
+
+      // Private members
+      //
+      const NppData& nppData;
+      const KeywordMatcherSettings& settings;
+      HWND messageWindow;
+
+      // Document of scheduled check, with Scintilla's document pointer to tell if the view still shows it when timer fires
+      HWND scheduledScintillaHandle {0};
+      npp_buffer_t scheduledBufferID {0};
+      npp_ptr_t scheduledDocument {nullptr};
+      std::unique_ptr<utility::Timer> checkTimer;
+
+      int indicatorID {0};
+      HWND handle {0};
+      utility::IndicatorRanges indicatorRanges;
+  };
+
+} // namespace
@@ -0,0 +1,103 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BlockNavigator.hpp"
+
+#include "..\Lexer\Lexer.hpp"
+
+#include "..\..\external\npp\Common.h"
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <filesystem>
+#include <tuple>
+#include <vector>
+
+namespace papyrus {
+
+  namespace {
+    // Locate caret by line and column, which is how block index locates keywords
+    std::pair<npp_position_t, npp_position_t> getCaretLocation(HWND scintillaHandle) {
+      npp_position_t caret = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETCURRENTPOS, 0, 0));
+      npp_position_t line = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_LINEFROMPOSITION, caret, 0));
+      npp_position_t lineStart = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_POSITIONFROMLINE, line, 0));
+      return std::make_pair(line, caret - lineStart);
+    }
+  }
+
+  BlockNavigator::BlockNavigator(const NppData& nppData)
+    : nppData(nppData) {
+  }
+
+  std::wstring BlockNavigator::getCaretContext(HWND scintillaHandle, npp_buffer_t bufferID) const {
+    auto blockIndex = Lexer::getBlockIndex(bufferID);
+    if (!blockIndex) {
+      return std::wstring();
+    }
+
+    auto [line, column] = getCaretLocation(scintillaHandle);
+    std::vector<BlockRange> blocks;
+    if (!blockIndex->findEnclosingBlocks(line, column, blocks)) {
+      return std::wstring();
+    }
+
+    // Script name must be the same as file name, so take it from there rather than from the lower-cased lexer token
+    std::wstring context = std::filesystem::path(utility::getFilePathFromBuffer(nppData._nppHandle, bufferID)).stem().wstring();
+    UINT codePage = static_cast<UINT>(::SendMessage(scintillaHandle, SCI_GETCODEPAGE, 0, 0));
+    for (const auto& block : blocks) {
+      if (block.opening.nameLength > 0) {
+        npp_position_t nameStart = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_POSITIONFROMLINE, block.opening.line, 0)) + block.opening.nameColumn;
+        std::string name(block.opening.nameLength + 1, '\0');
+        Sci_TextRange textRange {
+          .chrg = {
+            .cpMin = static_cast<Sci_PositionCR>(nameStart),
+            .cpMax = static_cast<Sci_PositionCR>(nameStart + block.opening.nameLength)
+          },
+          .lpstrText = name.data()
+        };
+        ::SendMessage(scintillaHandle, SCI_GETTEXTRANGE, 0, reinterpret_cast<LPARAM>(&textRange));
+        name.resize(block.opening.nameLength);
+        context += L" > " + string2wstring(name, codePage);
+      }
+    }
+    return context;
+  }
+
+  bool BlockNavigator::goToEnclosingBlock(HWND scintillaHandle, npp_buffer_t bufferID) const {
+    auto blockIndex = Lexer::getBlockIndex(bufferID);
+    if (!blockIndex) {
+      return false;
+    }
+
+    auto [line, column] = getCaretLocation(scintillaHandle);
+    std::vector<BlockRange> blocks;
+    if (!blockIndex->findEnclosingBlocks(line, column, blocks)) {
+      return false;
+    }
+
+    for (auto iter = blocks.rbegin(); iter != blocks.rend(); ++iter) {
+      if (std::tie(iter->opening.line, iter->opening.column) < std::tie(line, column)) {
+        npp_position_t pos = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_POSITIONFROMLINE, iter->opening.line, 0)) + iter->opening.column;
+        ::SendMessage(scintillaHandle, SCI_GOTOPOS, pos, 0);
+        return true;
+      }
+    }
+    return false;
+  }
+
+} // namespace
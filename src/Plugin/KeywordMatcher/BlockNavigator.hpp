@@ -0,0 +1,52 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\Common\NotepadPlusPlus.hpp"
+
+#include "..\..\external\npp\PluginInterface.h"
+
+#include <string>
+
+#include <windows.h>
+
+namespace papyrus {
+
+  // Navigates blocks enclosing caret, e.g. state, function and event, using ranges of blocks in block index built by lexer.
+  // Enclosing blocks are found by searching backward in the keyword tree from caret, for the previous opening keyword of each
+  // non-nestable block type and, by nesting depth, for each open if and while block, instead of scanning document text.
+  class BlockNavigator {
+    public:
+      BlockNavigator(const NppData& nppData);
+
+      // Get names of the script and named blocks that enclose caret, e.g. "MyScript > MyState > OnInit"
+      std::wstring getCaretContext(HWND scintillaHandle, npp_buffer_t bufferID) const;
+
+      // Move caret to the opening keyword of the innermost block that starts before caret, so doing it repeatedly walks out to
+      // outer blocks. Returns false if there is no such block.
+      bool goToEnclosingBlock(HWND scintillaHandle, npp_buffer_t bufferID) const;
+
+    private:
+      // Private members
+      //
+      const NppData& nppData;
+  };
+
+} // namespace
@@ -19,16 +19,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "KeywordMatcher.hpp"
 
+#include "KeywordScanner.hpp"
+
+#include "..\Common\GameFeatures.hpp"
 #include "..\Common\Logger.hpp"
 #include "..\Common\StringUtil.hpp"
 #include "..\Lexer\Lexer.hpp"
 
 #include "..\..\external\gsl\include\gsl\util"
-#include "..\..\external\npp\Common.h"
 
-namespace papyrus {
+#include <algorithm>
+#include <cctype>
 
-  using SavedSearch = KeywordMatcher::SavedSearch;
+namespace papyrus {
 
   // Internal static variables
   namespace {
@@ -37,19 +40,20 @@ namespace papyrus {
       "Else",
       "ElseIf"
     };
-  }
 
-  SavedSearch::SavedSearch(HWND handle)
-    : handle(handle) {
-    startPos = ::SendMessage(handle, SCI_GETTARGETSTART, 0, 0);
-    endPos = ::SendMessage(handle, SCI_GETTARGETEND, 0, 0);
-    flags = static_cast<int>(::SendMessage(handle, SCI_GETSEARCHFLAGS, 0, 0));
-  }
-
-  SavedSearch::~SavedSearch() {
-    ::SendMessage(handle, SCI_SETTARGETSTART, startPos, 0);
-    ::SendMessage(handle, SCI_SETTARGETEND, endPos, 0);
-    ::SendMessage(handle, SCI_SETSEARCHFLAGS, flags, 0);
+    // All keywords that can be matched, scanned for in a single pass
+    const std::vector<std::string> blockKeywords {
+      "Function", "EndFunction", "Native",
+      "Struct", "EndStruct",
+      "Property", "EndProperty", "Auto", "AutoReadOnly",
+      "Group", "EndGroup",
+      "State", "EndState",
+      "Event", "EndEvent",
+      "If", "ElseIf", "Else", "EndIf",
+      "While", "EndWhile"
+    };
+    const KeywordScanner forwardScanner(blockKeywords, false);
+    const KeywordScanner backwardScanner(blockKeywords, true);
   }
 
   KeywordMatcher::KeywordMatcher(const NppData& nppData, const KeywordMatcherSettings& settings)
@@ -67,16 +71,23 @@ namespace papyrus {
    }
 
   bool KeywordMatcher::match(HWND scintillaHandle) {
+    // Caret moving within the same word of an unchanged document doesn't change the result
+    MatchKey matchKey = getMatchKey(scintillaHandle);
+    if (cachedMatchKey && *cachedMatchKey == matchKey) {
+      return matched;
+    }
+
     handle = scintillaHandle;
     match();
+    cachedMatchKey = matchKey;
     return matched;
   }
 
   void KeywordMatcher::clear() {
+    cachedMatchKey.reset();
     if (handle != 0) {
       docLength = static_cast<Sci_PositionCR>(::SendMessage(handle, SCI_GETLENGTH, 0, 0));
-      ::SendMessage(handle, SCI_SETINDICATORCURRENT, indicatorID, 0);
-      ::SendMessage(handle, SCI_INDICATORCLEARRANGE, 0, docLength);
+      indicatorRanges.clear(handle);
 
       matched = false;
       matchedPos = 0;
@@ -86,12 +97,33 @@ namespace papyrus {
   // Private methods
   //
 
+  KeywordMatcher::MatchKey KeywordMatcher::getMatchKey(HWND scintillaHandle) const {
+    npp_position_t currentPos = ::SendMessage(scintillaHandle, SCI_GETCURRENTPOS, 0, 0);
+    npp_position_t currentWordStart = ::SendMessage(scintillaHandle, SCI_WORDSTARTPOSITION, currentPos, true);
+    npp_position_t currentWordEnd = ::SendMessage(scintillaHandle, SCI_WORDENDPOSITION, currentPos, true);
+    if (currentWordEnd <= currentWordStart) {
+      // All positions that are not on a word share the same result
+      currentWordStart = currentWordEnd = -1;
+    }
+
+    return MatchKey {
+      .handle = scintillaHandle,
+      .bufferID = static_cast<npp_buffer_t>(::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0)),
+      .wordStart = currentWordStart,
+      .wordEnd = currentWordEnd,
+      .modificationCount = modificationCount
+    };
+  }
+
   void KeywordMatcher::match() {
     if (handle != 0) {
       // Clear existing matches
       clear();
 
       if (settings.enableKeywordMatching && settings.enabledKeywords != KEYWORD_NONE) {
+        // Read document text in place. This doesn't change Scintilla's search target or flags, which other plugins might rely on.
+        docText = reinterpret_cast<const char*>(::SendMessage(handle, SCI_GETCHARACTERPOINTER, 0, 0));
+
         // Get current word at caret
         npp_position_t currentPos = ::SendMessage(handle, SCI_GETCURRENTPOS, 0, 0);
         npp_position_t currentWordStart = ::SendMessage(handle, SCI_WORDSTARTPOSITION, currentPos, true);
@@ -113,57 +145,16 @@ namespace papyrus {
             };
             ::SendMessage(handle, SCI_GETTEXTRANGE, 0, reinterpret_cast<LPARAM>(&textRange));
 
+            // Look up the block structure index built by lexer first, which doesn't need any text search
+            if (matchWithBlockIndex(textRange.chrg)) {
+              return;
+            }
+
             std::string currentWord(word);
             if (isKeyword) {
-              if (utility::compare(currentWord, "Function")) {
-                if (settings.enabledKeywords & KEYWORD_FUNCTION) {
-                  matchKeyword(textRange.chrg, word, { "EndFunction", "Native" });
-                }
-              } else if (utility::compare(currentWord, "EndFunction") || utility::compare(currentWord, "Native")) {
-                if (settings.enabledKeywords & KEYWORD_FUNCTION) {
-                  matchKeyword(textRange.chrg, word, { "Function" }, false);
-                }
-              } else if (utility::compare(currentWord, "Struct")) {
-                if (settings.enabledKeywords & KEYWORD_STRUCT) {
-                  matchKeyword(textRange.chrg, word, { "EndStruct" });
-                }
-              } else if (utility::compare(currentWord, "EndStruct")) {
-                if (settings.enabledKeywords & KEYWORD_STRUCT) {
-                  matchKeyword(textRange.chrg, word, { "Struct" }, false);
-                }
-              } else if (utility::compare(currentWord, "Property")) {
-                if (settings.enabledKeywords & KEYWORD_PROPERTY) {
-                  matchKeyword(textRange.chrg, word, { "EndProperty", "Auto", "AutoReadOnly" });
-                }
-              } else if (utility::compare(currentWord, "EndProperty") || utility::compare(currentWord, "Auto") || utility::compare(currentWord, "AutoReadOnly")) {
-                if (settings.enabledKeywords & KEYWORD_PROPERTY) {
-                  matchKeyword(textRange.chrg, word, { "Property" }, false);
-                }
-              } else if (utility::compare(currentWord, "Group")) {
-                if (settings.enabledKeywords & KEYWORD_GROUP) {
-                  matchKeyword(textRange.chrg, word, { "EndGroup" });
-                }
-              } else if (utility::compare(currentWord, "EndGroup")) {
-                if (settings.enabledKeywords & KEYWORD_GROUP) {
-                  matchKeyword(textRange.chrg, word, { "Group" }, false);
-                }
-              } else if (utility::compare(currentWord, "State")) {
-                if (settings.enabledKeywords & KEYWORD_STATE) {
-                  matchKeyword(textRange.chrg, word, { "EndState" });
-                }
-              } else if (utility::compare(currentWord, "EndState")) {
-                if (settings.enabledKeywords & KEYWORD_STATE) {
-                  matchKeyword(textRange.chrg, word, { "State" }, false);
-                }
-              } else if (utility::compare(currentWord, "Event")) {
-                if (settings.enabledKeywords & KEYWORD_EVENT) {
-                  matchKeyword(textRange.chrg, word, { "EndEvent" });
-                }
-              } else if (utility::compare(currentWord, "EndEvent")) {
-                if (settings.enabledKeywords & KEYWORD_EVENT) {
-                  matchKeyword(textRange.chrg, word, { "Event" }, false);
-                }
-              }
+              game::dispatch(lexerData->currentGame, [&](auto gameType) {
+                matchBlockKeyword<decltype(gameType)::value>(textRange.chrg, word);
+              });
             } else { // isFlowControl
               if (utility::compare(currentWord, "While")) {
                 if (settings.enabledKeywords & KEYWORD_WHILE) {
@@ -194,151 +185,259 @@ namespace papyrus {
     }
   }
 
-  void KeywordMatcher::matchKeyword(Sci_CharacterRange currentWordPos, const char* currentWord, word_list_t matchingWords, bool searchForward) {
-    SavedSearch savedSearch(handle);
-    Sci_PositionCR searchStart = searchForward ? currentWordPos.cpMax : currentWordPos.cpMin;
-    Sci_PositionCR searchEnd = searchForward ? docLength : 0;
-    Sci_PositionCR matchedStart = searchEnd;
-    Sci_PositionCR matchedEnd = searchEnd;
+  bool KeywordMatcher::matchWithBlockIndex(Sci_CharacterRange currentWordPos) {
+    // Index is only complete when the whole document has been lexed
+    npp_buffer_t bufferID = static_cast<npp_buffer_t>(::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0));
+    auto blockIndex = Lexer::getBlockIndex(bufferID);
+    if (!blockIndex || ::SendMessage(handle, SCI_GETENDSTYLED, 0, 0) < docLength) {
+      return false;
+    }
 
-    // Find the one closest to current word in matching words list
-    for (const auto& matchingWord : matchingWords) {
-      auto found = findText(matchingWord, searchStart, searchEnd, SearchWordType::Keyword, searchForward);
-      if (found.cpMin != -1) {
-        if (searchForward) {
-          matchedStart = min(matchedStart, found.cpMin);
-          matchedEnd = min(matchedEnd, found.cpMax);
-        } else {
-          matchedStart = max(matchedStart, found.cpMin);
-          matchedEnd = max(matchedEnd, found.cpMax);
-        }
+    Sci_Position line = ::SendMessage(handle, SCI_LINEFROMPOSITION, currentWordPos.cpMin, 0);
+    Sci_Position column = currentWordPos.cpMin - ::SendMessage(handle, SCI_POSITIONFROMLINE, line, 0);
+    BlockMatch blockMatch;
+    if (!blockIndex->find(line, column, blockMatch)) {
+      return false;
+    }
+
+    // Found in index. Whether to highlight it depends on enabled keywords.
+    int enabledKeyword = blockKeywordFlag(blockMatch.current.type);
+    bool isMiddle = (blockMatch.current.role == BlockRole::Middle);
+    if (!(settings.enabledKeywords & enabledKeyword) || (isMiddle && !(settings.enabledKeywords & KEYWORD_ELSE))) {
+      return true;
+    }
+
+    auto toCharacterRange = [&](const BlockKeyword& keyword) {
+      Sci_PositionCR start = static_cast<Sci_PositionCR>(::SendMessage(handle, SCI_POSITIONFROMLINE, keyword.line, 0) + keyword.column);
+      return Sci_CharacterRange {
+        .cpMin = start,
+        .cpMax = start + static_cast<Sci_PositionCR>(keyword.length)
+      };
+    };
+
+    matched = blockMatch.matched;
+    setupIndicator();
+    Sci_PositionCR fillRange = currentWordPos.cpMax - currentWordPos.cpMin;
+    indicatorRanges.add(currentWordPos.cpMin, fillRange);
+    for (const auto& keyword : blockMatch.related) {
+      if (keyword.role != BlockRole::Middle || (settings.enabledKeywords & KEYWORD_ELSE)) {
+        auto pos = toCharacterRange(keyword);
+        fillRange = pos.cpMax - pos.cpMin;
+        indicatorRanges.add(pos.cpMin, fillRange);
       }
     }
 
-    matched = (matchedStart != searchEnd);
     if (matched) {
-      // Find the closest match of current word
-      auto foundComparison = findText(currentWord, searchStart, searchEnd, SearchWordType::Keyword, searchForward);
+      auto pos = toCharacterRange(blockMatch.matching);
+      matchedPos = pos.cpMin;
+      fillRange = pos.cpMax - pos.cpMin;
+      indicatorRanges.add(pos.cpMin, fillRange);
+    }
+    indicatorRanges.paint(handle, indicatorID);
+    return true;
+  }
+
+  int KeywordMatcher::blockKeywordFlag(BlockType type) {
+    switch (type) {
+      case BlockType::Function:
+        return KEYWORD_FUNCTION;
+
+      case BlockType::Struct:
+        return KEYWORD_STRUCT;
+
+      case BlockType::Property:
+        return KEYWORD_PROPERTY;
+
+      case BlockType::Group:
+        return KEYWORD_GROUP;
+
+      case BlockType::State:
+        return KEYWORD_STATE;
+
+      case BlockType::Event:
+        return KEYWORD_EVENT;
+
+      case BlockType::If:
+        return KEYWORD_IF;
+
+      case BlockType::While:
+        return KEYWORD_WHILE;
 
-      // Check if the found current word is closer than matching word
-      if (foundComparison.cpMin >= 0 && ((searchForward && foundComparison.cpMin < matchedStart) || (!searchForward && foundComparison.cpMin > matchedStart))) {
-        // In this case, the found matching keyword is not a true match.
-        matched = false;
+      default:
+        return KEYWORD_NONE;
+    }
+  }
+
+  template <Game gameType>
+  void KeywordMatcher::matchBlockKeyword(Sci_CharacterRange currentWordPos, const char* currentWord) {
+    std::string word(currentWord);
+    if (utility::compare(word, "Function")) {
+      if (settings.enabledKeywords & KEYWORD_FUNCTION) {
+        matchKeyword(currentWordPos, currentWord, { "EndFunction", "Native" });
+      }
+    } else if (utility::compare(word, "EndFunction") || utility::compare(word, "Native")) {
+      if (settings.enabledKeywords & KEYWORD_FUNCTION) {
+        matchKeyword(currentWordPos, currentWord, { "Function" }, false);
+      }
+    } else if (game::gameFeatures<gameType>.structs && utility::compare(word, "Struct")) {
+      if (settings.enabledKeywords & KEYWORD_STRUCT) {
+        matchKeyword(currentWordPos, currentWord, { "EndStruct" });
+      }
+    } else if (game::gameFeatures<gameType>.structs && utility::compare(word, "EndStruct")) {
+      if (settings.enabledKeywords & KEYWORD_STRUCT) {
+        matchKeyword(currentWordPos, currentWord, { "Struct" }, false);
+      }
+    } else if (utility::compare(word, "Property")) {
+      if (settings.enabledKeywords & KEYWORD_PROPERTY) {
+        matchKeyword(currentWordPos, currentWord, { "EndProperty", "Auto", "AutoReadOnly" });
+      }
+    } else if (utility::compare(word, "EndProperty") || utility::compare(word, "Auto") || utility::compare(word, "AutoReadOnly")) {
+      if (settings.enabledKeywords & KEYWORD_PROPERTY) {
+        matchKeyword(currentWordPos, currentWord, { "Property" }, false);
+      }
+    } else if (game::gameFeatures<gameType>.groups && utility::compare(word, "Group")) {
+      if (settings.enabledKeywords & KEYWORD_GROUP) {
+        matchKeyword(currentWordPos, currentWord, { "EndGroup" });
+      }
+    } else if (game::gameFeatures<gameType>.groups && utility::compare(word, "EndGroup")) {
+      if (settings.enabledKeywords & KEYWORD_GROUP) {
+        matchKeyword(currentWordPos, currentWord, { "Group" }, false);
+      }
+    } else if (utility::compare(word, "State")) {
+      if (settings.enabledKeywords & KEYWORD_STATE) {
+        matchKeyword(currentWordPos, currentWord, { "EndState" });
+      }
+    } else if (utility::compare(word, "EndState")) {
+      if (settings.enabledKeywords & KEYWORD_STATE) {
+        matchKeyword(currentWordPos, currentWord, { "State" }, false);
+      }
+    } else if (utility::compare(word, "Event")) {
+      if (settings.enabledKeywords & KEYWORD_EVENT) {
+        matchKeyword(currentWordPos, currentWord, { "EndEvent" });
+      }
+    } else if (utility::compare(word, "EndEvent")) {
+      if (settings.enabledKeywords & KEYWORD_EVENT) {
+        matchKeyword(currentWordPos, currentWord, { "Event" }, false);
       }
     }
+  }
+
+  template <class Callback>
+  void KeywordMatcher::scanKeywords(Sci_PositionCR start, Sci_PositionCR end, const std::vector<int>& wordIndexes, SearchWordType searchWordType, bool searchForward, Callback callback) {
+    if (docText == nullptr) {
+      return;
+    }
+
+    const auto& scanner = searchForward ? forwardScanner : backwardScanner;
+    scanner.scan(docText, start, end, [&](int wordIndex, Sci_PositionCR pos) {
+      if (std::find(wordIndexes.begin(), wordIndexes.end(), wordIndex) == wordIndexes.end()) {
+        return true;
+      }
+
+      auto length = static_cast<Sci_PositionCR>(scanner.words()[wordIndex].size());
+      if (!isWholeWordAt(pos, length)) {
+        return true;
+      }
+
+      // Found word has to be either keyword or flow control, depending on search word type. Otherwise it's likely in a comment
+      // or string.
+      int style = static_cast<int>(::SendMessage(handle, SCI_GETSTYLEAT, pos, 0));
+      if ((searchWordType == SearchWordType::Keyword && !Lexer::isKeyword(style)) || (searchWordType == SearchWordType::FlowControl && !Lexer::isFlowControl(style))) {
+        return true;
+      }
+
+      return callback(wordIndex, Sci_CharacterRange { .cpMin = pos, .cpMax = pos + length });
+    });
+  }
+
+  void KeywordMatcher::matchKeyword(Sci_CharacterRange currentWordPos, const char* currentWord, word_list_t matchingWords, bool searchForward) {
+    Sci_PositionCR searchStart = searchForward ? currentWordPos.cpMax : currentWordPos.cpMin;
+    Sci_PositionCR searchEnd = searchForward ? docLength : 0;
+
+    // Find the closest one of either matching words or current word. If it's current word, there is no true match.
+    int currentWordIndex = forwardScanner.indexOf(currentWord);
+    std::vector<int> wordIndexes { currentWordIndex };
+    for (const auto& matchingWord : matchingWords) {
+      wordIndexes.push_back(forwardScanner.indexOf(matchingWord));
+    }
+
+    Sci_CharacterRange matchedRange { .cpMin = -1 };
+    scanKeywords(searchStart, searchEnd, wordIndexes, SearchWordType::Keyword, searchForward, [&](int wordIndex, Sci_CharacterRange found) {
+      if (wordIndex != currentWordIndex) {
+        matchedRange = found;
+      }
+      return false;
+    });
+    matched = (matchedRange.cpMin != -1);
 
     setupIndicator();
     Sci_PositionCR fillRange = currentWordPos.cpMax - currentWordPos.cpMin;
-    ::SendMessage(handle, SCI_INDICATORFILLRANGE, currentWordPos.cpMin, fillRange);
+    indicatorRanges.add(currentWordPos.cpMin, fillRange);
     if (matched) {
-      matchedPos = matchedStart;
-      fillRange = matchedEnd - matchedStart;
-      ::SendMessage(handle, SCI_INDICATORFILLRANGE, matchedStart, fillRange);
+      matchedPos = matchedRange.cpMin;
+      fillRange = matchedRange.cpMax - matchedRange.cpMin;
+      indicatorRanges.add(matchedRange.cpMin, fillRange);
     }
+    indicatorRanges.paint(handle, indicatorID);
   }
 
   void KeywordMatcher::matchFlowControl(Sci_CharacterRange currentWordPos, const char* currentWord, const char* matchingWord, word_list_t otherWords, bool searchForward) {
-    SavedSearch savedSearch(handle);
     result_list_t otherWordsPosList;
     auto found = matchFlowControl(currentWordPos, currentWord, matchingWord, otherWords, otherWordsPosList, searchForward);
     matched = (found.cpMin != -1);
 
     setupIndicator();
     Sci_PositionCR fillRange = currentWordPos.cpMax - currentWordPos.cpMin;
-    ::SendMessage(handle, SCI_INDICATORFILLRANGE, currentWordPos.cpMin, fillRange);
+    indicatorRanges.add(currentWordPos.cpMin, fillRange);
     for (const auto& pos : otherWordsPosList) {
       fillRange = pos.cpMax - pos.cpMin;
-      ::SendMessage(handle, SCI_INDICATORFILLRANGE, pos.cpMin, fillRange);
+      indicatorRanges.add(pos.cpMin, fillRange);
     }
 
     if (matched) {
       matchedPos = found.cpMin;
       fillRange = found.cpMax - found.cpMin;
-      ::SendMessage(handle, SCI_INDICATORFILLRANGE, found.cpMin, fillRange);
+      indicatorRanges.add(found.cpMin, fillRange);
     }
+    indicatorRanges.paint(handle, indicatorID);
   }
 
   Sci_CharacterRange KeywordMatcher::matchFlowControl(Sci_CharacterRange currentWordPos, const char* currentWord, const char* matchingWord, word_list_t otherWords, result_list_t& otherWordsPosList, bool searchForward) {
     Sci_PositionCR searchStart = searchForward ? currentWordPos.cpMax : currentWordPos.cpMin;
     Sci_PositionCR searchEnd = searchForward ? docLength : 0;
 
-    while ((searchForward && searchStart < searchEnd) || (!searchForward && searchStart > searchEnd)) {
-      // Find the matching flow control closest to current word
-      auto foundMatchingWord = findText(matchingWord, searchStart, searchEnd, SearchWordType::FlowControl, searchForward);
-      if (foundMatchingWord.cpMin == -1) {
-        // Can't find matching flow control
-        return foundMatchingWord;
-      }
-
-      // Find the closest flow control of current word
-      auto foundComparison = findText(currentWord, searchStart, searchEnd, SearchWordType::FlowControl, searchForward);
-
-      // Check if the found matching word is closer
-      if (foundComparison.cpMin == -1 || (searchForward && foundMatchingWord.cpMin < foundComparison.cpMin) || (!searchForward && foundMatchingWord.cpMin > foundComparison.cpMin)) {
-        // In this case, the found matching flow control is the true match. Add other highlighting words from current pos to matching word pos
-        findWords(searchStart, searchForward ? foundMatchingWord.cpMin : foundMatchingWord.cpMax, otherWords, otherWordsPosList, SearchWordType::FlowControl, searchForward);
-        return foundMatchingWord;
-      }
-
-      // Nested flow control. Use recursive method to find the end position of nested block.
-      // Add any other highlighting words from current pos to start of nested block, and skip highlighting other words inside nested block
-      findWords(searchStart, searchForward ? foundComparison.cpMin : foundComparison.cpMax, otherWords, otherWordsPosList, SearchWordType::FlowControl, searchForward);
-      auto nestedFlowControlEnd = matchFlowControl(foundComparison, currentWord, matchingWord, {}, otherWordsPosList, searchForward);
-
-      // If nested control is open-ended, return as well
-      if (nestedFlowControlEnd.cpMin == -1) {
-        return nestedFlowControlEnd;
-      }
-
-      // Use nested flow control block's end postion as new start search position
-      searchStart = searchForward ? nestedFlowControlEnd.cpMax : nestedFlowControlEnd.cpMin;
+    int currentWordIndex = forwardScanner.indexOf(currentWord);
+    int matchingWordIndex = forwardScanner.indexOf(matchingWord);
+    std::vector<int> wordIndexes { currentWordIndex, matchingWordIndex };
+    for (const auto& otherWord : otherWords) {
+      wordIndexes.push_back(forwardScanner.indexOf(otherWord));
     }
 
-    // Didn't find anything
-    return Sci_CharacterRange { .cpMin = -1 };
-  }
-
-  Sci_CharacterRange KeywordMatcher::findText(const char* text, Sci_PositionCR start, Sci_PositionCR end, SearchWordType searchWordType, bool searchForward, int searchFlags) {
-    Sci_TextToFind search {
-      .chrg = {
-        .cpMin = start,
-        .cpMax = end
-      },
-      .lpstrText = text
-    };
-    while (::SendMessage(handle, SCI_FINDTEXT, searchFlags, reinterpret_cast<LPARAM>(&search)) != -1) {
-      // Search result has to be either keyword or flow control, depending on search word type
-      int style = static_cast<int>(::SendMessage(handle, SCI_GETSTYLEAT, search.chrgText.cpMin, 0));
-      if ((searchWordType == SearchWordType::Keyword && !Lexer::isKeyword(style)) || (searchWordType == SearchWordType::FlowControl && !Lexer::isFlowControl(style))) {
-        // Not in correct style, likely a comment or string, search again
-        search.chrg.cpMin = searchForward ? search.chrgText.cpMax : search.chrgText.cpMin;
-      } else {
-        // Found
-        return search.chrgText;
+    // Track nesting depth in one pass. Nested blocks of current word are skipped, along with other highlighting words in them.
+    int depth = 0;
+    Sci_CharacterRange matchedRange { .cpMin = -1 };
+    scanKeywords(searchStart, searchEnd, wordIndexes, SearchWordType::FlowControl, searchForward, [&](int wordIndex, Sci_CharacterRange found) {
+      if (wordIndex == matchingWordIndex) {
+        if (depth == 0) {
+          matchedRange = found;
+          return false;
+        }
+        depth--;
+      } else if (wordIndex == currentWordIndex) {
+        depth++;
+      } else if (depth == 0) {
+        otherWordsPosList.push_back(found);
       }
-    }
-
-    // Didn't find
-    search.chrgText.cpMin = -1;
-    return search.chrgText;
+      return true;
+    });
+    return matchedRange;
   }
 
-  void KeywordMatcher::findWords(Sci_PositionCR start, Sci_PositionCR end, word_list_t words, result_list_t& foundPosList, SearchWordType searchWordType, bool searchForward) {
-    for (const auto& word : words) {
-      Sci_PositionCR searchStart = start;
-      Sci_PositionCR searchEnd = end;
-      while (true) {
-        auto found = findText(word, searchStart, searchEnd, searchWordType, searchForward);
-        if (found.cpMin == -1) {
-          // No more matches
-          break;
-        }
-        foundPosList.push_back(found);
-
-        // Search again
-        searchStart = searchForward ? found.cpMax : found.cpMin;
-      }
-    }
+  bool KeywordMatcher::isWholeWordAt(Sci_PositionCR pos, Sci_PositionCR length) const {
+    auto isWordChar = [](char ch) {
+      return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+    };
+    return (pos == 0 || !isWordChar(docText[pos - 1])) && (pos + length >= docLength || !isWordChar(docText[pos + length]));
   }
 
   void KeywordMatcher::setupIndicator() {
@@ -388,9 +487,9 @@ namespace papyrus {
         utility::clearIndications(nppData._scintillaSecondHandle, oldIndicatorID);
       }
 
+      // Ranges painted with old indicator are already cleared above
+      indicatorRanges.discard();
       if (handle != 0) {
-        ::SendMessage(handle, SCI_SETINDICATORCURRENT, indicatorID, 0);
-        ::SendMessage(handle, SCI_INDICATORCLEARRANGE, 0, docLength);
         match();
       }
     }
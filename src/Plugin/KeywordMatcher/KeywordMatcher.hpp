@@ -21,33 +21,39 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "KeywordMatcherSettings.hpp"
 
+#include "..\Common\Game.hpp"
+#include "..\Common\IndicatorRanges.hpp"
 #include "..\Common\NotepadPlusPlus.hpp"
+#include "..\Lexer\BlockIndex.hpp"
 
 #include "..\..\external\npp\PluginInterface.h"
 
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace papyrus {
 
+  using Game = game::Game;
   using word_list_t = std::vector<const char*>;
   using result_list_t = std::vector<Sci_CharacterRange>;
 
+  // Delay (in milliseconds) before matching keyword after caret moves, so bursts of caret movements are coalesced
+  constexpr int KEYWORD_MATCH_DELAY = 50;
+
   class KeywordMatcher {
     public:
-      struct SavedSearch {
-        SavedSearch(HWND handle);
-        ~SavedSearch();
-
-        HWND handle;
-        npp_position_t startPos;
-        npp_position_t endPos;
-        int flags;
-      };
-
       KeywordMatcher(const NppData& nppData, const KeywordMatcherSettings& settings);
 
+      // Match keyword at caret. Result is cached, so it's only redone when caret moves to another word or document changes.
       bool match(HWND scintillaHandle);
+
+      // Document content has changed, so cached match result is no longer valid, and highlighted keywords have moved
+      inline void contentChanged(HWND scintillaHandle, npp_position_t position, npp_length_t lengthAdded) {
+        modificationCount++;
+        indicatorRanges.contentChanged(scintillaHandle, position, lengthAdded);
+      }
+
       inline void goToMatchedPos() const {
         if (handle != 0 && matched) {
           ::SendMessage(handle, SCI_GOTOPOS, matchedPos, 0);
@@ -61,12 +67,38 @@ namespace papyrus {
         FlowControl
       };
 
+      // Identifies what a match result was computed for
+      struct MatchKey {
+        HWND handle;
+        npp_buffer_t bufferID;
+        npp_position_t wordStart;
+        npp_position_t wordEnd;
+        size_t modificationCount;
+
+        bool operator==(const MatchKey&) const = default;
+      };
+
+      MatchKey getMatchKey(HWND scintillaHandle) const;
+
       void match();
+
+      // Match keyword at current word using block index built by lexer. Returns false if the index can't be used, in which case
+      // text search is used instead.
+      bool matchWithBlockIndex(Sci_CharacterRange currentWordPos);
+      static int blockKeywordFlag(BlockType type);
+
+      // Match block keywords, e.g. Function/EndFunction. Blocks not supported by the game are skipped at compile time.
+      template <Game gameType>
+      void matchBlockKeyword(Sci_CharacterRange currentWordPos, const char* currentWord);
+
       void matchKeyword(Sci_CharacterRange currentWordPos, const char* currentWord, word_list_t matchingWords, bool searchForward = true);
       void matchFlowControl(Sci_CharacterRange currentWordPos, const char* currentWord, const char* matchingWord, word_list_t otherWords, bool searchForward = true);
       Sci_CharacterRange matchFlowControl(Sci_CharacterRange currentWordPos, const char* currentWord, const char* matchingWord, word_list_t otherWords, result_list_t& otherWordsPosList, bool searchForward = true);
-      Sci_CharacterRange findText(const char* text, Sci_PositionCR start, Sci_PositionCR end, SearchWordType searchWordType, bool searchForward = true, int searchFlags = SCFIND_WHOLEWORD);
-      void findWords(Sci_PositionCR start, Sci_PositionCR end, word_list_t words, result_list_t& foundPosList, SearchWordType searchWordType, bool searchForward = true);
+      // Scan document text between start and end for given keywords in a single pass. Callback is called with each whole word
+      // found in the style of search word type, and scanning stops when it returns false.
+      template <class Callback>
+      void scanKeywords(Sci_PositionCR start, Sci_PositionCR end, const std::vector<int>& wordIndexes, SearchWordType searchWordType, bool searchForward, Callback callback);
+      bool isWholeWordAt(Sci_PositionCR pos, Sci_PositionCR length) const;
 
       void setupIndicator();
       void showIndicator();
@@ -84,11 +116,19 @@ namespace papyrus {
       HWND handle {0};
       Sci_PositionCR docLength {0};
 
+      // Document text retrieved from Scintilla when matching. Only valid until the document is modified.
+      const char* docText {nullptr};
+
       int indicatorID {0};
       int allocatedIndicatorID {0};
+      utility::IndicatorRanges indicatorRanges;
 
       bool matched {false};
       Sci_PositionCR matchedPos {0};
+
+      // Cached match result is for this key
+      std::optional<MatchKey> cachedMatchKey;
+      size_t modificationCount {0};
   };
 
 } // namespace
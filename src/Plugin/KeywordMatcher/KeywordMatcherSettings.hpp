@@ -50,6 +50,10 @@ namespace papyrus {
     utility::PrimitiveTypeValueMonitor<COLORREF> matchedIndicatorForegroundColor;
     utility::PrimitiveTypeValueMonitor<int>      unmatchedIndicatorStyle;
     utility::PrimitiveTypeValueMonitor<COLORREF> unmatchedIndicatorForegroundColor;
+    utility::PrimitiveTypeValueMonitor<bool>     enableBlockCheck;
+    utility::PrimitiveTypeValueMonitor<bool>     enableOccurrenceHighlighting;
+    utility::PrimitiveTypeValueMonitor<bool>     showCaretContext;
+    utility::PrimitiveTypeValueMonitor<bool>     enableAutoIndentation;
   };
 
 } // namespace
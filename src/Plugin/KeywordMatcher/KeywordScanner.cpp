@@ -0,0 +1,81 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KeywordScanner.hpp"
+
+#include "..\Common\StringUtil.hpp"
+
+#include <queue>
+
+namespace papyrus {
+
+  KeywordScanner::KeywordScanner(const std::vector<std::string>& words, bool backward)
+    : wordList(words), backward(backward) {
+    // Build the trie. State 0 is root.
+    transitions.push_back({});
+    outputs.push_back({});
+    for (int wordIndex = 0; wordIndex < static_cast<int>(wordList.size()); ++wordIndex) {
+      const auto& word = wordList[wordIndex];
+      int state = 0;
+      for (size_t i = 0; i < word.size(); ++i) {
+        int index = charIndex(word[backward ? word.size() - 1 - i : i]);
+        if (transitions[state][index] == 0) {
+          transitions[state][index] = static_cast<int>(transitions.size());
+          transitions.push_back({});
+          outputs.push_back({});
+        }
+        state = transitions[state][index];
+      }
+      outputs[state].push_back(wordIndex);
+    }
+
+    // Compute failure links breadth first, and fold them into transitions and outputs
+    std::vector<int> failures(transitions.size(), 0);
+    std::queue<int> states;
+    for (int next : transitions[0]) {
+      if (next != 0) {
+        states.push(next);
+      }
+    }
+    while (!states.empty()) {
+      int state = states.front();
+      states.pop();
+      outputs[state].insert(outputs[state].end(), outputs[failures[state]].begin(), outputs[failures[state]].end());
+      for (int index = 0; index < ALPHABET_SIZE; ++index) {
+        int next = transitions[state][index];
+        if (next != 0) {
+          failures[next] = transitions[failures[state]][index];
+          states.push(next);
+        } else {
+          transitions[state][index] = transitions[failures[state]][index];
+        }
+      }
+    }
+  }
+
+  int KeywordScanner::indexOf(const std::string& word) const {
+    for (int wordIndex = 0; wordIndex < static_cast<int>(wordList.size()); ++wordIndex) {
+      if (utility::compare(wordList[wordIndex], word)) {
+        return wordIndex;
+      }
+    }
+    return -1;
+  }
+
+} // namespace
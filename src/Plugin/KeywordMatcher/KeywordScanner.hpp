@@ -0,0 +1,77 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\..\external\scintilla\Sci_Position.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace papyrus {
+
+  // Finds all occurrences of a fixed set of alphabetic words in a single pass, case insensitively, using an Aho-Corasick
+  // automaton. Text can be scanned either forward, or backward with an automaton built on reversed words. The scanner only
+  // reports occurrences, and it's up to the caller to check word boundaries.
+  class KeywordScanner {
+    public:
+      KeywordScanner(const std::vector<std::string>& words, bool backward);
+
+      inline const std::vector<std::string>& words() const { return wordList; }
+
+      // Find index of a word, case insensitively. Returns -1 if not found.
+      int indexOf(const std::string& word) const;
+
+      // Scan text between start and end. When scanning backward, start is after end and the text right before start is scanned
+      // first. Callback is called with word index and start position of each occurrence, in the order they are found, and
+      // scanning stops when it returns false.
+      template <class Callback>
+      void scan(const char* text, Sci_PositionCR start, Sci_PositionCR end, Callback callback) const {
+        int state = 0;
+        Sci_PositionCR step = backward ? -1 : 1;
+        for (Sci_PositionCR pos = backward ? start - 1 : start; backward ? pos >= end : pos < end; pos += step) {
+          state = transitions[state][charIndex(text[pos])];
+          for (int wordIndex : outputs[state]) {
+            Sci_PositionCR wordStart = backward ? pos : pos - static_cast<Sci_PositionCR>(wordList[wordIndex].size()) + 1;
+            if (!callback(wordIndex, wordStart)) {
+              return;
+            }
+          }
+        }
+      }
+
+    private:
+      static constexpr int ALPHABET_SIZE = 27; // a - z, and anything else
+
+      inline static int charIndex(char ch) {
+        return (ch >= 'a' && ch <= 'z') ? ch - 'a' : (ch >= 'A' && ch <= 'Z') ? ch - 'A' : ALPHABET_SIZE - 1;
+      }
+
+      // Private members
+      //
+      std::vector<std::string> wordList;
+      bool backward;
+
+      // Automaton with failure links already folded into transitions, so each character takes exactly one step
+      std::vector<std::array<int, ALPHABET_SIZE>> transitions;
+      std::vector<std::vector<int>> outputs;
+  };
+
+} // namespace
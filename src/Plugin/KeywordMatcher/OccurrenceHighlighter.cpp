@@ -0,0 +1,117 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "OccurrenceHighlighter.hpp"
+
+#include "..\Lexer\Lexer.hpp"
+
+#include <vector>
+
+namespace papyrus {
+
+  OccurrenceHighlighter::OccurrenceHighlighter(const NppData& nppData, const KeywordMatcherSettings& settings)
+    : nppData(nppData), settings(settings) {
+    // Subscribe to settings changes
+    KeywordMatcherSettings& subscribableSettings = const_cast<KeywordMatcherSettings&>(settings);
+    subscribableSettings.enableOccurrenceHighlighting.subscribe([&](auto eventData) {
+      if (!eventData.newValue) {
+        clear();
+      }
+    });
+    subscribableSettings.matchedIndicatorStyle.subscribe([&](auto) { if (handle != 0) { setupIndicator(handle); } });
+    subscribableSettings.matchedIndicatorForegroundColor.subscribe([&](auto) { if (handle != 0) { setupIndicator(handle); } });
+  }
+
+  void OccurrenceHighlighter::highlight(HWND scintillaHandle, npp_buffer_t bufferID) {
+    if (!settings.enableOccurrenceHighlighting) {
+      return;
+    }
+
+    // Only highlight for caret, not selection, so it doesn't interfere with Notepad++'s smart highlighting of selected text
+    npp_position_t caret = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETCURRENTPOS, 0, 0));
+    auto identifierIndex = Lexer::getIdentifierIndex(bufferID);
+    if (!identifierIndex || caret != static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_GETANCHOR, 0, 0))) {
+      clear();
+      return;
+    }
+
+    npp_position_t line = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_LINEFROMPOSITION, caret, 0));
+    npp_position_t lineStart = static_cast<npp_position_t>(::SendMessage(scintillaHandle, SCI_POSITIONFROMLINE, line, 0));
+    std::string identifier;
+    if (!identifierIndex->findAt(line, caret - lineStart, identifier)) {
+      clear();
+      return;
+    }
+
+    // Generation is taken before finding occurrences, so if the index changes in between, the next call will redo it
+    HighlightKey key {
+      .handle = scintillaHandle,
+      .bufferID = bufferID,
+      .identifier = identifier,
+      .generation = identifierIndex->getGeneration()
+    };
+    if (highlightedKey && *highlightedKey == key) {
+      return;
+    }
+
+    std::vector<IdentifierOccurrence> occurrences;
+    identifierIndex->find(identifier, occurrences);
+    clear();
+    indicatorRanges.clear(scintillaHandle);
+    if (!setupIndicator(scintillaHandle)) {
+      return;
+    }
+
+    handle = scintillaHandle;
+    highlightedKey = key;
+    for (const auto& occurrence : occurrences) {
+      npp_position_t pos = static_cast<npp_position_t>(::SendMessage(handle, SCI_POSITIONFROMLINE, occurrence.line, 0)) + occurrence.column;
+      indicatorRanges.add(pos, occurrence.length);
+    }
+    indicatorRanges.paint(handle, indicatorID);
+  }
+
+  void OccurrenceHighlighter::clear() {
+    if (handle != 0) {
+      indicatorRanges.clear(handle);
+      handle = 0;
+    }
+    highlightedKey.reset();
+  }
+
+  // Private methods
+  //
+
+  bool OccurrenceHighlighter::setupIndicator(HWND scintillaHandle) {
+    if (indicatorID == 0) {
+      if (!static_cast<bool>(::SendMessage(nppData._nppHandle, NPPM_ALLOCATEINDICATOR, 1, reinterpret_cast<LPARAM>(&indicatorID)))) {
+        // Likely no available indicator ID left.
+        indicatorID = -1;
+      }
+    }
+    if (indicatorID < 0) {
+      return false;
+    }
+
+    ::SendMessage(scintillaHandle, SCI_INDICSETSTYLE, indicatorID, settings.matchedIndicatorStyle);
+    ::SendMessage(scintillaHandle, SCI_INDICSETFORE, indicatorID, settings.matchedIndicatorForegroundColor);
+    return true;
+  }
+
+} // namespace
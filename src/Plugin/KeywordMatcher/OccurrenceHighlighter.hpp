@@ -0,0 +1,78 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "KeywordMatcherSettings.hpp"
+
+#include "..\Common\IndicatorRanges.hpp"
+#include "..\Common\NotepadPlusPlus.hpp"
+
+#include "..\..\external\npp\PluginInterface.h"
+
+#include <optional>
+#include <string>
+
+namespace papyrus {
+
+  // Highlights all occurrences of the identifier at caret, e.g. a property, a variable or a function. Unlike Notepad++'s smart
+  // highlighting, occurrences come from identifier index built by lexer, so words in comments and strings are never matched
+  // and the document is never searched.
+  class OccurrenceHighlighter {
+    public:
+      OccurrenceHighlighter(const NppData& nppData, const KeywordMatcherSettings& settings);
+
+      // Highlight occurrences of the identifier at caret. Result is cached, so it's only redone when caret moves to another
+      // identifier or the index changes.
+      void highlight(HWND scintillaHandle, npp_buffer_t bufferID);
+
+      // Document content has changed, so highlighted occurrences have moved
+      inline void contentChanged(HWND scintillaHandle, npp_position_t position, npp_length_t lengthAdded) {
+        indicatorRanges.contentChanged(scintillaHandle, position, lengthAdded);
+      }
+
+      void clear();
+
+    private:
+      // Identifies what highlighted occurrences were found for
+      struct HighlightKey {
+        HWND handle;
+        npp_buffer_t bufferID;
+        std::string identifier;
+        size_t generation;
+
+        bool operator==(const HighlightKey&) const = default;
+      };
+
+      bool setupIndicator(HWND scintillaHandle);
+
+      // Private members
+      //
+      const NppData& nppData;
+      const KeywordMatcherSettings& settings;
+
+      int indicatorID {0};
+      HWND handle {0};
+      utility::IndicatorRanges indicatorRanges;
+
+      // Currently highlighted occurrences are for this key
+      std::optional<HighlightKey> highlightedKey;
+  };
+
+} // namespace
@@ -0,0 +1,247 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AssemblyLexer.hpp"
+
+#include "LexerData.hpp"
+#include "LexerIDs.hpp"
+
+#include "..\..\external\lexilla\LexerModule.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace papyrus {
+
+  // Character classes used by the scanner
+  constexpr uint8_t CHAR_OTHER      = 0;
+  constexpr uint8_t CHAR_BLANK      = 0b1;
+  constexpr uint8_t CHAR_LINE_END   = 0b10;
+  constexpr uint8_t CHAR_WORD_START = 0b100;
+  constexpr uint8_t CHAR_WORD       = 0b1000;
+  constexpr uint8_t CHAR_DIGIT      = 0b10000;
+  constexpr uint8_t CHAR_NUMBER     = 0b100000;
+
+  // Longest word that needs to be looked up in word lists, e.g. "array_rfindelement"
+  constexpr size_t MAX_WORD_LENGTH = 32;
+
+  namespace {
+    constexpr std::array<uint8_t, 256> createCharClasses() {
+      std::array<uint8_t, 256> charClasses {};
+      charClasses[' '] = charClasses['\t'] = CHAR_BLANK;
+      charClasses['\r'] = charClasses['\n'] = CHAR_LINE_END;
+      for (int ch = 'a'; ch <= 'z'; ++ch) {
+        charClasses[ch] = charClasses[ch - 'a' + 'A'] = CHAR_WORD_START | CHAR_WORD;
+      }
+      for (int ch = 'a'; ch <= 'f'; ++ch) {
+        charClasses[ch] |= CHAR_NUMBER;
+        charClasses[ch - 'a' + 'A'] |= CHAR_NUMBER;
+      }
+      for (int ch = '0'; ch <= '9'; ++ch) {
+        charClasses[ch] = CHAR_DIGIT | CHAR_NUMBER | CHAR_WORD;
+      }
+      charClasses['_'] = CHAR_WORD_START | CHAR_WORD;
+      charClasses[':'] = CHAR_WORD; // FO4's namespaces, and also label definitions
+      charClasses['x'] |= CHAR_NUMBER;
+      charClasses['X'] |= CHAR_NUMBER;
+      charClasses['.'] = CHAR_NUMBER;
+      return charClasses;
+    }
+
+    constexpr std::array<uint8_t, 256> charClasses = createCharClasses();
+
+    inline uint8_t charClass(char ch) {
+      return charClasses[static_cast<unsigned char>(ch)];
+    }
+
+    inline bool isJumpOpcode(const char* opcode) {
+      return std::strcmp(opcode, "jmp") == 0 || std::strcmp(opcode, "jmpt") == 0 || std::strcmp(opcode, "jmpf") == 0;
+    }
+  }
+
+  AssemblyLexer::AssemblyLexer()
+    : SimpleLexerBase(ASSEMBLY_LEXER_NAME, SCLEX_PAPYRUS_ASSEMBLY),
+      instreWordLists{&wordListOpcodes, &wordListKeywords},
+      typeWordLists{&wordListFoldDirectives} {
+  }
+
+  void SCI_METHOD AssemblyLexer::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument* pAccess) {
+    if (isUsable()) {
+      Accessor accessor(pAccess, nullptr);
+
+      // Nothing spans multiple lines, so always start from the beginning of a line.
+      Sci_Position start = accessor.LineStart(accessor.GetLine(startPos));
+      Sci_Position end = startPos + lengthDoc;
+      accessor.StartAt(start);
+      accessor.StartSegment(start);
+
+      char word[MAX_WORD_LENGTH + 1];
+      bool afterJump = false; // Jump target is a label
+      Sci_Position position = start;
+      while (position < end) {
+        char ch = accessor[position];
+        uint8_t chClass = charClass(ch);
+        if (chClass & (CHAR_BLANK | CHAR_LINE_END)) {
+          if (chClass & CHAR_LINE_END) {
+            afterJump = false;
+          }
+          position++;
+          continue;
+        }
+
+        // Default style for everything in between tokens
+        accessor.ColourTo(position - 1, std::to_underlying(State::Default));
+
+        State state = State::Default;
+        Sci_Position tokenEnd = position + 1;
+        if (ch == ';') {
+          // Comment till the end of line
+          while (tokenEnd < end && !(charClass(accessor[tokenEnd]) & CHAR_LINE_END)) {
+            tokenEnd++;
+          }
+          state = State::Comment;
+        } else if (ch == '"') {
+          // Single line string with escapes
+          while (tokenEnd < end && !(charClass(accessor[tokenEnd]) & CHAR_LINE_END)) {
+            char chString = accessor[tokenEnd++];
+            if (chString == '\\') {
+              tokenEnd++;
+            } else if (chString == '"') {
+              break;
+            }
+          }
+          state = State::String;
+        } else if (ch == '.' && (charClass(accessor.SafeGetCharAt(position + 1)) & CHAR_WORD_START)) {
+          // Directive, e.g. ".function"
+          tokenEnd = readWord(accessor, position + 1, end, word, sizeof(word));
+          state = State::Directive;
+        } else if (ch == ':' && accessor.SafeGetCharAt(position + 1) == ':') {
+          // Register, e.g. "::temp0" or "::NoneVar"
+          while (tokenEnd < end && (charClass(accessor[tokenEnd]) & CHAR_WORD)) {
+            tokenEnd++;
+          }
+          state = State::Register;
+        } else if ((chClass & CHAR_DIGIT) || (ch == '-' && (charClass(accessor.SafeGetCharAt(position + 1)) & CHAR_DIGIT))) {
+          while (tokenEnd < end && (charClass(accessor[tokenEnd]) & CHAR_NUMBER)) {
+            tokenEnd++;
+          }
+          state = State::Number;
+        } else if (chClass & CHAR_WORD_START) {
+          tokenEnd = readWord(accessor, position, end, word, sizeof(word));
+          if (accessor[tokenEnd - 1] == ':') {
+            // Label definition, e.g. "label1:"
+            state = State::Label;
+          } else if (wordListOpcodes.InList(word)) {
+            state = State::Opcode;
+            afterJump = isJumpOpcode(word);
+          } else if (wordListKeywords.InList(word)) {
+            state = State::Keyword;
+          } else if (afterJump) {
+            state = State::Label;
+          }
+        }
+
+        tokenEnd = std::min(tokenEnd, end); // An escape at the end of styling range
+        accessor.ColourTo(tokenEnd - 1, std::to_underlying(state));
+        position = tokenEnd;
+      }
+      accessor.ColourTo(end - 1, std::to_underlying(State::Default));
+      accessor.Flush();
+    }
+  }
+
+  void SCI_METHOD AssemblyLexer::Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument* pAccess) {
+    if (isUsable()) {
+      Accessor accessor(pAccess, nullptr);
+
+      char word[MAX_WORD_LENGTH + 1];
+      int levelPrev = accessor.LevelAt(accessor.GetLine(startPos)) & SC_FOLDLEVELNUMBERMASK;
+      for (auto line = accessor.GetLine(startPos); line <= accessor.GetLine(startPos + lengthDoc); ++line) {
+        // Sections are always defined by directives at the beginning of a line, e.g. ".function" and ".endFunction".
+        int levelDelta = 0;
+        Sci_Position position = accessor.LineStart(line);
+        Sci_Position lineEnd = accessor.LineEnd(line);
+        while (position < lineEnd && (charClass(accessor[position]) & CHAR_BLANK)) {
+          position++;
+        }
+        if (position < lineEnd && accessor[position] == '.') {
+          position = readWord(accessor, position + 1, lineEnd, word, sizeof(word));
+          if (std::strncmp(word, "end", 3) == 0) {
+            levelDelta = -1;
+          } else if (wordListFoldDirectives.InList(word)) {
+            levelDelta = 1;
+
+            // ".property" inside a property group only lists property name, and doesn't have a matching ".endProperty".
+            if (std::strcmp(word, "property") == 0) {
+              int operandCount = 0;
+              while (position < lineEnd && accessor[position] != ';') {
+                if (charClass(accessor[position]) & CHAR_BLANK) {
+                  position++;
+                } else {
+                  operandCount++;
+                  while (position < lineEnd && !(charClass(accessor[position]) & CHAR_BLANK)) {
+                    position++;
+                  }
+                }
+              }
+              if (operandCount < 2) {
+                levelDelta = 0;
+              }
+            }
+          }
+        }
+
+        int level = levelPrev;
+        if (levelDelta > 0) {
+          level |= SC_FOLDLEVELHEADERFLAG;
+        }
+        accessor.SetLevel(line, level);
+        levelPrev += levelDelta;
+      }
+    }
+  }
+
+  // Protected methods
+  //
+
+  bool AssemblyLexer::isUsable() const {
+    return lexerData != nullptr && lexerData->usable;
+  }
+
+  // Private methods
+  //
+
+  Sci_Position AssemblyLexer::readWord(Accessor& accessor, Sci_Position position, Sci_Position end, char* buffer, size_t bufferSize) const {
+    size_t length = 0;
+    while (position < end && (charClass(accessor[position]) & CHAR_WORD)) {
+      if (length < bufferSize - 1) {
+        buffer[length] = static_cast<char>(std::tolower(static_cast<unsigned char>(accessor[position])));
+      }
+      length++;
+      position++;
+    }
+    buffer[length < bufferSize ? length : 0] = '\0';
+    return position;
+  }
+
+} // namespace
@@ -0,0 +1,92 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SimpleLexerBase.hpp"
+
+#include "..\..\external\lexilla\Accessor.h"
+#include "..\..\external\lexilla\WordList.h"
+#include "..\..\external\scintilla\ILexer.h"
+
+#include <vector>
+
+#include <windows.h>
+
+namespace papyrus {
+
+  constexpr char ASSEMBLY_LEXER_NAME[] = "Papyrus Assembly";
+  constexpr TCHAR ASSEMBLY_LEXER_STATUS_TEXT[] = L"Papyrus Assembly"; // Not required anymore, but kept for compatibility with Notepad++ 8.3 - 8.3.3
+
+  // Lexer for Papyrus assembly (.pas) files generated by PapyrusCompiler. Generated files can be really large, so this lexer is built for
+  // throughput: characters are classified through a lookup table, words are looked up from a stack buffer, and nothing in the assembly
+  // syntax spans multiple lines, so lexing can always restart from the beginning of a line without any saved state.
+  class AssemblyLexer : public SimpleLexerBase {
+    public:
+      AssemblyLexer();
+
+      // Interface functions with Notepad++
+      inline static char* name() { return const_cast<char*>(ASSEMBLY_LEXER_NAME); }
+      inline static TCHAR* statusText() { return const_cast<TCHAR*>(ASSEMBLY_LEXER_STATUS_TEXT); }  // Not required anymore, but kept for compatibility with Notepad++ 8.3 - 8.3.3
+      inline static ILexer* factory() { return new AssemblyLexer(); }
+
+      // Lexer functions
+      void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument* pAccess) override;
+      void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument* pAccess) override;
+
+    protected:
+      // Only when configuration file exists under Notepad++'s plugin config folder can this lexer be used
+      bool isUsable() const override;
+
+      // Get word lists pointers for instre1 & 2, type1
+      inline const std::vector<WordList*>& getInstreWordLists() const override { return instreWordLists; }
+      inline const std::vector<WordList*>& getTypeWordLists() const override { return typeWordLists; }
+
+    private:
+      // Lexer style states
+      enum class State {
+        Default,
+        Directive,
+        Opcode,
+        Keyword,
+        Register,
+        Label,
+        Comment,
+        Number,
+        String
+      };
+
+      // Read a word starting at given position into buffer, lower-cased and null terminated. Returns the position after the word.
+      // If the word is longer than the buffer, the buffer contains an empty string so it never matches any word list.
+      Sci_Position readWord(Accessor& accessor, Sci_Position position, Sci_Position end, char* buffer, size_t bufferSize) const;
+
+      // Private members
+      //
+
+      // Word lists for different function groups
+      WordList wordListOpcodes;         // instre1
+      WordList wordListKeywords;        // instre2
+      WordList wordListFoldDirectives;  // type1
+
+      // Provide pointers to corresponding word lists to base class
+      const std::vector<WordList*> instreWordLists;
+      const std::vector<WordList*> typeWordLists;
+  };
+
+} // namespace
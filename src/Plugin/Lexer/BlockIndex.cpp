@@ -0,0 +1,512 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BlockIndex.hpp"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace papyrus {
+
+  using Lock = std::lock_guard<std::mutex>;
+
+  constexpr size_t NO_MATCH = static_cast<size_t>(-1);
+
+  namespace {
+    struct BlockKeywordDefinition {
+      std::string_view word;
+      BlockType type;
+      BlockRole role;
+    };
+
+    constexpr BlockKeywordDefinition blockKeywordDefinitions[] {
+      {"function", BlockType::Function, BlockRole::Open},
+      {"endfunction", BlockType::Function, BlockRole::Close},
+      {"native", BlockType::Function, BlockRole::Close},
+      {"struct", BlockType::Struct, BlockRole::Open},
+      {"endstruct", BlockType::Struct, BlockRole::Close},
+      {"property", BlockType::Property, BlockRole::Open},
+      {"endproperty", BlockType::Property, BlockRole::Close},
+      {"auto", BlockType::Property, BlockRole::Close},
+      {"autoreadonly", BlockType::Property, BlockRole::Close},
+      {"group", BlockType::Group, BlockRole::Open},
+      {"endgroup", BlockType::Group, BlockRole::Close},
+      {"state", BlockType::State, BlockRole::Open},
+      {"endstate", BlockType::State, BlockRole::Close},
+      {"event", BlockType::Event, BlockRole::Open},
+      {"endevent", BlockType::Event, BlockRole::Close},
+      {"if", BlockType::If, BlockRole::Open},
+      {"elseif", BlockType::If, BlockRole::Middle},
+      {"else", BlockType::If, BlockRole::Middle},
+      {"endif", BlockType::If, BlockRole::Close},
+      {"while", BlockType::While, BlockRole::Open},
+      {"endwhile", BlockType::While, BlockRole::Close}
+    };
+
+    // Flow control blocks can be nested. Other blocks can't, and their keywords are simply paired with adjacent ones.
+    inline bool isNestable(BlockType type) {
+      return type == BlockType::If || type == BlockType::While;
+    }
+
+    // Index of depth change of nestable block types in keyword summary
+    inline size_t depthIndex(BlockType type) {
+      return (type == BlockType::If) ? 0 : 1;
+    }
+
+    inline uint16_t typeBit(BlockType type) {
+      return static_cast<uint16_t>(1 << std::to_underlying(type));
+    }
+  }
+
+  // Finds the next or previous keyword of given types
+  struct BlockIndex::TypeSearcher {
+    uint16_t types;
+
+    inline bool contains(const KeywordSummary& summary) const { return (summary.types & types) != 0; }
+    inline void skip(const KeywordSummary&) const {}
+  };
+
+  // Finds where depth of a nestable block type first reaches a target, relative to where the search starts. Going forward,
+  // reaching -1 finds the closing keyword of the block the search starts in. Going backward, reaching 1 finds its opening one.
+  struct BlockIndex::DepthSearcher {
+    size_t index;
+    bool forward;
+    int target;
+    int depth {0};
+
+    inline bool contains(const KeywordSummary& summary) const {
+      const auto& depthChange = summary.depthChanges[index];
+      return forward ? (depth + depthChange.lowest <= target) : (depth + depthChange.highestFromEnd >= target);
+    }
+
+    inline void skip(const KeywordSummary& summary) {
+      depth += summary.depthChanges[index].total;
+    }
+  };
+
+  bool BlockIndex::isBlockKeyword(std::string_view word, BlockType& type, BlockRole& role) {
+    for (const auto& definition : blockKeywordDefinitions) {
+      if (definition.word == word) {
+        type = definition.type;
+        role = definition.role;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void BlockIndex::reset(bool usable) {
+    Lock lock(mutex);
+    this->usable = usable;
+    keywords.clear();
+    changed();
+  }
+
+  bool BlockIndex::getKeywords(std::vector<BlockKeyword>& allKeywords) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    allKeywords.clear();
+    allKeywords.reserve(keywords.size());
+    keywords.forEach([&](Sci_Position line, const IndexedKeyword& keyword) {
+      allKeywords.push_back(BlockKeyword {
+        .line = line,
+        .column = keyword.column,
+        .length = keyword.length,
+        .type = keyword.type,
+        .role = keyword.role,
+        .nameColumn = keyword.nameColumn,
+        .nameLength = keyword.nameLength
+      });
+    });
+    return true;
+  }
+
+  void BlockIndex::restore(const std::vector<BlockKeyword>& allKeywords) {
+    Lock lock(mutex);
+    usable = true;
+    keywords.clear();
+    for (const auto& keyword : allKeywords) {
+      keywords.insert(keyword.line, IndexedKeyword {
+        .column = keyword.column,
+        .length = keyword.length,
+        .type = keyword.type,
+        .role = keyword.role,
+        .nameColumn = keyword.nameColumn,
+        .nameLength = keyword.nameLength
+      });
+    }
+    changed();
+  }
+
+  void BlockIndex::clearLine(Sci_Position line) {
+    Lock lock(mutex);
+    if (keywords.eraseLines(line, line)) {
+      changed();
+    }
+  }
+
+  void BlockIndex::addKeyword(Sci_Position line, Sci_Position column, Sci_Position length, BlockType type, BlockRole role, Sci_Position nameColumn, Sci_Position nameLength) {
+    Lock lock(mutex);
+
+    // "Native" also ends native events, e.g. "Event OnInit() Native"
+    if (type == BlockType::Function && role == BlockRole::Close) {
+      auto nextLine = keywords.lowerBound(line + 1);
+      auto lastOnLine = (nextLine != nullptr) ? keywords.previous(nextLine) : keywords.last();
+      if (lastOnLine != nullptr && lastOnLine->item().type == BlockType::Event && lastOnLine->item().role == BlockRole::Open
+        && keywords.lineOf(lastOnLine) == line) {
+        type = BlockType::Event;
+      }
+    }
+
+    keywords.insert(line, IndexedKeyword {
+      .column = column,
+      .length = length,
+      .type = type,
+      .role = role,
+      .nameColumn = nameColumn,
+      .nameLength = nameLength
+    });
+    changed();
+  }
+
+  void BlockIndex::shiftLines(Sci_Position line, Sci_Position linesAdded) {
+    if (linesAdded == 0) {
+      return;
+    }
+
+    Lock lock(mutex);
+    keywords.shiftLines(line, linesAdded);
+    changed();
+  }
+
+  bool BlockIndex::findOnLine(Sci_Position line, std::vector<BlockKeyword>& keywordsOnLine) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    keywordsOnLine.clear();
+    auto nextLine = keywords.lowerBound(line + 1);
+    for (auto node = keywords.lowerBound(line); node != nextLine; node = keywords.next(node)) {
+      keywordsOnLine.push_back(toBlockKeyword(node));
+    }
+    return true;
+  }
+
+  bool BlockIndex::find(Sci_Position line, Sci_Position column, BlockMatch& blockMatch) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    auto node = findNode(line, column);
+    if (node == nullptr) {
+      return false;
+    }
+
+    blockMatch.current = toBlockKeyword(node);
+    blockMatch.related.clear();
+
+    // Middle keywords are matched to the opening keyword, and the closing keyword becomes related. Others are matched to their
+    // partners, and middle keywords of the block become related.
+    auto matchingNode = findMatch(node);
+    const KeywordNode* openingNode = nullptr;
+    if (node->item().role == BlockRole::Middle) {
+      openingNode = matchingNode;
+      if (openingNode != nullptr) {
+        if (auto closingNode = findMatch(openingNode)) {
+          blockMatch.related.push_back(toBlockKeyword(closingNode));
+        }
+      }
+    } else {
+      openingNode = (node->item().role == BlockRole::Open) ? node : matchingNode;
+    }
+
+    blockMatch.matched = (matchingNode != nullptr);
+    if (blockMatch.matched) {
+      blockMatch.matching = toBlockKeyword(matchingNode);
+    }
+    if (openingNode != nullptr) {
+      std::vector<const KeywordNode*> middles;
+      findMiddles(openingNode, middles);
+      for (auto middleNode : middles) {
+        if (middleNode != node) {
+          blockMatch.related.push_back(toBlockKeyword(middleNode));
+        }
+      }
+    }
+    return true;
+  }
+
+  bool BlockIndex::findUnbalancedKeywords(std::vector<BlockKeyword>& unbalancedKeywords) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    // This reports on the whole document anyway, so simply go through all keywords once, tracking open blocks
+    std::vector<const KeywordNode*> allKeywords;
+    allKeywords.reserve(keywords.size());
+    for (auto node = keywords.first(); node != nullptr; node = keywords.next(node)) {
+      allKeywords.push_back(node);
+    }
+    std::vector<bool> unbalanced(allKeywords.size(), true);
+    std::vector<bool> overlapped(allKeywords.size(), false);
+
+    // All open nestable blocks regardless of type, to detect blocks closed out of order, e.g. "If ... While ... EndIf ... EndWhile"
+    std::vector<size_t> nestedBlocks;
+
+    // Per block type, open nestable blocks, and the last seen keyword of non-nestable blocks
+    std::map<BlockType, std::vector<size_t>> openBlocks;
+    std::map<BlockType, size_t> lastKeywords;
+    for (size_t index = 0; index < allKeywords.size(); ++index) {
+      const auto& keyword = allKeywords[index]->item();
+      if (isNestable(keyword.type)) {
+        auto& blocks = openBlocks[keyword.type];
+        if (keyword.role == BlockRole::Open) {
+          blocks.push_back(index);
+          nestedBlocks.push_back(index);
+        } else if (!blocks.empty()) {
+          unbalanced[index] = false;
+          if (keyword.role == BlockRole::Close) {
+            unbalanced[blocks.back()] = false;
+
+            // Blocks opened after this one but not yet closed are crossed by it, so both sides overlap
+            auto nestedBlock = std::find(nestedBlocks.rbegin(), nestedBlocks.rend(), blocks.back()).base() - 1;
+            if (nestedBlock + 1 != nestedBlocks.end()) {
+              overlapped[index] = overlapped[blocks.back()] = true;
+              for (auto crossedBlock = nestedBlock + 1; crossedBlock != nestedBlocks.end(); ++crossedBlock) {
+                overlapped[*crossedBlock] = true;
+              }
+            } else if (overlapped[blocks.back()]) {
+              overlapped[index] = true;
+            }
+            nestedBlocks.erase(nestedBlock);
+            blocks.pop_back();
+          }
+        }
+      } else {
+        auto iter = lastKeywords.find(keyword.type);
+        if (iter != lastKeywords.end() && allKeywords[iter->second]->item().role == BlockRole::Open && keyword.role == BlockRole::Close) {
+          unbalanced[index] = unbalanced[iter->second] = false;
+        }
+        lastKeywords[keyword.type] = index;
+      }
+    }
+
+    unbalancedKeywords.clear();
+    for (size_t index = 0; index < allKeywords.size(); ++index) {
+      if (unbalanced[index] || overlapped[index]) {
+        unbalancedKeywords.push_back(toBlockKeyword(allKeywords[index]));
+      }
+    }
+    return true;
+  }
+
+  bool BlockIndex::findEnclosingBlocks(Sci_Position line, Sci_Position column, std::vector<BlockRange>& blocks) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    // Blocks are searched backward from the first keyword after the location. A closing keyword the location is on still
+    // counts as being in the block, so the search starts from it instead.
+    auto nextLine = keywords.lowerBound(line + 1);
+    auto start = keywords.lowerBound(line);
+    while (start != nextLine && start->item().column <= column) {
+      start = keywords.next(start);
+    }
+    auto last = (start != nullptr) ? keywords.previous(start) : keywords.last();
+    if (last != nullptr && last->item().role == BlockRole::Close && keywords.lineOf(last) == line && column <= last->item().column + last->item().length) {
+      start = last;
+    }
+
+    std::vector<std::pair<const KeywordNode*, const KeywordNode*>> blockNodes;
+    auto addBlock = [&](const KeywordNode* opening) {
+      if (auto closing = findMatch(opening)) {
+        blockNodes.emplace_back(opening, closing);
+      }
+    };
+    for (auto type : {BlockType::Function, BlockType::Struct, BlockType::Property, BlockType::Group, BlockType::State, BlockType::Event}) {
+      // Non-nestable blocks are paired with adjacent keywords, so only the previous keyword of the same type can open one
+      TypeSearcher searcher {
+        .types = typeBit(type)
+      };
+      auto opening = keywords.findPrevious(start, searcher);
+      if (opening != nullptr && opening->item().role == BlockRole::Open) {
+        addBlock(opening);
+      }
+    }
+    for (auto type : {BlockType::If, BlockType::While}) {
+      // Each nestable block still open before the location is found by going backward until depth rises above it. Blocks that
+      // are never closed are skipped, but the ones enclosing them aren't.
+      for (const KeywordNode* from = start;;) {
+        DepthSearcher searcher {
+          .index = depthIndex(type),
+          .forward = false,
+          .target = 1
+        };
+        auto opening = keywords.findPrevious(from, searcher);
+        if (opening == nullptr) {
+          break;
+        }
+        addBlock(opening);
+        from = opening;
+      }
+    }
+
+    blocks.clear();
+    for (const auto& [opening, closing] : blockNodes) {
+      blocks.push_back(BlockRange {
+        .opening = toBlockKeyword(opening),
+        .closing = toBlockKeyword(closing)
+      });
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const auto& block1, const auto& block2) {
+      return std::tie(block1.opening.line, block1.opening.column) < std::tie(block2.opening.line, block2.opening.column);
+    });
+    return true;
+  }
+
+  // Private methods
+  //
+
+  BlockIndex::KeywordSummary BlockIndex::KeywordSummary::of(const IndexedKeyword& keyword) {
+    KeywordSummary summary {
+      .types = typeBit(keyword.type)
+    };
+    if (isNestable(keyword.type)) {
+      auto& depthChange = summary.depthChanges[depthIndex(keyword.type)];
+      if (keyword.role == BlockRole::Open) {
+        depthChange = {
+          .total = 1,
+          .lowest = 0,
+          .highestFromEnd = 1
+        };
+      } else if (keyword.role == BlockRole::Close) {
+        depthChange = {
+          .total = -1,
+          .lowest = -1,
+          .highestFromEnd = 0
+        };
+      }
+    }
+    return summary;
+  }
+
+  BlockIndex::KeywordSummary BlockIndex::KeywordSummary::combine(const KeywordSummary& summary1, const KeywordSummary& summary2) {
+    KeywordSummary summary {
+      .types = static_cast<uint16_t>(summary1.types | summary2.types)
+    };
+    for (size_t index = 0; index < summary.depthChanges.size(); ++index) {
+      const auto& depthChange1 = summary1.depthChanges[index];
+      const auto& depthChange2 = summary2.depthChanges[index];
+      summary.depthChanges[index] = {
+        .total = depthChange1.total + depthChange2.total,
+        .lowest = std::min(depthChange1.lowest, depthChange1.total + depthChange2.lowest),
+        .highestFromEnd = std::max(depthChange2.highestFromEnd, depthChange2.total + depthChange1.highestFromEnd)
+      };
+    }
+    return summary;
+  }
+
+  BlockKeyword BlockIndex::toBlockKeyword(const KeywordNode* node) const {
+    const auto& keyword = node->item();
+    return BlockKeyword {
+      .line = keywords.lineOf(node),
+      .column = keyword.column,
+      .length = keyword.length,
+      .type = keyword.type,
+      .role = keyword.role,
+      .nameColumn = keyword.nameColumn,
+      .nameLength = keyword.nameLength
+    };
+  }
+
+  BlockIndex::KeywordNode* BlockIndex::findNode(Sci_Position line, Sci_Position column) const {
+    auto nextLine = keywords.lowerBound(line + 1);
+    for (auto node = keywords.lowerBound(line); node != nextLine; node = keywords.next(node)) {
+      if (node->item().column == column) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  BlockIndex::KeywordNode* BlockIndex::findMatch(const KeywordNode* node) const {
+    const auto& keyword = node->item();
+    if (isNestable(keyword.type)) {
+      // Closing keyword is where the block's depth drops below it. Opening keyword, for both closing and middle keywords, is
+      // the innermost block still open before them.
+      DepthSearcher searcher {
+        .index = depthIndex(keyword.type),
+        .forward = (keyword.role == BlockRole::Open),
+        .target = (keyword.role == BlockRole::Open) ? -1 : 1
+      };
+      return searcher.forward ? keywords.findNext(node, searcher) : keywords.findPrevious(node, searcher);
+    }
+
+    // Non-nestable keywords are simply paired with adjacent ones of the same type
+    TypeSearcher searcher {
+      .types = typeBit(keyword.type)
+    };
+    if (keyword.role == BlockRole::Open) {
+      auto nextNode = keywords.findNext(node, searcher);
+      return (nextNode != nullptr && nextNode->item().role == BlockRole::Close) ? nextNode : nullptr;
+    } else {
+      auto previousNode = keywords.findPrevious(node, searcher);
+      return (previousNode != nullptr && previousNode->item().role == BlockRole::Open) ? previousNode : nullptr;
+    }
+  }
+
+  void BlockIndex::findMiddles(const KeywordNode* opening, std::vector<const KeywordNode*>& middles) const {
+    if (!isNestable(opening->item().type)) {
+      return;
+    }
+
+    // Go through keywords of the same type, skipping nested blocks
+    TypeSearcher searcher {
+      .types = typeBit(opening->item().type)
+    };
+    for (auto node = keywords.findNext(opening, searcher); node != nullptr; node = keywords.findNext(node, searcher)) {
+      if (node->item().role == BlockRole::Close) {
+        break;
+      }
+      if (node->item().role == BlockRole::Middle) {
+        middles.push_back(node);
+      } else {
+        node = findMatch(node);
+        if (node == nullptr) {
+          // Everything after an unclosed nested block belongs to it
+          break;
+        }
+      }
+    }
+  }
+
+  void BlockIndex::changed() {
+    generation++;
+  }
+
+} // namespace
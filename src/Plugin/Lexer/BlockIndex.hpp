@@ -0,0 +1,173 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\Common\LineTree.hpp"
+
+#include "..\..\external\scintilla\Sci_Position.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace papyrus {
+
+  // Block structures that have keywords to be matched
+  enum class BlockType {
+    Function,
+    Struct,
+    Property,
+    Group,
+    State,
+    Event,
+    If,
+    While
+  };
+
+  // Role of a keyword in its block, e.g. "If" opens a block, "ElseIf" is in the middle, and "EndIf" closes it
+  enum class BlockRole {
+    Open,
+    Middle,
+    Close
+  };
+
+  // A block keyword found by lexer, located by line and column so it survives edits on other lines
+  struct BlockKeyword {
+    Sci_Position line;
+    Sci_Position column;
+    Sci_Position length;
+    BlockType type;
+    BlockRole role;
+    Sci_Position nameColumn {0}; // Name of the block for opening keywords, e.g. function name. Empty if length is 0.
+    Sci_Position nameLength {0};
+  };
+
+  // Result of looking up a block keyword in the index
+  struct BlockMatch {
+    BlockKeyword current;
+    bool matched {false};
+    BlockKeyword matching {};
+    std::vector<BlockKeyword> related; // Other keywords in the same block, e.g. "Else" and "ElseIf" in an "If" block
+  };
+
+  // A block from its opening keyword to its closing keyword
+  struct BlockRange {
+    BlockKeyword opening;
+    BlockKeyword closing;
+  };
+
+  // Index of block keywords of a document, built from lexer output. Lexer updates keywords of each line it lexes, and line
+  // numbers are shifted when lines are added or deleted. Keywords are kept in a tree with lines stored relative to each other,
+  // so both only touch keywords around the edit. Matching pairs are not stored at all. Instead, the tree keeps a summary of how
+  // keywords in each subtree change the nesting depth, so a keyword's match is found by a search that skips whole subtrees.
+  class BlockIndex {
+    public:
+      // Check whether a lower-cased word is a block keyword. If so, its block type and role are returned in the parameters.
+      static bool isBlockKeyword(std::string_view word, BlockType& type, BlockRole& role);
+
+      // Discard everything. An unusable index never finds anything, e.g. before the document is lexed.
+      void reset(bool usable);
+
+      // Get all keywords in document order, e.g. to store them along with cached styles. Returns false if the index is unusable.
+      bool getKeywords(std::vector<BlockKeyword>& allKeywords);
+
+      // Replace everything with keywords previously returned by getKeywords, e.g. when styles are restored from cache without lexing
+      void restore(const std::vector<BlockKeyword>& allKeywords);
+
+      // Keywords of a line are cleared before the line is lexed, then added back one by one
+      void clearLine(Sci_Position line);
+      void addKeyword(Sci_Position line, Sci_Position column, Sci_Position length, BlockType type, BlockRole role, Sci_Position nameColumn = 0, Sci_Position nameLength = 0);
+
+      // Shift line numbers after lines were added (positive) or deleted (negative) after the given line
+      void shiftLines(Sci_Position line, Sci_Position linesAdded);
+
+      // Get keywords on the given line, in the order they appear. Returns false if the index is unusable.
+      bool findOnLine(Sci_Position line, std::vector<BlockKeyword>& keywordsOnLine);
+
+      // Look up the block keyword at the given location. Returns false if there isn't one, or the index is unusable.
+      bool find(Sci_Position line, Sci_Position column, BlockMatch& blockMatch);
+
+      // Find keywords that are not balanced: opening or closing keywords without a match, middle keywords outside of any block,
+      // and flow control blocks that overlap others instead of nesting in them. Returns false if the index is unusable.
+      bool findUnbalancedKeywords(std::vector<BlockKeyword>& unbalancedKeywords);
+
+      // Find blocks that enclose the given location, from the outermost to the innermost. Returns false if the index is unusable.
+      bool findEnclosingBlocks(Sci_Position line, Sci_Position column, std::vector<BlockRange>& blocks);
+
+      // Generation increases on every change, so a result computed from the index can be checked for staleness
+      inline size_t getGeneration() const { return generation; }
+
+    private:
+      // Keyword as stored in the tree, which tracks its line
+      struct IndexedKeyword {
+        Sci_Position column;
+        Sci_Position length;
+        BlockType type;
+        BlockRole role;
+        Sci_Position nameColumn;
+        Sci_Position nameLength;
+      };
+
+      // Summary of consecutive keywords: types that appear, and for each nestable block type, how depth changes over them
+      struct KeywordSummary {
+        struct DepthChange {
+          int total {0};
+          int lowest {0};            // Lowest depth reached from the start, relative to the depth before them
+          int highestFromEnd {0};    // Highest depth reached going backward from the end, relative to the depth after them
+        };
+
+        uint16_t types {0};
+        std::array<DepthChange, 2> depthChanges {};
+
+        static KeywordSummary of(const IndexedKeyword& keyword);
+        static KeywordSummary combine(const KeywordSummary& summary1, const KeywordSummary& summary2);
+      };
+
+      using KeywordTree = utility::LineTree<IndexedKeyword, KeywordSummary>;
+      using KeywordNode = KeywordTree::Node;
+
+      struct TypeSearcher;
+      struct DepthSearcher;
+
+      BlockKeyword toBlockKeyword(const KeywordNode* node) const;
+      KeywordNode* findNode(Sci_Position line, Sci_Position column) const;
+
+      // Matching keyword of an opening or closing keyword, or the opening keyword of a middle keyword. Returns nullptr if there
+      // isn't one.
+      KeywordNode* findMatch(const KeywordNode* node) const;
+
+      // Middle keywords of a block, in order
+      void findMiddles(const KeywordNode* opening, std::vector<const KeywordNode*>& middles) const;
+
+      void changed();
+
+      // Private members
+      //
+      std::mutex mutex;
+      bool usable {false};
+      std::atomic<size_t> generation {0};
+
+      KeywordTree keywords;
+  };
+
+} // namespace
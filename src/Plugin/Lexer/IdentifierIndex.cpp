@@ -0,0 +1,169 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "IdentifierIndex.hpp"
+
+#include <algorithm>
+
+namespace papyrus {
+
+  using Lock = std::lock_guard<std::mutex>;
+
+  void IdentifierIndex::reset(bool usable) {
+    Lock lock(mutex);
+    this->usable = usable;
+    clear();
+    generation++;
+  }
+
+  bool IdentifierIndex::isUsable() {
+    Lock lock(mutex);
+    return usable;
+  }
+
+  bool IdentifierIndex::getIdentifiers(std::vector<IndexedIdentifier>& allIdentifiers) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    allIdentifiers.clear();
+    allIdentifiers.reserve(identifiers.size());
+    identifiers.forEach([&](Sci_Position line, const IdentifierOnLine& identifierOnLine) {
+      allIdentifiers.push_back(IndexedIdentifier {
+        .line = line,
+        .column = identifierOnLine.column,
+        .identifier = identifierOnLine.identifier
+      });
+    });
+    return true;
+  }
+
+  void IdentifierIndex::restore(const std::vector<IndexedIdentifier>& allIdentifiers) {
+    Lock lock(mutex);
+    usable = true;
+    clear();
+    for (const auto& indexedIdentifier : allIdentifiers) {
+      insert(indexedIdentifier.line, indexedIdentifier.column, indexedIdentifier.identifier);
+    }
+    generation++;
+  }
+
+  void IdentifierIndex::clearLine(Sci_Position line) {
+    Lock lock(mutex);
+    if (eraseLines(line, line)) {
+      generation++;
+    }
+  }
+
+  void IdentifierIndex::addIdentifier(Sci_Position line, Sci_Position column, const std::string& identifier) {
+    Lock lock(mutex);
+    insert(line, column, identifier);
+    generation++;
+  }
+
+  void IdentifierIndex::shiftLines(Sci_Position line, Sci_Position linesAdded) {
+    if (linesAdded == 0) {
+      return;
+    }
+
+    Lock lock(mutex);
+    if (linesAdded < 0) {
+      // Lines deleted. Erase them here, so their occurrences are erased as well.
+      eraseLines(line + 1, line - linesAdded);
+    }
+    identifiers.shiftLines(line, linesAdded);
+    generation++;
+  }
+
+  bool IdentifierIndex::findAt(Sci_Position line, Sci_Position column, std::string& identifier) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    // Caret right after an identifier also counts, as it's where caret ends up after typing the identifier
+    auto nextLine = identifiers.lowerBound(line + 1);
+    for (auto node = identifiers.lowerBound(line); node != nextLine; node = identifiers.next(node)) {
+      const auto& identifierOnLine = node->item();
+      if (column >= identifierOnLine.column && column <= identifierOnLine.column + static_cast<Sci_Position>(identifierOnLine.identifier.length())) {
+        identifier = identifierOnLine.identifier;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool IdentifierIndex::find(const std::string& identifier, std::vector<IdentifierOccurrence>& occurrences) {
+    Lock lock(mutex);
+    if (!usable) {
+      return false;
+    }
+
+    occurrences.clear();
+    auto iter = occurrencesByIdentifier.find(identifier);
+    if (iter != occurrencesByIdentifier.end()) {
+      occurrences.reserve(iter->second.size());
+      for (const auto node : iter->second) {
+        occurrences.push_back(IdentifierOccurrence {
+          .line = identifiers.lineOf(node),
+          .column = node->item().column,
+          .length = static_cast<Sci_Position>(identifier.length())
+        });
+      }
+      std::sort(occurrences.begin(), occurrences.end(), [](const auto& occurrence1, const auto& occurrence2) {
+        return (occurrence1.line != occurrence2.line) ? occurrence1.line < occurrence2.line : occurrence1.column < occurrence2.column;
+      });
+    }
+    return true;
+  }
+
+  // Private methods
+  //
+
+  void IdentifierIndex::clear() {
+    identifiers.clear();
+    occurrencesByIdentifier.clear();
+  }
+
+  void IdentifierIndex::insert(Sci_Position line, Sci_Position column, const std::string& identifier) {
+    auto node = identifiers.insert(line, IdentifierOnLine {
+      .column = column,
+      .identifier = identifier
+    });
+    occurrencesByIdentifier[identifier].insert(node);
+  }
+
+  bool IdentifierIndex::eraseLines(Sci_Position firstLine, Sci_Position lastLine) {
+    bool erased = false;
+    auto end = identifiers.lowerBound(lastLine + 1);
+    for (auto node = identifiers.lowerBound(firstLine); node != end;) {
+      auto nextNode = identifiers.next(node);
+      auto iter = occurrencesByIdentifier.find(node->item().identifier);
+      if (iter != occurrencesByIdentifier.end() && iter->second.erase(node) > 0 && iter->second.empty()) {
+        occurrencesByIdentifier.erase(iter);
+      }
+      identifiers.erase(node);
+      node = nextNode;
+      erased = true;
+    }
+    return erased;
+  }
+
+} // namespace
@@ -0,0 +1,109 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\Common\LineTree.hpp"
+
+#include "..\..\external\scintilla\Sci_Position.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace papyrus {
+
+  // An identifier found by lexer, located by line and column so it survives edits on other lines
+  struct IdentifierOccurrence {
+    Sci_Position line;
+    Sci_Position column;
+    Sci_Position length;
+  };
+
+  // An identifier with its location, as stored along with cached styles
+  struct IndexedIdentifier {
+    Sci_Position line;
+    Sci_Position column;
+    std::string identifier;
+  };
+
+  // Index of identifiers of a document, e.g. properties, variables, functions and class names, built from lexer output. Words
+  // in comments and strings, and keywords are never indexed, so occurrences of an identifier are exactly its uses in code.
+  // Like block index, lexer updates identifiers of each line it lexes, and line numbers are shifted when lines are added or
+  // deleted. Identifiers are kept in a tree with lines stored relative to each other, and each identifier keeps the tree nodes
+  // of its occurrences, so both only touch identifiers around the edit.
+  class IdentifierIndex {
+    public:
+      // Discard everything. An unusable index never finds anything, e.g. before the document is lexed, or when identifiers
+      // are not needed.
+      void reset(bool usable);
+
+      bool isUsable();
+
+      // Get all identifiers in document order, e.g. to store them along with cached styles. Returns false if the index is unusable.
+      bool getIdentifiers(std::vector<IndexedIdentifier>& allIdentifiers);
+
+      // Replace everything with identifiers previously returned by getIdentifiers, e.g. when styles are restored from cache without lexing
+      void restore(const std::vector<IndexedIdentifier>& allIdentifiers);
+
+      // Identifiers of a line are cleared before the line is lexed, then added back one by one. Identifier is lower-cased.
+      void clearLine(Sci_Position line);
+      void addIdentifier(Sci_Position line, Sci_Position column, const std::string& identifier);
+
+      // Shift line numbers after lines were added (positive) or deleted (negative) after the given line
+      void shiftLines(Sci_Position line, Sci_Position linesAdded);
+
+      // Find the identifier that covers the given location. Returns false if there isn't one, or the index is unusable.
+      bool findAt(Sci_Position line, Sci_Position column, std::string& identifier);
+
+      // Find all occurrences of a lower-cased identifier, in document order. Returns false if the index is unusable.
+      bool find(const std::string& identifier, std::vector<IdentifierOccurrence>& occurrences);
+
+      // Generation increases on every change, so a result computed from the index can be checked for staleness
+      inline size_t getGeneration() const { return generation; }
+
+    private:
+      struct IdentifierOnLine {
+        Sci_Position column;
+        std::string identifier;
+      };
+
+      using IdentifierTree = utility::LineTree<IdentifierOnLine>;
+      using IdentifierNode = IdentifierTree::Node;
+
+      void clear();
+      void insert(Sci_Position line, Sci_Position column, const std::string& identifier);
+
+      // Erase identifiers on lines in [firstLine, lastLine], along with their occurrences. Returns whether anything was erased.
+      bool eraseLines(Sci_Position firstLine, Sci_Position lastLine);
+
+      // Private members
+      //
+      std::mutex mutex;
+      bool usable {false};
+      std::atomic<size_t> generation {0};
+
+      IdentifierTree identifiers;
+      std::map<std::string, std::unordered_set<IdentifierNode*>, std::less<>> occurrencesByIdentifier;
+  };
+
+} // namespace
@@ -21,7 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Lexer.hpp"
 
 #include "LexerIDs.hpp"
-#include "..\Common\FileSystemUtil.hpp"
+#include "..\Common\DirectoryIndex.hpp"
+#include "..\Common\GameFeatures.hpp"
+#include "..\Common\Hash.hpp"
 #include "..\Common\Logger.hpp"
 #include "..\Common\StringUtil.hpp"
 
@@ -31,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "..\..\external\scintilla\Scintilla.h"
 
 #include <filesystem>
+#include <fstream>
 #include <map>
 #include <memory>
 
@@ -46,6 +49,9 @@ namespace papyrus {
     std::vector<Lexer*> lexerList;
     std::mutex scriptNameMapMutex;
     std::map<npp_buffer_t, std::string> scriptNameMap;
+    std::mutex indexMapMutex;
+    std::map<npp_buffer_t, std::shared_ptr<BlockIndex>> blockIndexMap;
+    std::map<npp_buffer_t, std::shared_ptr<IdentifierIndex>> identifierIndexMap;
   }
 
   Lexer::Lexer()
@@ -86,6 +92,19 @@ namespace papyrus {
     hoverEventSubscription->unsubscribe();
     changeEventSubscription->unsubscribe();
 
+    // Remove indexes of this instance
+    {
+      Lock lock(indexMapMutex);
+      auto blockIndexIter = blockIndexMap.find(indexBufferID);
+      if (blockIndexIter != blockIndexMap.end() && blockIndexIter->second == blockIndex) {
+        blockIndexMap.erase(blockIndexIter);
+      }
+      auto identifierIndexIter = identifierIndexMap.find(indexBufferID);
+      if (identifierIndexIter != identifierIndexMap.end() && identifierIndexIter->second == identifierIndex) {
+        identifierIndexMap.erase(identifierIndexIter);
+      }
+    }
+
     // Remove this instance from lexer list
     Lock lock(lexerListMutex);
     auto iter = std::find(lexerList.begin(), lexerList.end(), this);
@@ -117,235 +136,349 @@ namespace papyrus {
     }
   }
 
+  std::shared_ptr<BlockIndex> Lexer::getBlockIndex(npp_buffer_t bufferID) {
+    Lock lock(indexMapMutex);
+    auto iter = blockIndexMap.find(bufferID);
+    return (iter != blockIndexMap.end()) ? iter->second : nullptr;
+  }
+
+  std::shared_ptr<IdentifierIndex> Lexer::getIdentifierIndex(npp_buffer_t bufferID) {
+    Lock lock(indexMapMutex);
+    auto iter = identifierIndexMap.find(bufferID);
+    return (iter != identifierIndexMap.end()) ? iter->second : nullptr;
+  }
+
   void SCI_METHOD Lexer::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument* pAccess) {
     if (isUsable()) {
       detectBufferId();
+      registerIndexes();
+
+      if (!styleCacheChecked && startPos == 0 && applyStyleCache(pAccess)) {
+        // Block keywords and identifiers have been restored from cache as well
+        return;
+      }
+      indexingIdentifiers = lexerData->indexIdentifiers;
+      if (!indexingIdentifiers && identifierIndex->isUsable()) {
+        // Identifiers are no longer needed
+        identifierIndex->reset(false);
+      } else if (indexingIdentifiers && !identifierIndex->isUsable() && startPos > 0) {
+        // Identifiers were not indexed when the rest was lexed, e.g. occurrence highlighting has just been turned on. Lex from
+        // the beginning instead, so they are.
+        lengthDoc += static_cast<Sci_Position>(startPos);
+        startPos = 0;
+      }
+      if (startPos == 0) {
+        // Whole document is being restyled, and block keywords and identifiers will be indexed from the beginning
+        blockIndex->reset(true);
+        identifierIndex->reset(indexingIdentifiers);
+      }
+
+      selectGameSpecificMethods();
+      (this->*lexMethod)(startPos, lengthDoc, pAccess);
+    }
+  }
 
-      Accessor accessor(pAccess, nullptr);
-      StyleContext styleContext(startPos, lengthDoc, accessor.StyleAt(startPos - 1), accessor);
+  void SCI_METHOD Lexer::Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument* pAccess) {
+    if (isUsable()) {
+      if (!cachedFoldLevels.empty()) {
+        // Styles were restored from cache in Lex, so are fold levels.
+        for (size_t line = 0; line < cachedFoldLevels.size(); ++line) {
+          pAccess->SetLevel(static_cast<Sci_Position>(line), cachedFoldLevels[line]);
+        }
+        cachedFoldLevels.clear();
+        return;
+      }
 
-      // This state is saved in the line feed character. It can be used to initialize the state of the next line.
-      State messageStateLast = static_cast<State>(accessor.StyleAt(startPos - 1));
-      for (auto line = accessor.GetLine(startPos); line <= accessor.GetLine(startPos + lengthDoc - 1); ++line) {
-        auto tokens = tokenize(accessor, line);
-        State messageState = messageStateLast;
+      selectGameSpecificMethods();
+      (this->*foldMethod)(startPos, lengthDoc, pAccess);
 
-        // Styling
-        for (auto iterTokens = tokens.begin(); iterTokens != tokens.end(); ++iterTokens) {
-          const auto& tokenString = iterTokens->content;
+      // Whole document has been lexed and folded by now. Store the result if needed.
+      if (styleCacheStorePending && static_cast<Sci_Position>(startPos) + lengthDoc >= pAccess->Length()) {
+        styleCacheStorePending = false;
+        storeStyleCache(pAccess);
+      }
+    }
+  }
 
-          if (messageState == State::CommentDoc) {
-            colorToken(styleContext, *iterTokens, State::CommentDoc);
-            if (tokenString == "}") {
-              messageState = State::Default;
+  Sci_Position SCI_METHOD Lexer::WordListSet(int n, const char* wl) {
+    if (!isUsable() || n < 0 || static_cast<size_t>(n) >= wordListSources.size() || getWordList(n) == nullptr || wordListSources[n] == wl) {
+      return -1;
+    }
+
+    // Word lists in use are set from the new one when game specific methods are selected again, on next lexing
+    wordListSources[n] = wl;
+    lexMethod = nullptr;
+    return 0;
+  }
+
+  // Protected methods
+  //
+
+  bool Lexer::isUsable() const {
+    return helper->isUsable();
+  }
+
+  // Private methods
+  //
+
+  void Lexer::selectGameSpecificMethods() {
+    if (lexMethod == nullptr || gameSpecificMethodsGame != lexerData->currentGame) {
+      gameSpecificMethodsGame = lexerData->currentGame;
+      game::dispatch(gameSpecificMethodsGame, [&](auto gameType) {
+        lexMethod = &Lexer::lex<decltype(gameType)::value>;
+        foldMethod = &Lexer::fold<decltype(gameType)::value>;
+
+        // Word lists in use leave out words the game doesn't support, so they are told apart by word list lookup alone
+        for (size_t n = 0; n < wordListSources.size(); ++n) {
+          if (WordList* wordList = getWordList(n)) {
+            wordList->Set(game::filterWordList<decltype(gameType)::value>(wordListSources[n]).c_str());
+          }
+        }
+      });
+    }
+  }
+
+  WordList* Lexer::getWordList(size_t n) const {
+    if (n < 2) {
+      return (n < instreWordLists.size()) ? instreWordLists[n] : nullptr;
+    }
+    return (n - 2 < typeWordLists.size()) ? typeWordLists[n - 2] : nullptr;
+  }
+
+  template <Game gameType>
+  void Lexer::lex(Sci_PositionU startPos, Sci_Position lengthDoc, IDocument* pAccess) {
+    Accessor accessor(pAccess, nullptr);
+    StyleContext styleContext(startPos, lengthDoc, accessor.StyleAt(startPos - 1), accessor);
+
+    // This state is saved in the line feed character. It can be used to initialize the state of the next line.
+    State messageStateLast = static_cast<State>(accessor.StyleAt(startPos - 1));
+    for (auto line = accessor.GetLine(startPos); line <= accessor.GetLine(startPos + lengthDoc - 1); ++line) {
+      auto tokens = tokenize<gameType>(accessor, line);
+      State messageState = messageStateLast;
+      Sci_Position lineStart = accessor.LineStart(line);
+      blockIndex->clearLine(line);
+      if (indexingIdentifiers) {
+        identifierIndex->clearLine(line);
+      }
+
+      // Styling
+      for (auto iterTokens = tokens.begin(); iterTokens != tokens.end(); ++iterTokens) {
+        const auto& tokenString = iterTokens->content;
+
+        if (messageState == State::CommentDoc) {
+          colorToken(styleContext, *iterTokens, State::CommentDoc);
+          if (tokenString == "}") {
+            messageState = State::Default;
+          }
+        } else if (messageState == State::CommentMultiLine) {
+          colorToken(styleContext, *iterTokens, State::CommentMultiLine);
+            // A multi-line comment ends with "/;" and there can't be spaces in between.
+          if (tokenString == ";" && iterTokens != tokens.begin() && std::prev(iterTokens)->content == "/" && iterTokens->startPos == std::prev(iterTokens)->startPos + 1) {
+            messageState = State::Default;
+          }
+        } else if (messageState == State::Comment) {
+          colorToken(styleContext, *iterTokens, State::Comment);
+        } else if (messageState == State::String) {
+          colorToken(styleContext, *iterTokens, State::String);
+          if (tokenString == "\"") {
+            // This may be an escape for double quote. Check previous tokens.
+            int numBackslash = 0;
+            auto iterCheck = iterTokens;
+            while (iterCheck != tokens.begin()) {
+              if ((--iterCheck)->content == "\\") {
+                numBackslash++;
+              } else {
+                break;
+              }
             }
-          } else if (messageState == State::CommentMultiLine) {
-            colorToken(styleContext, *iterTokens, State::CommentMultiLine);
-              // A multi-line comment ends with "/;" and there can't be spaces in between.
-            if (tokenString == ";" && iterTokens != tokens.begin() && std::prev(iterTokens)->content == "/" && iterTokens->startPos == std::prev(iterTokens)->startPos + 1) {
+            if (numBackslash % 2 == 0) {
               messageState = State::Default;
             }
-          } else if (messageState == State::Comment) {
-            colorToken(styleContext, *iterTokens, State::Comment);
-          } else if (messageState == State::String) {
-            colorToken(styleContext, *iterTokens, State::String);
-            if (tokenString == "\"") {
-              // This may be an escape for double quote. Check previous tokens.
-              int numBackslash = 0;
-              auto iterCheck = iterTokens;
-              while (iterCheck != tokens.begin()) {
-                if ((--iterCheck)->content == "\\") {
-                  numBackslash++;
+          }
+        } else {
+          // Determine the type of the token and color it.
+          if (tokenString == "{") {
+            colorToken(styleContext, *iterTokens, messageState = State::CommentDoc);
+          } else if (tokenString == ";") {
+            // A multi-line comment starts with ";/" and there can't be spaces in between.
+            if (std::next(iterTokens) != tokens.end() && std::next(iterTokens)->content == "/" && iterTokens->startPos == std::next(iterTokens)->startPos - 1) {
+              colorToken(styleContext, *iterTokens, messageState = State::CommentMultiLine);
+            } else {
+              colorToken(styleContext, *iterTokens, messageState = State::Comment);
+            }
+          } else if (tokenString == "\"") {
+            colorToken(styleContext, *iterTokens, messageState = State::String);
+          } else if (iterTokens->tokenType == TokenType::Numeric) {
+            colorToken(styleContext, *iterTokens, State::Number);
+          } else if (iterTokens->tokenType == TokenType::Identifier) {
+            if (!wordListFlowControl.InList(tokenString.c_str()) && isalnum(tokenString.back()) && std::next(iterTokens) != tokens.end() && std::next(iterTokens)->content == "(") {
+              // If next token is ( and current token is an identifier but not if/elseif/while, it is a function name.
+              indexIdentifier(line, lineStart, *iterTokens);
+              colorToken(styleContext, *iterTokens, State::Function);
+            } else if (wordListTypes.InList(tokenString.c_str())) {
+              colorToken(styleContext, *iterTokens, State::Type);
+            } else if (wordListFlowControl.InList(tokenString.c_str())) {
+              indexBlockKeyword(line, lineStart, iterTokens, tokens.end());
+              colorToken(styleContext, *iterTokens, State::FlowControl);
+            } else if (wordListKeywords.InList(tokenString.c_str())) {
+              // Check if a new property needs to be added, and update existing property list
+              if (tokenString == "scriptname" && std::next(iterTokens) != tokens.end()) {
+                const auto& fullScriptName = std::next(iterTokens)->content;
+                auto detectedScriptName = utility::split(fullScriptName, ":").back();
+                if (!utility::compare(scriptName, detectedScriptName)) {
+                  scriptName = detectedScriptName;
+                  detectBufferId();
+
+                  // Add full script name to map
+                  Lock lock(scriptNameMapMutex);
+                  scriptNameMap[bufferID] = fullScriptName;
+                }
+
+                // Check if this script extends another script, i.e. "ScriptName <name> extends <parent>"
+                auto iterExtends = std::next(iterTokens, 2);
+                if (iterExtends != tokens.end() && iterExtends->content == "extends" && std::next(iterExtends) != tokens.end()) {
+                  parentScriptName = std::next(iterExtends)->content;
                 } else {
-                  break;
+                  parentScriptName.clear();
                 }
-              }
-              if (numBackslash % 2 == 0) {
-                messageState = State::Default;
-              }
-            }
-          } else {
-            // Determine the type of the token and color it.
-            if (tokenString == "{") {
-              colorToken(styleContext, *iterTokens, messageState = State::CommentDoc);
-            } else if (tokenString == ";") {
-              // A multi-line comment starts with ";/" and there can't be spaces in between.
-              if (std::next(iterTokens) != tokens.end() && std::next(iterTokens)->content == "/" && iterTokens->startPos == std::next(iterTokens)->startPos - 1) {
-                colorToken(styleContext, *iterTokens, messageState = State::CommentMultiLine);
-              } else {
-                colorToken(styleContext, *iterTokens, messageState = State::Comment);
-              }
-            } else if (tokenString == "\"") {
-              colorToken(styleContext, *iterTokens, messageState = State::String);
-            } else if (iterTokens->tokenType == TokenType::Numeric) {
-              colorToken(styleContext, *iterTokens, State::Number);
-            } else if (iterTokens->tokenType == TokenType::Identifier) {
-              if (!wordListFlowControl.InList(tokenString.c_str()) && isalnum(tokenString.back()) && std::next(iterTokens) != tokens.end() && std::next(iterTokens)->content == "(") {
-                // If next token is ( and current token is an identifier but not if/elseif/while, it is a function name.
-                colorToken(styleContext, *iterTokens, State::Function);
-              } else if (wordListTypes.InList(tokenString.c_str())) {
-                colorToken(styleContext, *iterTokens, State::Type);
-              } else if (wordListFlowControl.InList(tokenString.c_str())) {
-                colorToken(styleContext, *iterTokens, State::FlowControl);
-              } else if (wordListKeywords.InList(tokenString.c_str())) {
-                // Check if a new property needs to be added, and update existing property list
-                if (tokenString == "scriptname" && std::next(iterTokens) != tokens.end()) {
-                  const auto& fullScriptName = std::next(iterTokens)->content;
-                  auto detectedScriptName = utility::split(fullScriptName, ":").back();
-                  if (!utility::compare(scriptName, detectedScriptName)) {
-                    scriptName = detectedScriptName;
-                    detectBufferId();
-
-                    // Add full script name to map
-                    Lock lock(scriptNameMapMutex);
-                    scriptNameMap[bufferID] = fullScriptName;
+              } else if (tokenString == "property" && std::next(iterTokens) != tokens.end() && std::next(iterTokens)->content != ";") {
+                std::string propertyName = std::next(iterTokens)->content;
+                auto iter = std::find_if(propertyLines.begin(), propertyLines.end(),
+                  [&](const auto& property) {
+                    return property.name == propertyName;
                   }
-                } else if (tokenString == "property" && std::next(iterTokens) != tokens.end() && std::next(iterTokens)->content != ";") {
-                  std::string propertyName = std::next(iterTokens)->content;
-                  auto iter = std::find_if(propertyLines.begin(), propertyLines.end(),
-                    [&](const auto& property) {
-                      return property.name == propertyName;
-                    }
-                  );
-                  if (iter != propertyLines.end()) {
-                    // See if there are properties marked as need to re-check due to line addition.
-                    if (iter->line < line) {
-                      iter = std::find_if(++iter, propertyLines.end(),
-                        [&](const auto& property) {
-                         return property.name == propertyName && iter->line > line; // Due to line addition
-                        }
-                      );
-                    }
-                    if (iter != propertyLines.end() && iter->needRecheck) {
-                      iter->line = line;
-                      iter->needRecheck = false;
-                    }
-                  } else {
-                    Property property {
-                      .name = propertyName,
-                      .line = line
-                    };
-                    propertyLines.push_back(property);
-                    propertyNames.insert(propertyName);
+                );
+                if (iter != propertyLines.end()) {
+                  // See if there are properties marked as need to re-check due to line addition.
+                  if (iter->line < line) {
+                    iter = std::find_if(++iter, propertyLines.end(),
+                      [&](const auto& property) {
+                       return property.name == propertyName && iter->line > line; // Due to line addition
+                      }
+                    );
                   }
+                  if (iter != propertyLines.end() && iter->needRecheck) {
+                    iter->line = line;
+                    iter->needRecheck = false;
+                  }
+                } else {
+                  Property property {
+                    .name = propertyName,
+                    .line = line
+                  };
+                  propertyLines.push_back(property);
+                  propertyNames.insert(propertyName);
                 }
+              }
 
-                colorToken(styleContext, *iterTokens, State::Keyword);
-              } else if (wordListKeywords2.InList(tokenString.c_str())) {
-                colorToken(styleContext, *iterTokens, State::Keyword2);
-              } else if (wordListOperators.InList(tokenString.c_str())) {
-                colorToken(styleContext, *iterTokens, State::Operator);
+              indexBlockKeyword(line, lineStart, iterTokens, tokens.end());
+              colorToken(styleContext, *iterTokens, State::Keyword);
+            } else if (wordListKeywords2.InList(tokenString.c_str())) {
+              colorToken(styleContext, *iterTokens, State::Keyword2);
+            } else if (wordListOperators.InList(tokenString.c_str())) {
+              colorToken(styleContext, *iterTokens, State::Operator);
+            } else {
+              // Anything not reserved is an identifier, be it a property, a variable or a class name
+              indexIdentifier(line, lineStart, *iterTokens);
+              bool found = (propertyNames.find(tokenString) != propertyNames.end()) || isInheritedProperty(tokenString);
+              if (found) {
+                colorToken(styleContext, *iterTokens, State::Property);
               } else {
-                bool found = (propertyNames.find(tokenString) != propertyNames.end());
-                if (found) {
-                  colorToken(styleContext, *iterTokens, State::Property);
-                } else {
-                  if (lexerData->currentGame != game::Game::Auto) {
-                    if (lexerData->settings.enableClassNameCache) {
-                      auto& currentGameClassNames = helper->getClassNamesForGame(lexerData->currentGame);
-                      if (isNameInCache(tokenString, currentGameClassNames.first, currentGameClassNames.second)) {
-                        colorToken(styleContext, *iterTokens, State::Class);
-                        found = true;
-                      } else {
-                        auto& currentGameNonClassNames = helper->getNonClassNamesForGame(lexerData->currentGame);
-                        if (!isNameInCache(tokenString, currentGameNonClassNames.first, currentGameNonClassNames.second)) {
-                          if (!getClassFilePath(bufferID, tokenString).empty()) {
-                            colorToken(styleContext, *iterTokens, State::Class);
-                            addNameToCache(tokenString, currentGameClassNames.first, currentGameClassNames.second);
-                            found = true;
-                          }
-
-                          if (!found) {
-                            addNameToCache(tokenString, currentGameNonClassNames.first, currentGameNonClassNames.second);
-                          }
+                if constexpr (gameType != Game::Auto) {
+                  if (lexerData->settings.enableClassNameCache) {
+                    auto& currentGameClassNames = helper->getClassNamesForGame(gameType);
+                    if (isNameInCache(tokenString, currentGameClassNames.first, currentGameClassNames.second)) {
+                      colorToken(styleContext, *iterTokens, State::Class);
+                      found = true;
+                    } else {
+                      auto& currentGameNonClassNames = helper->getNonClassNamesForGame(gameType);
+                      if (!isNameInCache(tokenString, currentGameNonClassNames.first, currentGameNonClassNames.second)) {
+                        if (!getClassFilePath(bufferID, tokenString).empty()) {
+                          colorToken(styleContext, *iterTokens, State::Class);
+                          addNameToCache(tokenString, currentGameClassNames.first, currentGameClassNames.second);
+                          found = true;
+                        }
+
+                        if (!found) {
+                          addNameToCache(tokenString, currentGameNonClassNames.first, currentGameNonClassNames.second);
                         }
                       }
-                    } else if (!getClassFilePath(bufferID, tokenString).empty()) {
-                        colorToken(styleContext, *iterTokens, State::Class);
-                        found = true;
                     }
+                  } else if (!getClassFilePath(bufferID, tokenString).empty()) {
+                      colorToken(styleContext, *iterTokens, State::Class);
+                      found = true;
                   }
+                }
 
-                  if (!found) {
-                    colorToken(styleContext, *iterTokens, State::Default);
-                  }
+                if (!found) {
+                  colorToken(styleContext, *iterTokens, State::Default);
                 }
               }
-            } else if (iterTokens->tokenType == TokenType::Special) {
-              if (wordListOperators.InList(iterTokens->content.c_str())) {
-                colorToken(styleContext, *iterTokens, State::Operator);
-              } else {
-                colorToken(styleContext, *iterTokens, State::Default);
-              }
+            }
+          } else if (iterTokens->tokenType == TokenType::Special) {
+            if (wordListOperators.InList(iterTokens->content.c_str())) {
+              colorToken(styleContext, *iterTokens, State::Operator);
+            } else {
+              colorToken(styleContext, *iterTokens, State::Default);
             }
           }
         }
-        if (messageState == State::Comment || messageState == State::String) {
-          messageState = State::Default;
-        }
-        if (styleContext.ch == '\r') {
-          styleContext.Forward();
-        }
-        if (styleContext.ch == '\n') {
-          styleContext.SetState(std::to_underlying(messageState));
-          styleContext.Forward();
-        }
-        messageStateLast = messageState;
       }
-      styleContext.Complete();
+      if (messageState == State::Comment || messageState == State::String) {
+        messageState = State::Default;
+      }
+      if (styleContext.ch == '\r') {
+        styleContext.Forward();
+      }
+      if (styleContext.ch == '\n') {
+        styleContext.SetState(std::to_underlying(messageState));
+        styleContext.Forward();
+      }
+      messageStateLast = messageState;
     }
+    styleContext.Complete();
   }
 
-  void SCI_METHOD Lexer::Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument* pAccess) {
-    if (isUsable()) {
-      Accessor accessor(pAccess, nullptr);
-
-      int levelPrev = accessor.LevelAt(accessor.GetLine(startPos)) & SC_FOLDLEVELNUMBERMASK;
-      // Lines
-      for (auto line = accessor.GetLine(startPos); line <= accessor.GetLine(startPos + lengthDoc); ++line) {
-        int numFoldOpen = 0;
-        int numFoldClose = 0;
-        bool hasFoldMiddle = false;
-        // Chars
-        auto tokens = tokenize(accessor, line);
-        for (const Token& token : tokens) {
-          if (!isComment(accessor.StyleAt(token.startPos)) && accessor.StyleAt(token.startPos) != std::to_underlying(State::String)) {
-            if (wordListFoldOpen.InList(token.content.c_str())) {
-              numFoldOpen++;
-            } else if (wordListFoldClose.InList(token.content.c_str())) {
-              numFoldClose++;
-            } else if (lexerData->settings.enableFoldMiddle && wordListFoldMiddle.InList(token.content.c_str())) {
-              hasFoldMiddle = true;
-            }
+  template <Game gameType>
+  void Lexer::fold(Sci_PositionU startPos, Sci_Position lengthDoc, IDocument* pAccess) {
+    Accessor accessor(pAccess, nullptr);
+
+    int levelPrev = accessor.LevelAt(accessor.GetLine(startPos)) & SC_FOLDLEVELNUMBERMASK;
+    // Lines
+    for (auto line = accessor.GetLine(startPos); line <= accessor.GetLine(startPos + lengthDoc); ++line) {
+      int numFoldOpen = 0;
+      int numFoldClose = 0;
+      bool hasFoldMiddle = false;
+      // Chars
+      auto tokens = tokenize<gameType>(accessor, line);
+      for (const Token& token : tokens) {
+        if (!isComment(accessor.StyleAt(token.startPos)) && accessor.StyleAt(token.startPos) != std::to_underlying(State::String)) {
+          if (wordListFoldOpen.InList(token.content.c_str())) {
+            numFoldOpen++;
+          } else if (wordListFoldClose.InList(token.content.c_str())) {
+            numFoldClose++;
+          } else if (lexerData->settings.enableFoldMiddle && wordListFoldMiddle.InList(token.content.c_str())) {
+            hasFoldMiddle = true;
           }
         }
+      }
 
-        // Skip the lines that have matching start and end keywords.
-        int level = levelPrev;
-        int levelDelta = numFoldOpen - numFoldClose;
-        if (levelDelta > 0) {
-          level |= SC_FOLDLEVELHEADERFLAG;
-        }
-        if (hasFoldMiddle && numFoldOpen == 0 && numFoldClose == 0) {
-          level--;
-          level |= SC_FOLDLEVELHEADERFLAG;
-        }
-        accessor.SetLevel(line, level);
-        levelPrev += levelDelta;
+      // Skip the lines that have matching start and end keywords.
+      int level = levelPrev;
+      int levelDelta = numFoldOpen - numFoldClose;
+      if (levelDelta > 0) {
+        level |= SC_FOLDLEVELHEADERFLAG;
+      }
+      if (hasFoldMiddle && numFoldOpen == 0 && numFoldClose == 0) {
+        level--;
+        level |= SC_FOLDLEVELHEADERFLAG;
       }
+      accessor.SetLevel(line, level);
+      levelPrev += levelDelta;
     }
   }
 
-  // Protected methods
-  //
-
-  bool Lexer::isUsable() const {
-    return helper->isUsable();
-  }
-
-  // Private methods
-  //
-
+  template <Game gameType>
   std::vector<Lexer::Token> Lexer::tokenize(Accessor& accessor, Sci_Position line) const {
     std::vector<Token> tokens;
     TokenType previousTokenType = TokenType::Special;
@@ -367,7 +500,7 @@ namespace papyrus {
             .tokenType = TokenType::Identifier,
             .startPos = index
           };
-          while (ch <= 255 && (std::isalnum(ch) || ch == '_' || ch == ':')) {
+          while (game::isIdentifierCharacter<gameType>(ch)) {
             token.content.push_back(std::tolower(ch)); // Papyrus script is case insensitive
             ch = getNextChar(accessor, index, indexNext);
           }
@@ -417,6 +550,34 @@ namespace papyrus {
     return tokens;
   }
 
+  void Lexer::indexBlockKeyword(Sci_Position line, Sci_Position lineStart, std::vector<Token>::const_iterator iterToken, std::vector<Token>::const_iterator iterEnd) {
+    BlockType type;
+    BlockRole role;
+    if (BlockIndex::isBlockKeyword(iterToken->content, type, role)) {
+      auto iterNext = std::next(iterToken);
+
+      // "Auto" is a property flag, unless it marks the auto state, i.e. "Auto State <name>"
+      if (iterToken->content == "auto" && iterNext != iterEnd && iterNext->content == "state") {
+        return;
+      }
+
+      // Opening keywords of blocks other than flow control are followed by the name of the block, e.g. "Function <name>(...)"
+      Sci_Position nameColumn {0};
+      Sci_Position nameLength {0};
+      if (role == BlockRole::Open && type != BlockType::If && type != BlockType::While && iterNext != iterEnd && iterNext->tokenType == TokenType::Identifier) {
+        nameColumn = iterNext->startPos - lineStart;
+        nameLength = static_cast<Sci_Position>(iterNext->content.length());
+      }
+      blockIndex->addKeyword(line, iterToken->startPos - lineStart, static_cast<Sci_Position>(iterToken->content.length()), type, role, nameColumn, nameLength);
+    }
+  }
+
+  void Lexer::indexIdentifier(Sci_Position line, Sci_Position lineStart, const Token& token) {
+    if (indexingIdentifiers) {
+      identifierIndex->addIdentifier(line, token.startPos - lineStart, token.content);
+    }
+  }
+
   void Lexer::colorToken(StyleContext & styleContext, Token token, State state) const {
     if (styleContext.currentPos < (Sci_PositionU)token.startPos) {
       // White spaces
@@ -451,6 +612,36 @@ namespace papyrus {
     namesCache.insert(name);
   }
 
+  bool Lexer::isInheritedProperty(const std::string& name) {
+    if (parentScriptName.empty()) {
+      return false;
+    }
+
+    const auto& names = getInheritedPropertyNames();
+    return names.find(name) != names.end();
+  }
+
+  const std::set<std::string>& Lexer::getInheritedPropertyNames() {
+    // Only walk the extends chain when something it depends on has changed. Otherwise it's the cached result.
+    size_t generation = helper->getScriptDeclarationsGeneration();
+    if (inheritedPropertyNamesParent != parentScriptName || inheritedPropertyNamesBufferID != bufferID || inheritedPropertyNamesGeneration != generation) {
+      inheritedPropertyNames = parentScriptName.empty() ? std::set<std::string>() : helper->getInheritedPropertyNames(bufferID, parentScriptName);
+      inheritedPropertyNamesParent = parentScriptName;
+      inheritedPropertyNamesBufferID = bufferID;
+      inheritedPropertyNamesGeneration = generation;
+    }
+    return inheritedPropertyNames;
+  }
+
+  uint64_t Lexer::computeInheritedPropertiesHash() {
+    uint64_t hash = utility::FNV_OFFSET_BASIS;
+    for (const auto& name : getInheritedPropertyNames()) {
+      // Include the terminating null, so names are delimited
+      hash = utility::hash(name.c_str(), name.size() + 1, hash);
+    }
+    return hash;
+  }
+
   void Lexer::handleMouseHover(HWND handle, bool hovering, Sci_Position position) const {
     if (isUsable() && lexerData->settings.enableHover) {
       // Cancel any displayed call tips
@@ -516,6 +707,10 @@ namespace papyrus {
   void Lexer::handleContentChange(HWND handle, Sci_Position position, Sci_Position linesAdded) {
     Sci_Position line = static_cast<Sci_Position>(::SendMessage(handle, SCI_LINEFROMPOSITION, position, 0));
 
+    // Update block and identifier indexes. The changed line itself will be re-indexed in Lex.
+    blockIndex->shiftLines(line, linesAdded);
+    identifierIndex->shiftLines(line, linesAdded);
+
     // Update property list
     for (auto iter = propertyLines.begin(); iter != propertyLines.end();) {
       if (iter->line >= line) {
@@ -541,6 +736,113 @@ namespace papyrus {
     }
   }
 
+  bool Lexer::applyStyleCache(IDocument* pAccess) {
+    styleCacheChecked = true;
+    if (!lexerData->settings.enableStyleCache || lexerData->styleCacheDirectory.empty() || pAccess->Length() < STYLE_CACHE_MIN_DOCUMENT_LENGTH) {
+      return false;
+    }
+
+    styleCacheKey = computeStyleCacheKey(pAccess);
+    StyleCacheEntry entry;
+    if (!StyleCache::load(lexerData->styleCacheDirectory, styleCacheKey, static_cast<size_t>(pAccess->Length()), entry)) {
+      // Cache miss. Store the result once the whole document is lexed.
+      styleCacheStorePending = true;
+      return false;
+    }
+
+    // Restore lexer states that would have been collected during lexing. They only depend on the document itself, so they are
+    // correct even if the entry turns out to be stale below.
+    if (!entry.scriptName.empty()) {
+      scriptName = utility::split(entry.scriptName, ":").back();
+      detectBufferId();
+
+      Lock lock(scriptNameMapMutex);
+      scriptNameMap[bufferID] = entry.scriptName;
+    }
+    parentScriptName = entry.parentScriptName;
+
+    // Parent scripts may have changed since the entry was stored, in which case properties inherited from them would be styled
+    // differently. Lex the document as if it's a cache miss, and replace the entry afterwards.
+    if (computeInheritedPropertiesHash() != entry.inheritedPropertiesHash) {
+      styleCacheStorePending = true;
+      return false;
+    }
+
+    // Same if identifiers are needed but weren't indexed when the entry was stored.
+    bool indexIdentifiers = lexerData->indexIdentifiers;
+    if (indexIdentifiers && !entry.identifiersIndexed) {
+      styleCacheStorePending = true;
+      return false;
+    }
+
+    pAccess->StartStyling(0);
+    pAccess->SetStyles(static_cast<Sci_Position>(entry.styles.size()), entry.styles.data());
+    cachedFoldLevels = std::move(entry.foldLevels);
+    blockIndex->restore(entry.blockKeywords);
+    if (indexIdentifiers) {
+      identifierIndex->restore(entry.identifiers);
+    } else {
+      identifierIndex->reset(false);
+    }
+
+    propertyLines.clear();
+    propertyNames.clear();
+    for (const auto& [name, line] : entry.properties) {
+      Property property {
+        .name = name,
+        .line = line
+      };
+      propertyLines.push_back(property);
+      propertyNames.insert(name);
+    }
+    return true;
+  }
+
+  void Lexer::storeStyleCache(IDocument* pAccess) {
+    // Document may have been changed since cache was checked, in which case the result doesn't match the key anymore.
+    if (!lexerData->settings.enableStyleCache || computeStyleCacheKey(pAccess) != styleCacheKey) {
+      return;
+    }
+
+    StyleCacheEntry entry {
+      .scriptName = getScriptName(bufferID),
+      .parentScriptName = parentScriptName,
+      .inheritedPropertiesHash = computeInheritedPropertiesHash()
+    };
+    if (!blockIndex->getKeywords(entry.blockKeywords)) {
+      return;
+    }
+    entry.identifiersIndexed = identifierIndex->getIdentifiers(entry.identifiers);
+    Sci_Position length = pAccess->Length();
+    entry.styles.reserve(static_cast<size_t>(length));
+    for (Sci_Position position = 0; position < length; ++position) {
+      entry.styles.push_back(pAccess->StyleAt(position));
+    }
+    Sci_Position lineCount = pAccess->LineFromPosition(length) + 1;
+    entry.foldLevels.reserve(static_cast<size_t>(lineCount));
+    for (Sci_Position line = 0; line < lineCount; ++line) {
+      entry.foldLevels.push_back(pAccess->GetLevel(line));
+    }
+    for (const auto& property : propertyLines) {
+      entry.properties.emplace_back(property.name, property.line);
+    }
+
+    StyleCache::store(lexerData->styleCacheDirectory, styleCacheKey, entry, lexerData->settings.styleCacheSizeLimit);
+  }
+
+  uint64_t Lexer::computeStyleCacheKey(IDocument* pAccess) const {
+    // Class names are searched in current file's directory before import directories
+    std::vector<std::wstring> searchDirectories;
+    auto currentBufferFilePath = utility::getFilePathFromBuffer(lexerData->nppData._nppHandle, bufferID);
+    if (!currentBufferFilePath.empty()) {
+      searchDirectories.push_back(std::filesystem::path(currentBufferFilePath).parent_path().wstring());
+    }
+    const auto& importDirectories = lexerData->importDirectories[lexerData->currentGame];
+    searchDirectories.insert(searchDirectories.end(), importDirectories.begin(), importDirectories.end());
+
+    return StyleCache::computeKey(pAccess->BufferPointer(), static_cast<size_t>(pAccess->Length()), lexerData->currentGame, searchDirectories);
+  }
+
   // For Notepad++ 8.4.9 or older releases, before NPPN_EXTERNALLEXERBUFFER message was introduced
   void Lexer::detectBufferId() {
     // Can only detect buffer ID if script name is known
@@ -562,6 +864,17 @@ namespace papyrus {
     }
   }
 
+  void Lexer::registerIndexes() {
+    if (bufferID != 0 && indexBufferID != bufferID) {
+      Lock lock(indexMapMutex);
+      blockIndexMap.erase(indexBufferID);
+      identifierIndexMap.erase(indexBufferID);
+      blockIndexMap[bufferID] = blockIndex;
+      identifierIndexMap[bufferID] = identifierIndex;
+      indexBufferID = bufferID;
+    }
+  }
+
   std::wstring Lexer::getClassFilePath(npp_buffer_t bufferID, std::string className) {
     // Find relative path from search directory. Support FO4's namespace.
     std::filesystem::path relativePath;
@@ -571,19 +884,20 @@ namespace papyrus {
     }
     relativePath.replace_extension(".psc");
 
-    // PapyrusCompiler searches in current directory before searching in import directories.
+    // PapyrusCompiler searches in current directory before searching in import directories. Class names are case insensitive, so
+    // lookups go through directory indexes to get the real file path.
     auto currentBufferFilePath = utility::getFilePathFromBuffer(lexerData->nppData._nppHandle, bufferID);
     if (!currentBufferFilePath.empty()) {
-      std::wstring filePath = std::filesystem::path(currentBufferFilePath).parent_path() / relativePath;
-      if (utility::fileExists(filePath)) {
+      std::wstring filePath = utility::findFileIgnoringCase(std::filesystem::path(currentBufferFilePath).parent_path().wstring(), relativePath.wstring());
+      if (!filePath.empty()) {
         return filePath;
       }
     }
 
     // Find the relative path in configured import directories.
     for (const auto& path : lexerData->importDirectories[lexerData->currentGame]) {
-      std::wstring filePath = std::filesystem::path(path) / relativePath;
-      if (utility::fileExists(filePath)) {
+      std::wstring filePath = utility::findFileIgnoringCase(path, relativePath.wstring());
+      if (!filePath.empty()) {
         return filePath;
       }
     }
@@ -622,6 +936,12 @@ namespace papyrus {
           } else {
             ::SendMessage(handle, SCI_SETMOUSEDWELLTIME, SC_TIME_FOREVER, 0);
           }
+
+          // Identifiers may not have been indexed when the document was lexed, if they weren't needed back then
+          auto identifierIndex = Lexer::getIdentifierIndex(eventData.bufferID);
+          if (lexerData->indexIdentifiers && identifierIndex && !identifierIndex->isUsable()) {
+            restyleDocument(eventData.view);
+          }
         } else {
           // Re-apply saved Scintilla settings as current buffer is not managed by this lexer
           if (savedScintillaSettings.saved) {
@@ -722,13 +1042,27 @@ namespace papyrus {
 
     lexerSettings.enableFoldMiddle.subscribe([&](auto) { restyleDocument(); });
 
+    lexerData->indexIdentifiers.subscribe([&](auto eventData) {
+      if (eventData.newValue) {
+        restyleDocument();
+      }
+    });
+
     lexerSettings.enableClassNameCache.subscribe([&](auto eventData) {
       if (!eventData.newValue) {
         clearClassNames();
         clearNonClassNames();
+        clearScriptDeclarations();
       }
       restyleDocument();
     });
+
+    lexerData->fileSaved.subscribe([&](auto eventData) {
+      // If saved file is a cached parent script, properties inherited from it may have changed.
+      if (isUsable() && utility::endsWith(eventData.filePath, L".psc") && invalidateScriptDeclarations(eventData.filePath)) {
+        restyleDocument();
+      }
+    });
   }
 
   npp_buffer_t Helper::getApplicableBufferIdOnView(npp_view_t view) const {
@@ -771,6 +1105,135 @@ namespace papyrus {
     nonClassNames.clear();
   }
 
+  std::set<std::string> Helper::getInheritedPropertyNames(npp_buffer_t bufferID, const std::string& parentScriptName) {
+    std::set<std::string> inheritedPropertyNames;
+    std::set<std::wstring> visitedFilePaths; // To break circular extends chain
+    std::string currentScriptName = parentScriptName;
+    while (!currentScriptName.empty()) {
+      std::wstring filePath = getClassFilePath(bufferID, currentScriptName);
+      if (filePath.empty() || !visitedFilePaths.insert(utility::toLower(filePath)).second) {
+        break;
+      }
+
+      ScriptDeclarations declarations = getScriptDeclarations(filePath);
+      inheritedPropertyNames.insert(declarations.propertyNames.begin(), declarations.propertyNames.end());
+      currentScriptName = declarations.parentScriptName;
+    }
+    return inheritedPropertyNames;
+  }
+
+  Helper::ScriptDeclarations Helper::getScriptDeclarations(const std::wstring& filePath) {
+    // Real path is needed to open the file on case-sensitive file systems, while cache is keyed by lower-cased path
+    std::wstring key = utility::toLower(filePath);
+    {
+      Lock lock(scriptDeclarationsMutex);
+      auto iter = scriptDeclarations.find(key);
+      if (iter != scriptDeclarations.end()) {
+        return iter->second;
+      }
+    }
+
+    ScriptDeclarations declarations = parseScriptDeclarations(filePath);
+    Lock lock(scriptDeclarationsMutex);
+    scriptDeclarations[key] = declarations;
+    return declarations;
+  }
+
+  Helper::ScriptDeclarations Helper::parseScriptDeclarations(const std::wstring& filePath) {
+    ScriptDeclarations declarations;
+    std::ifstream file(filePath);
+    if (!file) {
+      return declarations;
+    }
+
+    enum class CommentState {
+      None,
+      MultiLine,
+      Doc
+    };
+    CommentState commentState = CommentState::None;
+
+    std::string line;
+    while (std::getline(file, line)) {
+      // Collect identifiers on this line, skipping comments and strings.
+      std::vector<std::string> identifiers;
+      size_t index = 0;
+      while (index < line.size()) {
+        char ch = line[index];
+        if (commentState == CommentState::MultiLine) {
+          if (ch == '/' && index + 1 < line.size() && line[index + 1] == ';') {
+            commentState = CommentState::None;
+            index++;
+          }
+          index++;
+        } else if (commentState == CommentState::Doc) {
+          if (ch == '}') {
+            commentState = CommentState::None;
+          }
+          index++;
+        } else if (ch == ';') {
+          if (index + 1 < line.size() && line[index + 1] == '/') {
+            commentState = CommentState::MultiLine;
+            index += 2;
+          } else {
+            break; // Rest of the line is a comment
+          }
+        } else if (ch == '{') {
+          commentState = CommentState::Doc;
+          index++;
+        } else if (ch == '"') {
+          // Skip to the closing double quote, taking escapes into account
+          for (index++; index < line.size() && line[index] != '"'; index++) {
+            if (line[index] == '\\') {
+              index++;
+            }
+          }
+          index++;
+        } else if (std::isalpha(static_cast<unsigned char>(ch)) || ch == '_') {
+          std::string identifier;
+          while (index < line.size() && (std::isalnum(static_cast<unsigned char>(line[index])) || line[index] == '_' || line[index] == ':')) {
+            identifier.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(line[index])))); // Papyrus script is case insensitive
+            index++;
+          }
+          identifiers.push_back(identifier);
+        } else {
+          index++;
+        }
+      }
+
+      for (auto iter = identifiers.begin(); iter != identifiers.end(); ++iter) {
+        if (*iter == "scriptname") {
+          auto iterExtends = std::find(iter, identifiers.end(), "extends");
+          if (iterExtends != identifiers.end() && std::next(iterExtends) != identifiers.end()) {
+            declarations.parentScriptName = *std::next(iterExtends);
+          }
+          break;
+        } else if (*iter == "property") {
+          if (std::next(iter) != identifiers.end()) {
+            declarations.propertyNames.insert(*std::next(iter));
+          }
+          break;
+        }
+      }
+    }
+    return declarations;
+  }
+
+  bool Helper::invalidateScriptDeclarations(const std::wstring& filePath) {
+    Lock lock(scriptDeclarationsMutex);
+    bool invalidated = (scriptDeclarations.erase(utility::toLower(filePath)) > 0);
+
+    // Scripts that failed to resolve a parent may be able to now, so always move to a new generation.
+    scriptDeclarationsGeneration++;
+    return invalidated;
+  }
+
+  void Helper::clearScriptDeclarations() {
+    Lock lock(scriptDeclarationsMutex);
+    scriptDeclarations.clear();
+    scriptDeclarationsGeneration++;
+  }
+
   void Helper::handleHotspotClick(HWND handle, npp_buffer_t bufferID, Sci_Position position) const {
     if (isUsable() && lexerData->settings.enableClassLink && lexerData->currentGame != game::Game::Auto) {
       // Change Scintilla word chars to include ':' to support FO4's namespaces.
@@ -22,7 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SimpleLexerBase.hpp"
 
+#include "BlockIndex.hpp"
+#include "IdentifierIndex.hpp"
 #include "LexerData.hpp"
+#include "StyleCache.hpp"
 
 #include "..\Common\NotepadPlusPlus.hpp"
 
@@ -31,7 +34,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "..\..\external\lexilla\WordList.h"
 #include "..\..\external\scintilla\ILexer.h"
 
+#include <array>
+#include <atomic>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
@@ -60,6 +66,12 @@ namespace papyrus {
             int mouseDwellTime {0};
           };
 
+          // Declarations of a script file that are relevant to lexing scripts extending it
+          struct ScriptDeclarations {
+            std::string parentScriptName;
+            std::set<std::string> propertyNames;
+          };
+
           Helper();
 
           // Only when configuration file exists under Notepad++'s plugin config folder can this lexer be used
@@ -69,6 +81,12 @@ namespace papyrus {
           names_cache_t& getClassNamesForGame(Game game);
           names_cache_t& getNonClassNamesForGame(Game game);
 
+          // Get all properties inherited from the given parent script, by following the extends chain through import directories
+          std::set<std::string> getInheritedPropertyNames(npp_buffer_t bufferID, const std::string& parentScriptName);
+
+          // Generation of cached script declarations. It changes every time cached declarations are invalidated.
+          inline size_t getScriptDeclarationsGeneration() const { return scriptDeclarationsGeneration; }
+
         private:
           // Get current buffer ID on the given view, if it's a applicable
           npp_buffer_t getApplicableBufferIdOnView(npp_view_t view) const;
@@ -81,6 +99,16 @@ namespace papyrus {
           void clearClassNames();
           void clearNonClassNames();
 
+          // Get declarations of a script file, either from cache or by parsing the file
+          ScriptDeclarations getScriptDeclarations(const std::wstring& filePath);
+
+          // Parse a script file for its parent script and declared properties
+          static ScriptDeclarations parseScriptDeclarations(const std::wstring& filePath);
+
+          // Invalidate cached script declarations. Returns whether anything cached was removed.
+          bool invalidateScriptDeclarations(const std::wstring& filePath);
+          void clearScriptDeclarations();
+
           // Hotspot click handler
           void handleHotspotClick(HWND handle, npp_buffer_t bufferID, Sci_Position position) const;
 
@@ -95,6 +123,12 @@ namespace papyrus {
           std::mutex nonClassNamesMutex;
           std::map<Game, names_cache_t> nonClassNames;
 
+          // Cached declarations of parent scripts, keyed by lower-cased file path. Shared by all lexer instances so a parent script is
+          // only parsed once no matter how many scripts extend it. Entries are invalidated when corresponding file is saved in Notepad++.
+          std::mutex scriptDeclarationsMutex;
+          std::map<std::wstring, ScriptDeclarations> scriptDeclarations;
+          std::atomic<size_t> scriptDeclarationsGeneration {0};
+
           // Saved Scintilla settings before we make our own changes, in case some other plugins also change them
           Helper::SavedScintillaSettings savedMainViewScintillaSettings;
           Helper::SavedScintillaSettings savedSecondViewScintillaSettings;
@@ -114,6 +148,15 @@ namespace papyrus {
       // Utility method to retrieve script name for a given buffer.
       static std::string getScriptName(npp_buffer_t bufferID);
 
+      // Utility method to retrieve block keyword index for a given buffer. Returns nullptr if the buffer isn't lexed by this lexer.
+      static std::shared_ptr<BlockIndex> getBlockIndex(npp_buffer_t bufferID);
+
+      // Utility method to retrieve identifier index for a given buffer. Returns nullptr if the buffer isn't lexed by this lexer.
+      static std::shared_ptr<IdentifierIndex> getIdentifierIndex(npp_buffer_t bufferID);
+
+      // Word lists as Notepad++ provides them. Words current game doesn't support are left out of the lists in use.
+      Sci_Position SCI_METHOD WordListSet(int n, const char* wl) override;
+
       // Lexer functions
       void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument* pAccess) override;
       void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument* pAccess) override;
@@ -183,9 +226,30 @@ namespace papyrus {
         Sci_Position startPos;
       };
 
+      // Select lexing and folding methods specialized for current game, and filter word lists for it. Features a game doesn't
+      // support are then skipped at compile time, rather than checked on every token.
+      void selectGameSpecificMethods();
+
+      // Word list with the given index in WordListSet, or nullptr if it isn't used
+      WordList* getWordList(size_t n) const;
+
+      // Game specific lexing and folding
+      template <Game gameType>
+      void lex(Sci_PositionU startPos, Sci_Position lengthDoc, IDocument* pAccess);
+
+      template <Game gameType>
+      void fold(Sci_PositionU startPos, Sci_Position lengthDoc, IDocument* pAccess);
+
       // Parse a text line and tokenize each word/symbol, etc.
+      template <Game gameType>
       std::vector<Token> tokenize(Accessor& accessor, Sci_Position line) const;
 
+      // Add the token to block index if it is a block keyword. Tokens after it on the same line are checked for block name.
+      void indexBlockKeyword(Sci_Position line, Sci_Position lineStart, std::vector<Token>::const_iterator iterToken, std::vector<Token>::const_iterator iterEnd);
+
+      // Add the token to identifier index
+      void indexIdentifier(Sci_Position line, Sci_Position lineStart, const Token& token);
+
       // Colorize a word/symbol in StyleContext to a provided state based on the given token.
       void colorToken(StyleContext& styleContext, Token token, State state) const;
 
@@ -198,15 +262,36 @@ namespace papyrus {
       // Add a given name to a names cache
       void addNameToCache(const std::string& name, std::set<std::string>& namesCache, std::mutex& mutex);
 
+      // Check whether a given name is a property inherited from parent scripts
+      bool isInheritedProperty(const std::string& name);
+
+      // Get all property names inherited from parent scripts
+      const std::set<std::string>& getInheritedPropertyNames();
+
+      // Compute hash of property names inherited from parent scripts, to check whether a style cache entry is still valid
+      uint64_t computeInheritedPropertiesHash();
+
       // Mouse hover handler
       void handleMouseHover(HWND handle, bool hovering, Sci_Position position) const;
 
       // Content change handler. Update property list to make sure it's correct
       void handleContentChange(HWND handle, Sci_Position position, Sci_Position linesAdded);
 
+      // Restore styles, fold levels and lexer states from style cache, if current document has a matching entry
+      bool applyStyleCache(IDocument* pAccess);
+
+      // Store lexing result of current document to style cache
+      void storeStyleCache(IDocument* pAccess);
+
+      // Compute style cache key of current document
+      uint64_t computeStyleCacheKey(IDocument* pAccess) const;
+
       // Try to detect current document's Notepad++ buffer ID
       void detectBufferId();
 
+      // Make block and identifier indexes available under current buffer ID
+      void registerIndexes();
+
       // Utility method to retrieve the full path of a class. It supports FO4's namespaces
       static std::wstring getClassFilePath(npp_buffer_t bufferID, std::string className);
 
@@ -223,6 +308,9 @@ namespace papyrus {
       WordList wordListFoldMiddle;  // type5
       WordList wordListFoldClose;   // type6
 
+      // Word lists as set by Notepad++, indexed like in WordListSet
+      std::array<std::string, 9> wordListSources;
+
       // Provide pointers to corresponding word lists to base class
       const std::vector<WordList*> instreWordLists;
       const std::vector<WordList*> typeWordLists;
@@ -236,9 +324,42 @@ namespace papyrus {
       // Current script's name
       std::string scriptName {};
 
+      // Parent script's name, if current script extends another script
+      std::string parentScriptName {};
+
+      // Cache property names inherited through extends chain, flattened so each token only needs one lookup. It's rebuilt when
+      // parent script, buffer ID or generation of shared script declarations cache changes.
+      std::set<std::string> inheritedPropertyNames;
+      std::string inheritedPropertyNamesParent {};
+      npp_buffer_t inheritedPropertyNamesBufferID {0};
+      size_t inheritedPropertyNamesGeneration {0};
+
       // Current document's buffer ID managed by Notepad++
       npp_buffer_t bufferID {0};
 
+      // Block keywords in current document, shared with keyword matcher
+      std::shared_ptr<BlockIndex> blockIndex {std::make_shared<BlockIndex>()};
+
+      // Identifiers in current document, shared with occurrence highlighter
+      std::shared_ptr<IdentifierIndex> identifierIndex {std::make_shared<IdentifierIndex>()};
+      bool indexingIdentifiers {false};
+
+      // Buffer ID both indexes are registered under
+      npp_buffer_t indexBufferID {0};
+
+      // Lexing and folding methods specialized for the game current document is for
+      using game_specific_method_t = void (Lexer::*)(Sci_PositionU, Sci_Position, IDocument*);
+      game_specific_method_t lexMethod {nullptr};
+      game_specific_method_t foldMethod {nullptr};
+      Game gameSpecificMethodsGame {Game::Auto};
+
+      // Style cache states. Cache is only checked on the first lexing of a document, and lexing result is stored once the whole
+      // document has been lexed and folded. Fold levels restored from cache are applied in the following Fold call.
+      bool styleCacheChecked {false};
+      bool styleCacheStorePending {false};
+      uint64_t styleCacheKey {0};
+      std::vector<int> cachedFoldLevels;
+
       // Subscriptions
       hover_event_topic_t::subscription_t hoverEventSubscription;
       change_event_topic_t::subscription_t changeEventSubscription;
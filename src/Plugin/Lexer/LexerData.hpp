@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "LexerSettings.hpp"
 #include "..\Common\Game.hpp"
 #include "..\Common\NotepadPlusPlus.hpp"
+#include "..\Common\PrimitiveTypeValueMonitor.hpp"
 #include "..\Common\Topic.hpp"
 
 #include "..\..\external\npp\PluginInterface.h"
@@ -66,6 +67,12 @@ namespace papyrus {
   };
   using change_event_topic_t = utility::Topic<ChangeEventData>;
 
+  struct FileSaveEventData {
+    npp_buffer_t bufferID;
+    std::wstring filePath;
+  };
+  using file_saved_topic_t = utility::Topic<FileSaveEventData>;
+
   // Pass data from plugin to lexer, e.g. settings, and event data received from NPP or Scintilla
   struct LexerData {
     LexerData(const NppData& nppData, const LexerSettings& settings, Game currentGame = Game::Auto, game_import_dirs_t importDirectories = game_import_dirs_t(), bool usable = true)
@@ -76,11 +83,14 @@ namespace papyrus {
     const LexerSettings& settings;
     Game currentGame;
     game_import_dirs_t importDirectories;
+    std::wstring styleCacheDirectory;
     npp_lang_type_t scriptLangID;
     buffer_activated_topic_t bufferActivated;
     click_event_topic_t clickEventData;
     hover_event_topic_t hoverEventData;
     change_event_topic_t changeEventData;
+    file_saved_topic_t fileSaved;
+    utility::PrimitiveTypeValueMonitor<bool> indexIdentifiers; // Whether identifiers are needed, e.g. for occurrence highlighting
     bool usable;
   };
 
@@ -17,6 +17,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "AssemblyLexer.hpp"
 #include "Lexer.hpp"
 
 #include "..\..\external\lexilla\LexerModule.h"
@@ -24,7 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace papyrus {
 
   int SCI_METHOD GetLexerCount() {
-    return 1;
+    return 2;
   }
 
   void SCI_METHOD GetLexerName(int index, char* name, int length) {
@@ -35,6 +36,11 @@ namespace papyrus {
         strncpy_s(name, length, Lexer::name(), _TRUNCATE);
         break;
       }
+
+      case 1: {
+        strncpy_s(name, length, AssemblyLexer::name(), _TRUNCATE);
+        break;
+      }
     }
   }
 
@@ -42,6 +48,9 @@ namespace papyrus {
     if (strcmp(name, Lexer::name()) == 0) {
       return Lexer::factory();
     }
+    if (strcmp(name, AssemblyLexer::name()) == 0) {
+      return AssemblyLexer::factory();
+    }
     return nullptr;
   }
 
@@ -54,6 +63,11 @@ namespace papyrus {
         wcsncpy_s(text, length, Lexer::statusText(), _TRUNCATE);
         break;
       }
+
+      case 1: {
+        wcsncpy_s(text, length, AssemblyLexer::statusText(), _TRUNCATE);
+        break;
+      }
     }
   }
 
@@ -63,6 +77,10 @@ namespace papyrus {
       case 0: {
         return Lexer::factory;
       }
+
+      case 1: {
+        return AssemblyLexer::factory;
+      }
     }
     return nullptr;
   }
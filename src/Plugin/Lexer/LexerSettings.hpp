@@ -33,6 +33,8 @@ namespace papyrus {
 
   constexpr int DEFAULT_HOVER_DELAY     = 300;
 
+  constexpr int DEFAULT_STYLE_CACHE_SIZE_LIMIT = 64; // In MiB
+
   struct LexerSettings {
     utility::PrimitiveTypeValueMonitor<bool>     enableFoldMiddle;
     utility::PrimitiveTypeValueMonitor<bool>     enableClassNameCache;
@@ -45,6 +47,8 @@ namespace papyrus {
     utility::PrimitiveTypeValueMonitor<bool>     enableHover;
     utility::PrimitiveTypeValueMonitor<int>      enabledHoverCategories;
     utility::PrimitiveTypeValueMonitor<int>      hoverDelay;
+    utility::PrimitiveTypeValueMonitor<bool>     enableStyleCache;
+    utility::PrimitiveTypeValueMonitor<int>      styleCacheSizeLimit;
   };
 
 } // namespace
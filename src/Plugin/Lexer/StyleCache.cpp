@@ -0,0 +1,313 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StyleCache.hpp"
+
+#include "..\Common\Hash.hpp"
+#include "..\Common\StringUtil.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+namespace papyrus {
+
+  // Cache file layout, all numbers are stored in native byte order:
+  //   Signature:         4 bytes, "PSSC".
+  //   Format version:    4 bytes.
+  //   Key:               8 bytes.
+  //   Styles count:      8 bytes, followed by one byte per style.
+  //   Fold levels count: 8 bytes, followed by 4 bytes per level.
+  //   Script name:       4 bytes length, followed by the name.
+  //   Parent name:       4 bytes length, followed by the name.
+  //   Properties count:  4 bytes, followed by each property's name (4 bytes length + name) and line (8 bytes).
+  //   Inherited hash:    8 bytes, hash of property names inherited from parent scripts.
+  //   Keywords count:    4 bytes, followed by each block keyword's line, column, length, name column and name length (8 bytes
+  //                      each), type and role (1 byte each).
+  //   Identifiers flag:  1 byte, whether identifiers were indexed.
+  //   Identifiers count: 4 bytes, followed by each identifier's line and column (8 bytes each) and name (4 bytes length + name).
+  constexpr char STYLE_CACHE_SIGNATURE[] = {'P', 'S', 'S', 'C'};
+  constexpr uint32_t STYLE_CACHE_FORMAT_VERSION = 3;
+  constexpr wchar_t STYLE_CACHE_FILE_EXTENSION[] = L".cache";
+
+  namespace {
+    template <class T>
+    inline void writeValue(std::ofstream& file, T value) {
+      file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    inline void writeString(std::ofstream& file, const std::string& str) {
+      writeValue(file, static_cast<uint32_t>(str.size()));
+      file.write(str.data(), str.size());
+    }
+
+    template <class T>
+    inline bool readValue(std::ifstream& file, T& value) {
+      return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    // Check that a count read from file is possible given the bytes left in file, so a corrupted count can't cause a huge allocation
+    inline bool fitsInFile(std::ifstream& file, uint64_t fileSize, uint64_t count, size_t elementSize) {
+      auto position = static_cast<uint64_t>(file.tellg());
+      return position <= fileSize && count <= (fileSize - position) / elementSize;
+    }
+
+    inline bool readString(std::ifstream& file, uint64_t fileSize, std::string& str) {
+      uint32_t size {};
+      if (!readValue(file, size) || !fitsInFile(file, fileSize, size, 1)) {
+        return false;
+      }
+      str.resize(size);
+      return size == 0 || static_cast<bool>(file.read(str.data(), size));
+    }
+
+    inline bool readPosition(std::ifstream& file, Sci_Position& position) {
+      int64_t value {};
+      if (!readValue(file, value)) {
+        return false;
+      }
+      position = static_cast<Sci_Position>(value);
+      return true;
+    }
+
+    inline std::filesystem::path entryPath(const std::wstring& directory, uint64_t key) {
+      return std::filesystem::path(directory) / (utility::hashToHexStr(key) + STYLE_CACHE_FILE_EXTENSION);
+    }
+  }
+
+  uint64_t StyleCache::computeKey(const char* content, size_t length, Game game, const std::vector<std::wstring>& searchDirectories) {
+    uint64_t key = utility::hash(content, length);
+    key = utility::hash(game::gameNames[std::to_underlying(game)].first, key);
+    for (const auto& directory : searchDirectories) {
+      key = utility::hash(utility::toLower(directory), key);
+    }
+    return key;
+  }
+
+  bool StyleCache::load(const std::wstring& directory, uint64_t key, size_t documentLength, StyleCacheEntry& entry) {
+    auto filePath = entryPath(directory, key);
+    std::error_code errorCode;
+    uint64_t fileSize = static_cast<uint64_t>(std::filesystem::file_size(filePath, errorCode));
+    if (errorCode) {
+      return false;
+    }
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+      return false;
+    }
+
+    char signature[sizeof(STYLE_CACHE_SIGNATURE)] {};
+    uint32_t formatVersion {};
+    uint64_t storedKey {};
+    uint64_t stylesCount {};
+    if (!file.read(signature, sizeof(signature)) || !std::equal(std::begin(signature), std::end(signature), std::begin(STYLE_CACHE_SIGNATURE))
+      || !readValue(file, formatVersion) || formatVersion != STYLE_CACHE_FORMAT_VERSION
+      || !readValue(file, storedKey) || storedKey != key
+      || !readValue(file, stylesCount) || stylesCount != documentLength || !fitsInFile(file, fileSize, stylesCount, 1)) {
+      return false;
+    }
+
+    entry.styles.resize(static_cast<size_t>(stylesCount));
+    if (!file.read(entry.styles.data(), entry.styles.size())) {
+      return false;
+    }
+
+    uint64_t foldLevelsCount {};
+    if (!readValue(file, foldLevelsCount) || !fitsInFile(file, fileSize, foldLevelsCount, sizeof(int))) {
+      return false;
+    }
+    entry.foldLevels.resize(static_cast<size_t>(foldLevelsCount));
+    if (!file.read(reinterpret_cast<char*>(entry.foldLevels.data()), entry.foldLevels.size() * sizeof(int))) {
+      return false;
+    }
+
+    uint32_t propertiesCount {};
+    if (!readString(file, fileSize, entry.scriptName) || !readString(file, fileSize, entry.parentScriptName) || !readValue(file, propertiesCount)) {
+      return false;
+    }
+    entry.properties.clear();
+    for (uint32_t i = 0; i < propertiesCount; ++i) {
+      std::string name;
+      Sci_Position line {};
+      if (!readString(file, fileSize, name) || !readPosition(file, line)) {
+        return false;
+      }
+      entry.properties.emplace_back(name, line);
+    }
+
+    uint32_t keywordsCount {};
+    if (!readValue(file, entry.inheritedPropertiesHash) || !readValue(file, keywordsCount) || !fitsInFile(file, fileSize, keywordsCount, 5 * sizeof(int64_t) + 2)) {
+      return false;
+    }
+    entry.blockKeywords.clear();
+    entry.blockKeywords.reserve(keywordsCount);
+    for (uint32_t i = 0; i < keywordsCount; ++i) {
+      BlockKeyword keyword {};
+      uint8_t type {};
+      uint8_t role {};
+      if (!readPosition(file, keyword.line) || !readPosition(file, keyword.column) || !readPosition(file, keyword.length)
+        || !readPosition(file, keyword.nameColumn) || !readPosition(file, keyword.nameLength)
+        || !readValue(file, type) || type > std::to_underlying(BlockType::While) || !readValue(file, role) || role > std::to_underlying(BlockRole::Close)) {
+        return false;
+      }
+      keyword.type = static_cast<BlockType>(type);
+      keyword.role = static_cast<BlockRole>(role);
+      entry.blockKeywords.push_back(keyword);
+    }
+
+    uint8_t identifiersIndexed {};
+    uint32_t identifiersCount {};
+    if (!readValue(file, identifiersIndexed) || !readValue(file, identifiersCount) || !fitsInFile(file, fileSize, identifiersCount, 2 * sizeof(int64_t) + sizeof(uint32_t))) {
+      return false;
+    }
+    entry.identifiersIndexed = (identifiersIndexed != 0);
+    entry.identifiers.clear();
+    entry.identifiers.reserve(identifiersCount);
+    for (uint32_t i = 0; i < identifiersCount; ++i) {
+      IndexedIdentifier indexedIdentifier {};
+      if (!readPosition(file, indexedIdentifier.line) || !readPosition(file, indexedIdentifier.column) || !readString(file, fileSize, indexedIdentifier.identifier)) {
+        return false;
+      }
+      entry.identifiers.push_back(std::move(indexedIdentifier));
+    }
+    file.close();
+
+    // Mark this entry as recently used, so it's the last to be evicted.
+    std::filesystem::last_write_time(filePath, std::filesystem::file_time_type::clock::now(), errorCode);
+    return true;
+  }
+
+  void StyleCache::store(const std::wstring& directory, uint64_t key, const StyleCacheEntry& entry, int sizeLimit) {
+    std::error_code errorCode;
+    std::filesystem::create_directories(directory, errorCode);
+    if (errorCode) {
+      return;
+    }
+
+    // Write to a temporary file first, so a partially written entry can never be loaded.
+    auto filePath = entryPath(directory, key);
+    auto tempFilePath = std::filesystem::path(filePath).replace_extension(L".tmp");
+    {
+      std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+      if (!file) {
+        return;
+      }
+
+      file.write(STYLE_CACHE_SIGNATURE, sizeof(STYLE_CACHE_SIGNATURE));
+      writeValue(file, STYLE_CACHE_FORMAT_VERSION);
+      writeValue(file, key);
+      writeValue(file, static_cast<uint64_t>(entry.styles.size()));
+      file.write(entry.styles.data(), entry.styles.size());
+      writeValue(file, static_cast<uint64_t>(entry.foldLevels.size()));
+      file.write(reinterpret_cast<const char*>(entry.foldLevels.data()), entry.foldLevels.size() * sizeof(int));
+      writeString(file, entry.scriptName);
+      writeString(file, entry.parentScriptName);
+      writeValue(file, static_cast<uint32_t>(entry.properties.size()));
+      for (const auto& [name, line] : entry.properties) {
+        writeString(file, name);
+        writeValue(file, static_cast<int64_t>(line));
+      }
+      writeValue(file, entry.inheritedPropertiesHash);
+      writeValue(file, static_cast<uint32_t>(entry.blockKeywords.size()));
+      for (const auto& keyword : entry.blockKeywords) {
+        writeValue(file, static_cast<int64_t>(keyword.line));
+        writeValue(file, static_cast<int64_t>(keyword.column));
+        writeValue(file, static_cast<int64_t>(keyword.length));
+        writeValue(file, static_cast<int64_t>(keyword.nameColumn));
+        writeValue(file, static_cast<int64_t>(keyword.nameLength));
+        writeValue(file, static_cast<uint8_t>(keyword.type));
+        writeValue(file, static_cast<uint8_t>(keyword.role));
+      }
+      writeValue(file, static_cast<uint8_t>(entry.identifiersIndexed));
+      writeValue(file, static_cast<uint32_t>(entry.identifiers.size()));
+      for (const auto& indexedIdentifier : entry.identifiers) {
+        writeValue(file, static_cast<int64_t>(indexedIdentifier.line));
+        writeValue(file, static_cast<int64_t>(indexedIdentifier.column));
+        writeString(file, indexedIdentifier.identifier);
+      }
+
+      if (!file) {
+        file.close();
+        std::filesystem::remove(tempFilePath, errorCode);
+        return;
+      }
+    }
+
+    std::filesystem::rename(tempFilePath, filePath, errorCode);
+    if (errorCode) {
+      std::filesystem::remove(tempFilePath, errorCode);
+      return;
+    }
+
+    evict(directory, sizeLimit);
+  }
+
+  // Private methods
+  //
+
+  void StyleCache::evict(const std::wstring& directory, int sizeLimit) {
+    struct CacheFile {
+      std::filesystem::path path;
+      uintmax_t size;
+      std::filesystem::file_time_type lastUsed;
+    };
+
+    std::vector<CacheFile> cacheFiles;
+    uintmax_t totalSize = 0;
+    std::error_code errorCode;
+    for (auto iter = std::filesystem::directory_iterator(directory, errorCode); !errorCode && iter != std::filesystem::directory_iterator(); iter.increment(errorCode)) {
+      // Another Notepad++ instance may be evicting at the same time, so a file that can't be queried is skipped rather than
+      // ending the listing. Each query clears the error code when it succeeds, so each one is checked on its own.
+      std::error_code entryErrorCode;
+      if (!iter->is_regular_file(entryErrorCode) || iter->path().extension() != STYLE_CACHE_FILE_EXTENSION) {
+        continue;
+      }
+      CacheFile cacheFile {
+        .path = iter->path(),
+        .size = iter->file_size(entryErrorCode)
+      };
+      if (entryErrorCode) {
+        continue;
+      }
+      cacheFile.lastUsed = iter->last_write_time(entryErrorCode);
+      if (entryErrorCode) {
+        continue;
+      }
+      totalSize += cacheFile.size;
+      cacheFiles.push_back(cacheFile);
+    }
+
+    uintmax_t sizeLimitInBytes = static_cast<uintmax_t>(std::max(sizeLimit, 0)) * 1024 * 1024;
+    if (totalSize > sizeLimitInBytes) {
+      // Evict least recently used entries first
+      std::sort(cacheFiles.begin(), cacheFiles.end(), [](const auto& file1, const auto& file2) { return file1.lastUsed < file2.lastUsed; });
+      for (const auto& cacheFile : cacheFiles) {
+        if (totalSize <= sizeLimitInBytes) {
+          break;
+        }
+        if (std::filesystem::remove(cacheFile.path, errorCode)) {
+          totalSize -= cacheFile.size;
+        }
+      }
+    }
+  }
+
+} // namespace
@@ -0,0 +1,73 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "BlockIndex.hpp"
+#include "IdentifierIndex.hpp"
+
+#include "..\Common\Game.hpp"
+
+#include "..\..\external\scintilla\Sci_Position.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace papyrus {
+
+  using Game = game::Game;
+
+  // Only documents at least this large are worth caching
+  constexpr Sci_Position STYLE_CACHE_MIN_DOCUMENT_LENGTH = 64 * 1024;
+
+  // Lexing result of a document, enough to restore styling, lexer states and indexes without lexing the document again
+  struct StyleCacheEntry {
+    std::vector<char> styles;
+    std::vector<int> foldLevels;
+    std::string scriptName;
+    std::string parentScriptName;
+    std::vector<std::pair<std::string, Sci_Position>> properties;
+    uint64_t inheritedPropertiesHash {0}; // Properties inherited from parent scripts affect styling, but live in other files
+    std::vector<BlockKeyword> blockKeywords;
+    bool identifiersIndexed {false}; // Identifiers are only indexed when they are needed
+    std::vector<IndexedIdentifier> identifiers;
+  };
+
+  // On-disk cache of lexing results, one file per entry under the cache directory. Entries are keyed by document content,
+  // game and directories searched for classes, as they all affect the result. Properties inherited from parent scripts also
+  // affect the result, but they can only be known after the entry is loaded, so the loader needs to check them against
+  // inheritedPropertiesHash. When the total size of cached entries exceeds the limit, least recently used entries are evicted.
+  class StyleCache {
+    public:
+      // Compute cache key of a document
+      static uint64_t computeKey(const char* content, size_t length, Game game, const std::vector<std::wstring>& searchDirectories);
+
+      // Load a cached entry. Returns false if not found, or the entry doesn't match the document.
+      static bool load(const std::wstring& directory, uint64_t key, size_t documentLength, StyleCacheEntry& entry);
+
+      // Store an entry, then evict least recently used entries if the cache grows over size limit (in MiB)
+      static void store(const std::wstring& directory, uint64_t key, const StyleCacheEntry& entry, int sizeLimit);
+
+    private:
+      static void evict(const std::wstring& directory, int sizeLimit);
+  };
+
+} // namespace
@@ -30,6 +30,7 @@ https://www.creationkit.com/fallout4/index.php?title=Category:Papyrus
 
 #include "Plugin.hpp"
 
+#include "Common\DirectoryIndex.hpp"
 #include "Common\FileSystemUtil.hpp"
 #include "Common\Logger.hpp"
 #include "Common\Resources.hpp"
@@ -44,7 +45,9 @@ https://www.creationkit.com/fallout4/index.php?title=Category:Papyrus
 #include "..\external\tinyxml2\tinyxml2.h"
 #include "..\external\XMessageBox\XMessageBox.h"
 
+#include <chrono>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -76,7 +79,11 @@ namespace papyrus {
       FuncItem{}, // Separator1
       FuncItem{ L"Advanced", advancedMenuFunc, 0, false, nullptr },
       FuncItem{}, // Separator2
-      FuncItem{ L"About...", aboutMenuFunc, 0, false, nullptr }
+      FuncItem{ L"About...", aboutMenuFunc, 0, false, nullptr },
+      FuncItem{}, // Separator3
+      FuncItem{ L"Go to enclosing block", goToEnclosingBlockMenuFunc, 0, false, nullptr },
+      FuncItem{ L"Compile all scripts in folder", compileFolderMenuFunc, 0, false, nullptr },
+      FuncItem{ L"Cancel compilation", cancelCompilationMenuFunc, 0, false, nullptr }
     } {
   }
 
@@ -126,9 +133,17 @@ namespace papyrus {
           break;
         }
 
+        case SCN_CHARADDED: {
+          handleCharAdded(notification);
+          break;
+        }
+
         case SCN_UPDATEUI: {
           if (notification->updated & SC_UPDATE_SELECTION) {
             handleSelectionChange(notification);
+          } else if ((notification->updated & SC_UPDATE_V_SCROLL) && settings.keywordMatcherSettings.enableOccurrenceHighlighting) {
+            // Scrolling gets more lines lexed, which may have more occurrences of highlighted identifier
+            handleSelectionChange(notification);
           }
           break;
         }
@@ -150,6 +165,18 @@ namespace papyrus {
           break;
         }
 
+        case NPPN_SHUTDOWN: {
+          // Stop background work while the plugin is still fully functional, instead of in its destructor. Compiler workers
+          // in particular can't be waited for from the destructor, which runs while Windows holds the loader lock.
+          if (blockChecker) {
+            blockChecker->stop();
+          }
+          if (compiler) {
+            compiler->stop();
+          }
+          break;
+        }
+
         case NPPN_EXTERNALLEXERBUFFER: {
           Lexer::assignBufferID(notification->nmhdr.idFrom);
           break;
@@ -167,6 +194,11 @@ namespace papyrus {
           break;
         }
 
+        case NPPN_FILESAVED: {
+          handleFileSave(notification->nmhdr.idFrom);
+          break;
+        }
+
         case NPPN_DARKMODECHANGED: {
           updateNppUIParameters();
           break;
@@ -213,6 +245,10 @@ namespace papyrus {
     errorsWindow = std::make_unique<ErrorsWindow>(myInstance, nppData._nppHandle, messageWindow);
     errorAnnotator = std::make_unique<ErrorAnnotator>(nppData, settings.errorAnnotatorSettings);
     keywordMatcher = std::make_unique<KeywordMatcher>(nppData, settings.keywordMatcherSettings);
+    blockChecker = std::make_unique<BlockChecker>(nppData, settings.keywordMatcherSettings, messageWindow);
+    occurrenceHighlighter = std::make_unique<OccurrenceHighlighter>(nppData, settings.keywordMatcherSettings);
+    blockNavigator = std::make_unique<BlockNavigator>(nppData);
+    autoIndenter = std::make_unique<AutoIndenter>();
     settingsDialog.init(myInstance, nppData._nppHandle);
     aboutDialog.init(myInstance, nppData._nppHandle);
 
@@ -233,9 +269,17 @@ namespace papyrus {
       settingsStorage.init(std::filesystem::path(configPath) / PLUGIN_NAME L".ini");
       settings.loadSettings(settingsStorage, utility::Version(PLUGIN_VERSION));
       onSettingsUpdated();
+      lexerData->styleCacheDirectory = std::filesystem::path(configPath) / PLUGIN_NAME / L"StyleCache";
+
+      // Identifiers are only indexed by lexer when they are highlighted
+      lexerData->indexIdentifiers = settings.keywordMatcherSettings.enableOccurrenceHighlighting;
+      settings.keywordMatcherSettings.enableOccurrenceHighlighting.subscribe([&](auto eventData) {
+        lexerData->indexIdentifiers = eventData.newValue;
+      });
 
       // Only initialize compiler when settings are ready.
       compiler = std::make_unique<Compiler>(messageWindow, settings.compilerSettings);
+      batchBuilder = std::make_unique<BatchBuilder>(*compiler);
     }
   }
 
@@ -328,12 +372,14 @@ namespace papyrus {
         lexerData->currentGame = detectedGame;
       }
 
-      // Check if active compilation file is still the current one on either view.
-      if (activeCompilationRequest.bufferID != 0) {
-        isCompilingCurrentFile = utility::compare(activeCompilationRequest.filePath, filePath);
-        if (isCompilingCurrentFile && !fromLangChange) {
-          ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Compiling..."));
+      // Check if current file on either view is being compiled.
+      isCompilingCurrentFile = std::any_of(activeCompilationRequests.begin(), activeCompilationRequests.end(),
+        [&](const auto& request) {
+          return utility::compare(request.filePath, filePath);
         }
+      );
+      if (isCompilingCurrentFile && !fromLangChange) {
+        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Compiling..."));
       }
 
       // Check if we are waiting for a file to open as a result of user selecting an error from list.
@@ -350,12 +396,12 @@ namespace papyrus {
           int line = iter->line - 1;
 
           // When the buffer is big, asking Scintilla to scroll immediately doesn't always work, so use a short timer.
-          jumpToErrorLineTimer = utility::startTimer(100, [=] {
-            // Make sure the active document is still the one we are tracking before scrolling.
-            if (bufferID == ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0)) {
-              ::SendMessage(scintillaHandle, SCI_GOTOLINE, line, 0);
-            }
-          });
+          jumpToErrorLine = ErrorLineJump {
+            .scintillaHandle = scintillaHandle,
+            .bufferID = bufferID,
+            .line = line
+          };
+          ::SetTimer(messageWindow, PPT_JUMP_TO_ERROR_LINE, 100, nullptr);
 
           // Get rid of all tracked errors in the list for the same file.
           activatedErrorsTrackingList.erase(iter, activatedErrorsTrackingList.end());
@@ -377,13 +423,29 @@ namespace papyrus {
           std::wstring gameSpecificStatus(L"[" + game::gameNames[std::to_underlying(detectedGame)].second + L"] " + Lexer::statusText());
           ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(gameSpecificStatus.c_str()));
         }
+        caretContext.clear();
+        showCaretContext(scintillaHandle);
 
         if (keywordMatcher) {
           keywordMatched = keywordMatcher->match(scintillaHandle);
         }
-      } else if (isPapyrusScriptFile && fromLangChange && keywordMatcher) {
-        // Papyrus script file changed to other language, clear keyword matching.
-        keywordMatcher->clear();
+        if (occurrenceHighlighter) {
+          occurrenceHighlighter->highlight(scintillaHandle, bufferID);
+        }
+        if (blockChecker) {
+          blockChecker->check(scintillaHandle, bufferID);
+        }
+      } else if (isPapyrusScriptFile && fromLangChange) {
+        // Papyrus script file changed to other language, clear keyword matching, occurrence highlighting and block check result.
+        if (keywordMatcher) {
+          keywordMatcher->clear();
+        }
+        if (occurrenceHighlighter) {
+          occurrenceHighlighter->clear();
+        }
+        if (blockChecker) {
+          blockChecker->clear();
+        }
       }
 
       HMENU menu = reinterpret_cast<HMENU>(::SendMessage(nppData._nppHandle, NPPM_GETMENUHANDLE, 0, 0));
@@ -405,6 +467,21 @@ namespace papyrus {
     }
   }
 
+  void Plugin::handleFileSave(npp_buffer_t bufferID) {
+    // Saved file may be newly created, so make sure directory indexes know about it.
+    std::wstring filePath = utility::getFilePathFromBuffer(nppData._nppHandle, bufferID);
+    utility::addFileToDirectoryIndexes(filePath);
+
+    // Lexer uses saved file path to invalidate its caches, so there is no need to ensure saved file is a Papyrus Script buffer.
+    if (lexerData) {
+      FileSaveEventData fileSaveEventData {
+        .bufferID = bufferID,
+        .filePath = filePath
+      };
+      lexerData->fileSaved = fileSaveEventData;
+    }
+  }
+
   void Plugin::handleHotspotClick(SCNotification* notification) {
     // Only handle hotspot click if it's from a document buffer shown on current view and is managed by this plugin's lexer, and key modifier/mouse click match configuration.
     if (lexerData
@@ -447,20 +524,89 @@ namespace papyrus {
       };
       lexerData->changeEventData = changeEventData;
     }
+
+    // Indications painted by each component move along with the text
+    HWND scintillaHandle = static_cast<HWND>(notification->nmhdr.hwndFrom);
+    npp_length_t lengthAdded = (notification->modificationType & SC_MOD_INSERTTEXT) ? notification->length : -notification->length;
+    if (keywordMatcher) {
+      keywordMatcher->contentChanged(scintillaHandle, notification->position, lengthAdded);
+    }
+    if (occurrenceHighlighter) {
+      occurrenceHighlighter->contentChanged(scintillaHandle, notification->position, lengthAdded);
+    }
+    if (blockChecker) {
+      blockChecker->contentChanged(scintillaHandle, notification->position, lengthAdded);
+    }
+    if (errorAnnotator) {
+      errorAnnotator->contentChanged(scintillaHandle, notification->position, lengthAdded);
+    }
+
+    if (blockChecker && settings.keywordMatcherSettings.enableBlockCheck && isCurrentBufferManaged(scintillaHandle)) {
+      blockChecker->check(scintillaHandle, getBufferFromScintillaHandle(scintillaHandle));
+    }
+  }
+
+  void Plugin::handleCharAdded(SCNotification* notification) {
+    // Indentation is adjusted after Notepad++ is done with the notification, so its own auto-indent doesn't override it.
+    HWND scintillaHandle = static_cast<HWND>(notification->nmhdr.hwndFrom);
+    if (autoIndenter && settings.keywordMatcherSettings.enableAutoIndentation && isCurrentBufferManaged(scintillaHandle)) {
+      ::PostMessage(messageWindow, PPM_AUTO_INDENT, reinterpret_cast<WPARAM>(scintillaHandle), notification->ch);
+    }
   }
 
   void Plugin::handleSelectionChange(SCNotification* notification) {
     // Only handle selection change if it's from a document buffer shown on current view and is managed by this plugin's lexer.
+    HWND scintillaHandle = static_cast<HWND>(notification->nmhdr.hwndFrom);
+    if (isCurrentBufferManaged(scintillaHandle) && keywordMatcher) {
+      // Caret events come in bursts, e.g. when holding an arrow key. Only match after caret settles down. Setting the same timer
+      // again just restarts it, so a burst ends up with a single WM_TIMER on UI thread.
+      keywordMatchScintillaHandle = scintillaHandle;
+      ::SetTimer(messageWindow, PPT_MATCH_KEYWORD, KEYWORD_MATCH_DELAY, nullptr);
+    } else {
+      ::KillTimer(messageWindow, PPT_MATCH_KEYWORD);
+      matchKeyword(scintillaHandle);
+    }
+  }
+
+  void Plugin::matchKeyword(HWND scintillaHandle) {
     bool keywordMatched = false;
-    if (isCurrentBufferManaged(static_cast<HWND>(notification->nmhdr.hwndFrom)) && keywordMatcher) {
-      keywordMatched = keywordMatcher->match(static_cast<HWND>(notification->nmhdr.hwndFrom));
+    if (isCurrentBufferManaged(scintillaHandle)) {
+      if (keywordMatcher) {
+        keywordMatched = keywordMatcher->match(scintillaHandle);
+      }
+      if (occurrenceHighlighter) {
+        occurrenceHighlighter->highlight(scintillaHandle, getBufferFromScintillaHandle(scintillaHandle));
+      }
+      showCaretContext(scintillaHandle);
     }
 
     HMENU menu = reinterpret_cast<HMENU>(::SendMessage(nppData._nppHandle, NPPM_GETMENUHANDLE, 0, 0));
     ::EnableMenuItem(menu, funcs[std::to_underlying(Menu::GoToMatch)]._cmdID, MF_BYCOMMAND | (keywordMatched ? MF_ENABLED : MF_DISABLED));
   }
 
+  void Plugin::showCaretContext(HWND scintillaHandle) {
+    if (!blockNavigator || !settings.keywordMatcherSettings.showCaretContext || isCompilingCurrentFile) {
+      return;
+    }
+
+    std::wstring context = blockNavigator->getCaretContext(scintillaHandle, getBufferFromScintillaHandle(scintillaHandle));
+    if (context != caretContext) {
+      caretContext = context;
+      std::wstring status(Lexer::statusText());
+      if (lexerData && lexerData->currentGame != Game::Auto) {
+        status = L"[" + game::gameNames[std::to_underlying(lexerData->currentGame)].second + L"] " + status;
+      }
+      if (!caretContext.empty()) {
+        status += L" | " + caretContext;
+      }
+      ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(status.c_str()));
+    }
+  }
+
   void Plugin::onSettingsUpdated() {
+    // Import/output directories may have changed. Directory indexes will be rebuilt on demand.
+    utility::clearDirectoryIndexes();
+
     if (lexerData) {
       updateLexerDataGameSettings(Game::Skyrim, settings.compilerSettings.skyrim);
       updateLexerDataGameSettings(Game::SkyrimSE, settings.compilerSettings.sse);
@@ -565,12 +711,47 @@ namespace papyrus {
     return std::make_pair(detectedGameType, useAutoModeOutputDirectory);
   }
 
-  void Plugin::clearActiveCompilation() {
-    activeCompilationRequest = {
-      .game = Game::Auto,
-      .bufferID = 0
-    };
-    isCompilingCurrentFile = false;
+  bool Plugin::completeCompilation(const CompilationRequest& request) {
+    std::erase_if(activeCompilationRequests,
+      [&](const auto& activeRequest) {
+        return activeRequest.id == request.id;
+      }
+    );
+
+    npp_buffer_t currentBufferID = static_cast<npp_buffer_t>(::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0));
+    bool isCurrentFile = utility::compare(request.filePath, utility::getFilePathFromBuffer(nppData._nppHandle, currentBufferID));
+    if (isCurrentFile) {
+      isCompilingCurrentFile = false;
+    }
+    return isCurrentFile;
+  }
+
+  bool Plugin::handleBatchResult(const CompilationResult& result, bool succeeded) {
+    if (!batchBuilder || !batchBuilder->owns(result.request)) {
+      return false;
+    }
+
+    const BatchReport& report = batchBuilder->getReport();
+    if (batchBuilder->handleResult(result, succeeded)) {
+      if (errorsWindow) {
+        errorsWindow->clear();
+        if (!report.errors.empty()) {
+          errorsWindow->show(report.errors);
+        } else {
+          errorsWindow->hide();
+        }
+      }
+
+      double seconds = std::chrono::duration<double>(report.elapsedTime).count();
+      double scriptsPerMinute = (seconds > 0) ? (report.succeeded + report.failed) * 60 / seconds : 0;
+      std::wstring msg = std::format(L"Batch build {}: {} succeeded ({} up to date), {} failed, {} skipped in {:.1f} seconds ({:.1f} scripts per minute)",
+        report.cancelled ? L"cancelled" : L"finished", report.succeeded, report.upToDate, report.failed, report.skipped, seconds, scriptsPerMinute);
+      ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
+    } else {
+      std::wstring msg = std::format(L"Batch build: {} of {} scripts done", report.succeeded + report.failed + report.skipped, report.total);
+      ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
+    }
+    return true;
   }
 
   LRESULT CALLBACK Plugin::messageHandleProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -580,75 +761,136 @@ namespace papyrus {
   LRESULT Plugin::handleOwnMessage(HWND window, UINT message, WPARAM wParam, LPARAM lParam) {
     switch (message) {
       case PPM_COMPILATION_DONE: {
+        const CompilationResult& result = *reinterpret_cast<CompilationResult*>(wParam);
+        if (handleBatchResult(result, true)) {
+          return 0;
+        }
+
+        bool isCurrentFile = completeCompilation(result.request);
         if (errorsWindow) {
-          errorsWindow->clear();
-          errorsWindow->hide();
+          // Other compilations may still have their errors listed
+          errorsWindow->remove(result.request.filePath);
         }
 
         std::wstring msg(L"Compilation ");
-        if (wParam == PARAM_COMPILATION_WITH_ANONYMIZATION) {
+        if (result.anonymized) {
           msg += L"and anonymization ";
         }
         msg += L"succeeded";
-        if (!isCompilingCurrentFile) {
-          msg += L": " + activeCompilationRequest.filePath;
+        if (!isCurrentFile) {
+          msg += L": " + result.request.filePath;
         }
         ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
-        clearActiveCompilation();
         return 0;
       }
 
       case PPM_COMPILATION_FAILED: {
-        if (errorsWindow) {
-          errorsWindow->clear();
-          if (wParam) {
-            std::vector<Error>* errors = reinterpret_cast<std::vector<Error>*>(wParam);
+        const CompilationResult& result = *reinterpret_cast<CompilationResult*>(wParam);
+        if (handleBatchResult(result, false)) {
+          return 0;
+        }
 
-            errorsWindow->show(*errors);
+        bool isCurrentFile = completeCompilation(result.request);
+        if (errorsWindow) {
+          if (result.publishedErrors > 0) {
+            // Only errors that were not reported while compiler was running are new
+            std::vector<Error> newErrors(result.errors.begin() + std::min(result.publishedErrors, result.errors.size()), result.errors.end());
+            if (!newErrors.empty()) {
+              errorsWindow->add(newErrors, result.request.filePath);
+              if (errorAnnotator) {
+                errorAnnotator->annotate(newErrors);
+              }
+            }
+          } else {
+            errorsWindow->remove(result.request.filePath);
+            errorsWindow->add(result.errors, result.request.filePath);
 
             if (errorAnnotator) {
-              errorAnnotator->annotate(*errors);
+              errorAnnotator->annotate(result.errors);
             }
           }
         }
 
         std::wstring msg(L"Compilation failed");
-        if (!isCompilingCurrentFile) {
-          msg += L": " + activeCompilationRequest.filePath;
+        if (!isCurrentFile) {
+          msg += L": " + result.request.filePath;
         }
         ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
-        clearActiveCompilation();
 
-        if (lParam) {
+        if (result.hasUnparsableLines) {
           ::MessageBox(nppData._nppHandle, L"There are unparsable compilation errors.", PLUGIN_NAME L" plugin", MB_ICONERROR | MB_OK);
         }
         return 0;
       }
 
+      case PPM_COMPILATION_ERRORS: {
+        // Errors reported while compiler is still running. Batch build shows errors of all scripts together when it's done,
+        // so they are only listed for now.
+        const CompilationResult& result = *reinterpret_cast<CompilationResult*>(wParam);
+        if (errorsWindow) {
+          errorsWindow->add(result.errors, result.request.filePath);
+          if (errorAnnotator && !(batchBuilder && batchBuilder->owns(result.request))) {
+            errorAnnotator->annotate(result.errors);
+          }
+        }
+        return 0;
+      }
+
+      case PPM_COMPILATION_CANCELLED: {
+        const CompilationResult& result = *reinterpret_cast<CompilationResult*>(wParam);
+        if (handleBatchResult(result, false)) {
+          return 0;
+        }
+
+        bool isCurrentFile = completeCompilation(result.request);
+        std::wstring msg(L"Compilation cancelled");
+        if (!isCurrentFile) {
+          msg += L": " + result.request.filePath;
+        }
+        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
+        return 0;
+      }
+
       case PPM_COMPILER_NOT_FOUND: {
-        clearActiveCompilation();
+        CompilationResult result = *reinterpret_cast<CompilationResult*>(wParam);
+        result.message = L"Can't find the compiler executable";
+        if (handleBatchResult(result, false)) {
+          return 0;
+        }
+
+        completeCompilation(result.request);
         ::MessageBox(nppData._nppHandle, L"Can't find the compiler executable", PLUGIN_NAME L" plugin", MB_ICONERROR | MB_OK);
         return 0;
       }
 
       case PPM_ANONYMIZATION_FAILED: {
+        const CompilationResult& result = *reinterpret_cast<CompilationResult*>(wParam);
+        if (handleBatchResult(result, false)) {
+          return 0;
+        }
+
+        bool isCurrentFile = completeCompilation(result.request);
         if (errorsWindow) {
-          errorsWindow->clear();
+          errorsWindow->remove(result.request.filePath);
         }
 
         std::wstring msg(L"Compilation succeeded but anonymization failed: ");
-        msg += *reinterpret_cast<std::wstring*>(wParam);
-        if (!isCompilingCurrentFile) {
-          msg += L" File: " + activeCompilationRequest.filePath;
+        msg += result.message;
+        if (!isCurrentFile) {
+          msg += L" File: " + result.request.filePath;
         }
         ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
-        clearActiveCompilation();
         return 0;
       }
 
       case PPM_OTHER_ERROR: {
-        clearActiveCompilation();
-        ::MessageBox(nppData._nppHandle, reinterpret_cast<wchar_t*>(wParam), reinterpret_cast<wchar_t*>(lParam), MB_ICONERROR | MB_OK);
+        const CompilationResult& result = *reinterpret_cast<CompilationResult*>(wParam);
+        if (handleBatchResult(result, false)) {
+          return 0;
+        }
+
+        completeCompilation(result.request);
+        ::MessageBox(nppData._nppHandle, result.message.c_str(), result.title.c_str(), MB_ICONERROR | MB_OK);
         return 0;
       }
 
@@ -673,6 +915,50 @@ namespace papyrus {
         return 0;
       }
 
+      case WM_TIMER: {
+        // All timers are one-time
+        ::KillTimer(window, wParam);
+        switch (wParam) {
+          case PPT_MATCH_KEYWORD: {
+            matchKeyword(keywordMatchScintillaHandle);
+            break;
+          }
+
+          case PPT_JUMP_TO_ERROR_LINE: {
+            // Make sure the active document is still the one we are tracking before scrolling.
+            if (jumpToErrorLine.bufferID == ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0)) {
+              ::SendMessage(jumpToErrorLine.scintillaHandle, SCI_GOTOLINE, jumpToErrorLine.line, 0);
+            }
+            break;
+          }
+
+          case PPT_CHECK_BLOCKS: {
+            if (blockChecker) {
+              blockChecker->runScheduledCheck();
+            }
+            break;
+          }
+        }
+        return 0;
+      }
+
+      case PPM_AUTO_INDENT: {
+        HWND scintillaHandle = reinterpret_cast<HWND>(wParam);
+        if (autoIndenter && isCurrentBufferManaged(scintillaHandle)) {
+          autoIndenter->handleCharAdded(scintillaHandle, getBufferFromScintillaHandle(scintillaHandle), static_cast<int>(lParam));
+        }
+        return 0;
+      }
+
+      case PPM_BLOCK_CHECK_DONE: {
+        std::unique_ptr<BlockCheckResult> result(reinterpret_cast<BlockCheckResult*>(wParam));
+        // Document may have been switched or closed while checking.
+        if (blockChecker && isCurrentBufferManaged(result->scintillaHandle) && getBufferFromScintillaHandle(result->scintillaHandle) == result->bufferID) {
+          blockChecker->showResult(*result);
+        }
+        return 0;
+      }
+
       default: {
         return DefWindowProc(window, message, wParam, lParam);
       }
@@ -852,7 +1138,13 @@ namespace papyrus {
 
   void Plugin::compile() {
     if (compiler) {
-      if (activeCompilationRequest.bufferID == 0) {
+      npp_buffer_t currentBufferID = static_cast<npp_buffer_t>(::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0));
+      bool isAlreadyCompiling = std::any_of(activeCompilationRequests.begin(), activeCompilationRequests.end(),
+        [&](const auto& request) {
+          return request.bufferID == currentBufferID;
+        }
+      );
+      if (!isAlreadyCompiling) {
         // Get current file path.
         wchar_t filePath[MAX_PATH];
         if (::SendMessage(nppData._nppHandle, NPPM_GETFULLCURRENTPATH, MAX_PATH, reinterpret_cast<LPARAM>(filePath))) {
@@ -867,25 +1159,27 @@ namespace papyrus {
             auto [detectedGame, useAutoModeOutputDirectory] = detectGameType(filePath, settings.compilerSettings);
             if (detectedGame != Game::Auto) {
               if (errorsWindow) {
-                errorsWindow->clear();
-                errorsWindow->hide();
+                errorsWindow->remove(currentFile);
               }
 
               if (errorAnnotator) {
                 errorAnnotator->clear();
               }
 
-              activeCompilationRequest = {
+              CompilationRequest request {
+                .id = ++lastCompilationRequestID,
                 .game = detectedGame,
-                .bufferID = ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0),
+                .bufferID = currentBufferID,
                 .filePath { currentFile },
-                .useAutoModeOutputDirectory = useAutoModeOutputDirectory
+                .useAutoModeOutputDirectory = useAutoModeOutputDirectory,
+                .priority = CompilationPriority::Foreground
               };
+              activeCompilationRequests.push_back(request);
               isCompilingCurrentFile = true;
               ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Compiling..."));
               ::SendMessage(nppData._nppHandle, NPPM_SAVECURRENTFILE, 0, 0);
 
-              compiler->start(activeCompilationRequest);
+              compiler->start(request);
             } else {
               ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Cannot start compilation because no game is configured. Please at least enable one game in Settings dialog!"));
             }
@@ -898,18 +1192,76 @@ namespace papyrus {
           ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(errorMsg.c_str()));
         }
       } else {
-        if (activeCompilationRequest.bufferID == ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0)) {
-          ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Already compiling!"));
+        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Already compiling!"));
+      }
+    } else {
+      ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Waiting for completing Papyrus settings..."));
+    }
+  }
+
+  void Plugin::compileFolderMenuFunc() {
+    papyrusPlugin.compileFolder();
+  }
+
+  void Plugin::compileFolder() {
+    if (compiler && batchBuilder) {
+      if (!batchBuilder->isRunning()) {
+        wchar_t filePath[MAX_PATH];
+        if (::SendMessage(nppData._nppHandle, NPPM_GETFULLCURRENTPATH, MAX_PATH, reinterpret_cast<LPARAM>(filePath))) {
+          // Build all scripts in the folder of current file, including sub-folders.
+          std::wstring directory = std::filesystem::path(filePath).parent_path();
+          if (errorsWindow) {
+            errorsWindow->clear();
+            errorsWindow->hide();
+          }
+          size_t numScripts = batchBuilder->start(directory, static_cast<size_t>(settings.compilerSettings.batchGroupSize), [&](const std::wstring& scriptFilePath, CompilationRequest& request) {
+            auto [detectedGame, useAutoModeOutputDirectory] = detectGameType(scriptFilePath, settings.compilerSettings);
+            if (detectedGame == Game::Auto) {
+              return false;
+            }
+
+            request = {
+              .id = ++lastCompilationRequestID,
+              .game = detectedGame,
+              .filePath { scriptFilePath },
+              .useAutoModeOutputDirectory = useAutoModeOutputDirectory,
+              .priority = CompilationPriority::Background,
+              .skipIfUpToDate = settings.compilerSettings.incrementalBatchBuild
+            };
+            return true;
+          });
+
+          std::wstring msg = (numScripts > 0) ? std::format(L"Batch build started: {} scripts in {}", numScripts, directory) : L"No Papyrus script to compile in " + directory;
+          ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(msg.c_str()));
         } else {
-          std::wstring errorMsg(L"Can't start compilation due to active compilation of " + activeCompilationRequest.filePath);
+          std::wstring errorMsg = std::format(L"Can't start compilation due to file path exceeding {} chars", MAX_PATH);
           ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(errorMsg.c_str()));
         }
+      } else {
+        ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Batch build already running!"));
       }
     } else {
       ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Waiting for completing Papyrus settings..."));
     }
   }
 
+  void Plugin::cancelCompilationMenuFunc() {
+    papyrusPlugin.cancelCompilation();
+  }
+
+  void Plugin::cancelCompilation() {
+    if (compiler && (!activeCompilationRequests.empty() || (batchBuilder && batchBuilder->isRunning()))) {
+      // Batch builder is stopped first, so it doesn't queue scripts unblocked by the compilations being cancelled
+      if (batchBuilder) {
+        batchBuilder->cancel();
+      }
+      ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"Cancelling compilation..."));
+      compiler->cancelAll();
+    } else {
+      ::SendMessage(nppData._nppHandle, NPPM_SETSTATUSBAR, STATUSBAR_DOC_TYPE, reinterpret_cast<LPARAM>(L"No compilation to cancel."));
+    }
+  }
+
   void Plugin::goToMatchMenuFunc() {
     papyrusPlugin.goToMatch();
   }
@@ -920,6 +1272,18 @@ namespace papyrus {
     }
   }
 
+  void Plugin::goToEnclosingBlockMenuFunc() {
+    papyrusPlugin.goToEnclosingBlock();
+  }
+
+  void Plugin::goToEnclosingBlock() {
+    npp_view_t currentView = static_cast<npp_view_t>(::SendMessage(nppData._nppHandle, NPPM_GETCURRENTVIEW, 0, 0));
+    HWND scintillaHandle = (currentView == MAIN_VIEW) ? nppData._scintillaMainHandle : nppData._scintillaSecondHandle;
+    if (blockNavigator && isCurrentBufferManaged(scintillaHandle)) {
+      blockNavigator->goToEnclosingBlock(scintillaHandle, getBufferFromScintillaHandle(scintillaHandle));
+    }
+  }
+
   void Plugin::settingsMenuFunc() {
     papyrusPlugin.showSettings();
   }
@@ -22,12 +22,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Common\Game.hpp"
 #include "Common\NotepadPlusPlus.hpp"
-#include "Common\Timer.hpp"
 #include "CompilationErrorHandling\ErrorAnnotator.hpp"
 #include "CompilationErrorHandling\ErrorsWindow.hpp"
+#include "Compiler\BatchBuilder.hpp"
 #include "Compiler\Compiler.hpp"
 #include "Compiler\CompilerSettings.hpp"
+#include "KeywordMatcher\AutoIndenter.hpp"
+#include "KeywordMatcher\BlockChecker.hpp"
+#include "KeywordMatcher\BlockNavigator.hpp"
 #include "KeywordMatcher\KeywordMatcher.hpp"
+#include "KeywordMatcher\OccurrenceHighlighter.hpp"
 #include "Settings\Settings.hpp"
 #include "Settings\SettingsDialog.hpp"
 #include "UI\AboutDialog.hpp"
@@ -36,6 +40,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "..\external\npp\PluginInterface.h"
 
 #include <memory>
+#include <vector>
 
 // Plugin constants
 //
@@ -61,6 +66,13 @@ namespace papyrus {
       LRESULT handleNppMessage(UINT message, WPARAM wParam, LPARAM lParam);
 
     private:
+      // Error line to go to after a file is opened from errors window
+      struct ErrorLineJump {
+        HWND scintillaHandle;
+        npp_buffer_t bufferID;
+        int line;
+      };
+
       enum class Menu {
         Compile,
         GoToMatch,
@@ -69,6 +81,12 @@ namespace papyrus {
         Advanced,
         Seperator2,
         About,
+        // Items added after the original ones are appended, so shortcuts users assigned to existing items, which are bound by
+        // index, stay on the same items
+        Seperator3,
+        GoToEnclosingBlock,
+        CompileFolder,
+        CancelCompilation,
         COUNT
       };
 
@@ -90,6 +108,9 @@ namespace papyrus {
       // Notepad++ notification NPPN_BUFFERACTIVATED and NPPN_LANGCHANGED handler
       void handleBufferActivation(npp_buffer_t bufferID, bool fromLangChange);
 
+      // Notepad++ notification NPPN_FILESAVED handler
+      void handleFileSave(npp_buffer_t bufferID);
+
       // Scintilla notification SCN_HOTSPOTCLICK handler
       void handleHotspotClick(SCNotification* notification);
 
@@ -99,9 +120,19 @@ namespace papyrus {
       // Scintilla notification SCN_MODIFIED handler, when texts are added/deleted
       void handleContentChange(SCNotification* notification);
 
+      // Scintilla notification SCN_CHARADDED handler
+      void handleCharAdded(SCNotification* notification);
+
       // Scintilla notification SCN_UPDATEUI handler, when selection updated
       void handleSelectionChange(SCNotification* notification);
 
+      // Match keyword and highlight identifier occurrences at caret, and update menu accordingly. Bursts of selection changes
+      // are coalesced into one call.
+      void matchKeyword(HWND scintillaHandle);
+
+      // Show names of the blocks enclosing caret in status bar, if enabled. Status bar is only updated when they change.
+      void showCaretContext(HWND scintillaHandle);
+
       // Handle setting changes
       void onSettingsUpdated();
       void updateLexerDataGameSettings(Game game, const CompilerSettings::GameSettings& gameSettings);
@@ -119,9 +150,13 @@ namespace papyrus {
       // Find out game type based on file path and settings
       std::pair<Game, bool> detectGameType(const std::wstring& filePath, const CompilerSettings& compilerSettings) const;
 
-      // Clear cached active compilation request, so when buffer gets switched
-      // in NPP it can be properly handled
-      void clearActiveCompilation();
+      // Remove a finished request from active compilation requests, so when buffer gets switched in NPP it can be properly
+      // handled. Returns whether the request was for current file.
+      bool completeCompilation(const CompilationRequest& request);
+
+      // Pass the result of a request made by batch build to batch builder, and report progress. Returns false if the request
+      // is not part of batch build.
+      bool handleBatchResult(const CompilationResult& result, bool succeeded);
 
       // Plugin's own message handling
       static LRESULT CALLBACK messageHandleProc(HWND window, UINT message, WPARAM wparam, LPARAM lparam);
@@ -144,8 +179,15 @@ namespace papyrus {
 
       static void compileMenuFunc();
       void compile();
+      static void compileFolderMenuFunc();
+      void compileFolder();
+
+      static void cancelCompilationMenuFunc();
+      void cancelCompilation();
       static void goToMatchMenuFunc();
       void goToMatch();
+      static void goToEnclosingBlockMenuFunc();
+      void goToEnclosingBlock();
       static void settingsMenuFunc();
       void showSettings();
       static void aboutMenuFunc();
@@ -169,14 +211,22 @@ namespace papyrus {
       SettingsDialog settingsDialog {settings, uiParameters};
 
       std::unique_ptr<Compiler> compiler;
-      CompilationRequest activeCompilationRequest;
+      std::unique_ptr<BatchBuilder> batchBuilder;
+      std::vector<CompilationRequest> activeCompilationRequests;
+      size_t lastCompilationRequestID {0};
       bool isCompilingCurrentFile {false};
 
       std::unique_ptr<ErrorsWindow> errorsWindow;
       std::unique_ptr<ErrorAnnotator> errorAnnotator;
       std::unique_ptr<KeywordMatcher> keywordMatcher;
+      std::unique_ptr<BlockChecker> blockChecker;
+      std::unique_ptr<OccurrenceHighlighter> occurrenceHighlighter;
+      std::unique_ptr<BlockNavigator> blockNavigator;
+      std::unique_ptr<AutoIndenter> autoIndenter;
+      std::wstring caretContext;
       std::list<Error> activatedErrorsTrackingList;
-      std::unique_ptr<utility::Timer> jumpToErrorLineTimer;
+      ErrorLineJump jumpToErrorLine {};
+      HWND keywordMatchScintillaHandle {};
 
       npp_lang_type_t scriptLangID {0};
 
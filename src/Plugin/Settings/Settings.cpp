@@ -59,6 +59,8 @@ namespace papyrus {
     storage.putString(L"lexer.enableHover", utility::boolToStr(lexerSettings.enableHover));
     storage.putString(L"lexer.enabledHoverCategories", std::to_wstring(lexerSettings.enabledHoverCategories));
     storage.putString(L"lexer.hoverDelay", std::to_wstring(lexerSettings.hoverDelay));
+    storage.putString(L"lexer.enableStyleCache", utility::boolToStr(lexerSettings.enableStyleCache));
+    storage.putString(L"lexer.styleCacheSizeLimit", std::to_wstring(lexerSettings.styleCacheSizeLimit));
 
     storage.putString(L"keywordMatcher.enableKeywordMatching", utility::boolToStr(keywordMatcherSettings.enableKeywordMatching));
     storage.putString(L"keywordMatcher.enabledKeywords", std::to_wstring(keywordMatcherSettings.enabledKeywords));
@@ -68,6 +70,10 @@ namespace papyrus {
     storage.putString(L"keywordMatcher.matchedIndicatorForegroundColor" + themeSuffix, utility::colorToHexStr(keywordMatcherSettings.matchedIndicatorForegroundColor));
     storage.putString(L"keywordMatcher.unmatchedIndicatorStyle", std::to_wstring(keywordMatcherSettings.unmatchedIndicatorStyle));
     storage.putString(L"keywordMatcher.unmatchedIndicatorForegroundColor" + themeSuffix, utility::colorToHexStr(keywordMatcherSettings.unmatchedIndicatorForegroundColor));
+    storage.putString(L"keywordMatcher.enableBlockCheck", utility::boolToStr(keywordMatcherSettings.enableBlockCheck));
+    storage.putString(L"keywordMatcher.enableOccurrenceHighlighting", utility::boolToStr(keywordMatcherSettings.enableOccurrenceHighlighting));
+    storage.putString(L"keywordMatcher.showCaretContext", utility::boolToStr(keywordMatcherSettings.showCaretContext));
+    storage.putString(L"keywordMatcher.enableAutoIndentation", utility::boolToStr(keywordMatcherSettings.enableAutoIndentation));
 
     storage.putString(L"errorAnnotator.enableAnnotation", utility::boolToStr(errorAnnotatorSettings.enableAnnotation));
     storage.putString(L"errorAnnotator.annotationForegroundColor" + themeSuffix, utility::colorToHexStr(errorAnnotatorSettings.annotationForegroundColor));
@@ -81,6 +87,10 @@ namespace papyrus {
     storage.putString(L"errorAnnotator.indicatorForegroundColor" + themeSuffix, utility::colorToHexStr(errorAnnotatorSettings.indicatorForegroundColor));
 
     storage.putString(L"compiler.common.allowUnmanagedSource", utility::boolToStr(compilerSettings.allowUnmanagedSource));
+    storage.putString(L"compiler.common.maxConcurrentCompilations", std::to_wstring(compilerSettings.maxConcurrentCompilations));
+    storage.putString(L"compiler.common.incrementalBatchBuild", utility::boolToStr(compilerSettings.incrementalBatchBuild));
+    storage.putString(L"compiler.common.compilationTimeout", std::to_wstring(compilerSettings.compilationTimeout));
+    storage.putString(L"compiler.common.batchGroupSize", std::to_wstring(compilerSettings.batchGroupSize));
     storage.putString(L"compiler.common.gameMode", game::gameNames[std::to_underlying(compilerSettings.gameMode)].first);
     storage.putString(L"compiler.auto.defaultGame", game::gameNames[std::to_underlying(compilerSettings.autoModeDefaultGame)].first);
     storage.putString(L"compiler.auto.outputDirectory", compilerSettings.autoModeOutputDirectory);
@@ -173,6 +183,24 @@ namespace papyrus {
       updated = true;
     }
 
+    if (storage.getString(L"lexer.enableStyleCache", value)) {
+      lexerSettings.enableStyleCache = utility::strToBool(value);
+    } else {
+      lexerSettings.enableStyleCache = false;
+      updated = true;
+    }
+
+    if (storage.getString(L"lexer.styleCacheSizeLimit", value)) {
+      lexerSettings.styleCacheSizeLimit = std::stoi(value);
+      if (lexerSettings.styleCacheSizeLimit <= 0) {
+        lexerSettings.styleCacheSizeLimit = DEFAULT_STYLE_CACHE_SIZE_LIMIT;
+        updated = true;
+      }
+    } else {
+      lexerSettings.styleCacheSizeLimit = DEFAULT_STYLE_CACHE_SIZE_LIMIT;
+      updated = true;
+    }
+
     // Keyword matcher settings
     //
     if (storage.getString(L"keywordMatcher.enableKeywordMatching", value)) {
@@ -233,6 +261,34 @@ namespace papyrus {
       updated = true;
     }
 
+    if (storage.getString(L"keywordMatcher.enableBlockCheck", value)) {
+      keywordMatcherSettings.enableBlockCheck = utility::strToBool(value);
+    } else {
+      keywordMatcherSettings.enableBlockCheck = false;
+      updated = true;
+    }
+
+    if (storage.getString(L"keywordMatcher.enableOccurrenceHighlighting", value)) {
+      keywordMatcherSettings.enableOccurrenceHighlighting = utility::strToBool(value);
+    } else {
+      keywordMatcherSettings.enableOccurrenceHighlighting = false;
+      updated = true;
+    }
+
+    if (storage.getString(L"keywordMatcher.showCaretContext", value)) {
+      keywordMatcherSettings.showCaretContext = utility::strToBool(value);
+    } else {
+      keywordMatcherSettings.showCaretContext = false;
+      updated = true;
+    }
+
+    if (storage.getString(L"keywordMatcher.enableAutoIndentation", value)) {
+      keywordMatcherSettings.enableAutoIndentation = utility::strToBool(value);
+    } else {
+      keywordMatcherSettings.enableAutoIndentation = false;
+      updated = true;
+    }
+
     // Error annotator settings
     //
     if (storage.getString(L"errorAnnotator.enableAnnotation", value)) {
@@ -319,6 +375,46 @@ namespace papyrus {
       updated = true;
     }
 
+    if (storage.getString(L"compiler.common.maxConcurrentCompilations", value)) {
+      compilerSettings.maxConcurrentCompilations = std::stoi(value);
+      if (compilerSettings.maxConcurrentCompilations < 0) {
+        compilerSettings.maxConcurrentCompilations = DEFAULT_MAX_CONCURRENT_COMPILATIONS;
+        updated = true;
+      }
+    } else {
+      compilerSettings.maxConcurrentCompilations = DEFAULT_MAX_CONCURRENT_COMPILATIONS;
+      updated = true;
+    }
+
+    if (storage.getString(L"compiler.common.incrementalBatchBuild", value)) {
+      compilerSettings.incrementalBatchBuild = utility::strToBool(value);
+    } else {
+      compilerSettings.incrementalBatchBuild = true;
+      updated = true;
+    }
+
+    if (storage.getString(L"compiler.common.compilationTimeout", value)) {
+      compilerSettings.compilationTimeout = std::stoi(value);
+      if (compilerSettings.compilationTimeout < 0) {
+        compilerSettings.compilationTimeout = DEFAULT_COMPILATION_TIMEOUT;
+        updated = true;
+      }
+    } else {
+      compilerSettings.compilationTimeout = DEFAULT_COMPILATION_TIMEOUT;
+      updated = true;
+    }
+
+    if (storage.getString(L"compiler.common.batchGroupSize", value)) {
+      compilerSettings.batchGroupSize = std::stoi(value);
+      if (compilerSettings.batchGroupSize < 1) {
+        compilerSettings.batchGroupSize = DEFAULT_BATCH_GROUP_SIZE;
+        updated = true;
+      }
+    } else {
+      compilerSettings.batchGroupSize = DEFAULT_BATCH_GROUP_SIZE;
+      updated = true;
+    }
+
     if (storage.getString(L"compiler.common.gameMode", value)) {
       auto iter = game::gameAliases.find(value);
       if (iter != game::gameAliases.end()) {
@@ -0,0 +1,58 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+// Minimal helpers for benchmarks. Benchmarks are standalone executables that print their measurements. When run with
+// "--quick", e.g. from ctest, they only run a small workload to check they still work.
+namespace benchmark {
+
+  inline bool isQuickRun(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--quick") == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Run a function the given number of times, and return the best time in milliseconds
+  template <class F>
+  double measure(int repeats, F&& func) {
+    double bestTime = std::numeric_limits<double>::max();
+    for (int i = 0; i < repeats; ++i) {
+      auto startTime = std::chrono::steady_clock::now();
+      func();
+      bestTime = std::min(bestTime, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+    }
+    return bestTime;
+  }
+
+  inline void report(const char* name, double value, const char* unit) {
+    std::printf("%-48s %12.3f %s\n", name, value, unit);
+  }
+
+} // namespace
@@ -0,0 +1,152 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Common\DirectoryIndex.hpp"
+
+#include <thread>
+#include <vector>
+
+using utility::DirectoryIndex;
+
+TEST_CASE(findsRealSpellingInAnyCase) {
+  test::TemporaryDirectory root;
+  auto filePath = root.createFile(L"MyScript.psc");
+
+  DirectoryIndex index(root.path().wstring());
+  CHECK(index.find(L"MyScript.psc") == filePath.wstring());
+  CHECK(index.find(L"myscript.PSC") == filePath.wstring());
+  CHECK(index.find(L"MYSCRIPT.psc") == filePath.wstring());
+}
+
+TEST_CASE(findsNamespacedClassesInSubDirectories) {
+  test::TemporaryDirectory root;
+  auto filePath = root.createFile(std::filesystem::path(L"MyMod") / L"Quests" / L"QuestScript.psc");
+
+  DirectoryIndex index(root.path().wstring());
+  CHECK(index.find(L"mymod/quests/questscript.psc") == filePath.wstring());
+  CHECK(index.find(L"MYMOD\\QUESTS\\QuestScript.psc") == filePath.wstring());
+  CHECK(index.find(L"MyMod/Quests") == (root.path() / L"MyMod" / L"Quests").wstring());
+}
+
+TEST_CASE(returnsEmptyPathOnMiss) {
+  test::TemporaryDirectory root;
+  root.createFile(std::filesystem::path(L"MyMod") / L"QuestScript.psc");
+
+  DirectoryIndex index(root.path().wstring());
+  CHECK(index.find(L"Missing.psc").empty());
+  CHECK(index.find(L"MyMod/Missing.psc").empty());
+  CHECK(index.find(L"Missing/QuestScript.psc").empty());
+  CHECK(index.find(L"QuestScript.psc/MyMod").empty());
+  CHECK(index.find(L"").empty());
+}
+
+TEST_CASE(picksUpFilesCreatedOutsideOfEditor) {
+  test::TemporaryDirectory root;
+  root.createFile(std::filesystem::path(L"MyMod") / L"First.psc");
+
+  DirectoryIndex index(root.path().wstring());
+  REQUIRE(!index.find(L"MyMod/First.psc").empty());
+  CHECK(index.find(L"MyMod/Second.psc").empty());
+  CHECK(index.find(L"Other/Third.psc").empty());
+
+  // Created without notifying the index. Listed levels are re-listed on a miss.
+  auto secondFilePath = root.createFile(std::filesystem::path(L"MyMod") / L"Second.psc");
+  auto thirdFilePath = root.createFile(std::filesystem::path(L"Other") / L"Third.psc");
+  CHECK(index.find(L"mymod/second.psc") == secondFilePath.wstring());
+  CHECK(index.find(L"other/third.psc") == thirdFilePath.wstring());
+}
+
+TEST_CASE(picksUpModifiedLevelsAfterTheyHaveSettled) {
+  test::TemporaryDirectory root;
+  auto subDirectory = root.path() / L"MyMod";
+  root.createFile(subDirectory / L"First.psc");
+
+  // Make the level look old, so that a miss relies on its modification time rather than always re-listing it.
+  auto oldTime = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+  std::filesystem::last_write_time(subDirectory, oldTime);
+
+  DirectoryIndex index(root.path().wstring());
+  CHECK(index.find(L"MyMod/Second.psc").empty());
+
+  auto secondFilePath = root.createFile(subDirectory / L"Second.psc");
+  std::filesystem::last_write_time(subDirectory, oldTime + std::chrono::minutes(1));
+  CHECK(index.find(L"MyMod/Second.psc") == secondFilePath.wstring());
+}
+
+TEST_CASE(addsFilesUnderRootOnly) {
+  test::TemporaryDirectory root;
+  test::TemporaryDirectory otherRoot;
+  root.createFile(std::filesystem::path(L"MyMod") / L"First.psc");
+
+  DirectoryIndex index(root.path().wstring());
+  REQUIRE(!index.find(L"MyMod/First.psc").empty());
+
+  // Added file doesn't exist on disk, which shows listed levels are updated without listing them again.
+  auto addedFilePath = root.path() / L"MyMod" / L"Added.psc";
+  CHECK(index.add(addedFilePath.wstring()));
+  CHECK(index.find(L"mymod/added.psc") == addedFilePath.wstring());
+  CHECK(!index.add((otherRoot.path() / L"Other.psc").wstring()));
+  CHECK(!index.add(root.path().wstring()));
+}
+
+TEST_CASE(sharesIndexesAcrossCallers) {
+  test::TemporaryDirectory root;
+  auto filePath = root.createFile(L"Shared.psc");
+
+  auto index = utility::getDirectoryIndex(root.path().wstring());
+  CHECK(utility::getDirectoryIndex(utility::DirectoryIndex::foldPath(root.path().wstring()) + L"/") == index);
+  CHECK(utility::findFileIgnoringCase(root.path().wstring(), L"SHARED.PSC") == filePath.wstring());
+  CHECK(utility::findFileIgnoringCase(std::wstring(), L"Shared.psc").empty());
+
+  utility::clearDirectoryIndexes();
+  CHECK(utility::getDirectoryIndex(root.path().wstring()) != index);
+}
+
+TEST_CASE(supportsConcurrentLookups) {
+  test::TemporaryDirectory root;
+  std::vector<std::wstring> filePaths;
+  for (int i = 0; i < 20; ++i) {
+    filePaths.push_back(root.createFile(std::filesystem::path(L"Dir" + std::to_wstring(i % 4)) / (L"Script" + std::to_wstring(i) + L".psc")).wstring());
+  }
+
+  DirectoryIndex index(root.path().wstring());
+  std::vector<int> mismatches(8);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < mismatches.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 20; ++i) {
+          if (index.find(L"DIR" + std::to_wstring(i % 4) + L"/SCRIPT" + std::to_wstring(i) + L".PSC") != filePaths[i]) {
+            mismatches[t]++;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto mismatchCount : mismatches) {
+    CHECK(mismatchCount == 0);
+  }
+}
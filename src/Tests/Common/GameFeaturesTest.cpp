@@ -0,0 +1,136 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Common\GameFeatures.hpp"
+
+#include "..\..\external\lexilla\WordList.h"
+
+#include <string>
+#include <string_view>
+
+using namespace papyrus;
+using Game = game::Game;
+
+namespace {
+  // Word lists of Papyrus script lexer in Papyrus.xml
+  constexpr char OPERATORS[] = "( ) [ ] , = + - * / % . ! > < | & as is";
+  constexpr char TYPES[] = "bool float int string var";
+  constexpr char KEYWORDS[] = "scriptname extends import debugonly betaonly default event endevent state endstate function endfunction global "
+    "native struct endstruct property endproperty auto autoreadonly conditional hidden const mandatory group endgroup collapsed "
+    "collapsedonref collapsedonbase new return length";
+  constexpr char FOLD_OPEN[] = "if while function struct property group event state";
+  constexpr char FOLD_CLOSE[] = "endif endwhile endfunction native endstruct endproperty auto autoreadonly endgroup endevent endstate";
+
+  // Word list in use by lexer for a game
+  template <Game gameType>
+  class GameWordList {
+    public:
+      explicit GameWordList(std::string_view words) {
+        wordList.Set(game::filterWordList<gameType>(words).c_str());
+      }
+
+      inline bool contains(const char* word) const { return wordList.InList(word); }
+
+    private:
+      Lexilla::WordList wordList;
+  };
+
+  // Length of the identifier at the start of text, as lexer tokenizes it
+  template <Game gameType>
+  size_t identifierLength(std::string_view text) {
+    size_t length = 0;
+    while (length < text.size() && game::isIdentifierCharacter<gameType>(static_cast<unsigned char>(text[length]))) {
+      length++;
+    }
+    return length;
+  }
+}
+
+TEST_CASE(skyrimLacksFallout4Features) {
+  for (const auto& features : {game::gameFeatures<Game::Skyrim>, game::gameFeatures<Game::SkyrimSE>}) {
+    CHECK(!features.structs);
+    CHECK(!features.groups);
+    CHECK(!features.constants);
+    CHECK(!features.varType);
+    CHECK(!features.namespaces);
+    CHECK(!features.isOperator);
+    CHECK(!features.debugFlags);
+  }
+  CHECK(!game::hasAllFeatures<Game::Skyrim>);
+  CHECK(!game::hasAllFeatures<Game::SkyrimSE>);
+
+  // Auto mode doesn't know which game a script is for, so it allows everything
+  CHECK(game::hasAllFeatures<Game::Fallout4>);
+  CHECK(game::hasAllFeatures<Game::Auto>);
+}
+
+TEST_CASE(mapsFeatureWordsToFeatures) {
+  CHECK(!game::isWordSupported<Game::Skyrim>("struct"));
+  CHECK(!game::isWordSupported<Game::Skyrim>("endgroup"));
+  CHECK(!game::isWordSupported<Game::Skyrim>("mandatory"));
+  CHECK(!game::isWordSupported<Game::Skyrim>("var"));
+  CHECK(!game::isWordSupported<Game::Skyrim>("is"));
+  CHECK(!game::isWordSupported<Game::SkyrimSE>("betaonly"));
+  CHECK(game::isWordSupported<Game::Skyrim>("function"));
+  CHECK(game::isWordSupported<Game::Skyrim>("int"));
+  for (const auto& [word, feature] : game::featureWords) {
+    CHECK(game::isWordSupported<Game::Fallout4>(word));
+    CHECK(!game::isWordSupported<Game::Skyrim>(word));
+  }
+}
+
+TEST_CASE(leavesFallout4WordsOutOfSkyrimWordLists) {
+  CHECK(game::filterWordList<Game::Skyrim>("bool  float\tint\r\nstring var") == "bool float int string");
+  CHECK(game::filterWordList<Game::Fallout4>(TYPES) == TYPES);
+
+  GameWordList<Game::Skyrim> skyrimKeywords(KEYWORDS);
+  GameWordList<Game::Fallout4> fallout4Keywords(KEYWORDS);
+  for (const char* word : {"struct", "endstruct", "group", "endgroup", "const", "mandatory", "debugonly", "collapsedonref"}) {
+    CHECK(!skyrimKeywords.contains(word));
+    CHECK(fallout4Keywords.contains(word));
+  }
+  for (const char* word : {"scriptname", "function", "endfunction", "property", "auto", "length"}) {
+    CHECK(skyrimKeywords.contains(word));
+  }
+
+  CHECK(!GameWordList<Game::Skyrim>(TYPES).contains("var"));
+  CHECK(GameWordList<Game::Skyrim>(TYPES).contains("int"));
+  CHECK(GameWordList<Game::SkyrimSE>(TYPES).contains("string"));
+  CHECK(GameWordList<Game::Fallout4>(TYPES).contains("var"));
+  CHECK(GameWordList<Game::Auto>(TYPES).contains("var"));
+  CHECK(!GameWordList<Game::Skyrim>(OPERATORS).contains("is"));
+  CHECK(GameWordList<Game::Skyrim>(OPERATORS).contains("as"));
+  CHECK(GameWordList<Game::Fallout4>(OPERATORS).contains("is"));
+  CHECK(!GameWordList<Game::Skyrim>(FOLD_OPEN).contains("struct"));
+  CHECK(GameWordList<Game::Skyrim>(FOLD_OPEN).contains("function"));
+  CHECK(GameWordList<Game::Fallout4>(FOLD_OPEN).contains("struct"));
+  CHECK(!GameWordList<Game::Skyrim>(FOLD_CLOSE).contains("endgroup"));
+  CHECK(GameWordList<Game::Fallout4>(FOLD_CLOSE).contains("endgroup"));
+}
+
+TEST_CASE(splitsNamespacesOnlyInFallout4) {
+  // Skyrim script names have no namespaces, so ":" ends the identifier
+  CHECK(identifierLength<Game::Skyrim>("MyMod:MyScript extends Quest") == 5);
+  CHECK(identifierLength<Game::SkyrimSE>("MyMod:MyScript") == 5);
+  CHECK(identifierLength<Game::Fallout4>("MyMod:MyScript extends Quest") == 14);
+  CHECK(identifierLength<Game::Auto>("MyMod:MyScript") == 14);
+  CHECK(identifierLength<Game::Skyrim>("my_var1 = 2") == 7);
+}
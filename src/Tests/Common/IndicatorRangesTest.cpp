@@ -0,0 +1,154 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+#include "..\Support\TestScintilla.hpp"
+
+#include "..\..\Plugin\Common\IndicatorRanges.hpp"
+
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <string>
+
+using namespace utility;
+
+namespace {
+  constexpr int INDICATOR_ID = 9;
+
+  // Paint a range the way another component or plugin sharing the indicator would
+  void fillForeign(test::TestScintilla& scintilla, npp_position_t start, npp_length_t length) {
+    ::SendMessage(scintilla.handle(), SCI_SETINDICATORCURRENT, INDICATOR_ID, 0);
+    ::SendMessage(scintilla.handle(), SCI_INDICATORFILLRANGE, start, length);
+  }
+
+  bool isFilled(const test::TestScintilla& scintilla, npp_position_t start, npp_position_t end) {
+    for (npp_position_t pos = start; pos < end; ++pos) {
+      if (scintilla.indicatorValueAt(INDICATOR_ID, pos) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool isClear(const test::TestScintilla& scintilla, npp_position_t start, npp_position_t end) {
+    for (npp_position_t pos = start; pos < end; ++pos) {
+      if (scintilla.indicatorValueAt(INDICATOR_ID, pos) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+TEST_CASE(clearsOnlyRecordedRanges) {
+  test::TestDocument document(std::string(1000, 'x'));
+  test::TestScintilla scintilla(document);
+
+  // Many runs painted by others before this component's, which must neither be cleared nor keep its own from being cleared
+  for (npp_position_t pos = 0; pos < 500; pos += 10) {
+    fillForeign(scintilla, pos, 5);
+  }
+
+  IndicatorRanges indicatorRanges;
+  indicatorRanges.add(700, 5);
+  indicatorRanges.add(600, 10);
+  indicatorRanges.add(605, 10);
+  indicatorRanges.paint(scintilla.handle(), INDICATOR_ID);
+  CHECK(isFilled(scintilla, 600, 615));
+  CHECK(isFilled(scintilla, 700, 705));
+
+  indicatorRanges.clear(scintilla.handle());
+  CHECK(isClear(scintilla, 600, 1000));
+  for (npp_position_t pos = 0; pos < 500; pos += 10) {
+    CHECK(isFilled(scintilla, pos, pos + 5) && isClear(scintilla, pos + 5, pos + 10));
+  }
+
+  // Nothing is recorded anymore
+  fillForeign(scintilla, 600, 15);
+  indicatorRanges.clear(scintilla.handle());
+  CHECK(isFilled(scintilla, 600, 615));
+}
+
+TEST_CASE(movesRangesWithInsertedText) {
+  test::TestDocument document(std::string(200, 'x'));
+  test::TestScintilla scintilla(document);
+  IndicatorRanges indicatorRanges;
+  indicatorRanges.add(20, 10);
+  indicatorRanges.add(50, 10);
+  indicatorRanges.add(80, 10);
+  indicatorRanges.paint(scintilla.handle(), INDICATOR_ID);
+
+  // Before the first range, in the middle of the second range, and at both ends of the third range
+  indicatorRanges.contentChanged(scintilla.handle(), 0, 5);
+  indicatorRanges.contentChanged(scintilla.handle(), 60, 5);
+  indicatorRanges.contentChanged(scintilla.handle(), 90, 5);
+  indicatorRanges.contentChanged(scintilla.handle(), 105, 5);
+
+  // Stand-in doesn't move indications, so fill everything and see what is cleared
+  fillForeign(scintilla, 0, 200);
+  indicatorRanges.clear(scintilla.handle());
+  CHECK(isFilled(scintilla, 0, 25) && isClear(scintilla, 25, 35) && isFilled(scintilla, 35, 55));
+  CHECK(isClear(scintilla, 55, 70) && isFilled(scintilla, 70, 95));
+  CHECK(isClear(scintilla, 95, 105) && isFilled(scintilla, 105, 200));
+}
+
+TEST_CASE(movesRangesWithDeletedText) {
+  test::TestDocument document(std::string(200, 'x'));
+  test::TestScintilla scintilla(document);
+  IndicatorRanges indicatorRanges;
+  indicatorRanges.add(20, 10);
+  indicatorRanges.add(50, 10);
+  indicatorRanges.add(80, 10);
+  indicatorRanges.add(120, 10);
+  indicatorRanges.paint(scintilla.handle(), INDICATOR_ID);
+
+  // Before the first range, all of the second range, the end of the third range and the start of the fourth range
+  indicatorRanges.contentChanged(scintilla.handle(), 0, -5);        // 15-25, 45-55, 75-85, 115-125
+  indicatorRanges.contentChanged(scintilla.handle(), 40, -20);      // 15-25, 55-65, 95-105
+  indicatorRanges.contentChanged(scintilla.handle(), 60, -10);      // 15-25, 55-60, 85-95
+  indicatorRanges.contentChanged(scintilla.handle(), 80, -10);      // 15-25, 55-60, 80-85
+
+  fillForeign(scintilla, 0, 200);
+  indicatorRanges.clear(scintilla.handle());
+  CHECK(isFilled(scintilla, 0, 15) && isClear(scintilla, 15, 25) && isFilled(scintilla, 25, 55));
+  CHECK(isClear(scintilla, 55, 60) && isFilled(scintilla, 60, 80));
+  CHECK(isClear(scintilla, 80, 85) && isFilled(scintilla, 85, 200));
+}
+
+TEST_CASE(keepsRangesOfEachDocument) {
+  test::TestDocument document1(std::string(100, 'x'));
+  test::TestDocument document2(std::string(100, 'y'));
+  test::TestScintilla scintilla1(document1);
+  test::TestScintilla scintilla2(document2);
+  IndicatorRanges indicatorRanges;
+  indicatorRanges.add(10, 10);
+  indicatorRanges.paint(scintilla1.handle(), INDICATOR_ID);
+  indicatorRanges.add(30, 10);
+  indicatorRanges.paint(scintilla2.handle(), INDICATOR_ID);
+
+  // Edits on one document don't move ranges on the other
+  indicatorRanges.contentChanged(scintilla2.handle(), 0, 10);
+  fillForeign(scintilla2, 30, 20);
+  indicatorRanges.clear(scintilla1.handle());
+  CHECK(isClear(scintilla1, 0, 100));
+  CHECK(isFilled(scintilla2, 30, 50));
+
+  indicatorRanges.clear(scintilla2.handle());
+  CHECK(isFilled(scintilla2, 30, 40) && isClear(scintilla2, 40, 50));
+}
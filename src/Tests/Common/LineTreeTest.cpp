@@ -0,0 +1,146 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Common\LineTree.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace utility;
+
+namespace {
+  // Number of items, so searches can be checked against counting by hand
+  struct CountSummary {
+    int count {0};
+
+    static CountSummary of(int) { return CountSummary {.count = 1}; }
+    static CountSummary combine(const CountSummary& summary1, const CountSummary& summary2) { return CountSummary {.count = summary1.count + summary2.count}; }
+  };
+
+  // Finds the n-th item from where the search starts
+  struct NthSearcher {
+    int n;
+
+    bool contains(const CountSummary& summary) const { return summary.count >= n; }
+    void skip(const CountSummary& summary) { n -= summary.count; }
+  };
+
+  using Tree = LineTree<int, CountSummary>;
+  using Reference = std::vector<std::pair<std::ptrdiff_t, int>>;
+
+  Reference contentOf(const Tree& tree) {
+    Reference content;
+    tree.forEach([&](std::ptrdiff_t line, int item) {
+      content.emplace_back(line, item);
+    });
+    return content;
+  }
+}
+
+TEST_CASE(keepsItemsOnSameLineInInsertionOrder) {
+  Tree tree;
+  tree.insert(5, 1);
+  tree.insert(2, 2);
+  tree.insert(5, 3);
+  tree.insert(0, 4);
+  tree.insert(5, 5);
+  CHECK(contentOf(tree) == Reference({{0, 4}, {2, 2}, {5, 1}, {5, 3}, {5, 5}}));
+  CHECK(tree.size() == 5);
+  CHECK(tree.lineOf(tree.last()) == 5);
+  CHECK(tree.lowerBound(3)->item() == 1);
+  CHECK(tree.lowerBound(6) == nullptr);
+}
+
+TEST_CASE(shiftsLinesAfterEdit) {
+  Tree tree;
+  auto node1 = tree.insert(1, 1);
+  auto node2 = tree.insert(4, 2);
+  auto node3 = tree.insert(6, 3);
+
+  tree.shiftLines(2, 10);
+  CHECK(tree.lineOf(node1) == 1);
+  CHECK(tree.lineOf(node2) == 14);
+  CHECK(tree.lineOf(node3) == 16);
+
+  // Deleting lines 3 to 14 erases item on line 14
+  tree.shiftLines(2, -12);
+  CHECK(contentOf(tree) == Reference({{1, 1}, {4, 3}}));
+  CHECK(tree.lineOf(node3) == 4);
+}
+
+TEST_CASE(findsBySummaryInBothDirections) {
+  Tree tree;
+  std::vector<Tree::Node*> nodes;
+  for (int index = 0; index < 100; ++index) {
+    nodes.push_back(tree.insert(index, index));
+  }
+
+  NthSearcher forward {.n = 10};
+  CHECK(tree.findNext(nodes[20], forward) == nodes[30]);
+  NthSearcher backward {.n = 10};
+  CHECK(tree.findPrevious(nodes[20], backward) == nodes[10]);
+  NthSearcher fromStart {.n = 1};
+  CHECK(tree.findNext(nullptr, fromStart) == nodes[0]);
+  NthSearcher pastEnd {.n = 80};
+  CHECK(tree.findNext(nodes[20], pastEnd) == nullptr);
+}
+
+TEST_CASE(matchesReferenceAfterRandomEdits) {
+  Tree tree;
+  Reference reference;
+  std::mt19937 random(42);
+  for (int step = 0; step < 5000; ++step) {
+    std::ptrdiff_t line = random() % 200;
+    switch (random() % 4) {
+      case 0:
+      case 1: {
+        int item = step;
+        tree.insert(line, item);
+        auto iter = std::find_if(reference.begin(), reference.end(), [&](const auto& entry) { return entry.first > line; });
+        reference.insert(iter, {line, item});
+        break;
+      }
+
+      case 2:
+        tree.eraseLines(line, line + 2);
+        std::erase_if(reference, [&](const auto& entry) { return entry.first >= line && entry.first <= line + 2; });
+        break;
+
+      case 3: {
+        std::ptrdiff_t linesAdded = static_cast<std::ptrdiff_t>(random() % 11) - 5;
+        tree.shiftLines(line, linesAdded);
+        if (linesAdded < 0) {
+          std::erase_if(reference, [&](const auto& entry) { return entry.first > line && entry.first <= line - linesAdded; });
+        }
+        for (auto& entry : reference) {
+          if (entry.first > line) {
+            entry.first += linesAdded;
+          }
+        }
+        break;
+      }
+    }
+    REQUIRE(contentOf(tree) == reference);
+  }
+  CHECK(tree.size() == reference.size());
+}
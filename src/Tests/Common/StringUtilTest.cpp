@@ -0,0 +1,49 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Common\StringUtil.hpp"
+
+#include <string>
+#include <vector>
+
+TEST_CASE(splitsIntoAllComponents) {
+  CHECK((utility::split(std::string("MyMod:Quests:QuestScript"), ":") == std::vector<std::string> {"MyMod", "Quests", "QuestScript"}));
+  CHECK((utility::split(std::wstring(L"C:\\Base;C:\\Mod1;C:\\Mod2;C:\\Mod3"), L";") == std::vector<std::wstring> {L"C:\\Base", L"C:\\Mod1", L"C:\\Mod2", L"C:\\Mod3"}));
+  CHECK((utility::split(std::string("Script"), ":") == std::vector<std::string> {"Script"}));
+}
+
+TEST_CASE(splitsWithEmptyComponents) {
+  CHECK((utility::split(std::string("a::b:"), ":") == std::vector<std::string> {"a", "", "b", ""}));
+  CHECK((utility::split(std::wstring(L";a"), L";") == std::vector<std::wstring> {L"", L"a"}));
+  CHECK((utility::split(std::string(), ":") == std::vector<std::string> {""}));
+}
+
+TEST_CASE(splitsWithMultiCharacterDelimiterIgnoringCase) {
+  CHECK((utility::split(std::string("oneANDtwoandthree"), "and") == std::vector<std::string> {"one", "two", "three"}));
+  CHECK((utility::split(std::string("oneANDtwoandthree"), "and", false) == std::vector<std::string> {"oneANDtwo", "three"}));
+}
+
+TEST_CASE(comparesIgnoringCase) {
+  CHECK(utility::compare(std::wstring(L"Script.PSC"), std::wstring(L"script.psc")));
+  CHECK(!utility::compare(std::wstring(L"Script.PSC"), std::wstring(L"script.psc"), false));
+  CHECK(utility::toLower(std::wstring(L"MyMod\\QuestScript")) == L"mymod\\questscript");
+}
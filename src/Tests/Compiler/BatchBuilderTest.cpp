@@ -0,0 +1,156 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+#include "..\Support\TestCompiler.hpp"
+
+#include "..\..\Plugin\Compiler\BatchBuilder.hpp"
+
+#include <algorithm>
+#include <format>
+#include <string>
+#include <vector>
+
+using namespace papyrus;
+
+namespace {
+  // Batch of scripts under a temporary directory, built with a stand-in compiler
+  class TestBatch {
+    public:
+      TestBatch()
+        : compiler(nullptr, settings), batchBuilder(compiler) {
+        test::takeStartedRequests();
+      }
+
+      void addScript(const std::string& relativePath, const std::string& content) {
+        directory.createFile(relativePath, content);
+      }
+
+      size_t start(Game game, size_t groupSize) {
+        return batchBuilder.start(directory.path().wstring(), groupSize, [&](const std::wstring& filePath, CompilationRequest& request) {
+          request = {
+            .id = ++lastRequestID,
+            .game = game,
+            .filePath = filePath,
+            .priority = CompilationPriority::Background
+          };
+          return true;
+        });
+      }
+
+      // Hand result of a script back to batch builder, the way plugin does when compiler sends it
+      bool complete(const CompilationRequest& request, bool succeeded) {
+        CompilationResult result {
+          .request = request
+        };
+        if (!succeeded) {
+          result.errors.push_back(Error {
+            .file = request.filePath,
+            .message = L"Failed."
+          });
+        }
+        return batchBuilder.handleResult(result, succeeded);
+      }
+
+      inline const BatchReport& report() const { return batchBuilder.getReport(); }
+
+    private:
+      test::TemporaryDirectory directory;
+      CompilerSettings settings;
+      Compiler compiler;
+      BatchBuilder batchBuilder;
+      size_t lastRequestID {0};
+  };
+
+  std::vector<std::string> scriptNames(const std::vector<CompilationRequest>& requests) {
+    std::vector<std::string> names;
+    for (const auto& request : requests) {
+      names.push_back(std::filesystem::path(request.filePath).stem().string());
+    }
+    return names;
+  }
+}
+
+TEST_CASE(queuesScriptsOfAGroupAfterTheirBases) {
+  // Each script extends the next one, so any order other than the reverse of their names is a mistake
+  TestBatch batch;
+  constexpr int SCRIPT_COUNT = 8;
+  for (int i = 0; i < SCRIPT_COUNT; ++i) {
+    std::string content = std::format("ScriptName Script{}", i);
+    if (i + 1 < SCRIPT_COUNT) {
+      content += std::format(" extends Script{}", i + 1);
+    }
+    batch.addScript(std::format("Scripts/Script{}.psc", i), content + "\n");
+  }
+  batch.addScript("Scripts/Other.psc", "ScriptName Other\nImport Script3\n");
+
+  REQUIRE(batch.start(Game::Skyrim, 16) == SCRIPT_COUNT + 1);
+  auto started = test::takeStartedRequests();
+  REQUIRE(started.size() == 1 && started[0].size() == SCRIPT_COUNT + 1);
+  auto names = scriptNames(started[0]);
+  auto position = [&](const std::string& name) { return std::find(names.begin(), names.end(), name) - names.begin(); };
+  for (int i = 0; i + 1 < SCRIPT_COUNT; ++i) {
+    CHECK(position(std::format("Script{}", i + 1)) < position(std::format("Script{}", i)));
+  }
+  CHECK(position("Script3") < position("Other"));
+}
+
+TEST_CASE(queuesScriptsInACycleTogether) {
+  TestBatch batch;
+  batch.addScript("Scripts/First.psc", "ScriptName First\nImport Second\n");
+  batch.addScript("Scripts/Second.psc", "ScriptName Second\nImport First\n");
+  batch.addScript("Scripts/Base.psc", "ScriptName Base\n");
+  batch.addScript("Scripts/Derived.psc", "ScriptName Derived extends Base\nImport First\n");
+
+  REQUIRE(batch.start(Game::Skyrim, 16) == 4);
+  auto started = test::takeStartedRequests();
+  REQUIRE(started.size() == 1 && started[0].size() == 4);
+  auto names = scriptNames(started[0]);
+  CHECK(std::find(names.begin(), names.end(), "Base") < std::find(names.begin(), names.end(), "Derived"));
+}
+
+TEST_CASE(waitsForScriptsInOtherGroups) {
+  TestBatch batch;
+  batch.addScript("Base/Base.psc", "ScriptName Base\n");
+  batch.addScript("Derived/Derived.psc", "ScriptName Derived extends Base\n");
+
+  REQUIRE(batch.start(Game::Fallout4, 1) == 2);
+  auto started = test::takeStartedRequests();
+  REQUIRE(started.size() == 1 && scriptNames(started[0]) == std::vector<std::string> {"Base"});
+
+  CHECK(!batch.complete(started[0][0], true));
+  auto unblocked = test::takeStartedRequests();
+  REQUIRE(unblocked.size() == 1 && scriptNames(unblocked[0]) == std::vector<std::string> {"Derived"});
+  CHECK(batch.complete(unblocked[0][0], true));
+  CHECK(batch.report().succeeded == 2 && batch.report().failed == 0);
+}
+
+TEST_CASE(skipsDependentsOfFailedScripts) {
+  TestBatch batch;
+  batch.addScript("Base/Base.psc", "ScriptName Base\n");
+  batch.addScript("Derived/Derived.psc", "ScriptName Derived extends Base\n");
+  batch.addScript("Derived/MoreDerived.psc", "ScriptName MoreDerived extends Derived\n");
+
+  REQUIRE(batch.start(Game::Fallout4, 1) == 3);
+  auto started = test::takeStartedRequests();
+  REQUIRE(started.size() == 1);
+  CHECK(batch.complete(started[0][0], false));
+  CHECK(test::takeStartedRequests().empty());
+  CHECK(batch.report().failed == 1 && batch.report().skipped == 2 && batch.report().errors.size() == 1);
+}
@@ -0,0 +1,81 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Compiler\BuildManifest.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+using namespace papyrus;
+
+namespace {
+  const std::wstring SOURCE_FILE = L"Scripts/MyScript.psc";
+
+  void writeValue(std::ofstream& file, auto value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  // Manifest file with one entry whose source path claims the given length
+  void writeManifest(const std::filesystem::path& manifestFile, uint32_t pathLength) {
+    std::ofstream file(manifestFile, std::ios::binary | std::ios::trunc);
+    file.write("PSBM", 4);
+    writeValue(file, uint32_t {1});
+    writeValue(file, uint64_t {1});
+    writeValue(file, pathLength);
+    file.write(reinterpret_cast<const char*>(SOURCE_FILE.data()), SOURCE_FILE.size() * sizeof(wchar_t));
+  }
+}
+
+TEST_CASE(remembersRecordedCompilationsAfterSave) {
+  test::TemporaryDirectory directory;
+  auto outputFile = directory.createFile("Output/MyScript.pex", "compiled");
+  std::wstring outputDirectory = outputFile.parent_path().wstring();
+  BuildInputs inputs {
+    .sourceHash = 1,
+    .dependenciesHash = 2,
+    .flagsHash = 3
+  };
+  {
+    BuildManifest buildManifest;
+    CHECK(!buildManifest.isUpToDate(outputDirectory, SOURCE_FILE, inputs, outputFile.wstring()));
+    buildManifest.record(outputDirectory, SOURCE_FILE, inputs, outputFile.wstring());
+    buildManifest.save();
+  }
+
+  BuildManifest buildManifest;
+  CHECK(buildManifest.isUpToDate(outputDirectory, SOURCE_FILE, inputs, outputFile.wstring()));
+  BuildInputs changedInputs = inputs;
+  changedInputs.flagsHash++;
+  CHECK(!buildManifest.isUpToDate(outputDirectory, SOURCE_FILE, changedInputs, outputFile.wstring()));
+}
+
+TEST_CASE(rejectsStringSizesBeyondEndOfFile) {
+  test::TemporaryDirectory directory;
+  auto outputFile = directory.createFile("Output/MyScript.pex", "compiled");
+  std::wstring outputDirectory = outputFile.parent_path().wstring();
+  for (uint32_t pathLength : {UINT32_MAX, static_cast<uint32_t>(SOURCE_FILE.size() + 1)}) {
+    // A broken manifest is treated as missing, rather than allocating a string of the claimed size
+    writeManifest(outputFile.parent_path() / "PapyrusBuild.manifest", pathLength);
+    BuildManifest buildManifest;
+    CHECK(!buildManifest.isUpToDate(outputDirectory, SOURCE_FILE, BuildInputs(), outputFile.wstring()));
+  }
+}
@@ -0,0 +1,79 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Measures how fast compiler output is parsed into errors. A script with a broken base or import makes PapyrusCompiler report
+// the same few errors over and over, so output can run to a hundred thousand lines, read from the pipe in 64 KiB chunks.
+
+#include "..\Benchmark.hpp"
+
+#include "..\..\Plugin\Compiler\ErrorParser.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace {
+  constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+  // Generate distinct error lines spread over a few hundred scripts, with Windows line breaks like PapyrusCompiler's
+  std::string generateOutput(int lineCount) {
+    std::string output;
+    for (int line = 0; line < lineCount; ++line) {
+      output += "C:\\Mods\\Scripts\\Source\\User\\MyMod\\Script" + std::to_string(line % 500) + ".psc(" + std::to_string(line % 997 + 1) + ","
+        + std::to_string(line % 80 + 1) + "): variable Foo" + std::to_string(line) + " is undefined\r\n";
+    }
+    return output;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool quickRun = benchmark::isQuickRun(argc, argv);
+  int lineCount = quickRun ? 1000 : 100000;
+  int repeats = quickRun ? 1 : 5;
+
+  std::string output = generateOutput(lineCount);
+  double megabytes = static_cast<double>(output.size()) / (1024 * 1024);
+  std::printf("Output: %d lines, %.2f MiB\n", lineCount, megabytes);
+
+  size_t errorCount = 0;
+  double parseTime = benchmark::measure(repeats, [&] {
+    papyrus::ErrorParser errorParser(false, L"C:\\Mods\\Scripts");
+    for (size_t offset = 0; offset < output.size(); offset += CHUNK_SIZE) {
+      errorParser.feed(output.data() + offset, std::min(CHUNK_SIZE, output.size() - offset));
+    }
+    errorParser.finish();
+    errorCount = errorParser.getErrors().size();
+  });
+
+  // Output that has no parsable errors is shown as is
+  size_t decodedLength = 0;
+  double decodeTime = benchmark::measure(repeats, [&] {
+    decodedLength = papyrus::ErrorParser::decode(output).size();
+  });
+
+  benchmark::report("Parse whole output", parseTime, "ms");
+  benchmark::report("Parse throughput", static_cast<double>(lineCount) / parseTime, "klines/s");
+  benchmark::report("Decode whole output", decodeTime, "ms");
+  benchmark::report("Decode throughput", megabytes / (decodeTime / 1000), "MiB/s");
+  if (errorCount != static_cast<size_t>(lineCount) || decodedLength != output.size()) {
+    std::printf("Expected %d errors and %zu characters, got %zu and %zu\n", lineCount, output.size(), errorCount, decodedLength);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Measures how fast compiled scripts are read and anonymized. Vanilla scripts can't be shipped, so a set of synthetic Skyrim and
+// Fallout 4 scripts of about the same number and size is written to a temporary directory instead.
+
+#include "..\Benchmark.hpp"
+#include "..\Test.hpp"
+#include "..\Support\TestPex.hpp"
+
+#include "..\..\Plugin\Compiler\PexAnonymizer.hpp"
+#include "..\..\Plugin\Compiler\PexReader.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace papyrus;
+
+int main(int argc, char* argv[]) {
+  bool quickRun = benchmark::isQuickRun(argc, argv);
+  int fileCount = quickRun ? 20 : 9000;
+  int repeats = quickRun ? 1 : 5;
+
+  // Scripts alternate between games, and have from 10 to 49 functions
+  test::TemporaryDirectory directory;
+  std::vector<std::wstring> filePaths;
+  size_t totalSize = 0;
+  for (int file = 0; file < fileCount; ++file) {
+    std::string data = test::buildPex((file % 2 == 0) ? SKYRIM_GAME_ID : FALLOUT4_GAME_ID, 10 + file % 40);
+    totalSize += data.size();
+    filePaths.push_back(directory.createFile("Scripts" + std::to_string(file % 10) + "/Script" + std::to_string(file) + ".pex", data).wstring());
+  }
+  std::printf("Scripts: %d files, %.2f MiB\n", fileCount, static_cast<double>(totalSize) / (1024 * 1024));
+
+  int failures = 0;
+  size_t functionCount = 0;
+  double openTime = benchmark::measure(repeats, [&] {
+    functionCount = 0;
+    for (const auto& filePath : filePaths) {
+      PexReader reader;
+      if (!reader.open(filePath)) {
+        failures++;
+        continue;
+      }
+      for (const auto& object : reader.objects()) {
+        for (const auto& state : object.states) {
+          functionCount += state.functions.size();
+        }
+      }
+    }
+  });
+
+  // Instructions are only decoded on demand, e.g. to look into one function
+  size_t instructionCount = 0;
+  double decodeTime = benchmark::measure(repeats, [&] {
+    instructionCount = 0;
+    std::vector<PexInstruction> instructions;
+    for (const auto& filePath : filePaths) {
+      PexReader reader;
+      if (!reader.open(filePath)) {
+        failures++;
+        continue;
+      }
+      for (const auto& object : reader.objects()) {
+        for (const auto& state : object.states) {
+          for (const auto& function : state.functions) {
+            failures += reader.decodeInstructions(function, instructions) ? 0 : 1;
+            instructionCount += instructions.size();
+          }
+        }
+      }
+    }
+  });
+
+  AnonymizationReport report;
+  double anonymizeTime = benchmark::measure(repeats, [&] {
+    report = PexAnonymizer::anonymizeDirectory(directory.path().wstring());
+  });
+
+  benchmark::report("Open and parse all scripts", openTime, "ms");
+  benchmark::report("Open and parse throughput", fileCount / (openTime / 1000), "files/s");
+  benchmark::report("Open, parse and decode all functions", decodeTime, "ms");
+  benchmark::report("Decode throughput", static_cast<double>(instructionCount) / decodeTime, "kinstructions/s");
+  benchmark::report("Anonymize all scripts", anonymizeTime, "ms");
+  benchmark::report("Anonymize throughput", report.filesPerSecond(), "files/s");
+
+  size_t expectedFunctionCount = 0;
+  for (int file = 0; file < fileCount; ++file) {
+    expectedFunctionCount += static_cast<size_t>(10 + file % 40);
+  }
+  if (failures > 0 || functionCount != expectedFunctionCount || report.anonymized != static_cast<size_t>(fileCount)) {
+    std::printf("%d scripts failed to parse, %zu of %zu functions found, %zu of %d scripts anonymized\n", failures, functionCount,
+      expectedFunctionCount, report.anonymized, fileCount);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,237 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+#include "..\Support\TestPex.hpp"
+
+#include "..\..\Plugin\Compiler\PexAnonymizer.hpp"
+#include "..\..\Plugin\Compiler\PexReader.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace papyrus;
+
+namespace {
+  constexpr int FUNCTION_COUNT = 3;
+
+  std::span<const unsigned char> bytesOf(const std::string& data, size_t size) {
+    return std::span<const unsigned char>(reinterpret_cast<const unsigned char*>(data.data()), size);
+  }
+
+  std::string readFile(const std::filesystem::path& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  // Size of the header fields up to string table, which anonymizer may change
+  size_t headerSize() {
+    return 16 + 2 + std::strlen(test::PEX_SOURCE_FILE_NAME) + 2 + std::strlen(test::PEX_USER_NAME) + 2 + std::strlen(test::PEX_MACHINE_NAME);
+  }
+
+  void checkFunction(const PexReader& reader, const PexFunction& function, std::string_view returnType, int loops) {
+    CHECK(function.returnType == returnType);
+    REQUIRE(function.parameters.size() == 1);
+    CHECK(function.parameters[0].name == "value");
+    CHECK(function.parameters[0].typeName == "Int");
+    REQUIRE(function.locals.size() == 1);
+    CHECK(function.locals[0].name == "temp");
+    CHECK(function.instructionCount == loops * 2 + 1);
+    CHECK(!function.isGlobal());
+    CHECK(!function.isNative());
+
+    std::vector<PexInstruction> instructions;
+    REQUIRE(reader.decodeInstructions(function, instructions));
+    REQUIRE(instructions.size() == static_cast<size_t>(loops * 2 + 1));
+    for (int loop = 0; loop < loops; ++loop) {
+      const auto& addition = instructions[static_cast<size_t>(loop * 2)];
+      CHECK(addition.opcode == 0x01);
+      REQUIRE(addition.arguments.size() == 3);
+      CHECK(addition.arguments[0].type == PexValueType::Identifier);
+      CHECK(addition.arguments[0].string == "temp");
+      CHECK(addition.arguments[2].type == PexValueType::Integer);
+      CHECK(addition.arguments[2].integer == loop);
+
+      // Variable arguments follow the fixed ones, without their count
+      const auto& call = instructions[static_cast<size_t>(loop * 2 + 1)];
+      CHECK(call.opcode == 0x17);
+      REQUIRE(call.arguments.size() == 5);
+      CHECK(call.arguments[0].type == PexValueType::String);
+      CHECK(call.arguments[0].string == "SetValue");
+      CHECK(call.arguments[1].string == "self");
+      CHECK(call.arguments[3].string == "temp");
+      CHECK(call.arguments[4].type == PexValueType::Float);
+      CHECK(call.arguments[4].floatValue == 1.5f);
+    }
+    CHECK(instructions.back().opcode == 0x1A);
+  }
+
+  // Check everything test::buildPex writes
+  void checkScript(const PexReader& reader, uint16_t gameID) {
+    bool isFallout4 = (gameID == FALLOUT4_GAME_ID);
+    const auto& header = reader.header();
+    CHECK(header.isBigEndian == !isFallout4);
+    CHECK(header.majorVersion == 3);
+    CHECK(header.minorVersion == (isFallout4 ? 9 : 2));
+    CHECK(header.gameID == gameID);
+    CHECK(header.compilationTime == 1700000001);
+    CHECK(header.sourceFileName == test::PEX_SOURCE_FILE_NAME);
+    CHECK(header.userName == test::PEX_USER_NAME);
+    CHECK(header.machineName == test::PEX_MACHINE_NAME);
+
+    const auto& debugInfo = reader.debugInfo();
+    CHECK(debugInfo.hasDebugInfo);
+    CHECK(debugInfo.modificationTime == 1700000000);
+    REQUIRE(debugInfo.functions.size() == FUNCTION_COUNT);
+    CHECK(debugInfo.functions[1].objectName == "MyScript");
+    CHECK(debugInfo.functions[1].functionName == "Update1");
+    REQUIRE(debugInfo.functions[1].lineNumbers.size() == test::PEX_INSTRUCTIONS_PER_FUNCTION);
+    CHECK(debugInfo.functions[1].lineNumbers[0] == 10);
+    CHECK(debugInfo.functions[1].lineNumbers[test::PEX_INSTRUCTIONS_PER_FUNCTION - 1] == 10 + test::PEX_INSTRUCTIONS_PER_FUNCTION - 1);
+    if (isFallout4) {
+      REQUIRE(debugInfo.propertyGroups.size() == 1);
+      CHECK(debugInfo.propertyGroups[0].name == "Settings");
+      CHECK(debugInfo.propertyGroups[0].docString == "Group doc");
+      CHECK(debugInfo.propertyGroups[0].userFlags == 1);
+      REQUIRE(debugInfo.propertyGroups[0].propertyNames.size() == 1);
+      CHECK(debugInfo.propertyGroups[0].propertyNames[0] == "Count");
+      REQUIRE(debugInfo.structOrders.size() == 1);
+      CHECK(debugInfo.structOrders[0].name == "Point");
+      REQUIRE(debugInfo.structOrders[0].memberNames.size() == 1);
+      CHECK(debugInfo.structOrders[0].memberNames[0] == "X");
+    } else {
+      CHECK(debugInfo.propertyGroups.empty());
+      CHECK(debugInfo.structOrders.empty());
+    }
+
+    REQUIRE(reader.userFlags().size() == 2);
+    CHECK(reader.userFlags()[1].name == "conditional");
+    CHECK(reader.userFlags()[1].flagIndex == 1);
+
+    REQUIRE(reader.objects().size() == 1);
+    const auto& object = reader.objects()[0];
+    CHECK(object.name == "MyScript");
+    CHECK(object.parentClassName == "Form");
+    CHECK(object.docString == "Test script");
+    CHECK(object.isConst == isFallout4);
+    CHECK(object.userFlags == 5);
+    CHECK(object.autoStateName.empty());
+    if (isFallout4) {
+      REQUIRE(object.structs.size() == 1);
+      CHECK(object.structs[0].name == "Point");
+      REQUIRE(object.structs[0].members.size() == 1);
+      CHECK(object.structs[0].members[0].name == "X");
+      CHECK(object.structs[0].members[0].initialValue.integer == 7);
+      CHECK(object.structs[0].members[0].docString == "X coordinate");
+    } else {
+      CHECK(object.structs.empty());
+    }
+
+    REQUIRE(object.variables.size() == 1);
+    CHECK(object.variables[0].name == "::Count_var");
+    CHECK(object.variables[0].initialValue.type == PexValueType::Integer);
+    CHECK(object.variables[0].initialValue.integer == 42);
+
+    REQUIRE(object.properties.size() == 2);
+    const auto& autoProperty = object.properties[0];
+    CHECK(autoProperty.name == "Count");
+    CHECK(autoProperty.isAuto());
+    CHECK(autoProperty.autoVariableName == "::Count_var");
+    CHECK(!autoProperty.hasReadHandler);
+    CHECK(!autoProperty.hasWriteHandler);
+    const auto& fullProperty = object.properties[1];
+    CHECK(fullProperty.name == "Name");
+    CHECK(fullProperty.isRead());
+    CHECK(fullProperty.isWrite());
+    CHECK(!fullProperty.isAuto());
+    REQUIRE(fullProperty.hasReadHandler);
+    REQUIRE(fullProperty.hasWriteHandler);
+    checkFunction(reader, fullProperty.readHandler, "String", 1);
+    checkFunction(reader, fullProperty.writeHandler, "None", 0);
+
+    REQUIRE(object.states.size() == 1);
+    CHECK(object.states[0].name.empty());
+    REQUIRE(object.states[0].functions.size() == FUNCTION_COUNT);
+    for (size_t i = 0; i < FUNCTION_COUNT; ++i) {
+      CHECK(object.states[0].functions[i].name == "Update" + std::to_string(i));
+      checkFunction(reader, object.states[0].functions[i], "Int", test::PEX_LOOPS_PER_FUNCTION);
+    }
+  }
+}
+
+TEST_CASE(readsSkyrimScript) {
+  std::string data = test::buildPex(SKYRIM_GAME_ID, FUNCTION_COUNT);
+  PexReader reader;
+  REQUIRE(reader.parse(bytesOf(data, data.size())));
+  checkScript(reader, SKYRIM_GAME_ID);
+}
+
+TEST_CASE(readsFallout4Script) {
+  std::string data = test::buildPex(FALLOUT4_GAME_ID, FUNCTION_COUNT);
+  PexReader reader;
+  REQUIRE(reader.parse(bytesOf(data, data.size())));
+  checkScript(reader, FALLOUT4_GAME_ID);
+}
+
+TEST_CASE(rejectsTruncatedScripts) {
+  for (uint16_t gameID : {SKYRIM_GAME_ID, FALLOUT4_GAME_ID}) {
+    std::string data = test::buildPex(gameID, FUNCTION_COUNT);
+    for (size_t size = 0; size < data.size(); ++size) {
+      PexReader reader;
+      CHECK(!reader.parse(bytesOf(data, size)));
+      CHECK(!reader.getError().empty());
+    }
+  }
+}
+
+TEST_CASE(readsAnonymizedScriptsLikeOriginals) {
+  test::TemporaryDirectory directory;
+  for (uint16_t gameID : {SKYRIM_GAME_ID, FALLOUT4_GAME_ID}) {
+    std::string data = test::buildPex(gameID, FUNCTION_COUNT);
+    auto filePath = directory.createFile(std::to_string(gameID) + "/MyScript.pex", data);
+
+    std::wstring errorMsg;
+    REQUIRE(PexAnonymizer::anonymize(filePath.wstring(), errorMsg));
+    CHECK(errorMsg.empty());
+
+    // Only the header fields are overwritten, with dashes of the same length
+    std::string anonymizedData = readFile(filePath);
+    REQUIRE(anonymizedData.size() == data.size());
+    CHECK(anonymizedData.compare(headerSize(), std::string::npos, data, headerSize()) == 0);
+
+    PexReader reader;
+    REQUIRE(reader.open(filePath.wstring()));
+    CHECK(reader.header().sourceFileName == std::string(std::strlen(test::PEX_SOURCE_FILE_NAME), '-'));
+    CHECK(reader.header().userName == std::string(std::strlen(test::PEX_USER_NAME), '-'));
+    CHECK(reader.header().machineName == std::string(std::strlen(test::PEX_MACHINE_NAME), '-'));
+    CHECK(reader.objects().size() == 1);
+  }
+
+  // A file that isn't a PEX file is reported and left alone
+  auto filePath = directory.createFile("Broken.pex", "not a script");
+  auto report = PexAnonymizer::anonymizeDirectory(directory.path().wstring());
+  CHECK(report.total == 3);
+  CHECK(report.anonymized == 2);
+  CHECK(report.failed == 1);
+  CHECK(readFile(filePath) == "not a script");
+}
@@ -0,0 +1,164 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Compiler\ErrorParser.hpp"
+#include "..\..\Plugin\Compiler\ProcessLauncher.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+using namespace papyrus;
+using namespace std::chrono_literals;
+
+// Runs shell scripts standing in for the compiler through the same launcher and parser the plugin uses on Windows
+namespace {
+  // Create an executable shell script with the given body
+  std::filesystem::path createFakeCompiler(const test::TemporaryDirectory& directory, const std::string& name, const std::string& body) {
+    auto script = directory.createFile(name, "#!/bin/sh\n" + body);
+    std::filesystem::permissions(script, std::filesystem::perms::owner_all, std::filesystem::perm_options::add);
+    return script;
+  }
+
+  // Output of a process, gathered by stream
+  struct Output {
+    std::string output;
+    std::string error;
+  };
+
+  ProcessLauncher::output_callback_t gatherOutput(Output& output) {
+    return [&output](ProcessStream stream, const char* data, size_t size) {
+      (stream == ProcessStream::Output ? output.output : output.error).append(data, size);
+    };
+  }
+
+  double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+TEST_CASE(parsesErrorsStreamedByCompiler) {
+  test::TemporaryDirectory directory;
+  auto compiler = createFakeCompiler(directory, "PapyrusCompiler",
+    "echo \"Starting 1 compile threads for 1 files...\"\n"
+    "echo \"Compiling \\\"$1\\\"...\"\n"
+    "echo \"$1(3,5): variable Foo is undefined\" >&2\n"
+    "printf '%s(7,1): mismatched input' \"$1\" >&2\n"
+    "exit 1\n"
+  );
+
+  ErrorParser errorParser(false, directory.path().wstring());
+  Output output;
+  ProcessLauncher launcher;
+  REQUIRE(launcher.run({.program = compiler.wstring(), .arguments = {L"C:\\Scripts\\My Script.psc"}}, [&](ProcessStream stream, const char* data, size_t size) {
+    gatherOutput(output)(stream, data, size);
+    if (stream == ProcessStream::Error) {
+      errorParser.feed(data, size);
+    }
+  }));
+  errorParser.finish();
+
+  CHECK(launcher.getEnd() == ProcessEnd::Exited);
+  CHECK(launcher.getExitCode() == 1);
+  CHECK(output.output == "Starting 1 compile threads for 1 files...\nCompiling \"C:\\Scripts\\My Script.psc\"...\n");
+  const auto& errors = errorParser.getErrors();
+  REQUIRE(errors.size() == 2);
+  CHECK(errors[0].file == L"C:\\Scripts\\My Script.psc");
+  CHECK(errors[0].line == 3);
+  CHECK(errors[0].column == 5);
+  CHECK(errors[0].message == L"variable Foo is undefined");
+  CHECK(errors[1].line == 7);
+  CHECK(errors[1].message == L"mismatched input");
+  CHECK(!errorParser.hasUnparsableLines());
+}
+
+TEST_CASE(readsLargeOutputOnBothStreams) {
+  // Each stream gets far more than a pipe buffer holds, so reading one stream only until it ends would block forever
+  test::TemporaryDirectory directory;
+  auto compiler = createFakeCompiler(directory, "PapyrusCompiler",
+    "i=0\n"
+    "while [ $i -lt 16 ]; do\n"
+    "  head -c 65536 /dev/zero >&2\n"
+    "  head -c 65536 /dev/zero\n"
+    "  i=$((i + 1))\n"
+    "done\n"
+  );
+
+  Output output;
+  ProcessLauncher launcher;
+  REQUIRE(launcher.run({.program = compiler.wstring()}, gatherOutput(output), 30s));
+  CHECK(launcher.getEnd() == ProcessEnd::Exited);
+  CHECK(launcher.getExitCode() == 0);
+  CHECK(output.output.size() == 16 * 65536);
+  CHECK(output.error.size() == 16 * 65536);
+}
+
+TEST_CASE(killsProcessTreeWhenTimedOut) {
+  // The child process keeps output pipes open, so run would wait for it if only the compiler itself were killed
+  test::TemporaryDirectory directory;
+  auto compiler = createFakeCompiler(directory, "PapyrusCompiler",
+    "sleep 30 &\n"
+    "sleep 30\n"
+  );
+
+  auto start = std::chrono::steady_clock::now();
+  Output output;
+  ProcessLauncher launcher;
+  REQUIRE(launcher.run({.program = compiler.wstring()}, gatherOutput(output), 300ms));
+  CHECK(launcher.getEnd() == ProcessEnd::TimedOut);
+  CHECK(secondsSince(start) < 10);
+}
+
+TEST_CASE(doesNotInheritPipesOfConcurrentProcesses) {
+  // Pipes of a process launched by another thread must not be inherited, or one process's output can be held open by another
+  test::TemporaryDirectory directory;
+  auto listingCompiler = createFakeCompiler(directory, "ListingCompiler", "exec ls /proc/self/fd\n");
+  auto longCompiler = createFakeCompiler(directory, "LongCompiler", "sleep 5\n");
+
+  Output aloneOutput;
+  ProcessLauncher launcher;
+  REQUIRE(launcher.run({.program = listingCompiler.wstring()}, gatherOutput(aloneOutput)));
+
+  ProcessLauncher longLauncher;
+  std::thread longThread([&] {
+    CHECK(longLauncher.run({.program = longCompiler.wstring()}, [](ProcessStream, const char*, size_t) {}));
+  });
+  std::this_thread::sleep_for(200ms);
+  Output concurrentOutput;
+  auto start = std::chrono::steady_clock::now();
+  CHECK(launcher.run({.program = listingCompiler.wstring()}, gatherOutput(concurrentOutput)));
+  double seconds = secondsSince(start);
+  longLauncher.cancel();
+  longThread.join();
+
+  CHECK(!aloneOutput.output.empty());
+  CHECK(concurrentOutput.output == aloneOutput.output);
+  CHECK(seconds < 3);
+  CHECK(longLauncher.getEnd() == ProcessEnd::Cancelled);
+}
+
+TEST_CASE(reportsProgramThatCannotBeRun) {
+  test::TemporaryDirectory directory;
+  ProcessLauncher launcher;
+  CHECK(!launcher.run({.program = (directory.path() / "Missing").wstring()}, [](ProcessStream, const char*, size_t) {}));
+  CHECK(launcher.getFailedCall() != nullptr);
+}
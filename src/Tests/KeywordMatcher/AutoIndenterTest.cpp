@@ -0,0 +1,154 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+#include "..\Support\LexerEnvironment.hpp"
+#include "..\Support\LexerIndexes.hpp"
+#include "..\Support\TestDocument.hpp"
+#include "..\Support\TestScintilla.hpp"
+
+#include "..\..\Plugin\KeywordMatcher\AutoIndenter.hpp"
+#include "..\..\Plugin\Lexer\BlockIndex.hpp"
+
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <cctype>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using namespace papyrus;
+
+namespace {
+  constexpr npp_buffer_t BUFFER_ID = 1;
+  constexpr int INDENT_SIZE = 2;
+
+  // Replays typing into a document, the way Notepad++ notifies auto indenter of each added character. Block keywords are
+  // indexed whenever auto indenter asks for lines to be lexed, like lexer does.
+  class TypingReplay {
+    public:
+      TypingReplay()
+        : scintilla(document) {
+        blockIndex->reset(true);
+        test::setBlockIndex(BUFFER_ID, blockIndex);
+        scintilla.setColouriser([this](Sci_Position, Sci_Position) { lex(); });
+        ::SendMessage(scintilla.handle(), SCI_SETINDENT, INDENT_SIZE, 0);
+      }
+
+      ~TypingReplay() {
+        test::setBlockIndex(BUFFER_ID, nullptr);
+      }
+
+      void type(std::string_view keys) {
+        for (char ch : keys) {
+          Sci_Position caret = scintilla.currentPos();
+          document.insertText(caret, std::string_view(&ch, 1));
+          scintilla.setCurrentPos(caret + 1);
+          autoIndenter.handleCharAdded(scintilla.handle(), BUFFER_ID, ch);
+        }
+      }
+
+      inline const std::string& text() const { return document.text(); }
+      inline Sci_Position caret() const { return scintilla.currentPos(); }
+
+    private:
+      // Index block keywords of the whole document, which is plenty for the few lines typed here
+      void lex() {
+        blockIndex->reset(true);
+        const std::string& content = document.text();
+        for (Sci_Position line = 0; line < document.lineCount(); ++line) {
+          Sci_Position lineStart = document.LineStart(line);
+          Sci_Position lineEnd = document.LineEnd(line);
+          for (Sci_Position position = lineStart; position < lineEnd;) {
+            if (!std::isalpha(static_cast<unsigned char>(content[position]))) {
+              position++;
+              continue;
+            }
+
+            Sci_Position wordStart = position;
+            std::string word;
+            while (position < lineEnd && (std::isalnum(static_cast<unsigned char>(content[position])) || content[position] == '_')) {
+              word += static_cast<char>(std::tolower(static_cast<unsigned char>(content[position])));
+              position++;
+            }
+            BlockType type;
+            BlockRole role;
+            if (BlockIndex::isBlockKeyword(word, type, role)) {
+              blockIndex->addKeyword(line, wordStart - lineStart, position - wordStart, type, role);
+            }
+          }
+        }
+        document.StartStyling(0);
+        document.SetStyleFor(document.Length(), 0);
+      }
+
+      // Private members
+      //
+      test::LexerEnvironment environment;
+      test::TestDocument document;
+      test::TestScintilla scintilla;
+      std::shared_ptr<BlockIndex> blockIndex {std::make_shared<BlockIndex>()};
+      AutoIndenter autoIndenter;
+  };
+}
+
+TEST_CASE(indentsBlocksAsTyped) {
+  TypingReplay replay;
+  replay.type("Function Foo()\nIf x\ny = 1\nElseIf z\ny = 2\nElse\ny = 3\nEndIf\nWhile y\ny -= 1\nEndWhile\nEndFunction\n");
+  CHECK(replay.text() ==
+    "Function Foo()\n"
+    "  If x\n"
+    "    y = 1\n"
+    "  ElseIf z\n"
+    "    y = 2\n"
+    "  Else\n"
+    "    y = 3\n"
+    "  EndIf\n"
+    "  While y\n"
+    "    y -= 1\n"
+    "  EndWhile\n"
+    "EndFunction\n");
+  CHECK(replay.caret() == static_cast<Sci_Position>(replay.text().size()));
+}
+
+TEST_CASE(outdentsKeywordsFollowedByParenthesis) {
+  TypingReplay replay;
+  replay.type("If x\ny = 1\nElseIf(z)\ny = 2\n");
+  CHECK(replay.text() == "If x\n  y = 1\nElseIf(z)\n  y = 2\n  ");
+}
+
+TEST_CASE(keepsIndentationOfIdentifiersStartingWithKeywords) {
+  TypingReplay replay;
+  replay.type("If x\nElseCount = 1\nEndIfFound = True\nElse_1 = 2\nEndIf\n");
+  CHECK(replay.text() ==
+    "If x\n"
+    "  ElseCount = 1\n"
+    "  EndIfFound = True\n"
+    "  Else_1 = 2\n"
+    "EndIf\n");
+}
+
+TEST_CASE(waitsForKeywordToBeCompleted) {
+  TypingReplay replay;
+  replay.type("If x\nElse");
+  CHECK(replay.text() == "If x\n  Else");
+  replay.type("Count");
+  CHECK(replay.text() == "If x\n  ElseCount");
+  CHECK(replay.caret() == static_cast<Sci_Position>(replay.text().size()));
+}
@@ -0,0 +1,270 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Measures keyword matching latency per caret position on pathological scripts, both with the block index built by lexer and
+// with the text scan used before a document is completely lexed. Scintilla and Notepad++ are replaced by in-memory stand-ins.
+
+#include "..\Benchmark.hpp"
+#include "..\Support\LexerEnvironment.hpp"
+#include "..\Support\LexerIndexes.hpp"
+#include "..\Support\TestDocument.hpp"
+#include "..\Support\TestScintilla.hpp"
+#include "..\Support\TestWindow.hpp"
+
+#include "..\..\Plugin\KeywordMatcher\KeywordMatcher.hpp"
+#include "..\..\Plugin\Lexer\Lexer.hpp"
+
+#include "..\..\external\npp\Notepad_plus_msgs.h"
+
+#include <cctype>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace papyrus;
+
+namespace {
+  constexpr npp_buffer_t BUFFER_ID = 1;
+
+  // A caret position to measure, and where its match is expected, or -1 if it shouldn't match
+  struct Caret {
+    std::string name;
+    Sci_Position position;
+    Sci_Position expectedMatch;
+  };
+
+  // Builds a script along with the styles the lexer would give it, and the block keywords it would index
+  class ScriptBuilder {
+    public:
+      ScriptBuilder() {
+        // Styles are private to lexer, so find them through its style checks
+        for (int style = 1; style < 32; ++style) {
+          if (keywordStyle == 0 && Lexer::isKeyword(style)) {
+            keywordStyle = style;
+          }
+          if (flowControlStyle == 0 && Lexer::isFlowControl(style)) {
+            flowControlStyle = style;
+          }
+          if (commentStyle == 0 && Lexer::isComment(style)) {
+            commentStyle = style;
+          }
+        }
+      }
+
+      inline Sci_Position position() const { return static_cast<Sci_Position>(text.size()); }
+
+      // Add a block keyword, styled as keyword or flow control depending on the word. Returns its position.
+      Sci_Position keyword(std::string_view word) {
+        std::string lowerCaseWord(word);
+        for (auto& ch : lowerCaseWord) {
+          ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        }
+
+        Sci_Position start = position();
+        BlockType type;
+        BlockRole role;
+        if (BlockIndex::isBlockKeyword(lowerCaseWord, type, role)) {
+          keywords.push_back(BlockKeyword {
+            .line = line,
+            .column = start - lineStart,
+            .length = static_cast<Sci_Position>(word.size()),
+            .type = type,
+            .role = role
+          });
+        }
+        add(word, (type == BlockType::If || type == BlockType::While) ? flowControlStyle : keywordStyle);
+        return start;
+      }
+
+      // Comments and strings can contain keywords, which must not be matched. Strings don't need their own style here, as
+      // matcher only tells keywords and flow control apart from everything else.
+      inline void code(std::string_view content) { add(content, 0); }
+      inline void comment(std::string_view content) { add(content, commentStyle); }
+
+      void newLine(int indentation = 0) {
+        add("\n", 0);
+        line++;
+        lineStart = position();
+        add(std::string(static_cast<size_t>(indentation), ' '), 0);
+      }
+
+      void build(test::TestDocument& document, BlockIndex& blockIndex) const {
+        document.setText(text);
+        document.StartStyling(0);
+        document.SetStyles(static_cast<Sci_Position>(styles.size()), styles.data());
+
+        blockIndex.reset(true);
+        for (const auto& keyword : keywords) {
+          blockIndex.addKeyword(keyword.line, keyword.column, keyword.length, keyword.type, keyword.role);
+        }
+      }
+
+    private:
+      void add(std::string_view content, int style) {
+        text += content;
+        styles.append(content.size(), static_cast<char>(style));
+      }
+
+      int keywordStyle {0};
+      int flowControlStyle {0};
+      int commentStyle {0};
+      std::string text;
+      std::string styles;
+      Sci_Position line {0};
+      Sci_Position lineStart {0};
+      std::vector<BlockKeyword> keywords;
+  };
+
+  // Generated code nests If and While blocks deeper than anyone would write by hand
+  void deepNesting(ScriptBuilder& builder, int depth, std::vector<Caret>& carets) {
+    Sci_Position function = builder.keyword("Function");
+    builder.code(" Deep(int value)");
+    std::vector<Sci_Position> openings;
+    for (int level = 0; level < depth; ++level) {
+      builder.newLine(2 + level * 2);
+      openings.push_back(builder.keyword((level % 2 == 0) ? "If" : "While"));
+      builder.code(" value > " + std::to_string(level));
+      builder.newLine(4 + level * 2);
+      builder.code("value -= 1");
+    }
+    std::vector<Sci_Position> closings(openings.size());
+    for (int level = depth - 1; level >= 0; --level) {
+      builder.newLine(2 + level * 2);
+      closings[static_cast<size_t>(level)] = builder.keyword((level % 2 == 0) ? "EndIf" : "EndWhile");
+    }
+    builder.newLine();
+    Sci_Position endFunction = builder.keyword("EndFunction");
+    builder.newLine();
+
+    carets.push_back({"Deep nesting: outermost If", openings.front(), closings.front()});
+    carets.push_back({"Deep nesting: innermost EndIf", closings[static_cast<size_t>((depth - 1) & ~1)], openings[static_cast<size_t>((depth - 1) & ~1)]});
+    carets.push_back({"Deep nesting: outermost EndIf", closings.front(), openings.front()});
+    carets.push_back({"Deep nesting: EndFunction", endFunction, function});
+  }
+
+  // A generated dispatcher with thousands of ElseIf branches
+  void manyBranches(ScriptBuilder& builder, int branches, std::vector<Caret>& carets) {
+    builder.keyword("Function");
+    builder.code(" Dispatch(int id)");
+    builder.newLine(2);
+    Sci_Position opening = builder.keyword("If");
+    builder.code(" id == 0");
+    Sci_Position middle = 0;
+    for (int branch = 1; branch <= branches; ++branch) {
+      builder.newLine(4);
+      builder.code("Handle(" + std::to_string(branch - 1) + ")");
+      builder.newLine(2);
+      Sci_Position elseIf = builder.keyword("ElseIf");
+      builder.code(" id == " + std::to_string(branch));
+      if (branch == branches / 2) {
+        middle = elseIf;
+      }
+    }
+    builder.newLine(2);
+    builder.keyword("Else");
+    builder.newLine(4);
+    builder.code("Fail()");
+    builder.newLine(2);
+    Sci_Position closing = builder.keyword("EndIf");
+    builder.newLine();
+    builder.keyword("EndFunction");
+    builder.newLine();
+
+    carets.push_back({"Many ElseIf: If", opening, closing});
+    carets.push_back({"Many ElseIf: middle ElseIf", middle, opening});
+    carets.push_back({"Many ElseIf: EndIf", closing, opening});
+  }
+
+  // Long function where keywords appear in comments and strings, which text scan has to check and skip one by one
+  void keywordsInCommentsAndStrings(ScriptBuilder& builder, int lines, std::vector<Caret>& carets) {
+    Sci_Position function = builder.keyword("Function");
+    builder.code(" Describe()");
+    for (int line = 0; line < lines; ++line) {
+      builder.newLine(2);
+      if (line % 2 == 0) {
+        builder.comment("; EndFunction is reached after EndIf, EndWhile and EndEvent");
+      } else {
+        builder.code("Debug.Trace(\"EndFunction If EndIf While EndWhile\")");
+      }
+    }
+    builder.newLine();
+    Sci_Position endFunction = builder.keyword("EndFunction");
+    builder.newLine();
+
+    carets.push_back({"Comments and strings: Function", function, endFunction});
+    carets.push_back({"Comments and strings: EndFunction", endFunction, function});
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool quickRun = benchmark::isQuickRun(argc, argv);
+  int repeats = quickRun ? 1 : 20;
+
+  test::LexerEnvironment environment(Game::Fallout4);
+  test::TestWindow npp([](UINT message, WPARAM, LPARAM) -> LRESULT {
+    return (message == NPPM_GETCURRENTBUFFERID) ? BUFFER_ID : 0;
+  });
+  NppData nppData {
+    ._nppHandle = npp.handle()
+  };
+
+  ScriptBuilder builder;
+  std::vector<Caret> carets;
+  deepNesting(builder, quickRun ? 20 : 2000, carets);
+  builder.newLine();
+  manyBranches(builder, quickRun ? 50 : 5000, carets);
+  builder.newLine();
+  keywordsInCommentsAndStrings(builder, quickRun ? 100 : 50000, carets);
+
+  test::TestDocument document;
+  auto blockIndex = std::make_shared<BlockIndex>();
+  builder.build(document, *blockIndex);
+  test::TestScintilla scintilla(document);
+  std::printf("Document: %lld lines, %.2f MiB\n", static_cast<long long>(document.lineCount()), static_cast<double>(document.Length()) / (1024 * 1024));
+
+  KeywordMatcherSettings settings;
+  settings.enableKeywordMatching = true;
+  settings.enabledKeywords = KEYWORD_ALL;
+  KeywordMatcher matcher(nppData, settings);
+  settings.defaultIndicatorID = DEFAULT_MATCHER_INDICATOR;
+
+  int failures = 0;
+  for (bool useBlockIndex : {true, false}) {
+    test::setBlockIndex(BUFFER_ID, useBlockIndex ? blockIndex : nullptr);
+    for (const auto& caret : carets) {
+      scintilla.setCurrentPos(caret.position);
+      bool matched = false;
+      double time = benchmark::measure(repeats, [&] {
+        // Otherwise the result is cached until caret moves to another word
+        matcher.contentChanged(scintilla.handle(), 0, 0);
+        matched = matcher.match(scintilla.handle());
+      });
+
+      bool expectedMatch = (caret.expectedMatch >= 0);
+      if (matched != expectedMatch || (expectedMatch && scintilla.indicatorValueAt(DEFAULT_MATCHER_INDICATOR, caret.expectedMatch) == 0)) {
+        std::printf("Wrong match for %s\n", caret.name.c_str());
+        failures++;
+      }
+      benchmark::report((caret.name + (useBlockIndex ? ", block index" : ", text scan")).c_str(), time * 1000, "us");
+    }
+  }
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Measures throughput of Papyrus assembly lexer on a generated .pas file, which can be tens of thousands of lines long.
+
+#include "..\Benchmark.hpp"
+#include "..\Support\LexerEnvironment.hpp"
+#include "..\Support\TestDocument.hpp"
+
+#include "..\..\Plugin\Lexer\AssemblyLexer.hpp"
+
+#include <memory>
+#include <string>
+
+namespace {
+  constexpr char OPCODES[] = "nop iadd fadd isub fsub imul fmul idiv fdiv imod not ineg fneg assign cast cmp_eq cmp_lt cmp_le cmp_gt cmp_ge jmp jmpt jmpf "
+    "callmethod callparent callstatic return strcat propget propset array_create array_length array_getelement array_setelement array_findelement "
+    "array_rfindelement is struct_create struct_get struct_set array_findstruct array_rfindstruct array_add array_insert array_removelast array_remove array_clear";
+  constexpr char KEYWORDS[] = "none self true false bool float int string var";
+  constexpr char FOLD_DIRECTIVES[] = "info userflagsref objecttable object variabletable variable propertytable property propertygrouptable propertygroup "
+    "structtable struct member statetable state function paramtable localtable code";
+
+  // Generate an assembly file similar to PapyrusCompiler's output, with functions of the given number of code lines
+  std::string generateAssembly(int functionCount, int codeLinesPerFunction) {
+    std::string text =
+      ".info\n"
+      "  .source \"BenchmarkScript.psc\"\n"
+      "  .modifyTime 1700000000\n"
+      "  .compileTime 1700000001\n"
+      "  .user \"user\"\n"
+      "  .computer \"computer\"\n"
+      ".endInfo\n"
+      ".objectTable\n"
+      "  .object BenchmarkScript Quest\n"
+      "    .variableTable\n"
+      "      .variable ::count_var int\n"
+      "      .endVariable\n"
+      "    .endVariableTable\n"
+      "    .stateTable\n"
+      "      .state\n";
+    for (int function = 0; function < functionCount; ++function) {
+      std::string index = std::to_string(function);
+      text += "        .function Update" + index + "\n"
+        "          .userFlags 0\n"
+        "          .docString \"Generated function, with \\\"escapes\\\"\"\n"
+        "          .return None\n"
+        "          .paramTable\n"
+        "            .param value float\n"
+        "          .endParamTable\n"
+        "          .localTable\n"
+        "            .local ::temp0 bool\n"
+        "            .local ::temp1 float\n"
+        "          .endLocalTable\n"
+        "          .code\n";
+      for (int line = 0; line < codeLinesPerFunction; line += 4) {
+        std::string label = "label" + std::to_string(line);
+        text += "            cmp_lt ::temp0 value " + std::to_string(line) + ".5 ;@line " + std::to_string(line + 10) + "\n"
+          "            jmpf ::temp0 " + label + " ;@line " + std::to_string(line + 11) + "\n"
+          "            callmethod SetValue self ::NoneVar ::count_var -1 \"text\" ;@line " + std::to_string(line + 12) + "\n"
+          "          " + label + ":\n";
+      }
+      text += "          .endCode\n"
+        "        .endFunction\n";
+    }
+    text +=
+      "      .endState\n"
+      "    .endStateTable\n"
+      "  .endObject\n"
+      ".endObjectTable\n";
+    return text;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool quickRun = benchmark::isQuickRun(argc, argv);
+  int functionCount = quickRun ? 20 : 800;
+  int repeats = quickRun ? 1 : 5;
+
+  test::LexerEnvironment environment;
+  std::unique_ptr<papyrus::AssemblyLexer> lexer(static_cast<papyrus::AssemblyLexer*>(papyrus::AssemblyLexer::factory()));
+  lexer->WordListSet(0, OPCODES);
+  lexer->WordListSet(1, KEYWORDS);
+  lexer->WordListSet(2, FOLD_DIRECTIVES);
+
+  test::TestDocument document(generateAssembly(functionCount, 64));
+  double megabytes = static_cast<double>(document.Length()) / (1024 * 1024);
+  std::printf("Document: %lld lines, %.2f MiB\n", static_cast<long long>(document.lineCount()), megabytes);
+
+  // Notepad++ lexes what's visible first, and the rest in chunks when idle, so whole document lexing time is what users wait for
+  // when scrolling through a large file.
+  double lexTime = benchmark::measure(repeats, [&] {
+    lexer->Lex(0, document.Length(), 0, &document);
+  });
+  double foldTime = benchmark::measure(repeats, [&] {
+    lexer->Fold(0, document.Length(), 0, &document);
+  });
+
+  // Typing in a function only restyles from the changed line to the end of screen
+  Sci_Position middleLine = document.lineCount() / 2;
+  Sci_Position screenLength = document.LineStart(middleLine + 60) - document.LineStart(middleLine);
+  double screenTime = benchmark::measure(repeats * 100, [&] {
+    lexer->Lex(static_cast<Sci_PositionU>(document.LineStart(middleLine)), screenLength, 0, &document);
+  });
+
+  benchmark::report("Lex whole document", lexTime, "ms");
+  benchmark::report("Lex throughput", megabytes / (lexTime / 1000), "MiB/s");
+  benchmark::report("Lex throughput", static_cast<double>(document.lineCount()) / lexTime, "klines/s");
+  benchmark::report("Fold whole document", foldTime, "ms");
+  benchmark::report("Lex one screen (60 lines)", screenTime * 1000, "us");
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "..\Test.hpp"
+#include "..\Support\LexerEnvironment.hpp"
+#include "..\Support\TestDocument.hpp"
+
+#include "..\..\Plugin\Lexer\AssemblyLexer.hpp"
+
+#include <memory>
+#include <string_view>
+
+namespace {
+  // Lexer style states, as in AssemblyLexer
+  constexpr char DEFAULT = 0;
+  constexpr char DIRECTIVE = 1;
+  constexpr char OPCODE = 2;
+  constexpr char KEYWORD = 3;
+  constexpr char REGISTER = 4;
+  constexpr char LABEL = 5;
+  constexpr char COMMENT = 6;
+  constexpr char NUMBER = 7;
+  constexpr char STRING = 8;
+
+  std::unique_ptr<papyrus::AssemblyLexer> createLexer() {
+    std::unique_ptr<papyrus::AssemblyLexer> lexer(static_cast<papyrus::AssemblyLexer*>(papyrus::AssemblyLexer::factory()));
+    lexer->WordListSet(0, "assign jmp jmpf callmethod return");
+    lexer->WordListSet(1, "none self int");
+    lexer->WordListSet(2, "object function property propertygroup code");
+    return lexer;
+  }
+
+  // Check that every character of the first occurrence of a token at or after a position has the given style
+  bool hasStyle(const test::TestDocument& document, std::string_view token, char style, Sci_Position startPosition = 0) {
+    Sci_Position position = document.find(token, startPosition);
+    if (position < 0) {
+      return false;
+    }
+    for (Sci_Position i = 0; i < static_cast<Sci_Position>(token.size()); ++i) {
+      if (document.StyleAt(position + i) != style) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+TEST_CASE(stylesAssemblyTokens) {
+  test::LexerEnvironment environment;
+  auto lexer = createLexer();
+  test::TestDocument document(
+    ".function Update\n"
+    "  .code\n"
+    "    assign ::temp0 -12 ; comment with jmp\n"
+    "    jmpf ::temp0 label1\n"
+    "    callmethod Show self ::NoneVar \"a \\\" b\"\n"
+    "  label1:\n"
+    "    return none\n"
+    "  .endCode\n"
+    ".endFunction\n");
+  lexer->Lex(0, document.Length(), 0, &document);
+
+  CHECK(hasStyle(document, ".function", DIRECTIVE));
+  CHECK(hasStyle(document, "Update", DEFAULT));
+  CHECK(hasStyle(document, "assign", OPCODE));
+  CHECK(hasStyle(document, "::temp0", REGISTER));
+  CHECK(hasStyle(document, "-12", NUMBER));
+  CHECK(hasStyle(document, "; comment with jmp", COMMENT));
+  CHECK(hasStyle(document, "jmpf", OPCODE));
+  CHECK(hasStyle(document, "label1", LABEL));
+  CHECK(hasStyle(document, "self", KEYWORD));
+  CHECK(hasStyle(document, "::NoneVar", REGISTER));
+  CHECK(hasStyle(document, "\"a \\\" b\"", STRING));
+  CHECK(hasStyle(document, "label1:", LABEL, document.find("  label1:")));
+  CHECK(hasStyle(document, "none", KEYWORD));
+  CHECK(hasStyle(document, ".endCode", DIRECTIVE));
+}
+
+TEST_CASE(restylesFromLineStart) {
+  test::LexerEnvironment environment;
+  auto lexer = createLexer();
+  test::TestDocument document("  jmp label1\n  assign ::temp0 1\n");
+  lexer->Lex(0, document.Length(), 0, &document);
+
+  // Restyling from the middle of a line starts over from the beginning of the line
+  Sci_Position position = document.find("::temp0");
+  lexer->Lex(static_cast<Sci_PositionU>(position), document.Length() - position, 0, &document);
+  CHECK(hasStyle(document, "assign", OPCODE));
+  CHECK(hasStyle(document, "::temp0", REGISTER));
+  CHECK(hasStyle(document, "label1", LABEL));
+}
+
+TEST_CASE(foldsSections) {
+  test::LexerEnvironment environment;
+  auto lexer = createLexer();
+  test::TestDocument document(
+    ".object Script\n"
+    "  .propertyGroup Group1\n"
+    "    .property Value\n"
+    "  .endPropertyGroup\n"
+    "  .property Value int auto\n"
+    "  .endProperty\n"
+    ".endObject\n");
+  lexer->Lex(0, document.Length(), 0, &document);
+  lexer->Fold(0, document.Length(), 0, &document);
+
+  CHECK(document.GetLevel(0) == (SC_FOLDLEVELBASE | SC_FOLDLEVELHEADERFLAG));
+  CHECK(document.GetLevel(1) == ((SC_FOLDLEVELBASE + 1) | SC_FOLDLEVELHEADERFLAG));
+  CHECK(document.GetLevel(2) == SC_FOLDLEVELBASE + 2); // Property name in a group doesn't open a section
+  CHECK(document.GetLevel(3) == SC_FOLDLEVELBASE + 2);
+  CHECK(document.GetLevel(4) == ((SC_FOLDLEVELBASE + 1) | SC_FOLDLEVELHEADERFLAG));
+  CHECK(document.GetLevel(5) == SC_FOLDLEVELBASE + 2);
+  CHECK(document.GetLevel(6) == SC_FOLDLEVELBASE + 1);
+}
@@ -0,0 +1,285 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Lexer\BlockIndex.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace papyrus;
+
+namespace {
+  BlockKeyword keyword(Sci_Position line, Sci_Position column, BlockType type, BlockRole role) {
+    return BlockKeyword {
+      .line = line,
+      .column = column,
+      .length = 2,
+      .type = type,
+      .role = role
+    };
+  }
+
+  void add(BlockIndex& blockIndex, const BlockKeyword& keyword) {
+    blockIndex.addKeyword(keyword.line, keyword.column, keyword.length, keyword.type, keyword.role);
+  }
+
+  bool sameLocation(const BlockKeyword& keyword1, const BlockKeyword& keyword2) {
+    return keyword1.line == keyword2.line && keyword1.column == keyword2.column;
+  }
+
+  // Straightforward stack based matching over all keywords, to check the index against
+  struct ReferenceMatches {
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    explicit ReferenceMatches(const std::vector<BlockKeyword>& keywords) : partners(keywords.size(), NONE), owners(keywords.size(), NONE) {
+      std::map<BlockType, std::vector<size_t>> openBlocks;
+      std::map<BlockType, size_t> lastKeywords;
+      for (size_t index = 0; index < keywords.size(); ++index) {
+        const auto& keyword = keywords[index];
+        if (keyword.type == BlockType::If || keyword.type == BlockType::While) {
+          auto& blocks = openBlocks[keyword.type];
+          if (keyword.role == BlockRole::Open) {
+            blocks.push_back(index);
+          } else if (!blocks.empty()) {
+            if (keyword.role == BlockRole::Middle) {
+              owners[index] = blocks.back();
+            } else {
+              partners[index] = blocks.back();
+              partners[blocks.back()] = index;
+              blocks.pop_back();
+            }
+          }
+        } else {
+          auto iter = lastKeywords.find(keyword.type);
+          if (iter != lastKeywords.end() && keywords[iter->second].role == BlockRole::Open && keyword.role == BlockRole::Close) {
+            partners[index] = iter->second;
+            partners[iter->second] = index;
+          }
+          lastKeywords[keyword.type] = index;
+        }
+      }
+    }
+
+    std::vector<size_t> partners;
+    std::vector<size_t> owners;
+  };
+
+  // Check every keyword's match, and enclosing blocks around every keyword, against the reference
+  void checkAgainstReference(BlockIndex& blockIndex) {
+    std::vector<BlockKeyword> keywords;
+    REQUIRE(blockIndex.getKeywords(keywords));
+    ReferenceMatches reference(keywords);
+    for (size_t index = 0; index < keywords.size(); ++index) {
+      BlockMatch blockMatch;
+      REQUIRE(blockIndex.find(keywords[index].line, keywords[index].column, blockMatch));
+      size_t expected = (keywords[index].role == BlockRole::Middle) ? reference.owners[index] : reference.partners[index];
+      REQUIRE(blockMatch.matched == (expected != ReferenceMatches::NONE));
+      if (blockMatch.matched) {
+        REQUIRE(sameLocation(blockMatch.matching, keywords[expected]));
+      }
+
+      size_t opening = (keywords[index].role == BlockRole::Open) ? index : expected;
+      size_t expectedRelated = 0;
+      for (size_t middle = 0; middle < keywords.size(); ++middle) {
+        if (opening != ReferenceMatches::NONE && middle != index && reference.owners[middle] == opening) {
+          expectedRelated++;
+        }
+      }
+      if (keywords[index].role == BlockRole::Middle && opening != ReferenceMatches::NONE && reference.partners[opening] != ReferenceMatches::NONE) {
+        expectedRelated++;
+      }
+      REQUIRE(blockMatch.related.size() == expectedRelated);
+
+    }
+
+    // Enclosing blocks on, inside and right after every keyword, and at both ends of every line
+    std::vector<std::pair<Sci_Position, Sci_Position>> locations;
+    for (const auto& keyword : keywords) {
+      locations.emplace_back(keyword.line, keyword.column);
+      locations.emplace_back(keyword.line, keyword.column + 1);
+      locations.emplace_back(keyword.line, keyword.column + keyword.length);
+      locations.emplace_back(keyword.line, keyword.column + keyword.length + 1);
+    }
+    Sci_Position lastLine = keywords.empty() ? 0 : keywords.back().line + 1;
+    for (Sci_Position line = 0; line <= lastLine; ++line) {
+      locations.emplace_back(line, 0);
+      locations.emplace_back(line, 100);
+    }
+    for (const auto& [line, column] : locations) {
+      std::vector<BlockRange> blocks;
+      REQUIRE(blockIndex.findEnclosingBlocks(line, column, blocks));
+      size_t found = 0;
+      for (size_t opening = 0; opening < keywords.size(); ++opening) {
+        size_t closing = reference.partners[opening];
+        if (keywords[opening].role == BlockRole::Open && closing != ReferenceMatches::NONE
+          && std::tie(keywords[opening].line, keywords[opening].column) <= std::tie(line, column)
+          && std::tie(line, column) <= std::make_tuple(keywords[closing].line, keywords[closing].column + keywords[closing].length)) {
+          // Reference goes through keywords in document order, which is the order of blocks from outermost to innermost
+          REQUIRE(found < blocks.size());
+          CHECK(sameLocation(blocks[found].opening, keywords[opening]) && sameLocation(blocks[found].closing, keywords[closing]));
+          found++;
+        }
+      }
+      REQUIRE(blocks.size() == found);
+    }
+  }
+}
+
+TEST_CASE(matchesNestedBlocks) {
+  BlockIndex blockIndex;
+  blockIndex.reset(true);
+  add(blockIndex, keyword(0, 0, BlockType::Function, BlockRole::Open));
+  add(blockIndex, keyword(1, 2, BlockType::If, BlockRole::Open));
+  add(blockIndex, keyword(2, 4, BlockType::If, BlockRole::Open));
+  add(blockIndex, keyword(3, 4, BlockType::If, BlockRole::Close));
+  add(blockIndex, keyword(4, 2, BlockType::If, BlockRole::Middle));
+  add(blockIndex, keyword(5, 2, BlockType::If, BlockRole::Middle));
+  add(blockIndex, keyword(6, 2, BlockType::If, BlockRole::Close));
+  add(blockIndex, keyword(7, 0, BlockType::Function, BlockRole::Close));
+
+  BlockMatch blockMatch;
+  REQUIRE(blockIndex.find(1, 2, blockMatch));
+  CHECK(blockMatch.matched);
+  CHECK(blockMatch.matching.line == 6);
+  REQUIRE(blockMatch.related.size() == 2);
+  CHECK(blockMatch.related[0].line == 4);
+  CHECK(blockMatch.related[1].line == 5);
+
+  REQUIRE(blockIndex.find(4, 2, blockMatch));
+  CHECK(blockMatch.matched);
+  CHECK(blockMatch.matching.line == 1);
+  REQUIRE(blockMatch.related.size() == 2);
+  CHECK(blockMatch.related[0].line == 6);
+  CHECK(blockMatch.related[1].line == 5);
+
+  REQUIRE(blockIndex.find(3, 4, blockMatch));
+  CHECK(blockMatch.matching.line == 2);
+  CHECK(blockMatch.related.empty());
+
+  REQUIRE(blockIndex.find(7, 0, blockMatch));
+  CHECK(blockMatch.matching.line == 0);
+
+  std::vector<BlockRange> blocks;
+  REQUIRE(blockIndex.findEnclosingBlocks(2, 10, blocks));
+  REQUIRE(blocks.size() == 3);
+  CHECK(blocks[0].opening.line == 0);
+  CHECK(blocks[1].opening.line == 1);
+  CHECK(blocks[2].opening.line == 2);
+
+  std::vector<BlockKeyword> unbalancedKeywords;
+  REQUIRE(blockIndex.findUnbalancedKeywords(unbalancedKeywords));
+  CHECK(unbalancedKeywords.empty());
+}
+
+TEST_CASE(nativeEndsEventOnSameLine) {
+  BlockIndex blockIndex;
+  blockIndex.reset(true);
+  add(blockIndex, keyword(0, 0, BlockType::Event, BlockRole::Open));
+  add(blockIndex, keyword(0, 20, BlockType::Function, BlockRole::Close));
+
+  BlockMatch blockMatch;
+  REQUIRE(blockIndex.find(0, 20, blockMatch));
+  CHECK(blockMatch.current.type == BlockType::Event);
+  CHECK(blockMatch.matched);
+}
+
+TEST_CASE(reportsUnbalancedAndOverlappedKeywords) {
+  BlockIndex blockIndex;
+  blockIndex.reset(true);
+  add(blockIndex, keyword(0, 0, BlockType::If, BlockRole::Open));
+  add(blockIndex, keyword(1, 0, BlockType::While, BlockRole::Open));
+  add(blockIndex, keyword(2, 0, BlockType::If, BlockRole::Close));
+  add(blockIndex, keyword(3, 0, BlockType::While, BlockRole::Close));
+  add(blockIndex, keyword(4, 0, BlockType::If, BlockRole::Middle));
+  add(blockIndex, keyword(5, 0, BlockType::Function, BlockRole::Close));
+
+  std::vector<BlockKeyword> unbalancedKeywords;
+  REQUIRE(blockIndex.findUnbalancedKeywords(unbalancedKeywords));
+  CHECK(unbalancedKeywords.size() == 6);
+}
+
+TEST_CASE(keepsMatchesWhenLinesShift) {
+  BlockIndex blockIndex;
+  blockIndex.reset(true);
+  add(blockIndex, keyword(1, 0, BlockType::While, BlockRole::Open));
+  add(blockIndex, keyword(3, 0, BlockType::While, BlockRole::Close));
+  auto generation = blockIndex.getGeneration();
+
+  blockIndex.shiftLines(2, 5);
+  CHECK(blockIndex.getGeneration() != generation);
+  BlockMatch blockMatch;
+  REQUIRE(blockIndex.find(1, 0, blockMatch));
+  CHECK(blockMatch.matching.line == 8);
+
+  // Deleting the line with the closing keyword leaves the block open
+  blockIndex.shiftLines(7, -1);
+  REQUIRE(blockIndex.find(1, 0, blockMatch));
+  CHECK(!blockMatch.matched);
+}
+
+TEST_CASE(matchesReferenceAfterRandomEdits) {
+  constexpr BlockKeyword candidates[] {
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::If, .role = BlockRole::Open},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::If, .role = BlockRole::Middle},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::If, .role = BlockRole::Close},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::While, .role = BlockRole::Open},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::While, .role = BlockRole::Close},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::Function, .role = BlockRole::Open},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::Function, .role = BlockRole::Close},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::State, .role = BlockRole::Open},
+    {.line = 0, .column = 0, .length = 2, .type = BlockType::State, .role = BlockRole::Close}
+  };
+
+  BlockIndex blockIndex;
+  blockIndex.reset(true);
+  std::mt19937 random(7);
+  for (int step = 0; step < 300; ++step) {
+    Sci_Position line = random() % 60;
+    switch (random() % 3) {
+      case 0: {
+        // Relex a line
+        blockIndex.clearLine(line);
+        int count = random() % 3;
+        for (int column = 0; column < count; ++column) {
+          auto keyword = candidates[random() % std::size(candidates)];
+          keyword.line = line;
+          keyword.column = column * 10;
+          add(blockIndex, keyword);
+        }
+        break;
+      }
+
+      case 1:
+        blockIndex.shiftLines(line, static_cast<Sci_Position>(random() % 4) + 1);
+        break;
+
+      case 2:
+        blockIndex.shiftLines(line, -static_cast<Sci_Position>(random() % 4) - 1);
+        break;
+    }
+    checkAgainstReference(blockIndex);
+  }
+}
@@ -0,0 +1,166 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Lexer\IdentifierIndex.hpp"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace papyrus;
+
+namespace {
+  // Identifiers of each line, kept the way the index used to keep them, to check the index against
+  using ReferenceLines = std::map<Sci_Position, std::vector<std::pair<Sci_Position, std::string>>>;
+
+  void shiftReference(ReferenceLines& lines, Sci_Position line, Sci_Position linesAdded) {
+    ReferenceLines shiftedLines;
+    for (auto& [referenceLine, identifiers] : lines) {
+      if (referenceLine <= line) {
+        shiftedLines[referenceLine] = std::move(identifiers);
+      } else if (linesAdded > 0 || referenceLine > line - linesAdded) {
+        shiftedLines[referenceLine + linesAdded] = std::move(identifiers);
+      }
+    }
+    lines = std::move(shiftedLines);
+  }
+
+  void checkAgainstReference(IdentifierIndex& identifierIndex, const ReferenceLines& lines, const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+      std::vector<IdentifierOccurrence> expected;
+      for (const auto& [line, identifiers] : lines) {
+        for (const auto& [column, identifier] : identifiers) {
+          if (identifier == name) {
+            expected.push_back(IdentifierOccurrence {
+              .line = line,
+              .column = column,
+              .length = static_cast<Sci_Position>(identifier.length())
+            });
+          }
+        }
+      }
+
+      std::vector<IdentifierOccurrence> occurrences;
+      REQUIRE(identifierIndex.find(name, occurrences));
+      REQUIRE(occurrences.size() == expected.size());
+      for (size_t i = 0; i < expected.size(); ++i) {
+        CHECK(occurrences[i].line == expected[i].line && occurrences[i].column == expected[i].column && occurrences[i].length == expected[i].length);
+      }
+    }
+
+    std::vector<IndexedIdentifier> allIdentifiers;
+    REQUIRE(identifierIndex.getIdentifiers(allIdentifiers));
+    size_t index = 0;
+    for (const auto& [line, identifiers] : lines) {
+      for (const auto& [column, identifier] : identifiers) {
+        REQUIRE(index < allIdentifiers.size());
+        CHECK(allIdentifiers[index].line == line && allIdentifiers[index].column == column && allIdentifiers[index].identifier == identifier);
+        index++;
+      }
+    }
+    CHECK(index == allIdentifiers.size());
+  }
+}
+
+TEST_CASE(findsOccurrencesInDocumentOrder) {
+  IdentifierIndex identifierIndex;
+  identifierIndex.reset(true);
+  identifierIndex.addIdentifier(4, 8, "count");
+  identifierIndex.addIdentifier(1, 4, "count");
+  identifierIndex.addIdentifier(1, 12, "total");
+  identifierIndex.addIdentifier(1, 20, "count");
+
+  std::vector<IdentifierOccurrence> occurrences;
+  REQUIRE(identifierIndex.find("count", occurrences));
+  REQUIRE(occurrences.size() == 3);
+  CHECK(occurrences[0].line == 1 && occurrences[0].column == 4 && occurrences[0].length == 5);
+  CHECK(occurrences[1].line == 1 && occurrences[1].column == 20);
+  CHECK(occurrences[2].line == 4 && occurrences[2].column == 8);
+
+  REQUIRE(identifierIndex.find("missing", occurrences));
+  CHECK(occurrences.empty());
+
+  // Caret right after an identifier also counts
+  std::string identifier;
+  CHECK(identifierIndex.findAt(1, 17, identifier) && identifier == "total");
+  CHECK(!identifierIndex.findAt(1, 18, identifier));
+  CHECK(!identifierIndex.findAt(2, 4, identifier));
+}
+
+TEST_CASE(unusableIndexFindsNothing) {
+  IdentifierIndex identifierIndex;
+  identifierIndex.reset(false);
+  CHECK(!identifierIndex.isUsable());
+
+  std::vector<IdentifierOccurrence> occurrences;
+  std::vector<IndexedIdentifier> allIdentifiers;
+  std::string identifier;
+  CHECK(!identifierIndex.find("count", occurrences));
+  CHECK(!identifierIndex.findAt(0, 0, identifier));
+  CHECK(!identifierIndex.getIdentifiers(allIdentifiers));
+
+  identifierIndex.restore({{.line = 2, .column = 0, .identifier = "count"}});
+  CHECK(identifierIndex.isUsable());
+  REQUIRE(identifierIndex.find("count", occurrences));
+  CHECK(occurrences.size() == 1 && occurrences[0].line == 2);
+}
+
+TEST_CASE(matchesReferenceAfterRandomEdits) {
+  const std::vector<std::string> names {"a", "count", "self", "total", "update"};
+
+  IdentifierIndex identifierIndex;
+  identifierIndex.reset(true);
+  ReferenceLines lines;
+  std::mt19937 random(11);
+  for (int step = 0; step < 500; ++step) {
+    Sci_Position line = random() % 80;
+    switch (random() % 3) {
+      case 0: {
+        // Relex a line
+        identifierIndex.clearLine(line);
+        lines.erase(line);
+        int count = random() % 4;
+        for (int i = 0; i < count; ++i) {
+          const auto& name = names[random() % names.size()];
+          identifierIndex.addIdentifier(line, i * 10, name);
+          lines[line].emplace_back(i * 10, name);
+        }
+        break;
+      }
+
+      case 1: {
+        auto linesAdded = static_cast<Sci_Position>(random() % 4) + 1;
+        identifierIndex.shiftLines(line, linesAdded);
+        shiftReference(lines, line, linesAdded);
+        break;
+      }
+
+      case 2: {
+        auto linesAdded = -static_cast<Sci_Position>(random() % 4) - 1;
+        identifierIndex.shiftLines(line, linesAdded);
+        shiftReference(lines, line, linesAdded);
+        break;
+      }
+    }
+    checkAgainstReference(identifierIndex, lines, names);
+  }
+}
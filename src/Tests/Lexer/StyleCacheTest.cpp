@@ -0,0 +1,178 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "..\Test.hpp"
+
+#include "..\..\Plugin\Lexer\StyleCache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace papyrus;
+
+namespace {
+  constexpr uint64_t KEY = 0x0123456789ABCDEFULL;
+
+  StyleCacheEntry createEntry() {
+    StyleCacheEntry entry {
+      .styles = std::vector<char>(100, 3),
+      .foldLevels = {0x400, 0x2401, 0x401},
+      .scriptName = "MyMod:QuestScript",
+      .parentScriptName = "Quest",
+      .properties = {{"count", 2}},
+      .inheritedPropertiesHash = 0xFEEDFACECAFEBEEFULL,
+      .blockKeywords = {
+        {.line = 1, .column = 0, .length = 8, .type = BlockType::Function, .role = BlockRole::Open, .nameColumn = 9, .nameLength = 6},
+        {.line = 3, .column = 2, .length = 2, .type = BlockType::If, .role = BlockRole::Open},
+        {.line = 5, .column = 2, .length = 4, .type = BlockType::If, .role = BlockRole::Middle},
+        {.line = 7, .column = 2, .length = 5, .type = BlockType::If, .role = BlockRole::Close},
+        {.line = 8, .column = 0, .length = 11, .type = BlockType::Function, .role = BlockRole::Close}
+      },
+      .identifiersIndexed = true,
+      .identifiers = {
+        {.line = 1, .column = 9, .identifier = "update"},
+        {.line = 3, .column = 5, .identifier = "count"},
+        {.line = 4, .column = 4, .identifier = "count"}
+      }
+    };
+    return entry;
+  }
+
+  std::filesystem::path entryFile(const std::filesystem::path& directory) {
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+      return entry.path();
+    }
+    return std::filesystem::path();
+  }
+}
+
+TEST_CASE(restoresIndexesAlongWithStyles) {
+  test::TemporaryDirectory directory;
+  auto storedEntry = createEntry();
+  StyleCache::store(directory.path().wstring(), KEY, storedEntry, 10);
+
+  StyleCacheEntry loadedEntry;
+  REQUIRE(StyleCache::load(directory.path().wstring(), KEY, storedEntry.styles.size(), loadedEntry));
+  CHECK(loadedEntry.styles == storedEntry.styles);
+  CHECK(loadedEntry.foldLevels == storedEntry.foldLevels);
+  CHECK(loadedEntry.scriptName == storedEntry.scriptName);
+  CHECK(loadedEntry.parentScriptName == storedEntry.parentScriptName);
+  CHECK(loadedEntry.properties == storedEntry.properties);
+  CHECK(loadedEntry.inheritedPropertiesHash == storedEntry.inheritedPropertiesHash);
+
+  REQUIRE(loadedEntry.blockKeywords.size() == storedEntry.blockKeywords.size());
+  for (size_t i = 0; i < storedEntry.blockKeywords.size(); ++i) {
+    const auto& stored = storedEntry.blockKeywords[i];
+    const auto& loaded = loadedEntry.blockKeywords[i];
+    CHECK(loaded.line == stored.line && loaded.column == stored.column && loaded.length == stored.length);
+    CHECK(loaded.type == stored.type && loaded.role == stored.role);
+    CHECK(loaded.nameColumn == stored.nameColumn && loaded.nameLength == stored.nameLength);
+  }
+
+  CHECK(loadedEntry.identifiersIndexed);
+  REQUIRE(loadedEntry.identifiers.size() == storedEntry.identifiers.size());
+  for (size_t i = 0; i < storedEntry.identifiers.size(); ++i) {
+    CHECK(loadedEntry.identifiers[i].line == storedEntry.identifiers[i].line);
+    CHECK(loadedEntry.identifiers[i].column == storedEntry.identifiers[i].column);
+    CHECK(loadedEntry.identifiers[i].identifier == storedEntry.identifiers[i].identifier);
+  }
+}
+
+TEST_CASE(restoredKeywordsAreUsableByIndex) {
+  test::TemporaryDirectory directory;
+  auto storedEntry = createEntry();
+  StyleCache::store(directory.path().wstring(), KEY, storedEntry, 10);
+  StyleCacheEntry loadedEntry;
+  REQUIRE(StyleCache::load(directory.path().wstring(), KEY, storedEntry.styles.size(), loadedEntry));
+
+  BlockIndex blockIndex;
+  blockIndex.restore(loadedEntry.blockKeywords);
+  BlockMatch blockMatch;
+  REQUIRE(blockIndex.find(3, 2, blockMatch));
+  CHECK(blockMatch.matched && blockMatch.matching.line == 7);
+  CHECK(blockMatch.related.size() == 1 && blockMatch.related[0].line == 5);
+
+  IdentifierIndex identifierIndex;
+  identifierIndex.restore(loadedEntry.identifiers);
+  std::vector<IdentifierOccurrence> occurrences;
+  REQUIRE(identifierIndex.find("count", occurrences));
+  CHECK(occurrences.size() == 2);
+}
+
+TEST_CASE(remembersIdentifiersWereNotIndexed) {
+  test::TemporaryDirectory directory;
+  auto storedEntry = createEntry();
+  storedEntry.identifiersIndexed = false;
+  storedEntry.identifiers.clear();
+  StyleCache::store(directory.path().wstring(), KEY, storedEntry, 10);
+
+  StyleCacheEntry loadedEntry;
+  REQUIRE(StyleCache::load(directory.path().wstring(), KEY, storedEntry.styles.size(), loadedEntry));
+  CHECK(!loadedEntry.identifiersIndexed);
+  CHECK(loadedEntry.identifiers.empty());
+}
+
+TEST_CASE(rejectsMismatchingEntries) {
+  test::TemporaryDirectory directory;
+  auto storedEntry = createEntry();
+  StyleCache::store(directory.path().wstring(), KEY, storedEntry, 10);
+
+  StyleCacheEntry loadedEntry;
+  CHECK(!StyleCache::load(directory.path().wstring(), KEY + 1, storedEntry.styles.size(), loadedEntry));
+  CHECK(!StyleCache::load(directory.path().wstring(), KEY, storedEntry.styles.size() + 1, loadedEntry));
+}
+
+TEST_CASE(rejectsTruncatedEntries) {
+  test::TemporaryDirectory directory;
+  auto storedEntry = createEntry();
+  StyleCache::store(directory.path().wstring(), KEY, storedEntry, 10);
+  auto filePath = entryFile(directory.path());
+  REQUIRE(!filePath.empty());
+
+  auto fileSize = std::filesystem::file_size(filePath);
+  for (auto size : {fileSize - 1, fileSize / 2, static_cast<uintmax_t>(20)}) {
+    std::filesystem::resize_file(filePath, size);
+    StyleCacheEntry loadedEntry;
+    CHECK(!StyleCache::load(directory.path().wstring(), KEY, storedEntry.styles.size(), loadedEntry));
+  }
+}
+
+TEST_CASE(rejectsCorruptedCounts) {
+  test::TemporaryDirectory directory;
+  auto storedEntry = createEntry();
+  storedEntry.identifiers.clear();
+  StyleCache::store(directory.path().wstring(), KEY, storedEntry, 10);
+  auto filePath = entryFile(directory.path());
+  REQUIRE(!filePath.empty());
+
+  // Identifiers count is the last field when there's no identifier. A huge count must not be trusted.
+  auto fileSize = std::filesystem::file_size(filePath);
+  {
+    std::fstream file(filePath, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(fileSize - sizeof(uint32_t)));
+    uint32_t count = 0xFFFFFFFF;
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  }
+
+  StyleCacheEntry loadedEntry;
+  CHECK(!StyleCache::load(directory.path().wstring(), KEY, storedEntry.styles.size(), loadedEntry));
+}
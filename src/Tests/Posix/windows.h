@@ -0,0 +1,83 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Minimal stand-in of windows.h for building headless tests on other platforms. It only declares what tested sources use, and
+// functions declared here are implemented by test support code when a test needs them.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define __cdecl
+#define __stdcall
+#define __declspec(x)
+#define CALLBACK
+#define WINAPI
+
+using BYTE = std::uint8_t;
+using UCHAR = unsigned char;
+using WORD = std::uint16_t;
+using DWORD = std::uint32_t;
+using UINT = unsigned int;
+using BOOL = int;
+using LONG = std::int32_t;
+using ULONG = std::uint32_t;
+using COLORREF = DWORD;
+using TCHAR = wchar_t;
+using WCHAR = wchar_t;
+using LPCWSTR = const wchar_t*;
+using LPWSTR = wchar_t*;
+using UINT_PTR = std::uintptr_t;
+using LONG_PTR = std::intptr_t;
+using WPARAM = UINT_PTR;
+using LPARAM = LONG_PTR;
+using LRESULT = LONG_PTR;
+
+using HANDLE = void*;
+using HBITMAP = void*;
+using HICON = void*;
+using HINSTANCE = void*;
+using HMENU = void*;
+struct HWND__;
+using HWND = HWND__*;
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define WM_USER 0x0400
+
+#define RGB(r, g, b) ((COLORREF)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+
+struct RECT {
+  LONG left;
+  LONG top;
+  LONG right;
+  LONG bottom;
+};
+
+struct NMHDR {
+  HWND hwndFrom;
+  UINT_PTR idFrom;
+  UINT code;
+};
+
+LRESULT SendMessage(HWND handle, UINT message, WPARAM wParam, LPARAM lParam);
+BOOL PostMessage(HWND handle, UINT message, WPARAM wParam, LPARAM lParam);
@@ -0,0 +1,47 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "..\..\Plugin\Lexer\LexerData.hpp"
+#include "..\..\Plugin\Lexer\LexerSettings.hpp"
+
+#include "..\..\external\npp\PluginInterface.h"
+
+namespace test {
+
+  // Provides global lexer data that lexers read settings from, the way plugin does when Notepad++ loads it. There can only be
+  // one environment at a time.
+  class LexerEnvironment {
+    public:
+      explicit LexerEnvironment(papyrus::Game game = papyrus::Game::Auto);
+      ~LexerEnvironment();
+
+      // Disable all copy/move constructors/assignment operators
+      LexerEnvironment(LexerEnvironment&& other) = delete;
+
+      inline papyrus::LexerSettings& settings() noexcept { return lexerSettings; }
+
+    private:
+      NppData nppData {};
+      papyrus::LexerSettings lexerSettings {};
+  };
+
+} // namespace
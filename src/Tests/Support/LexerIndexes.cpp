@@ -0,0 +1,63 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "LexerIndexes.hpp"
+
+#include "..\..\Plugin\Lexer\Lexer.hpp"
+
+#include <map>
+#include <mutex>
+
+namespace test {
+
+  namespace {
+    std::mutex indexMapMutex;
+    std::map<npp_buffer_t, std::shared_ptr<papyrus::BlockIndex>> blockIndexMap;
+    std::map<npp_buffer_t, std::shared_ptr<papyrus::IdentifierIndex>> identifierIndexMap;
+  }
+
+  void setBlockIndex(npp_buffer_t bufferID, std::shared_ptr<papyrus::BlockIndex> blockIndex) {
+    std::lock_guard<std::mutex> lock(indexMapMutex);
+    blockIndexMap[bufferID] = std::move(blockIndex);
+  }
+
+  void setIdentifierIndex(npp_buffer_t bufferID, std::shared_ptr<papyrus::IdentifierIndex> identifierIndex) {
+    std::lock_guard<std::mutex> lock(indexMapMutex);
+    identifierIndexMap[bufferID] = std::move(identifierIndex);
+  }
+
+} // namespace
+
+namespace papyrus {
+
+  // Normally defined by lexer, along with the rest of it
+  std::shared_ptr<BlockIndex> Lexer::getBlockIndex(npp_buffer_t bufferID) {
+    std::lock_guard<std::mutex> lock(test::indexMapMutex);
+    auto iter = test::blockIndexMap.find(bufferID);
+    return (iter != test::blockIndexMap.end()) ? iter->second : nullptr;
+  }
+
+  std::shared_ptr<IdentifierIndex> Lexer::getIdentifierIndex(npp_buffer_t bufferID) {
+    std::lock_guard<std::mutex> lock(test::indexMapMutex);
+    auto iter = test::identifierIndexMap.find(bufferID);
+    return (iter != test::identifierIndexMap.end()) ? iter->second : nullptr;
+  }
+
+} // namespace
@@ -0,0 +1,36 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "..\..\Plugin\Common\NotepadPlusPlus.hpp"
+#include "..\..\Plugin\Lexer\BlockIndex.hpp"
+#include "..\..\Plugin\Lexer\IdentifierIndex.hpp"
+
+#include <memory>
+
+namespace test {
+
+  // Stand-in of the lexer's indexes by buffer, which features look up through Lexer::getBlockIndex and
+  // Lexer::getIdentifierIndex. Tests register indexes they build themselves, instead of lexing with the Papyrus lexer.
+  void setBlockIndex(npp_buffer_t bufferID, std::shared_ptr<papyrus::BlockIndex> blockIndex);
+  void setIdentifierIndex(npp_buffer_t bufferID, std::shared_ptr<papyrus::IdentifierIndex> identifierIndex);
+
+} // namespace
@@ -0,0 +1,66 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestCompiler.hpp"
+
+#include "..\..\Plugin\Compiler\Compiler.hpp"
+
+#include <mutex>
+#include <utility>
+
+namespace test {
+
+  namespace {
+    std::mutex startedRequestsMutex;
+    std::vector<std::vector<papyrus::CompilationRequest>> startedRequests;
+  }
+
+  std::vector<std::vector<papyrus::CompilationRequest>> takeStartedRequests() {
+    std::lock_guard<std::mutex> lock(startedRequestsMutex);
+    return std::exchange(startedRequests, {});
+  }
+
+} // namespace
+
+namespace papyrus {
+
+  // Normally defined by compiler, along with the rest of it
+  Compiler::Compiler(HWND messageWindow, const CompilerSettings& settings)
+   : messageWindow(messageWindow), settings(settings) {
+  }
+
+  Compiler::~Compiler() {
+  }
+
+  void Compiler::start(const CompilationRequest& request) {
+    start(std::vector<CompilationRequest> {request});
+  }
+
+  void Compiler::start(const std::vector<CompilationRequest>& requests) {
+    std::lock_guard<std::mutex> lock(test::startedRequestsMutex);
+    test::startedRequests.push_back(requests);
+  }
+
+  void Compiler::cancelAll() {
+  }
+
+  void Compiler::stop() {
+  }
+
+} // namespace
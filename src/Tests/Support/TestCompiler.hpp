@@ -0,0 +1,32 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\..\Plugin\Compiler\CompilationRequest.hpp"
+
+#include <vector>
+
+namespace test {
+
+  // Stand-in of compiler, which batch builder queues requests with. Compiler's methods are defined by test support code to
+  // record the groups of requests started, instead of running compiler processes, so tests hand results back themselves.
+  std::vector<std::vector<papyrus::CompilationRequest>> takeStartedRequests();
+
+} // namespace
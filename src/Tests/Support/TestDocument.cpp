@@ -0,0 +1,196 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "TestDocument.hpp"
+
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace test {
+
+  TestDocument::TestDocument(std::string_view text) {
+    setText(text);
+  }
+
+  void TestDocument::setText(std::string_view text) {
+    content = text;
+    styles.assign(content.size(), 0);
+    updateLineStarts();
+    levels.assign(lineStarts.size(), SC_FOLDLEVELBASE);
+    lineStates.assign(lineStarts.size(), 0);
+    stylingPosition = styledEnd = 0;
+  }
+
+  void TestDocument::insertText(Sci_Position position, std::string_view text) {
+    Sci_Position line = LineFromPosition(position);
+    Sci_Position linesBefore = lineCount();
+    content.insert(static_cast<size_t>(position), text);
+    styles.insert(styles.begin() + position, text.size(), 0);
+    updateLineStarts();
+
+    // New lines take the level and state of the line they are split from
+    Sci_Position linesAdded = lineCount() - linesBefore;
+    levels.insert(levels.begin() + line + 1, static_cast<size_t>(linesAdded), levels[static_cast<size_t>(line)]);
+    lineStates.insert(lineStates.begin() + line + 1, static_cast<size_t>(linesAdded), lineStates[static_cast<size_t>(line)]);
+    styledEnd = std::min(styledEnd, LineStart(line));
+  }
+
+  void TestDocument::deleteText(Sci_Position position, Sci_Position length) {
+    Sci_Position line = LineFromPosition(position);
+    Sci_Position linesBefore = lineCount();
+    content.erase(static_cast<size_t>(position), static_cast<size_t>(length));
+    styles.erase(styles.begin() + position, styles.begin() + position + length);
+    updateLineStarts();
+
+    Sci_Position linesDeleted = linesBefore - lineCount();
+    levels.erase(levels.begin() + line + 1, levels.begin() + line + 1 + linesDeleted);
+    lineStates.erase(lineStates.begin() + line + 1, lineStates.begin() + line + 1 + linesDeleted);
+    styledEnd = std::min(styledEnd, LineStart(line));
+  }
+
+  Sci_Position TestDocument::find(std::string_view text, Sci_Position startPosition) const {
+    auto position = content.find(text, static_cast<size_t>(startPosition));
+    return (position == std::string::npos) ? -1 : static_cast<Sci_Position>(position);
+  }
+
+  void SCI_METHOD TestDocument::GetCharRange(char* buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+    // Like Scintilla, positions outside of the document read as nulls
+    for (Sci_Position i = 0; i < lengthRetrieve; ++i) {
+      Sci_Position charPosition = position + i;
+      buffer[i] = (charPosition >= 0 && charPosition < Length()) ? content[static_cast<size_t>(charPosition)] : '\0';
+    }
+  }
+
+  char SCI_METHOD TestDocument::StyleAt(Sci_Position position) const {
+    return (position >= 0 && position < Length()) ? styles[static_cast<size_t>(position)] : 0;
+  }
+
+  Sci_Position SCI_METHOD TestDocument::LineFromPosition(Sci_Position position) const {
+    auto iter = std::upper_bound(lineStarts.begin(), lineStarts.end(), std::max<Sci_Position>(position, 0));
+    return static_cast<Sci_Position>(iter - lineStarts.begin()) - 1;
+  }
+
+  Sci_Position SCI_METHOD TestDocument::LineStart(Sci_Position line) const {
+    if (line < 0) {
+      return 0;
+    }
+    return (line < lineCount()) ? lineStarts[static_cast<size_t>(line)] : Length();
+  }
+
+  int SCI_METHOD TestDocument::GetLevel(Sci_Position line) const {
+    return (line >= 0 && line < lineCount()) ? levels[static_cast<size_t>(line)] : SC_FOLDLEVELBASE;
+  }
+
+  int SCI_METHOD TestDocument::SetLevel(Sci_Position line, int level) {
+    if (line < 0 || line >= lineCount()) {
+      return SC_FOLDLEVELBASE;
+    }
+    return std::exchange(levels[static_cast<size_t>(line)], level);
+  }
+
+  int SCI_METHOD TestDocument::GetLineState(Sci_Position line) const {
+    return (line >= 0 && line < lineCount()) ? lineStates[static_cast<size_t>(line)] : 0;
+  }
+
+  int SCI_METHOD TestDocument::SetLineState(Sci_Position line, int state) {
+    if (line < 0 || line >= lineCount()) {
+      return 0;
+    }
+    return std::exchange(lineStates[static_cast<size_t>(line)], state);
+  }
+
+  void SCI_METHOD TestDocument::StartStyling(Sci_Position position) {
+    stylingPosition = position;
+  }
+
+  bool SCI_METHOD TestDocument::SetStyleFor(Sci_Position length, char style) {
+    if (stylingPosition < 0 || stylingPosition + length > Length()) {
+      return false;
+    }
+    std::fill_n(styles.begin() + stylingPosition, length, style);
+    stylingPosition += length;
+    styledEnd = std::max(styledEnd, stylingPosition);
+    return true;
+  }
+
+  bool SCI_METHOD TestDocument::SetStyles(Sci_Position length, const char* newStyles) {
+    if (stylingPosition < 0 || stylingPosition + length > Length()) {
+      return false;
+    }
+    std::copy_n(newStyles, length, styles.begin() + stylingPosition);
+    stylingPosition += length;
+    styledEnd = std::max(styledEnd, stylingPosition);
+    return true;
+  }
+
+  int SCI_METHOD TestDocument::GetLineIndentation(Sci_Position line) {
+    int indentation = 0;
+    for (Sci_Position position = LineStart(line); position < LineEnd(line); ++position) {
+      char ch = content[static_cast<size_t>(position)];
+      if (ch == ' ') {
+        indentation++;
+      } else if (ch == '\t') {
+        indentation = (indentation / 4 + 1) * 4;
+      } else {
+        break;
+      }
+    }
+    return indentation;
+  }
+
+  Sci_Position SCI_METHOD TestDocument::LineEnd(Sci_Position line) const {
+    Sci_Position position = LineStart(line + 1);
+    if (line + 1 < lineCount()) {
+      // Exclude line end characters
+      while (position > LineStart(line) && (content[static_cast<size_t>(position - 1)] == '\n' || content[static_cast<size_t>(position - 1)] == '\r')) {
+        position--;
+      }
+    }
+    return position;
+  }
+
+  Sci_Position SCI_METHOD TestDocument::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
+    Sci_Position position = positionStart + characterOffset;
+    return (position >= 0 && position <= Length()) ? position : -1;
+  }
+
+  int SCI_METHOD TestDocument::GetCharacterAndWidth(Sci_Position position, Sci_Position* pWidth) const {
+    if (pWidth != nullptr) {
+      *pWidth = 1;
+    }
+    return (position >= 0 && position < Length()) ? static_cast<unsigned char>(content[static_cast<size_t>(position)]) : 0;
+  }
+
+  // Private methods
+  //
+
+  void TestDocument::updateLineStarts() {
+    // Lines are separated by "\n", with an optional "\r" before it, which is what Papyrus scripts use
+    lineStarts.assign(1, 0);
+    for (size_t position = 0; position < content.size(); ++position) {
+      if (content[position] == '\n') {
+        lineStarts.push_back(static_cast<Sci_Position>(position + 1));
+      }
+    }
+  }
+
+} // namespace
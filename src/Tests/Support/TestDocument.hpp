@@ -0,0 +1,92 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "..\..\external\scintilla\ILexer.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace test {
+
+  // In-memory stand-in of a Scintilla document, so lexers can be driven without Scintilla. It keeps text, styles, fold levels
+  // and line states, and supports editing so that incremental lexing can be exercised as well.
+  class TestDocument : public Scintilla::IDocument {
+    public:
+      explicit TestDocument(std::string_view text = std::string_view());
+
+      // Replace all text. Styles, fold levels and line states are discarded.
+      void setText(std::string_view text);
+
+      // Insert or delete text. Styles and line data after the change move with the text, and styling becomes invalid from the
+      // start of the changed line, like Scintilla does.
+      void insertText(Sci_Position position, std::string_view text);
+      void deleteText(Sci_Position position, Sci_Position length);
+
+      inline const std::string& text() const noexcept { return content; }
+      inline Sci_Position lineCount() const noexcept { return static_cast<Sci_Position>(lineStarts.size()); }
+      inline Sci_Position endStyled() const noexcept { return styledEnd; }
+
+      // Position of the first occurrence of given text at or after a position, or -1 if not found
+      Sci_Position find(std::string_view text, Sci_Position startPosition = 0) const;
+
+      // IDocument interface
+      int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+      void SCI_METHOD SetErrorStatus(int) override {}
+      Sci_Position SCI_METHOD Length() const override { return static_cast<Sci_Position>(content.size()); }
+      void SCI_METHOD GetCharRange(char* buffer, Sci_Position position, Sci_Position lengthRetrieve) const override;
+      char SCI_METHOD StyleAt(Sci_Position position) const override;
+      Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override;
+      Sci_Position SCI_METHOD LineStart(Sci_Position line) const override;
+      int SCI_METHOD GetLevel(Sci_Position line) const override;
+      int SCI_METHOD SetLevel(Sci_Position line, int level) override;
+      int SCI_METHOD GetLineState(Sci_Position line) const override;
+      int SCI_METHOD SetLineState(Sci_Position line, int state) override;
+      void SCI_METHOD StartStyling(Sci_Position position) override;
+      bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override;
+      bool SCI_METHOD SetStyles(Sci_Position length, const char* styles) override;
+      void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+      void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override {}
+      void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+      int SCI_METHOD CodePage() const override { return 65001; }
+      bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+      const char* SCI_METHOD BufferPointer() override { return content.c_str(); }
+      int SCI_METHOD GetLineIndentation(Sci_Position line) override;
+      Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override;
+      Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override;
+      int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position* pWidth) const override;
+
+    private:
+      void updateLineStarts();
+
+      // Private members
+      //
+      std::string content;
+      std::vector<char> styles;
+      std::vector<Sci_Position> lineStarts;
+      std::vector<int> levels;
+      std::vector<int> lineStates;
+      Sci_Position stylingPosition {0};
+      Sci_Position styledEnd {0};
+  };
+
+} // namespace
@@ -0,0 +1,231 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestPex.hpp"
+
+#include <cstring>
+#include <map>
+#include <string_view>
+#include <vector>
+
+namespace test {
+
+  namespace {
+    constexpr uint8_t OPCODE_IADD = 0x01;
+    constexpr uint8_t OPCODE_CALLMETHOD = 0x17;
+    constexpr uint8_t OPCODE_RETURN = 0x1A;
+
+    // Writes PEX data in a byte order. Strings are written as indexes into a string table the writer builds along the way.
+    class PexWriter {
+      public:
+        PexWriter(bool isBigEndian, std::map<std::string, uint16_t, std::less<>>& stringIndexes, std::vector<std::string>& strings)
+          : isBigEndian(isBigEndian), stringIndexes(stringIndexes), strings(strings) {
+        }
+
+        inline const std::string& data() const { return content; }
+
+        inline void u8(uint8_t value) { content += static_cast<char>(value); }
+        inline void u16(uint16_t value) { number(value, 2); }
+        inline void u32(uint32_t value) { number(value, 4); }
+        inline void u64(uint64_t value) { number(value, 8); }
+        inline void bytes(std::string_view data) { content += data; }
+
+        // A string written in place, as in header and string table
+        void inlineString(std::string_view str) {
+          u16(static_cast<uint16_t>(str.size()));
+          bytes(str);
+        }
+
+        void string(std::string_view str) {
+          auto iter = stringIndexes.find(str);
+          if (iter == stringIndexes.end()) {
+            iter = stringIndexes.emplace(std::string(str), static_cast<uint16_t>(strings.size())).first;
+            strings.emplace_back(str);
+          }
+          u16(iter->second);
+        }
+
+        void noneValue() { u8(0); }
+        void identifierValue(std::string_view identifier) { u8(1); string(identifier); }
+        void stringValue(std::string_view str) { u8(2); string(str); }
+        void integerValue(int32_t value) { u8(3); u32(static_cast<uint32_t>(value)); }
+        void floatValue(float value) {
+          uint32_t bits;
+          std::memcpy(&bits, &value, sizeof(bits));
+          u8(4);
+          u32(bits);
+        }
+
+        void function(std::string_view returnType, int loops) {
+          string(returnType);
+          string(""); // Doc string
+          u32(0);     // User flags
+          u8(0);      // Flags
+          u16(1);
+          string("value");
+          string("Int");
+          u16(1);
+          string("temp");
+          string("Int");
+          u16(static_cast<uint16_t>(loops * 2 + 1));
+          for (int loop = 0; loop < loops; ++loop) {
+            u8(OPCODE_IADD);
+            identifierValue("temp");
+            identifierValue("value");
+            integerValue(loop);
+            u8(OPCODE_CALLMETHOD);
+            stringValue("SetValue");
+            identifierValue("self");
+            identifierValue("::NoneVar");
+            integerValue(2); // Number of variable arguments
+            identifierValue("temp");
+            floatValue(1.5f);
+          }
+          u8(OPCODE_RETURN);
+          identifierValue("temp");
+        }
+
+      private:
+        void number(uint64_t value, int size) {
+          for (int i = 0; i < size; ++i) {
+            int shift = (isBigEndian ? size - 1 - i : i) * 8;
+            content += static_cast<char>((value >> shift) & 0xFF);
+          }
+        }
+
+        bool isBigEndian;
+        std::map<std::string, uint16_t, std::less<>>& stringIndexes;
+        std::vector<std::string>& strings;
+        std::string content;
+    };
+  }
+
+  std::string buildPex(uint16_t gameID, int functionCount) {
+    bool isFallout4 = (gameID == papyrus::FALLOUT4_GAME_ID);
+    bool isBigEndian = !isFallout4;
+    std::map<std::string, uint16_t, std::less<>> stringIndexes;
+    std::vector<std::string> strings;
+
+    // Everything after string table is written first, so the table is complete when it's written
+    PexWriter body(isBigEndian, stringIndexes, strings);
+    body.u8(1); // Has debug info
+    body.u64(1700000000);
+    body.u16(static_cast<uint16_t>(functionCount));
+    for (int function = 0; function < functionCount; ++function) {
+      body.string("MyScript");
+      body.string("");
+      body.string("Update" + std::to_string(function));
+      body.u8(0);
+      body.u16(PEX_INSTRUCTIONS_PER_FUNCTION);
+      for (int instruction = 0; instruction < PEX_INSTRUCTIONS_PER_FUNCTION; ++instruction) {
+        body.u16(static_cast<uint16_t>(10 + instruction));
+      }
+    }
+    if (isFallout4) {
+      body.u16(1);
+      body.string("MyScript");
+      body.string("Settings");
+      body.string("Group doc");
+      body.u32(1);
+      body.u16(1);
+      body.string("Count");
+      body.u16(1);
+      body.string("MyScript");
+      body.string("Point");
+      body.u16(1);
+      body.string("X");
+    }
+
+    body.u16(2);
+    body.string("hidden");
+    body.u8(0);
+    body.string("conditional");
+    body.u8(1);
+
+    // Object data is preceded by its size
+    PexWriter object(isBigEndian, stringIndexes, strings);
+    object.string("Form");
+    object.string("Test script");
+    if (isFallout4) {
+      object.u8(1);
+    }
+    object.u32(5);
+    object.string(""); // Auto state
+    if (isFallout4) {
+      object.u16(1);
+      object.string("Point");
+      object.u16(1);
+      object.string("X");
+      object.string("Int");
+      object.u32(0);
+      object.integerValue(7);
+      object.u8(0);
+      object.string("X coordinate");
+    }
+    object.u16(1);
+    object.string("::Count_var");
+    object.string("Int");
+    object.u32(0);
+    object.integerValue(42);
+    if (isFallout4) {
+      object.u8(0);
+    }
+    object.u16(2);
+    object.string("Count");
+    object.string("Int");
+    object.string("");
+    object.u32(0);
+    object.u8(0x07); // Read, write and auto
+    object.string("::Count_var");
+    object.string("Name");
+    object.string("String");
+    object.string("");
+    object.u32(0);
+    object.u8(0x03); // Read and write
+    object.function("String", 1);
+    object.function("None", 0);
+    object.u16(1);
+    object.string("");
+    object.u16(static_cast<uint16_t>(functionCount));
+    for (int function = 0; function < functionCount; ++function) {
+      object.string("Update" + std::to_string(function));
+      object.function("Int", PEX_LOOPS_PER_FUNCTION);
+    }
+    body.u16(1);
+    body.string("MyScript");
+    body.u32(static_cast<uint32_t>(object.data().size() + 4));
+    body.bytes(object.data());
+
+    PexWriter pex(isBigEndian, stringIndexes, strings);
+    pex.bytes(isBigEndian ? std::string_view("\xFA\x57\xC0\xDE", 4) : std::string_view("\xDE\xC0\x57\xFA", 4));
+    pex.u8(3);
+    pex.u8(isFallout4 ? 9 : 2);
+    pex.u16(gameID);
+    pex.u64(1700000001);
+    pex.inlineString(PEX_SOURCE_FILE_NAME);
+    pex.inlineString(PEX_USER_NAME);
+    pex.inlineString(PEX_MACHINE_NAME);
+    pex.u16(static_cast<uint16_t>(strings.size()));
+    for (const auto& str : strings) {
+      pex.inlineString(str);
+    }
+    return pex.data() + body.data();
+  }
+
+} // namespace
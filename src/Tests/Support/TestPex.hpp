@@ -0,0 +1,47 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "..\..\Plugin\Compiler\PexReader.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace test {
+
+  // Header fields of synthetic PEX files, which anonymizer overwrites
+  constexpr char PEX_SOURCE_FILE_NAME[] = "C:\\Mods\\Scripts\\Source\\MyScript.psc";
+  constexpr char PEX_USER_NAME[] = "modder";
+  constexpr char PEX_MACHINE_NAME[] = "MODDING-PC";
+
+  // Each function repeats an addition and a method call this many times before returning
+  constexpr int PEX_LOOPS_PER_FUNCTION = 5;
+  constexpr int PEX_INSTRUCTIONS_PER_FUNCTION = PEX_LOOPS_PER_FUNCTION * 2 + 1;
+
+  // Build a compiled script in the layout and byte order compiler uses for the given game (papyrus::SKYRIM_GAME_ID or
+  // papyrus::FALLOUT4_GAME_ID). Object "MyScript" extends "Form", with user flags 5 and user flags "hidden" and "conditional"
+  // defined. It has an Int variable "::Count_var" set to 42, an auto property "Count" backed by it, and a String property
+  // "Name" with read and write handlers. Its empty state has functions "Update0", "Update1" and so on, each taking an Int
+  // "value" and using an Int local "temp", with debug info giving the instructions of each function lines from 10 on. Fallout 4
+  // scripts are const, and also have struct "Point" with Int member "X" set to 7, property group "Settings" with "Count" in it,
+  // and struct order of "Point".
+  std::string buildPex(uint16_t gameID, int functionCount);
+
+} // namespace
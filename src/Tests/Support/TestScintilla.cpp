@@ -0,0 +1,236 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "TestScintilla.hpp"
+
+#include "..\..\external\scintilla\Scintilla.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+namespace test {
+
+  TestScintilla::TestScintilla(TestDocument& document)
+    : doc(document), window([this](UINT message, WPARAM wParam, LPARAM lParam) { return handleMessage(message, wParam, lParam); }) {
+  }
+
+  int TestScintilla::indicatorValueAt(int indicatorID, Sci_Position position) const {
+    auto iter = indicators.find(indicatorID);
+    if (iter == indicators.end() || position < 0 || position >= doc.Length()) {
+      return 0;
+    }
+    return std::prev(iter->second.upper_bound(position))->second;
+  }
+
+  // Private methods
+  //
+
+  LRESULT TestScintilla::handleMessage(UINT message, WPARAM wParam, LPARAM lParam) {
+    Sci_Position length = doc.Length();
+    auto clamp = [&](Sci_Position position) { return std::clamp<Sci_Position>(position, 0, length); };
+    switch (message) {
+      case SCI_GETLENGTH:
+      case SCI_GETTEXTLENGTH:
+        return length;
+
+      case SCI_GETCHARACTERPOINTER:
+        return reinterpret_cast<LRESULT>(doc.BufferPointer());
+
+      case SCI_GETDOCPOINTER:
+        return reinterpret_cast<LRESULT>(&doc);
+
+      case SCI_GETCHARAT:
+        return (static_cast<Sci_Position>(wParam) < length) ? static_cast<unsigned char>(doc.text()[wParam]) : 0;
+
+      case SCI_GETSTYLEAT:
+        return static_cast<unsigned char>(doc.StyleAt(static_cast<Sci_Position>(wParam)));
+
+      case SCI_GETENDSTYLED:
+        return doc.endStyled();
+
+      case SCI_GETTEXTRANGE: {
+        auto textRange = reinterpret_cast<Sci_TextRange*>(lParam);
+        Sci_Position start = clamp(textRange->chrg.cpMin);
+        Sci_Position end = (textRange->chrg.cpMax < 0) ? length : clamp(textRange->chrg.cpMax);
+        std::memcpy(textRange->lpstrText, doc.text().data() + start, static_cast<size_t>(end - start));
+        textRange->lpstrText[end - start] = '\0';
+        return end - start;
+      }
+
+      case SCI_GETCURRENTPOS:
+      case SCI_GETANCHOR:
+        return caret;
+
+      case SCI_GOTOPOS:
+      case SCI_SETCURRENTPOS:
+      case SCI_SETEMPTYSELECTION:
+        caret = clamp(static_cast<Sci_Position>(wParam));
+        return 0;
+
+      case SCI_GETLINECOUNT:
+        return doc.lineCount();
+
+      case SCI_LINEFROMPOSITION:
+        return doc.LineFromPosition(clamp(static_cast<Sci_Position>(wParam)));
+
+      case SCI_POSITIONFROMLINE:
+        return (static_cast<Sci_Position>(wParam) < doc.lineCount()) ? doc.LineStart(static_cast<Sci_Position>(wParam)) : -1;
+
+      case SCI_GETLINEENDPOSITION:
+        return doc.LineEnd(static_cast<Sci_Position>(wParam));
+
+      case SCI_GETLINEINDENTATION:
+        return doc.GetLineIndentation(static_cast<Sci_Position>(wParam));
+
+      case SCI_GETLINEINDENTPOSITION:
+        return lineIndentPosition(static_cast<Sci_Position>(wParam));
+
+      case SCI_SETLINEINDENTATION:
+        setLineIndentation(static_cast<Sci_Position>(wParam), static_cast<int>(lParam));
+        return 0;
+
+      case SCI_SETINDENT:
+        indentSize = static_cast<int>(wParam);
+        return 0;
+
+      case SCI_GETINDENT:
+        return indentSize;
+
+      case SCI_GETTABWIDTH:
+        // Same as tab width used by document when measuring indentation
+        return 4;
+
+      case SCI_GETEOLMODE:
+        return SC_EOL_LF;
+
+      case SCI_COLOURISE:
+        if (colouriser) {
+          colouriser(clamp(static_cast<Sci_Position>(wParam)), (static_cast<Sci_Position>(lParam) < 0) ? length : clamp(static_cast<Sci_Position>(lParam)));
+        }
+        return 0;
+
+      case SCI_WORDSTARTPOSITION: {
+        Sci_Position position = clamp(static_cast<Sci_Position>(wParam));
+        while (position > 0 && isWordCharAt(position - 1)) {
+          position--;
+        }
+        return position;
+      }
+
+      case SCI_WORDENDPOSITION: {
+        Sci_Position position = clamp(static_cast<Sci_Position>(wParam));
+        while (position < length && isWordCharAt(position)) {
+          position++;
+        }
+        return position;
+      }
+
+      case SCI_SETINDICATORCURRENT:
+        currentIndicator = static_cast<int>(wParam);
+        return 0;
+
+      case SCI_INDICATORFILLRANGE:
+      case SCI_INDICATORCLEARRANGE: {
+        Sci_Position start = clamp(static_cast<Sci_Position>(wParam));
+        fillIndicator(start, clamp(start + static_cast<Sci_Position>(lParam)), (message == SCI_INDICATORFILLRANGE) ? 1 : 0);
+        return 0;
+      }
+
+      case SCI_INDICATORVALUEAT:
+        return indicatorValueAt(static_cast<int>(wParam), static_cast<Sci_Position>(lParam));
+
+      case SCI_INDICATORSTART:
+      case SCI_INDICATOREND: {
+        // Like Scintilla, an indicator that was never drawn has no runs
+        auto iter = indicators.find(static_cast<int>(wParam));
+        if (iter == indicators.end()) {
+          return 0;
+        }
+
+        const auto& runs = iter->second;
+        auto nextRun = runs.upper_bound(clamp(static_cast<Sci_Position>(lParam)));
+        if (message == SCI_INDICATORSTART) {
+          return std::prev(nextRun)->first;
+        }
+        return (nextRun != runs.end()) ? nextRun->first : length;
+      }
+
+      default:
+        // Styling of indicators and others that don't affect content
+        return 0;
+    }
+  }
+
+  void TestScintilla::fillIndicator(Sci_Position start, Sci_Position end, int value) {
+    if (start >= end) {
+      return;
+    }
+
+    auto& runs = indicators.try_emplace(currentIndicator, std::map<Sci_Position, int> {{0, 0}}).first->second;
+    int valueAfter = indicatorValueAt(currentIndicator, end);
+    runs.erase(runs.lower_bound(start), runs.lower_bound(end));
+    runs[start] = value;
+    if (end < doc.Length()) {
+      runs[end] = valueAfter;
+    }
+
+    // Merge with adjacent runs of the same value
+    if (start > 0 && std::prev(runs.find(start))->second == value) {
+      runs.erase(start);
+    }
+    auto runAfter = runs.find(end);
+    if (runAfter != runs.end() && runAfter->second == value) {
+      runs.erase(runAfter);
+    }
+  }
+
+  Sci_Position TestScintilla::lineIndentPosition(Sci_Position line) const {
+    Sci_Position position = doc.LineStart(line);
+    Sci_Position lineEnd = doc.LineEnd(line);
+    while (position < lineEnd && (doc.text()[static_cast<size_t>(position)] == ' ' || doc.text()[static_cast<size_t>(position)] == '\t')) {
+      position++;
+    }
+    return position;
+  }
+
+  void TestScintilla::setLineIndentation(Sci_Position line, int indentation) {
+    // Like Scintilla, indentation is deleted and inserted again with spaces, and caret moves with the text after it
+    Sci_Position lineStart = doc.LineStart(line);
+    Sci_Position indentEnd = lineIndentPosition(line);
+    doc.deleteText(lineStart, indentEnd - lineStart);
+    if (caret > indentEnd) {
+      caret -= indentEnd - lineStart;
+    } else if (caret > lineStart) {
+      caret = lineStart;
+    }
+    doc.insertText(lineStart, std::string(static_cast<size_t>(indentation), ' '));
+    if (caret > lineStart) {
+      caret += indentation;
+    }
+  }
+
+  bool TestScintilla::isWordCharAt(Sci_Position position) const {
+    unsigned char ch = static_cast<unsigned char>(doc.text()[static_cast<size_t>(position)]);
+    return std::isalnum(ch) || ch == '_' || ch >= 0x80;
+  }
+
+} // namespace
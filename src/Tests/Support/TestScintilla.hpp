@@ -0,0 +1,69 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "TestDocument.hpp"
+#include "TestWindow.hpp"
+
+#include <functional>
+#include <map>
+
+namespace test {
+
+  // Stand-in of a Scintilla view showing a test document. It handles the messages plugin features send to read text, styles and
+  // lines, move caret, change indentation, and draw indicators, so those features can be driven without Scintilla.
+  class TestScintilla {
+    public:
+      explicit TestScintilla(TestDocument& document);
+
+      inline HWND handle() const noexcept { return window.handle(); }
+      inline TestDocument& document() noexcept { return doc; }
+
+      inline Sci_Position currentPos() const noexcept { return caret; }
+      inline void setCurrentPos(Sci_Position position) noexcept { caret = position; }
+
+      // Called on SCI_COLOURISE with the range to lex, so tests can stand in for the lexer
+      inline void setColouriser(std::function<void(Sci_Position start, Sci_Position end)> func) { colouriser = std::move(func); }
+
+      // Value of an indicator at a position, 0 if not drawn
+      int indicatorValueAt(int indicatorID, Sci_Position position) const;
+
+    private:
+      LRESULT handleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+      void fillIndicator(Sci_Position start, Sci_Position end, int value);
+      bool isWordCharAt(Sci_Position position) const;
+      Sci_Position lineIndentPosition(Sci_Position line) const;
+      void setLineIndentation(Sci_Position line, int indentation);
+
+      // Private members
+      //
+      TestDocument& doc;
+      TestWindow window;
+      Sci_Position caret {0};
+      int currentIndicator {0};
+      int indentSize {0};
+      std::function<void(Sci_Position start, Sci_Position end)> colouriser;
+
+      // Like Scintilla, each indicator is kept as runs of the same value, by start of the run
+      std::map<int, std::map<Sci_Position, int>> indicators;
+  };
+
+} // namespace
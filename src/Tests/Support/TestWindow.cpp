@@ -0,0 +1,132 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "TestWindow.hpp"
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace test {
+
+#ifdef _WIN32
+  namespace {
+    constexpr wchar_t WINDOW_CLASS_NAME[] = L"PAPYRUS_TEST_WINDOW";
+  }
+
+  TestWindow::TestWindow(message_handler_t handler) : handler(std::move(handler)) {
+    static bool classRegistered = false;
+    if (!classRegistered) {
+      WNDCLASS windowClass {
+        .lpfnWndProc = windowProc,
+        .hInstance = ::GetModuleHandle(nullptr),
+        .lpszClassName = WINDOW_CLASS_NAME
+      };
+      ::RegisterClass(&windowClass);
+      classRegistered = true;
+    }
+    windowHandle = ::CreateWindow(WINDOW_CLASS_NAME, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, ::GetModuleHandle(nullptr), nullptr);
+    ::SetWindowLongPtr(windowHandle, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+  }
+
+  TestWindow::~TestWindow() {
+    ::DestroyWindow(windowHandle);
+  }
+
+  LRESULT CALLBACK TestWindow::windowProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam) {
+    auto testWindow = reinterpret_cast<TestWindow*>(::GetWindowLongPtr(window, GWLP_USERDATA));
+    if (testWindow != nullptr && message >= WM_USER) {
+      return testWindow->handler(message, wParam, lParam);
+    }
+    return ::DefWindowProc(window, message, wParam, lParam);
+  }
+
+  size_t dispatchPostedMessages() {
+    size_t count = 0;
+    MSG message;
+    while (::PeekMessage(&message, nullptr, 0, 0, PM_REMOVE)) {
+      ::DispatchMessage(&message);
+      count++;
+    }
+    return count;
+  }
+#else
+  namespace {
+    std::mutex windowsMutex;
+    std::map<HWND, TestWindow*> windows;
+    uintptr_t lastWindowID {0};
+
+    std::mutex postedMessagesMutex;
+    std::deque<std::tuple<HWND, UINT, WPARAM, LPARAM>> postedMessages;
+  }
+
+  TestWindow::TestWindow(message_handler_t handler) : handler(std::move(handler)) {
+    std::lock_guard<std::mutex> lock(windowsMutex);
+    windowHandle = reinterpret_cast<HWND>(++lastWindowID);
+    windows[windowHandle] = this;
+  }
+
+  TestWindow::~TestWindow() {
+    std::lock_guard<std::mutex> lock(windowsMutex);
+    windows.erase(windowHandle);
+  }
+
+  size_t dispatchPostedMessages() {
+    size_t count = 0;
+    while (true) {
+      std::tuple<HWND, UINT, WPARAM, LPARAM> message;
+      {
+        std::lock_guard<std::mutex> lock(postedMessagesMutex);
+        if (postedMessages.empty()) {
+          return count;
+        }
+        message = postedMessages.front();
+        postedMessages.pop_front();
+      }
+      std::apply(::SendMessage, message);
+      count++;
+    }
+  }
+#endif
+
+} // namespace
+
+#ifndef _WIN32
+// Messages are handled on the calling thread. Sending to a window that doesn't exist does nothing and returns 0, like Windows.
+LRESULT SendMessage(HWND handle, UINT message, WPARAM wParam, LPARAM lParam) {
+  test::TestWindow* window = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(test::windowsMutex);
+    auto iter = test::windows.find(handle);
+    if (iter != test::windows.end()) {
+      window = iter->second;
+    }
+  }
+  return (window != nullptr) ? window->handler(message, wParam, lParam) : 0;
+}
+
+// Posted messages are queued until test calls dispatchPostedMessages
+BOOL PostMessage(HWND handle, UINT message, WPARAM wParam, LPARAM lParam) {
+  std::lock_guard<std::mutex> lock(test::postedMessagesMutex);
+  test::postedMessages.emplace_back(handle, message, wParam, lParam);
+  return TRUE;
+}
+#endif
@@ -0,0 +1,57 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <functional>
+
+#include <windows.h>
+
+namespace test {
+
+  // Stand-in of a window, e.g. Notepad++'s main window or a Scintilla view, that handles messages sent or posted to it with a
+  // function. On Windows it's a message-only window. Elsewhere, SendMessage and PostMessage are implemented by this module.
+  class TestWindow {
+    public:
+      using message_handler_t = std::function<LRESULT(UINT message, WPARAM wParam, LPARAM lParam)>;
+
+      explicit TestWindow(message_handler_t handler);
+      ~TestWindow();
+
+      // Disable all copy/move constructors/assignment operators
+      TestWindow(TestWindow&& other) = delete;
+
+      inline HWND handle() const noexcept { return windowHandle; }
+
+    private:
+      message_handler_t handler;
+      HWND windowHandle {};
+
+#ifdef _WIN32
+      static LRESULT CALLBACK windowProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam);
+#else
+      friend LRESULT (::SendMessage)(HWND handle, UINT message, WPARAM wParam, LPARAM lParam);
+#endif
+  };
+
+  // Deliver messages posted to test windows so far, in the order they were posted. Returns the number of messages delivered.
+  size_t dispatchPostedMessages();
+
+} // namespace
@@ -0,0 +1,91 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal test framework for headless tests. Each test executable links TestMain.cpp, which runs all registered test cases.
+namespace test {
+
+  using test_func_t = void (*)();
+
+  // Thrown by REQUIRE to abort current test case
+  struct RequirementFailure {};
+
+  inline std::vector<std::pair<const char*, test_func_t>>& testCases() {
+    static std::vector<std::pair<const char*, test_func_t>> registeredTestCases;
+    return registeredTestCases;
+  }
+
+  struct Registration {
+    inline Registration(const char* name, test_func_t func) { testCases().emplace_back(name, func); }
+  };
+
+  // Report a failed check of current test case
+  void fail(const char* file, int line, const char* expression);
+
+  // A uniquely named directory under system temp directory, removed with all its contents when destroyed
+  class TemporaryDirectory {
+    public:
+      inline TemporaryDirectory() {
+        static std::atomic<int> counter {0};
+        auto uniqueId = std::chrono::steady_clock::now().time_since_epoch().count();
+        directory = std::filesystem::temp_directory_path() / ("PapyrusTest" + std::to_string(uniqueId) + "_" + std::to_string(counter++));
+        std::filesystem::create_directories(directory);
+      }
+
+      inline ~TemporaryDirectory() {
+        std::error_code errorCode;
+        std::filesystem::remove_all(directory, errorCode);
+      }
+
+      // Disable all copy/move constructors/assignment operators
+      TemporaryDirectory(TemporaryDirectory&& other) = delete;
+
+      inline const std::filesystem::path& path() const noexcept { return directory; }
+
+      // Create a file with given relative path and content, creating parent directories as needed
+      inline std::filesystem::path createFile(const std::filesystem::path& relativePath, const std::string& content = std::string()) const {
+        auto filePath = directory / relativePath;
+        std::filesystem::create_directories(filePath.parent_path());
+        std::ofstream(filePath, std::ios::binary) << content;
+        return filePath;
+      }
+
+    private:
+      std::filesystem::path directory;
+  };
+
+} // namespace
+
+#define TEST_CASE(name) \
+  static void name(); \
+  static test::Registration name##Registration(#name, name); \
+  static void name()
+
+#define CHECK(expression) ((expression) ? (void)0 : test::fail(__FILE__, __LINE__, #expression))
+#define REQUIRE(expression) ((expression) ? (void)0 : (test::fail(__FILE__, __LINE__, #expression), throw test::RequirementFailure()))
@@ -0,0 +1,60 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Test.hpp"
+
+#include <exception>
+#include <iostream>
+
+namespace test {
+
+  namespace {
+    int failedChecks {0};
+  }
+
+  void fail(const char* file, int line, const char* expression) {
+    failedChecks++;
+    std::cerr << file << "(" << line << "): check failed: " << expression << std::endl;
+  }
+
+} // namespace
+
+int main() {
+  int failedTestCases = 0;
+  for (const auto& [name, func] : test::testCases()) {
+    int previouslyFailedChecks = test::failedChecks;
+    try {
+      func();
+    } catch (const test::RequirementFailure&) {
+      // Failure has been reported
+    } catch (const std::exception& exception) {
+      test::fail(name, 0, exception.what());
+    }
+
+    bool passed = (test::failedChecks == previouslyFailedChecks);
+    if (!passed) {
+      failedTestCases++;
+    }
+    std::cout << (passed ? "[  PASSED  ] " : "[  FAILED  ] ") << name << std::endl;
+  }
+
+  std::cout << test::testCases().size() - failedTestCases << " of " << test::testCases().size() << " test cases passed" << std::endl;
+  return (failedTestCases == 0) ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+/*
+This file is part of Papyrus Plugin for Notepad++.
+
+Copyright (C) 2021 blu3mania <blu3mania@hotmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Anonymizes all PEX files under a directory from command line, e.g. before packaging a mod on a build server where Notepad++
+// isn't available, and reports how fast it went.
+//
+// Usage: PexAnonymizerTool <directory> [threads]
+
+#include "..\Plugin\Compiler\PexAnonymizer.hpp"
+
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::fprintf(stderr, "Usage: %s <directory> [threads]\n", argv[0]);
+    return 2;
+  }
+
+  // Error messages contain file paths, which are printed in user's locale
+  std::setlocale(LC_ALL, "");
+
+  std::filesystem::path directory(argv[1]);
+  if (!std::filesystem::is_directory(directory)) {
+    std::fprintf(stderr, "Not a directory: %s\n", argv[1]);
+    return 2;
+  }
+  size_t maxThreads = (argc == 3) ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+  auto report = papyrus::PexAnonymizer::anonymizeDirectory(directory.wstring(), maxThreads);
+  for (const auto& errorMessage : report.errorMessages) {
+    if (!errorMessage.empty()) {
+      std::fprintf(stderr, "%ls\n", errorMessage.c_str());
+    }
+  }
+  std::printf("Anonymized %zu of %zu files, %zu failed, in %.3f s (%.0f files/s)\n", report.anonymized, report.total, report.failed,
+    std::chrono::duration<double>(report.elapsedTime).count(), report.filesPerSecond());
+  return (report.failed == 0) ? 0 : 1;
+}